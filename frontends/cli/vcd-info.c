@@ -1179,7 +1179,9 @@ dump (char *image_fname[])
                "%s\n\n", _rcsid);
     }
 
-  open_rc = vcdinfo_open(&obj, image_fname, gl.source_type, gl.access_mode);
+  /* libvcdinfo reads the disc files through a sector cache then */
+  open_rc = vcdinfo_open_flags(&obj, image_fname, gl.source_type,
+                               gl.access_mode, VCDINFO_OPEN_FLAG_CACHE);
 
   if (NULL == obj) {
     if (*image_fname == NULL) {
@@ -1657,6 +1659,10 @@ main (int argc, const char *argv[])
       gl.source_type = OP_SOURCE_UNDEF;
     }
 
+  /* what _vcd_log_handler drops needn't be formatted at all */
+  vcd_log_set_threshold (gl.debug_level >= 1 ? VCD_LOG_DEBUG
+                         : gl.quiet_flag ? VCD_LOG_WARN : VCD_LOG_INFO);
+
   if (gl.debug_level == 3) {
     vcd_loglevel_default = VCD_LOG_INFO;
     cdio_loglevel_default = CDIO_LOG_INFO;
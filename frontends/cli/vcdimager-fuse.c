@@ -0,0 +1,407 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* mounts a bin/cue image of a simple VCD/SVCD as a filesystem; the
+   image is never written, every sector read is generated on demand */
+
+#define FUSE_USE_VERSION 26
+
+/* Private includes */
+#include "vcd.h"
+#include "vcd_assert.h"
+#include "image_sink.h"
+#include "stream_stdio.h"
+#include "util.h"
+
+/* Public includes */
+#include <libvcd/logging.h>
+#include <libvcd/sector.h>
+
+#include <stdio.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_TIME_H
+#define __USE_XOPEN
+#include <time.h>
+#endif
+
+#include <fuse.h>
+#include <popt.h>
+
+#include "vcdimager_common.h"
+
+static struct {
+  const char *mountpoint;
+  const char *mount_opts;
+  char **track_fnames;
+
+  int foreground_flag;
+
+  /* the virtual files */
+  char bin_path[1024];
+  char cue_path[1024];
+  unsigned sectors;
+  char *cue_text;
+  long cue_len;
+  time_t create_time;
+} gl = { 0, };                             /* global */
+
+static VcdObj_t *gl_vcd_obj = NULL;
+
+static unsigned
+_sector_size (void)
+{
+  return vcdimager_opts.sector_2336_flag ? M2RAW_SECTOR_SIZE : CDIO_CD_FRAMESIZE_RAW;
+}
+
+/* the cue sheet is what the bincue image sink would write, so have it
+   written to a temporary file and keep that in memory */
+static int
+_make_cue_text (void)
+{
+  char tmp_fname[] = "/tmp/vcdimager-fuse-XXXXXX";
+  VcdImageSink_t *p_image_sink;
+  FILE *fd;
+  int fdno;
+
+  if ((fdno = mkstemp (tmp_fname)) < 0)
+    return -1;
+
+  close (fdno);
+
+  p_image_sink = vcd_image_sink_new_bincue ();
+
+  vcd_image_sink_set_arg (p_image_sink, "bin", vcdimager_opts.image_fname);
+  vcd_image_sink_set_arg (p_image_sink, "cue", tmp_fname);
+  vcd_image_sink_set_arg (p_image_sink, "sector",
+                          vcdimager_opts.sector_2336_flag ? "2336" : "2352");
+
+  vcd_obj_write_cuesheet (gl_vcd_obj, p_image_sink);
+
+  vcd_image_sink_destroy (p_image_sink);
+
+  if (!(fd = fopen (tmp_fname, "rb")))
+    {
+      unlink (tmp_fname);
+      return -1;
+    }
+
+  fseek (fd, 0, SEEK_END);
+  gl.cue_len = ftell (fd);
+  fseek (fd, 0, SEEK_SET);
+
+  gl.cue_text = calloc(1, gl.cue_len + 1);
+
+  if (fread (gl.cue_text, 1, gl.cue_len, fd) != (size_t) gl.cue_len)
+    gl.cue_len = 0;
+
+  fclose (fd);
+  unlink (tmp_fname);
+
+  return gl.cue_len ? 0 : -1;
+}
+
+/****************************************************************************
+ * filesystem operations
+ */
+
+static int
+_vcd_fuse_getattr (const char *path, struct stat *stbuf)
+{
+  memset (stbuf, 0, sizeof (struct stat));
+
+  stbuf->st_uid = getuid ();
+  stbuf->st_gid = getgid ();
+  stbuf->st_atime = stbuf->st_mtime = stbuf->st_ctime = gl.create_time;
+
+  if (!strcmp (path, "/"))
+    {
+      stbuf->st_mode = S_IFDIR | 0555;
+      stbuf->st_nlink = 2;
+    }
+  else if (!strcmp (path, gl.bin_path))
+    {
+      stbuf->st_mode = S_IFREG | 0444;
+      stbuf->st_nlink = 1;
+      stbuf->st_size = (off_t) gl.sectors * _sector_size ();
+    }
+  else if (!strcmp (path, gl.cue_path))
+    {
+      stbuf->st_mode = S_IFREG | 0444;
+      stbuf->st_nlink = 1;
+      stbuf->st_size = gl.cue_len;
+    }
+  else
+    return -ENOENT;
+
+  return 0;
+}
+
+static int
+_vcd_fuse_readdir (const char *path, void *buf, fuse_fill_dir_t filler,
+                   off_t offset, struct fuse_file_info *fi)
+{
+  if (strcmp (path, "/"))
+    return -ENOENT;
+
+  filler (buf, ".", NULL, 0);
+  filler (buf, "..", NULL, 0);
+  filler (buf, gl.bin_path + 1, NULL, 0);
+  filler (buf, gl.cue_path + 1, NULL, 0);
+
+  return 0;
+}
+
+static int
+_vcd_fuse_open (const char *path, struct fuse_file_info *fi)
+{
+  if (strcmp (path, gl.bin_path) && strcmp (path, gl.cue_path))
+    return -ENOENT;
+
+  if ((fi->flags & O_ACCMODE) != O_RDONLY)
+    return -EACCES;
+
+  return 0;
+}
+
+static int
+_vcd_fuse_read (const char *path, char *buf, size_t size, off_t offset,
+                struct fuse_file_info *fi)
+{
+  const unsigned sector_size = _sector_size ();
+  const off_t image_len = (off_t) gl.sectors * sector_size;
+  size_t done = 0;
+
+  if (!strcmp (path, gl.cue_path))
+    {
+      if (offset >= gl.cue_len)
+        return 0;
+
+      size = MIN (size, (size_t) (gl.cue_len - offset));
+      memcpy (buf, gl.cue_text + offset, size);
+
+      return size;
+    }
+
+  if (strcmp (path, gl.bin_path))
+    return -ENOENT;
+
+  if (offset >= image_len)
+    return 0;
+
+  size = MIN (size, (size_t) (image_len - offset));
+
+  while (done < size)
+    {
+      uint8_t sector[CDIO_CD_FRAMESIZE_RAW];
+      const lsn_t lsn = (offset + done) / sector_size;
+      const unsigned pos = (offset + done) % sector_size;
+      const size_t len = MIN (size - done, sector_size - pos);
+
+      if (vcd_obj_read_sector (gl_vcd_obj, lsn, sector))
+        return done ? (int) done : -EIO;
+
+      memcpy (buf + done,
+              sector + (vcdimager_opts.sector_2336_flag ? 12 + 4 : 0) + pos, len);
+
+      done += len;
+    }
+
+  return done;
+}
+
+int
+main (int argc, const char *argv[])
+{
+  int retval;
+
+  vcdimager_opts_init ();
+
+  gl.track_fnames = NULL;
+
+  {
+    const char **args = NULL;
+    int opt = 0;
+
+    enum {
+      CL_VERSION = 1,
+      CL_IMG_TYPE
+    };
+
+    struct poptOption optionsTable[] =
+      {
+        {NULL, '\0', POPT_ARG_INCLUDE_TABLE, vcdimager_options, 0,
+         NULL, NULL},
+
+        {"image-type", 'i', POPT_ARG_STRING, NULL, CL_IMG_TYPE,
+         "specify image type to serve (only 'bincue' is supported)",
+         "TYPE"},
+
+
+        {"foreground", 'f', POPT_ARG_NONE, &gl.foreground_flag, 0,
+         "don't detach from the terminal"},
+
+        {"mount-options", 'o', POPT_ARG_STRING, &gl.mount_opts, 0,
+         "pass comma separated OPTIONS on to FUSE", "OPTIONS"},
+
+        {"version", 'V', POPT_ARG_NONE, NULL, CL_VERSION,
+         "display version and copyright information and exit"},
+
+        POPT_AUTOHELP
+
+        {NULL, 0, 0, NULL, 0}
+      };
+
+    poptContext optCon = poptGetContext ("vcdimager-fuse", argc, argv,
+                                         optionsTable, 0);
+    poptSetOtherOptionHelp (optCon, "[OPTION...] <mountpoint> <mpeg-tracks...>");
+
+    if (poptReadDefaultConfig (optCon, 0))
+      fprintf (stderr, "warning, reading popt configuration failed\n");
+
+    while ((opt = poptGetNextOpt (optCon)) != -1)
+      switch (opt)
+        {
+        case CL_VERSION:
+          fprintf (stdout, vcd_version_string (true), "vcdimager-fuse");
+          fflush (stdout);
+          poptFreeContext(optCon);
+          exit (EXIT_SUCCESS);
+          break;
+
+        case CL_IMG_TYPE:
+          {
+            const char *arg = poptGetOptArg (optCon);
+
+            if (!strcmp (arg, "cdrdao") || !strcmp (arg, "nrg"))
+              vcd_error ("image type '%s' can't be served,"
+                         " only 'bincue' is supported", arg);
+            else if (strcmp (arg, "bincue"))
+              vcd_error ("unknown image type '%s'", arg);
+          }
+          break;
+
+        default:
+          if (!vcdimager_parse_opt (optCon, opt))
+            vcd_error ("error while parsing command line - try --help");
+          break;
+        }
+
+    vcdimager_opts_done ();
+
+    if ((args = poptGetArgs (optCon)) == NULL || !args[0] || !args[1])
+      vcd_error ("error: need a mountpoint and at least one data track"
+                 " as arguments -- try --help");
+
+    gl.mountpoint = strdup (args[0]);
+    gl.track_fnames = vcdimager_track_fnames (args + 1);
+
+    /* fuse_main() changes to / when it detaches */
+    vcdimager_resolve_paths (gl.track_fnames);
+
+    poptFreeContext (optCon);
+  }
+
+  /* done with argument processing */
+
+  if (strchr (vcdimager_opts.image_fname, '/')
+      || strchr (vcdimager_opts.cue_fname, '/')
+      || !strcmp (vcdimager_opts.image_fname, vcdimager_opts.cue_fname))
+    vcd_error ("bin and cue file need distinct names without a directory");
+
+  snprintf (gl.bin_path, sizeof (gl.bin_path), "/%s",
+            vcdimager_opts.image_fname);
+  snprintf (gl.cue_path, sizeof (gl.cue_path), "/%s",
+            vcdimager_opts.cue_fname);
+
+  gl_vcd_obj = vcdimager_obj_new ();
+
+  gl.create_time = vcdimager_create_time ();
+
+  vcdimager_obj_add_files (gl_vcd_obj);
+  vcdimager_obj_add_tracks (gl_vcd_obj, gl.track_fnames);
+
+  gl.sectors = vcd_obj_begin_output (gl_vcd_obj);
+
+  if (vcd_obj_begin_read (gl_vcd_obj, &gl.create_time)
+      || _make_cue_text ())
+    {
+      vcd_obj_end_output (gl_vcd_obj);
+      vcd_error ("failed to prepare image");
+      exit (EXIT_FAILURE);
+    }
+
+  {
+    struct fuse_operations _ops;
+    char *fuse_argv[7];
+    int fuse_argc = 0;
+
+    memset (&_ops, 0, sizeof (_ops));
+
+    _ops.getattr = _vcd_fuse_getattr;
+    _ops.readdir = _vcd_fuse_readdir;
+    _ops.open    = _vcd_fuse_open;
+    _ops.read    = _vcd_fuse_read;
+
+    fuse_argv[fuse_argc++] = (char *) argv[0];
+    fuse_argv[fuse_argc++] = (char *) gl.mountpoint;
+    fuse_argv[fuse_argc++] = "-s"; /* the VcdObj_t is not thread safe */
+
+    if (gl.foreground_flag)
+      fuse_argv[fuse_argc++] = "-f";
+
+    if (gl.mount_opts)
+      {
+        fuse_argv[fuse_argc++] = "-o";
+        fuse_argv[fuse_argc++] = (char *) gl.mount_opts;
+      }
+
+    fuse_argv[fuse_argc] = NULL;
+
+    vcd_info ("serving %u sectors as `%s' and `%s' at %s",
+              gl.sectors, vcdimager_opts.image_fname,
+              vcdimager_opts.cue_fname, gl.mountpoint);
+
+    retval = fuse_main (fuse_argc, fuse_argv, &_ops, NULL);
+  }
+
+  vcd_obj_end_output (gl_vcd_obj);
+  vcd_obj_destroy (gl_vcd_obj);
+
+  free (gl.cue_text);
+
+  return retval ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
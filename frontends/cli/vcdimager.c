@@ -44,150 +44,125 @@
 
 #include <popt.h>
 
+#include "vcdimager_common.h"
+
 /* defaults */
-#define DEFAULT_CUE_FILE       "videocd.cue"
-#define DEFAULT_BIN_FILE       "videocd.bin"
-#define DEFAULT_VOLUME_ID      "VIDEOCD"
-#define DEFAULT_APPLICATION_ID ""
-#define DEFAULT_ALBUM_ID       ""
-#define DEFAULT_TYPE           "vcd2"
+#define DEFAULT_CDRDAO_BASE    "videocd"
+#define DEFAULT_NRG_FILE       "videocd.nrg"
+#define DEFAULT_IMG_TYPE       "bincue"
 
 /* global stuff kept as a singleton makes for less typing effort :-)
  */
 
-struct add_files_t {
-  char *fname;
-  char *iso_fname;
-  int raw_flag;
+enum {
+  IMG_TYPE_BINCUE = 1 << 0,
+  IMG_TYPE_CDRDAO = 1 << 1,
+  IMG_TYPE_NRG    = 1 << 2
 };
 
 static struct {
-  const char *type;
-  const char *image_fname;
-  const char *cue_fname;
-  const char *create_timestr;
+  const char *cdrdao_base;
+  const char *nrg_fname;
+  unsigned img_types; /* all image types requested, bincue if none */
+  const char *digest_fname;
   char **track_fnames;
 
-  CdioList_t *add_files;
-
-  const char *volume_label;
-  const char *application_id;
-  const char *album_id;
-
-  int volume_number;
-  int volume_count;
+  int estimate_flag;
+  int null_output_flag;
+  int jobs;
+  int stats_flag;
+  int stats_json_flag;
+} gl = { 0, };                             /* global */
 
-  int sector_2336_flag;
-  int broken_svcd_mode_flag;
-  int update_scan_offsets;
 
-  int verbose_flag;
-  int quiet_flag;
-  int check_flag;
 
-  vcd_log_handler_t default_vcd_log_handler;
-} gl = { 0, };                             /* global */
+/****************************************************************************/
 
+static VcdObj_t *gl_vcd_obj = NULL;
 
-static void
-gl_add_file (char *fname, char *iso_fname, int raw_flag)
+static VcdImageSink_t *
+_create_sink (void)
 {
-  struct add_files_t *tmp = calloc(1, sizeof (struct add_files_t));
+  const char *sector = vcdimager_opts.sector_2336_flag ? "2336" : "2352";
+  CdioList_t *sink_list = _cdio_list_new ();
+  VcdImageSink_t *p_image_sink;
 
-  _cdio_list_append (gl.add_files, tmp);
+  if (gl.null_output_flag)
+    gl.img_types = 0;
+  else if (!gl.img_types)
+    gl.img_types = IMG_TYPE_BINCUE;
 
-  tmp->fname = fname;
-  tmp->iso_fname = iso_fname;
-  tmp->raw_flag = raw_flag;
-}
+  if (gl.img_types & IMG_TYPE_BINCUE)
+    {
+      p_image_sink = vcd_image_sink_new_bincue ();
 
-static void
-gl_add_dir (char *iso_fname)
-{
-  gl_add_file (NULL, iso_fname, false);
-}
+      vcd_image_sink_set_arg (p_image_sink, "bin", vcdimager_opts.image_fname);
+      vcd_image_sink_set_arg (p_image_sink, "cue", vcdimager_opts.cue_fname);
+      vcd_image_sink_set_arg (p_image_sink, "sector", sector);
 
+      _cdio_list_append (sink_list, p_image_sink);
+    }
 
-/****************************************************************************/
+  if (gl.img_types & IMG_TYPE_CDRDAO)
+    {
+      char toc_fname[1024] = { 0, };
 
-static VcdObj_t *gl_vcd_obj = NULL;
+      snprintf (toc_fname, sizeof (toc_fname), "%s.toc", gl.cdrdao_base);
 
-static void
-_vcd_log_handler (vcd_log_level_t level, const char message[])
-{
-  if (level == VCD_LOG_DEBUG && !gl.verbose_flag)
-    return;
+      p_image_sink = vcd_image_sink_new_cdrdao ();
 
-  if (level == VCD_LOG_INFO && gl.quiet_flag)
-    return;
+      vcd_image_sink_set_arg (p_image_sink, "img_base", gl.cdrdao_base);
+      vcd_image_sink_set_arg (p_image_sink, "toc", toc_fname);
+      vcd_image_sink_set_arg (p_image_sink, "sector", sector);
 
-  gl.default_vcd_log_handler (level, message);
-}
+      _cdio_list_append (sink_list, p_image_sink);
+    }
 
-static int
-_parse_file_arg (const char *arg, char **fname1, char **fname2)
-{
-  int rc = 0;
-  char *tmp, *arg_cpy = strdup (arg);
+  if (gl.img_types & IMG_TYPE_NRG)
+    {
+      p_image_sink = vcd_image_sink_new_nrg ();
 
-  *fname1 = *fname2 = NULL;
+      vcd_image_sink_set_arg (p_image_sink, "nrg", gl.nrg_fname);
 
-  tmp = strtok(arg_cpy, ",");
-  if (tmp)
-    *fname1 = strdup (tmp);
-  else
-    rc = -1;
+      _cdio_list_append (sink_list, p_image_sink);
+    }
 
-  tmp = strtok(NULL, ",");
-  if (tmp)
-    *fname2 = strdup (tmp);
+  /* several image types are written in one pass */
+  if (_cdio_list_length (sink_list) > 1)
+    p_image_sink = vcd_image_sink_new_multi (sink_list);
   else
-    rc = -1;
-
-  tmp = strtok(NULL, ",");
-  if (tmp)
-    rc = -1;
-
-  free (tmp);
+    {
+      p_image_sink = NULL; /* null output */
+      if (_cdio_list_length (sink_list))
+        p_image_sink = _cdio_list_node_data (_cdio_list_begin (sink_list));
+      _cdio_list_free (sink_list, false, NULL);
+    }
 
-  if(rc)
+  if (gl.digest_fname || gl.null_output_flag)
     {
-      free (*fname1);
-      free (*fname2);
+      p_image_sink = vcd_image_sink_new_digest (p_image_sink);
 
-      *fname1 = *fname2 = NULL;
+      vcd_image_sink_set_arg (p_image_sink, "sector", sector);
+
+      if (gl.digest_fname)
+        vcd_image_sink_set_arg (p_image_sink, "digest_file", gl.digest_fname);
     }
 
-  return rc;
+  return p_image_sink;
 }
 
 int
 main (int argc, const char *argv[])
 {
-  int n = 0;
-  vcd_type_t type_id;
-  CdioListNode_t *node;
   time_t create_time;
 
   /* g_set_prgname (argv[0]); */
 
-  gl.cue_fname = DEFAULT_CUE_FILE;
-  gl.create_timestr = NULL;
-  gl.image_fname = DEFAULT_BIN_FILE;
-  gl.track_fnames = NULL;
-
-  gl.type = DEFAULT_TYPE;
+  vcdimager_opts_init ();
 
-  gl.volume_label = DEFAULT_VOLUME_ID;
-  gl.application_id = DEFAULT_APPLICATION_ID;
-  gl.album_id = DEFAULT_ALBUM_ID;
-
-  gl.volume_count = 1;
-  gl.volume_number = 1;
-
-  gl.default_vcd_log_handler = vcd_log_set_handler (_vcd_log_handler);
-
-  gl.add_files = _cdio_list_new ();
+  gl.cdrdao_base = DEFAULT_CDRDAO_BASE;
+  gl.nrg_fname = DEFAULT_NRG_FILE;
+  gl.track_fnames = NULL;
 
   {
     const char **args = NULL;
@@ -195,76 +170,50 @@ main (int argc, const char *argv[])
 
     enum {
       CL_VERSION = 1,
-      CL_ADD_DIR,
-      CL_ADD_FILE,
-      CL_ADD_FILE_RAW
+      CL_IMG_TYPE,
+      CL_CDRDAO_FILE,
+      CL_NRG_FILE,
+      CL_STATS
     };
 
     struct poptOption optionsTable[] =
       {
-        {"type", 't', POPT_ARG_STRING, &gl.type, 0,
-         "select VideoCD type ('vcd11', 'vcd2', 'svcd' or 'hqvcd')"
-         " (default: '" DEFAULT_TYPE "')", "TYPE"},
-
-        {"cue-file", 'c', POPT_ARG_STRING, &gl.cue_fname, 0,
-         "specify cue file for output (default: '" DEFAULT_CUE_FILE "')",
-         "FILE"},
+        {NULL, '\0', POPT_ARG_INCLUDE_TABLE, vcdimager_options, 0,
+         NULL, NULL},
 
-        {"bin-file", 'b', POPT_ARG_STRING, &gl.image_fname, 0,
-         "specify bin file for output (default: '" DEFAULT_BIN_FILE "')",
-         "FILE"},
+        {"image-type", 'i', POPT_ARG_STRING, NULL, CL_IMG_TYPE,
+         "specify image type for output ('bincue', 'cdrdao' or 'nrg'),"
+         " may be given more than once (default: '" DEFAULT_IMG_TYPE "')",
+         "TYPE"},
 
-        {"iso-volume-label", 'l', POPT_ARG_STRING, &gl.volume_label, 0,
-         "specify ISO volume label for video cd (default: '" DEFAULT_VOLUME_ID
-         "')", "LABEL"},
+        {"cdrdao-file", '\0', POPT_ARG_STRING, &gl.cdrdao_base, CL_CDRDAO_FILE,
+         "specify cdrdao-style image filename base (default: '"
+         DEFAULT_CDRDAO_BASE "')", "FILE"},
 
-        {"iso-application-id", '\0', POPT_ARG_STRING, &gl.application_id, 0,
-         "specify ISO application id for video cd (default: '"
-         DEFAULT_APPLICATION_ID "')", "LABEL"},
+        {"nrg-file", '\0', POPT_ARG_STRING, &gl.nrg_fname, CL_NRG_FILE,
+         "specify nrg-style image filename (default: '"
+         DEFAULT_NRG_FILE "')", "FILE"},
 
-        {"info-album-id", '\0', POPT_ARG_STRING, &gl.album_id, 0,
-         "specify album id for video cd set (default: '" DEFAULT_ALBUM_ID
-         "')", "LABEL"},
+        {"estimate", '\0', POPT_ARG_NONE, &gl.estimate_flag, 0,
+         "only report the resulting image size, don't write anything"},
 
-        {"volume-count", '\0', POPT_ARG_INT, &gl.volume_count, 0,
-         "specify number of volumes in album set", "NUMBER"},
+        {"digest-file", '\0', POPT_ARG_STRING, &gl.digest_fname, 0,
+         "write MD5/SHA-256 digests of the image and CRC32 checksums"
+         " of its tracks to FILE", "FILE"},
 
-        {"volume-number", '\0', POPT_ARG_INT, &gl.volume_number, 0,
-         "specify album set sequence number (< volume-count)", "NUMBER"},
+        {"null-output", '\0', POPT_ARG_NONE, &gl.null_output_flag, 0,
+         "don't write any image, only compute its digests"},
 
-        {"broken-svcd-mode", '\0', POPT_ARG_NONE, &gl.broken_svcd_mode_flag, 0,
-         "enable non-compliant compatibility mode for broken devices"},
+        {"jobs", 'j', POPT_ARG_INT, &gl.jobs, 0,
+         "write up to NUMBER tracks in parallel", "NUMBER"},
 
-        {"update-scan-offsets", '\0', POPT_ARG_NONE, &gl.update_scan_offsets, 0,
-         "update scan data offsets in video mpeg2 stream"},
-
-        {"sector-2336", '\0', POPT_ARG_NONE, &gl.sector_2336_flag, 0,
-         "use 2336 byte sectors for output"},
-
-        {"add-dir", '\0', POPT_ARG_STRING, NULL, CL_ADD_DIR,
-         "add empty dir to ISO fs", "ISO_DIRNAME"},
-
-        {"add-file", '\0', POPT_ARG_STRING, NULL, CL_ADD_FILE,
-         "add single file to ISO fs", "FILE,ISO_FILENAME"},
-
-        {"add-file-2336", '\0', POPT_ARG_STRING, NULL, CL_ADD_FILE_RAW,
-         "add file containing full 2336 byte sectors to ISO fs",
-         "FILE,ISO_FILENAME"},
-
-        {"create-time", 'T', POPT_ARG_STRING, &gl.create_timestr, 0,
-         "specify creation date on files in CD image (default: current date)"},
+        {"stats", '\0', POPT_ARG_STRING | POPT_ARGFLAG_OPTIONAL, NULL,
+         CL_STATS, "report time and throughput of each stage when done,"
+         " as text or as 'json'", "FORMAT"},
 
         {"progress", 'p', POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN,
          NULL, 0, "show progress"},
 
-        {"check", '\0', POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN,
-         &gl.check_flag, 0, "enabled check mode"},
-
-        {"verbose", 'v', POPT_ARG_NONE, &gl.verbose_flag, 0, "be verbose"},
-
-        {"quiet", 'q', POPT_ARG_NONE, &gl.quiet_flag, 0,
-         "show only critical messages"},
-
         {"version", 'V', POPT_ARG_NONE, NULL, CL_VERSION,
          "display version and copyright information and exit"},
 
@@ -289,197 +238,122 @@ main (int argc, const char *argv[])
           exit (EXIT_SUCCESS);
           break;
 
-        case CL_ADD_DIR:
+        case CL_IMG_TYPE:
           {
             const char *arg = poptGetOptArg (optCon);
 
-            vcd_assert (arg != NULL);
-            gl_add_dir (strdup (arg));
+            if (!strcmp (arg, "bincue"))
+              gl.img_types |= IMG_TYPE_BINCUE;
+            else if (!strcmp (arg, "cdrdao"))
+              gl.img_types |= IMG_TYPE_CDRDAO;
+            else if (!strcmp (arg, "nrg"))
+              gl.img_types |= IMG_TYPE_NRG;
+            else
+              vcd_error ("unknown image type '%s'", arg);
           }
           break;
 
-        case CL_ADD_FILE:
-        case CL_ADD_FILE_RAW:
+        case CL_CDRDAO_FILE:
+          gl.img_types |= IMG_TYPE_CDRDAO;
+          break;
+
+        case CL_NRG_FILE:
+          gl.img_types |= IMG_TYPE_NRG;
+          break;
+
+        case CL_STATS:
           {
             const char *arg = poptGetOptArg (optCon);
-            char *fname1 = NULL, *fname2 = NULL;
 
-            vcd_assert (arg != NULL);
+            gl.stats_flag = true;
 
-            if(!_parse_file_arg (arg, &fname1, &fname2))
-              gl_add_file (fname1, fname2, (opt == CL_ADD_FILE_RAW));
+            if (!arg || !strcmp (arg, "text"))
+              gl.stats_json_flag = false;
+            else if (!strcmp (arg, "json"))
+              gl.stats_json_flag = true;
             else
-              {
-                fprintf (stderr, "file parsing of `%s' failed\n", arg);
-                poptFreeContext(optCon);
-                exit (EXIT_FAILURE);
-              }
+              vcd_error ("unknown stats format '%s'", arg);
           }
           break;
 
         default:
-          vcd_error ("error while parsing command line - try --help");
+          if (!vcdimager_parse_opt (optCon, opt))
+            vcd_error ("error while parsing command line - try --help");
           break;
         }
 
-    if (gl.verbose_flag && gl.quiet_flag)
-      vcd_error ("I can't be both, quiet and verbose... either one or another ;-)");
-
-    if ((args = poptGetArgs (optCon)) == NULL)
-      vcd_error ("error: need at least one data track as argument "
-                 "-- try --help");
-
-    for (n = 0; args[n]; n++);
-
-    if (n > CDIO_CD_MAX_TRACKS - 1)
-      vcd_error ("error: maximal number of supported mpeg tracks (%d) reached",
-                 CDIO_CD_MAX_TRACKS - 1);
+    vcdimager_opts_done ();
 
-    gl.track_fnames = calloc(1, sizeof (char *) * (n + 1));
+    vcd_stats_enabled = gl.stats_flag;
 
-    for (n = 0; args[n]; n++)
-      gl.track_fnames[n] = strdup (args[n]);
+    if (vcdimager_opts.bincue_flag)
+      gl.img_types |= IMG_TYPE_BINCUE;
 
-    {
-      struct {
-        const char *str;
-        vcd_type_t id;
-      } type_str[] =
-        {
-          { "vcd10", VCD_TYPE_VCD },
-          { "vcd11", VCD_TYPE_VCD11 },
-          { "vcd2", VCD_TYPE_VCD2 },
-          { "vcd20", VCD_TYPE_VCD2 },
-          { "svcd", VCD_TYPE_SVCD },
-          { "hqvcd", VCD_TYPE_HQVCD },
-          { NULL, }
-        };
-
-      int i = 0;
-
-      while (type_str[i].str)
-        if (strcasecmp(gl.type, type_str[i].str))
-          i++;
-        else
-          break;
+    if (gl.null_output_flag && gl.img_types)
+      vcd_error ("--null-output writes no image and can't be combined with"
+                 " image type or image file options -- try --help");
 
-      if (!type_str[i].str)
-        vcd_error ("invalid type given");
+    if ((args = poptGetArgs (optCon)) == NULL)
+      vcd_error ("error: need at least one data track as argument "
+                 "-- try --help");
 
-      type_id = type_str[i].id;
-    }
+    gl.track_fnames = vcdimager_track_fnames (args);
 
     poptFreeContext (optCon);
   }
 
   /* done with argument processing */
 
-  if (!strcmp (gl.image_fname, gl.cue_fname))
+  if (!gl.estimate_flag && !gl.null_output_flag
+      && !strcmp (vcdimager_opts.image_fname, vcdimager_opts.cue_fname))
     vcd_warn ("bin and cue file seem to be the same"
               " -- cue file may get overwritten by bin file!");
 
-  gl_vcd_obj = vcd_obj_new (type_id);
+  gl_vcd_obj = vcdimager_obj_new ();
 
-  if (gl.check_flag)
-    vcd_obj_set_param_str (gl_vcd_obj, VCD_PARM_PREPARER_ID, "GNU VCDIMAGER CHECK MODE");
+  if (gl.estimate_flag)
+    vcd_obj_set_param_bool (gl_vcd_obj, VCD_PARM_LAYOUT_SCAN, true);
 
-  vcd_obj_set_param_str (gl_vcd_obj, VCD_PARM_VOLUME_ID, gl.volume_label);
-  vcd_obj_set_param_str (gl_vcd_obj, VCD_PARM_APPLICATION_ID,
-                         gl.application_id);
-  vcd_obj_set_param_str (gl_vcd_obj, VCD_PARM_ALBUM_ID, gl.album_id);
+  if (gl.jobs > 1)
+    vcd_obj_set_param_uint (gl_vcd_obj, VCD_PARM_OUTPUT_JOBS, gl.jobs);
 
-  vcd_obj_set_param_uint (gl_vcd_obj, VCD_PARM_VOLUME_COUNT, gl.volume_count);
-  vcd_obj_set_param_uint (gl_vcd_obj, VCD_PARM_VOLUME_NUMBER,
-                          gl.volume_number);
+  create_time = vcdimager_create_time ();
 
-  if (type_id == VCD_TYPE_SVCD)
-    {
-      vcd_obj_set_param_bool (gl_vcd_obj, VCD_PARM_SVCD_VCD3_MPEGAV,
-                              gl.broken_svcd_mode_flag);
-      vcd_obj_set_param_bool (gl_vcd_obj, VCD_PARM_SVCD_VCD3_ENTRYSVD,
-                              gl.broken_svcd_mode_flag);
-
-      vcd_obj_set_param_bool (gl_vcd_obj, VCD_PARM_UPDATE_SCAN_OFFSETS,
-                              gl.update_scan_offsets);
-    }
-
-  create_time = time(NULL);
-  if (gl.create_timestr != NULL) {
-    if (!strcmp (gl.create_timestr, "TESTING"))
-      create_time = 269236800L;
-    else {
-#ifdef HAVE_STRPTIME
-      struct tm tm;
-
-      if (NULL == strptime(gl.create_timestr, "%Y-%m-%d %H:%M:%S", &tm)) {
-        vcd_warn("Trouble converting date string %s using strptime.",
-                 gl.create_timestr);
-        vcd_warn("String should match %%Y-%%m-%%d %%H:%%M:%%S");
-      } else {
-        create_time = mktime(&tm);
-      }
-#else
-      create_time = 269236800L;
-#endif
-    }
-  }
+  vcdimager_obj_add_files (gl_vcd_obj);
+  vcdimager_obj_add_tracks (gl_vcd_obj, gl.track_fnames);
 
-  _CDIO_LIST_FOREACH (node, gl.add_files)
-  {
-    struct add_files_t *p = _cdio_list_node_data (node);
+  if (gl.estimate_flag)
+    {
+      const long sectors = vcd_obj_get_image_size (gl_vcd_obj);
+      long _bytes;
+      char *_msfstr;
 
-    if (p->fname)
-      {
-        fprintf (stdout, "debug: adding [%s] as [%s] (raw=%d)\n",
-                 p->fname, p->iso_fname, p->raw_flag);
+      /* no sequence track to lay out */
+      if (sectors < 0)
+        vcd_error ("can't estimate the image size");
 
-        if (vcd_obj_add_file(gl_vcd_obj, p->iso_fname,
-                             vcd_data_source_new_stdio (p->fname),
-                             p->raw_flag))
-          {
-            fprintf (stderr,
-                     "error while adding file `%s' as `%s' to (S)VCD\n",
-                     p->fname, p->iso_fname);
-            exit (EXIT_FAILURE);
-          }
-      }
-    else
-      {
-        fprintf (stdout, "debug: adding empty dir [%s]\n", p->iso_fname);
-
-        if (vcd_obj_add_dir(gl_vcd_obj, p->iso_fname))
-          {
-            fprintf (stderr,
-                     "error while adding dir `%s' to (S)VCD\n", p->iso_fname);
-            exit (EXIT_FAILURE);
-          }
-      }
-  } /* _CDIO_LIST_FOREACH */
+      _bytes = sectors *
+        (vcdimager_opts.sector_2336_flag ? M2RAW_SECTOR_SIZE : CDIO_CD_FRAMESIZE_RAW);
+      _msfstr = cdio_lba_to_msf_str (sectors);
 
-  for (n = 0; gl.track_fnames[n] != NULL; n++)
-    {
-      VcdDataSource_t *data_source;
+      fprintf (stdout,
+               "estimated image size is %ld sectors [%s] (%ld bytes)\n",
+               sectors, _msfstr, _bytes);
 
-      data_source = vcd_data_source_new_stdio (gl.track_fnames[n]);
+      fprintf (stdout, "fits on 74min CDR: %s, fits on 80min CDR: %s\n",
+               sectors <= CDIO_CD_74MIN_SECTORS ? "yes" : "no",
+               sectors <= CDIO_CD_80MIN_SECTORS ? "yes" : "no");
 
-      vcd_assert (data_source != NULL);
+      free (_msfstr);
 
-      vcd_obj_append_sequence_play_item (gl_vcd_obj,
-                                         vcd_mpeg_source_new (data_source),
-                                         NULL, NULL);
+      return EXIT_SUCCESS;
     }
 
-
   {
     unsigned sectors;
     VcdImageSink_t *p_image_sink;
 
-    p_image_sink = vcd_image_sink_new_bincue ();
-
-    vcd_image_sink_set_arg (p_image_sink, "bin", gl.image_fname);
-    vcd_image_sink_set_arg (p_image_sink, "cue", gl.cue_fname);
-    vcd_image_sink_set_arg (p_image_sink, "sector",
-                            gl.sector_2336_flag ? "2336" : "2352");
+    p_image_sink = _create_sink ();
 
     if (!p_image_sink)
       {
@@ -495,7 +369,7 @@ main (int argc, const char *argv[])
 
     {
       unsigned _bytes = sectors *
-        (gl.sector_2336_flag ? M2RAW_SECTOR_SIZE : CDIO_CD_FRAMESIZE_RAW);
+        (vcdimager_opts.sector_2336_flag ? M2RAW_SECTOR_SIZE : CDIO_CD_FRAMESIZE_RAW);
       char *_msfstr = cdio_lba_to_msf_str (sectors);
 
       fprintf (stdout,
@@ -504,6 +378,17 @@ main (int argc, const char *argv[])
 
       free (_msfstr);
     }
+
+    if (gl.stats_flag)
+      {
+        VcdStats_t _stats;
+        char *_str;
+
+        vcd_obj_get_stats (gl_vcd_obj, &_stats);
+
+        fputs (_str = vcd_stats_format (&_stats, gl.stats_json_flag), stdout);
+        free (_str);
+      }
   }
 
   return EXIT_SUCCESS;
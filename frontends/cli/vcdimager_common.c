@@ -0,0 +1,492 @@
+/*
+    Copyright (C) 2018 Rocky Bernstein <rocky@gnu.org>
+    Copyright (C) 2001, 2003, 2004, 2005 Herbert Valerio Riedel <hvr@gnu.org>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Private includes */
+#include "vcd.h"
+#include "vcd_assert.h"
+#include "stream_stdio.h"
+#include "util.h"
+
+/* Public includes */
+#include <libvcd/logging.h>
+
+#include <stdio.h>
+#include <errno.h>
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#ifdef HAVE_TIME_H
+#define __USE_XOPEN
+#include <time.h>
+#endif
+
+#include "vcdimager_common.h"
+
+struct add_files_t {
+  char *fname;
+  char *iso_fname;
+  int raw_flag;
+};
+
+struct vcdimager_opts vcdimager_opts = { 0, };
+
+static vcd_log_handler_t default_vcd_log_handler;
+
+enum {
+  CL_ADD_DIR = 0x100,
+  CL_ADD_FILE,
+  CL_ADD_FILE_RAW,
+  CL_BIN_FILE,
+  CL_CUE_FILE
+};
+
+struct poptOption vcdimager_options[] =
+  {
+    {"type", 't', POPT_ARG_STRING, &vcdimager_opts.type, 0,
+     "select VideoCD type ('vcd11', 'vcd2', 'svcd' or 'hqvcd')"
+     " (default: '" DEFAULT_TYPE "')", "TYPE"},
+
+    {"cue-file", 'c', POPT_ARG_STRING, &vcdimager_opts.cue_fname, CL_CUE_FILE,
+     "specify cue file for output (default: '" DEFAULT_CUE_FILE "')",
+     "FILE"},
+
+    {"bin-file", 'b', POPT_ARG_STRING, &vcdimager_opts.image_fname,
+     CL_BIN_FILE,
+     "specify bin file for output (default: '" DEFAULT_BIN_FILE "')",
+     "FILE"},
+
+    {"iso-volume-label", 'l', POPT_ARG_STRING, &vcdimager_opts.volume_label, 0,
+     "specify ISO volume label for video cd (default: '" DEFAULT_VOLUME_ID
+     "')", "LABEL"},
+
+    {"iso-application-id", '\0', POPT_ARG_STRING,
+     &vcdimager_opts.application_id, 0,
+     "specify ISO application id for video cd (default: '"
+     DEFAULT_APPLICATION_ID "')", "LABEL"},
+
+    {"info-album-id", '\0', POPT_ARG_STRING, &vcdimager_opts.album_id, 0,
+     "specify album id for video cd set (default: '" DEFAULT_ALBUM_ID
+     "')", "LABEL"},
+
+    {"volume-count", '\0', POPT_ARG_INT, &vcdimager_opts.volume_count, 0,
+     "specify number of volumes in album set", "NUMBER"},
+
+    {"volume-number", '\0', POPT_ARG_INT, &vcdimager_opts.volume_number, 0,
+     "specify album set sequence number (< volume-count)", "NUMBER"},
+
+    {"broken-svcd-mode", '\0', POPT_ARG_NONE,
+     &vcdimager_opts.broken_svcd_mode_flag, 0,
+     "enable non-compliant compatibility mode for broken devices"},
+
+    {"update-scan-offsets", '\0', POPT_ARG_NONE,
+     &vcdimager_opts.update_scan_offsets, 0,
+     "update scan data offsets in video mpeg2 stream"},
+
+    {"sector-2336", '\0', POPT_ARG_NONE, &vcdimager_opts.sector_2336_flag, 0,
+     "use 2336 byte sectors for output"},
+
+    {"add-dir", '\0', POPT_ARG_STRING, NULL, CL_ADD_DIR,
+     "add empty dir to ISO fs", "ISO_DIRNAME"},
+
+    {"add-file", '\0', POPT_ARG_STRING, NULL, CL_ADD_FILE,
+     "add single file to ISO fs", "FILE,ISO_FILENAME"},
+
+    {"add-file-2336", '\0', POPT_ARG_STRING, NULL, CL_ADD_FILE_RAW,
+     "add file containing full 2336 byte sectors to ISO fs",
+     "FILE,ISO_FILENAME"},
+
+    {"create-time", 'T', POPT_ARG_STRING, &vcdimager_opts.create_timestr, 0,
+     "specify creation date on files in CD image (default: current date)"},
+
+    {"check", '\0', POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN,
+     &vcdimager_opts.check_flag, 0, "enabled check mode"},
+
+    {"verbose", 'v', POPT_ARG_NONE, &vcdimager_opts.verbose_flag, 0,
+     "be verbose"},
+
+    {"quiet", 'q', POPT_ARG_NONE, &vcdimager_opts.quiet_flag, 0,
+     "show only critical messages"},
+
+    {NULL, 0, 0, NULL, 0}
+  };
+
+static void
+_vcd_log_handler (vcd_log_level_t level, const char message[])
+{
+  if (level == VCD_LOG_DEBUG && !vcdimager_opts.verbose_flag)
+    return;
+
+  if (level == VCD_LOG_INFO && vcdimager_opts.quiet_flag)
+    return;
+
+  default_vcd_log_handler (level, message);
+}
+
+static void
+_add_file (char *fname, char *iso_fname, int raw_flag)
+{
+  struct add_files_t *tmp = calloc(1, sizeof (struct add_files_t));
+
+  _cdio_list_append (vcdimager_opts.add_files, tmp);
+
+  tmp->fname = fname;
+  tmp->iso_fname = iso_fname;
+  tmp->raw_flag = raw_flag;
+}
+
+static void
+_add_dir (char *iso_fname)
+{
+  _add_file (NULL, iso_fname, false);
+}
+
+static int
+_parse_file_arg (const char *arg, char **fname1, char **fname2)
+{
+  int rc = 0;
+  char *tmp, *arg_cpy = strdup (arg);
+
+  *fname1 = *fname2 = NULL;
+
+  tmp = strtok(arg_cpy, ",");
+  if (tmp)
+    *fname1 = strdup (tmp);
+  else
+    rc = -1;
+
+  tmp = strtok(NULL, ",");
+  if (tmp)
+    *fname2 = strdup (tmp);
+  else
+    rc = -1;
+
+  tmp = strtok(NULL, ",");
+  if (tmp)
+    rc = -1;
+
+  free (arg_cpy);
+
+  if(rc)
+    {
+      free (*fname1);
+      free (*fname2);
+
+      *fname1 = *fname2 = NULL;
+    }
+
+  return rc;
+}
+
+void
+vcdimager_opts_init (void)
+{
+  vcdimager_opts.cue_fname = DEFAULT_CUE_FILE;
+  vcdimager_opts.create_timestr = NULL;
+  vcdimager_opts.image_fname = DEFAULT_BIN_FILE;
+
+  vcdimager_opts.type = DEFAULT_TYPE;
+
+  vcdimager_opts.volume_label = DEFAULT_VOLUME_ID;
+  vcdimager_opts.application_id = DEFAULT_APPLICATION_ID;
+  vcdimager_opts.album_id = DEFAULT_ALBUM_ID;
+
+  vcdimager_opts.volume_count = 1;
+  vcdimager_opts.volume_number = 1;
+
+  default_vcd_log_handler = vcd_log_set_handler (_vcd_log_handler);
+
+  vcdimager_opts.add_files = _cdio_list_new ();
+}
+
+bool
+vcdimager_parse_opt (poptContext optCon, int opt)
+{
+  switch (opt)
+    {
+    case CL_BIN_FILE:
+    case CL_CUE_FILE:
+      vcdimager_opts.bincue_flag = true;
+      break;
+
+    case CL_ADD_DIR:
+      {
+        const char *arg = poptGetOptArg (optCon);
+
+        vcd_assert (arg != NULL);
+        _add_dir (strdup (arg));
+      }
+      break;
+
+    case CL_ADD_FILE:
+    case CL_ADD_FILE_RAW:
+      {
+        const char *arg = poptGetOptArg (optCon);
+        char *fname1 = NULL, *fname2 = NULL;
+
+        vcd_assert (arg != NULL);
+
+        if(!_parse_file_arg (arg, &fname1, &fname2))
+          _add_file (fname1, fname2, (opt == CL_ADD_FILE_RAW));
+        else
+          {
+            fprintf (stderr, "file parsing of `%s' failed\n", arg);
+            poptFreeContext(optCon);
+            exit (EXIT_FAILURE);
+          }
+      }
+      break;
+
+    default:
+      return false;
+    }
+
+  return true;
+}
+
+void
+vcdimager_opts_done (void)
+{
+  if (vcdimager_opts.verbose_flag && vcdimager_opts.quiet_flag)
+    vcd_error ("I can't be both, quiet and verbose... either one or another ;-)");
+
+  /* what _vcd_log_handler drops needn't be formatted at all */
+  vcd_log_set_threshold (vcdimager_opts.verbose_flag ? VCD_LOG_DEBUG
+                         : vcdimager_opts.quiet_flag ? VCD_LOG_WARN
+                         : VCD_LOG_INFO);
+}
+
+char **
+vcdimager_track_fnames (const char *args[])
+{
+  char **track_fnames;
+  int n;
+
+  for (n = 0; args[n]; n++);
+
+  if (n > CDIO_CD_MAX_TRACKS - 1)
+    vcd_error ("error: maximal number of supported mpeg tracks (%d) reached",
+               CDIO_CD_MAX_TRACKS - 1);
+
+  track_fnames = calloc(1, sizeof (char *) * (n + 1));
+
+  for (n = 0; args[n]; n++)
+    track_fnames[n] = strdup (args[n]);
+
+  return track_fnames;
+}
+
+time_t
+vcdimager_create_time (void)
+{
+  const char *create_timestr = vcdimager_opts.create_timestr;
+  time_t create_time = time(NULL);
+
+  if (create_timestr != NULL) {
+    if (!strcmp (create_timestr, "TESTING"))
+      create_time = 269236800L;
+    else {
+#ifdef HAVE_STRPTIME
+      struct tm tm;
+
+      if (NULL == strptime(create_timestr, "%Y-%m-%d %H:%M:%S", &tm)) {
+        vcd_warn("Trouble converting date string %s using strptime.",
+                 create_timestr);
+        vcd_warn("String should match %%Y-%%m-%%d %%H:%%M:%%S");
+      } else {
+        create_time = mktime(&tm);
+      }
+#else
+      create_time = 269236800L;
+#endif
+    }
+  }
+
+  return create_time;
+}
+
+VcdObj_t *
+vcdimager_obj_new (void)
+{
+  struct {
+    const char *str;
+    vcd_type_t id;
+  } type_str[] =
+    {
+      { "vcd10", VCD_TYPE_VCD },
+      { "vcd11", VCD_TYPE_VCD11 },
+      { "vcd2", VCD_TYPE_VCD2 },
+      { "vcd20", VCD_TYPE_VCD2 },
+      { "svcd", VCD_TYPE_SVCD },
+      { "hqvcd", VCD_TYPE_HQVCD },
+      { NULL, }
+    };
+
+  VcdObj_t *p_obj;
+  vcd_type_t type_id;
+  int i = 0;
+
+  while (type_str[i].str)
+    if (strcasecmp(vcdimager_opts.type, type_str[i].str))
+      i++;
+    else
+      break;
+
+  if (!type_str[i].str)
+    vcd_error ("invalid type given");
+
+  type_id = type_str[i].id;
+
+  p_obj = vcd_obj_new (type_id);
+
+  if (vcdimager_opts.check_flag)
+    vcd_obj_set_param_str (p_obj, VCD_PARM_PREPARER_ID,
+                           "GNU VCDIMAGER CHECK MODE");
+
+  vcd_obj_set_param_str (p_obj, VCD_PARM_VOLUME_ID,
+                         vcdimager_opts.volume_label);
+  vcd_obj_set_param_str (p_obj, VCD_PARM_APPLICATION_ID,
+                         vcdimager_opts.application_id);
+  vcd_obj_set_param_str (p_obj, VCD_PARM_ALBUM_ID, vcdimager_opts.album_id);
+
+  vcd_obj_set_param_uint (p_obj, VCD_PARM_VOLUME_COUNT,
+                          vcdimager_opts.volume_count);
+  vcd_obj_set_param_uint (p_obj, VCD_PARM_VOLUME_NUMBER,
+                          vcdimager_opts.volume_number);
+
+  if (type_id == VCD_TYPE_SVCD)
+    {
+      vcd_obj_set_param_bool (p_obj, VCD_PARM_SVCD_VCD3_MPEGAV,
+                              vcdimager_opts.broken_svcd_mode_flag);
+      vcd_obj_set_param_bool (p_obj, VCD_PARM_SVCD_VCD3_ENTRYSVD,
+                              vcdimager_opts.broken_svcd_mode_flag);
+
+      vcd_obj_set_param_bool (p_obj, VCD_PARM_UPDATE_SCAN_OFFSETS,
+                              vcdimager_opts.update_scan_offsets);
+    }
+
+  return p_obj;
+}
+
+static char *
+_resolve_path (char *fname)
+{
+#ifdef HAVE_REALPATH
+  char *resolved = realpath (fname, NULL);
+
+  if (!resolved)
+    vcd_error ("can't resolve `%s': %s", fname, strerror (errno));
+
+  free (fname);
+
+  return resolved;
+#else
+  if (fname[0] != '/')
+    vcd_warn ("relative path `%s' may not be found later", fname);
+
+  return fname;
+#endif
+}
+
+void
+vcdimager_resolve_paths (char *track_fnames[])
+{
+  CdioListNode_t *node;
+  int n;
+
+  for (n = 0; track_fnames[n] != NULL; n++)
+    track_fnames[n] = _resolve_path (track_fnames[n]);
+
+  _CDIO_LIST_FOREACH (node, vcdimager_opts.add_files)
+    {
+      struct add_files_t *p = _cdio_list_node_data (node);
+
+      if (p->fname)
+        p->fname = _resolve_path (p->fname);
+    }
+}
+
+void
+vcdimager_obj_add_files (VcdObj_t *p_obj)
+{
+  CdioListNode_t *node;
+
+  _CDIO_LIST_FOREACH (node, vcdimager_opts.add_files)
+  {
+    struct add_files_t *p = _cdio_list_node_data (node);
+
+    if (p->fname)
+      {
+        fprintf (stdout, "debug: adding [%s] as [%s] (raw=%d)\n",
+                 p->fname, p->iso_fname, p->raw_flag);
+
+        if (vcd_obj_add_file(p_obj, p->iso_fname,
+                             vcd_data_source_new_stdio (p->fname),
+                             p->raw_flag))
+          {
+            fprintf (stderr,
+                     "error while adding file `%s' as `%s' to (S)VCD\n",
+                     p->fname, p->iso_fname);
+            exit (EXIT_FAILURE);
+          }
+      }
+    else
+      {
+        fprintf (stdout, "debug: adding empty dir [%s]\n", p->iso_fname);
+
+        if (vcd_obj_add_dir(p_obj, p->iso_fname))
+          {
+            fprintf (stderr,
+                     "error while adding dir `%s' to (S)VCD\n", p->iso_fname);
+            exit (EXIT_FAILURE);
+          }
+      }
+  } /* _CDIO_LIST_FOREACH */
+}
+
+void
+vcdimager_obj_add_tracks (VcdObj_t *p_obj, char *track_fnames[])
+{
+  int n;
+
+  for (n = 0; track_fnames[n] != NULL; n++)
+    {
+      VcdDataSource_t *data_source;
+
+      data_source = vcd_data_source_new_stdio (track_fnames[n]);
+
+      vcd_assert (data_source != NULL);
+
+      vcd_obj_append_sequence_play_item (p_obj,
+                                         vcd_mpeg_source_new (data_source),
+                                         NULL, NULL);
+    }
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
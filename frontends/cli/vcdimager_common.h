@@ -0,0 +1,101 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* what vcdimager and vcdimager-fuse have in common: the options
+   describing the disc and turning them into a VcdObj_t */
+
+#ifndef __VCDIMAGER_COMMON_H__
+#define __VCDIMAGER_COMMON_H__
+
+#include <time.h>
+#include <popt.h>
+
+#include <libvcd/types.h>
+
+/* defaults */
+#define DEFAULT_CUE_FILE       "videocd.cue"
+#define DEFAULT_BIN_FILE       "videocd.bin"
+#define DEFAULT_VOLUME_ID      "VIDEOCD"
+#define DEFAULT_APPLICATION_ID ""
+#define DEFAULT_ALBUM_ID       ""
+#define DEFAULT_TYPE           "vcd2"
+
+extern struct vcdimager_opts {
+  const char *type;
+  const char *image_fname;
+  const char *cue_fname;
+  const char *create_timestr;
+
+  CdioList_t *add_files;
+
+  const char *volume_label;
+  const char *application_id;
+  const char *album_id;
+
+  int volume_number;
+  int volume_count;
+
+  int sector_2336_flag;
+  int broken_svcd_mode_flag;
+  int update_scan_offsets;
+
+  int verbose_flag;
+  int quiet_flag;
+  int check_flag;
+
+  bool bincue_flag; /* --bin-file or --cue-file given */
+} vcdimager_opts;
+
+/* to be included with POPT_ARG_INCLUDE_TABLE; values returned by
+   poptGetNextOpt() for these go to vcdimager_parse_opt() */
+extern struct poptOption vcdimager_options[];
+
+/* sets the defaults and installs the log handler */
+void vcdimager_opts_init (void);
+
+/* handles an option of vcdimager_options[]; returns false for
+   values it doesn't know */
+bool vcdimager_parse_opt (poptContext optCon, int opt);
+
+/* checks the parsed options and sets the log threshold */
+void vcdimager_opts_done (void);
+
+/* copies the track arguments into a NULL terminated array */
+char **vcdimager_track_fnames (const char *args[]);
+
+time_t vcdimager_create_time (void);
+
+/* creates the VcdObj_t for the type and disc options given */
+VcdObj_t *vcdimager_obj_new (void);
+
+/* makes the names of the tracks and of the --add-file files absolute,
+   for running from another working directory */
+void vcdimager_resolve_paths (char *track_fnames[]);
+
+/* adds the files and dirs of --add-* and the tracks to p_obj */
+void vcdimager_obj_add_files (VcdObj_t *p_obj);
+void vcdimager_obj_add_tracks (VcdObj_t *p_obj, char *track_fnames[]);
+
+#endif /* __VCDIMAGER_COMMON_H__ */
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -128,12 +128,15 @@ _xmlParseFile(const char *filename)
 #define DEFAULT_BIN_FILE       "videocd.bin"
 #define DEFAULT_IMG_TYPE       "bincue"
 
+enum {
+  IMG_TYPE_BINCUE = 1 << 0,
+  IMG_TYPE_CDRDAO = 1 << 1,
+  IMG_TYPE_NRG    = 1 << 2
+};
+
 static struct {
-  enum {
-    IMG_TYPE_BINCUE = 0,
-    IMG_TYPE_CDRDAO,
-    IMG_TYPE_NRG
-  } img_type;
+  unsigned img_types; /* all image types requested, bincue if none */
+  bool digest_flag;
 
   CdioList_t *img_options;
 
@@ -141,11 +144,20 @@ static struct {
   char *file_prefix;
   char *create_timestr;
 
+  char *manifest_fname;
+  char *prev_image_fname;
+  char *prev_manifest_fname;
+
   int verbose_flag;
   int check_flag;
   int quiet_flag;
   int progress_flag;
   int gui_flag;
+  int null_output_flag;
+  int no_scan_index_flag;
+  int jobs;
+  bool stats_flag;
+  bool stats_json_flag;
 } gl;
 
 struct key_val_t {
@@ -183,14 +195,16 @@ _do_cl (int argc, const char *argv[])
     CL_CDRDAO_FILE,
     CL_NRG_FILE,
     CL_2336_FLAG,
+    CL_DIGEST_FILE,
+    CL_STATS,
     CL_DUMP_DTD
   };
   poptContext optCon = NULL;
   struct poptOption optionsTable[] =
     {
       {"image-type", 'i', POPT_ARG_STRING, NULL, CL_IMG_TYPE,
-       "specify image type for output (default: '" DEFAULT_IMG_TYPE "')",
-       "TYPE"},
+       "specify image type for output, may be given more than once"
+       " (default: '" DEFAULT_IMG_TYPE "')", "TYPE"},
 
       {"image-option", 'o', POPT_ARG_STRING, NULL, CL_IMG_OPT,
        "specify image option", "KEY=VALUE"},
@@ -212,12 +226,41 @@ _do_cl (int argc, const char *argv[])
       {"sector-2336", '\0', POPT_ARG_NONE, NULL, CL_2336_FLAG,
        "use 2336 byte sectors for output"},
 
+      {"digest-file", '\0', POPT_ARG_STRING, NULL, CL_DIGEST_FILE,
+       "write MD5/SHA-256 digests of the image and CRC32 checksums of"
+       " its tracks as XML comments to FILE", "FILE"},
+
+      {"null-output", '\0', POPT_ARG_NONE, &gl.null_output_flag, 0,
+       "don't write any image, only compute its digests"},
+
+      {"manifest", '\0', POPT_ARG_STRING, &gl.manifest_fname, 0,
+       "write a build manifest to FILE, for use with --previous-manifest",
+       "FILE"},
+
+      {"previous-image", '\0', POPT_ARG_STRING, &gl.prev_image_fname, 0,
+       "reuse the MPEG tracks of bin FILE, built before with --manifest,"
+       " if they did not change", "FILE"},
+
+      {"previous-manifest", '\0', POPT_ARG_STRING, &gl.prev_manifest_fname, 0,
+       "manifest written along with the --previous-image", "FILE"},
+
+      {"no-scan-index", '\0', POPT_ARG_NONE, &gl.no_scan_index_flag, 0,
+       "scan all MPEG files, even those with a scan index left by"
+       " vcdxrip --scan-index"},
+
+      {"jobs", 'j', POPT_ARG_INT, &gl.jobs, 0,
+       "write up to NUMBER tracks in parallel", "NUMBER"},
+
       {"create-time", 'T', POPT_ARG_STRING, &gl.create_timestr, 0,
        "specify creation date on files in CD image (default: current date)"},
 
       {"progress", 'p', POPT_ARG_NONE, &gl.progress_flag, 0,
        "show progress"},
 
+      {"stats", '\0', POPT_ARG_STRING | POPT_ARGFLAG_OPTIONAL, NULL, CL_STATS,
+       "report time and throughput of each stage when done,"
+       " as text or as 'json'", "FORMAT"},
+
       {"dump-dtd", '\0', POPT_ARG_NONE, NULL, CL_DUMP_DTD,
        "dump internal DTD to stdout"},
 
@@ -271,7 +314,7 @@ _do_cl (int argc, const char *argv[])
 
       case CL_CDRDAO_FILE:
 	opt_arg = poptGetOptArg (optCon);
-	gl.img_type = IMG_TYPE_CDRDAO;
+	gl.img_types |= IMG_TYPE_CDRDAO;
 
 	_set_img_opt ("img_base", opt_arg);
 
@@ -285,17 +328,17 @@ _do_cl (int argc, const char *argv[])
 	break;
 
       case CL_NRG_FILE:
-	gl.img_type = IMG_TYPE_NRG;
+	gl.img_types |= IMG_TYPE_NRG;
 	_set_img_opt ("nrg", poptGetOptArg (optCon));
 	break;
 
       case CL_BIN_FILE:
-	gl.img_type = IMG_TYPE_BINCUE;
+	gl.img_types |= IMG_TYPE_BINCUE;
 	_set_img_opt ("bin", poptGetOptArg (optCon));
 	break;
 
       case CL_CUE_FILE:
-	gl.img_type = IMG_TYPE_BINCUE;
+	gl.img_types |= IMG_TYPE_BINCUE;
 	_set_img_opt ("cue", poptGetOptArg (optCon));
 	break;
 
@@ -303,15 +346,32 @@ _do_cl (int argc, const char *argv[])
 	_set_img_opt ("sector", "2336");
 	break;
 
+      case CL_DIGEST_FILE:
+	gl.digest_flag = true;
+	_set_img_opt ("digest_file", poptGetOptArg (optCon));
+	break;
+
+      case CL_STATS:
+	opt_arg = poptGetOptArg (optCon);
+	gl.stats_flag = true;
+
+	if (!opt_arg || !strcmp (opt_arg, "text"))
+	  gl.stats_json_flag = false;
+	else if (!strcmp (opt_arg, "json"))
+	  gl.stats_json_flag = true;
+	else
+	  vcd_error ("unknown stats format '%s'", opt_arg);
+	break;
+
       case CL_IMG_TYPE:
 	opt_arg = poptGetOptArg (optCon);
 
 	if (!strcmp (opt_arg, "bincue"))
-	  gl.img_type = IMG_TYPE_BINCUE;
+	  gl.img_types |= IMG_TYPE_BINCUE;
 	else if (!strcmp (opt_arg, "cdrdao"))
-	  gl.img_type = IMG_TYPE_CDRDAO;
+	  gl.img_types |= IMG_TYPE_CDRDAO;
 	else if (!strcmp (opt_arg, "nrg"))
-	  gl.img_type = IMG_TYPE_NRG;
+	  gl.img_types |= IMG_TYPE_NRG;
 	else
 	  vcd_error ("unknown image type '%s'", opt_arg);
 	break;
@@ -341,6 +401,10 @@ _do_cl (int argc, const char *argv[])
   if (gl.verbose_flag && gl.quiet_flag)
     vcd_error ("I can't be both, quiet and verbose... either one or another ;-)");
 
+  if (gl.null_output_flag && gl.img_types)
+    vcd_error ("--null-output writes no image and can't be combined with"
+	       " image type or image file options -- try --help");
+
   if ((args = poptGetArgs (optCon)) == NULL)
     vcd_error ("xml input file argument missing -- try --help");
 
@@ -351,6 +415,10 @@ _do_cl (int argc, const char *argv[])
 
   gl.xml_fname = strdup (args[0]);
 
+  if (!gl.prev_image_fname != !gl.prev_manifest_fname)
+    vcd_error ("--previous-image and --previous-manifest go together"
+	       " -- try --help");
+
   poptFreeContext (optCon);
 
   return 0;
@@ -360,21 +428,37 @@ static VcdImageSink_t *
 _create_sink (void)
 {
   VcdImageSink_t *image_sink = NULL;
+  CdioList_t *sink_list = _cdio_list_new ();
   CdioListNode_t *node;
 
-  switch (gl.img_type)
-    {
-    case IMG_TYPE_BINCUE:
-      image_sink = vcd_image_sink_new_bincue ();
-      break;
+  if (gl.null_output_flag)
+    gl.img_types = 0;
+  else if (!gl.img_types)
+    gl.img_types = IMG_TYPE_BINCUE;
+
+  if (gl.img_types & IMG_TYPE_BINCUE)
+    _cdio_list_append (sink_list, vcd_image_sink_new_bincue ());
 
-    case IMG_TYPE_CDRDAO:
-      image_sink = vcd_image_sink_new_cdrdao ();
-      break;
+  if (gl.img_types & IMG_TYPE_CDRDAO)
+    _cdio_list_append (sink_list, vcd_image_sink_new_cdrdao ());
 
-    case IMG_TYPE_NRG:
-      image_sink = vcd_image_sink_new_nrg ();
-      break;
+  if (gl.img_types & IMG_TYPE_NRG)
+    _cdio_list_append (sink_list, vcd_image_sink_new_nrg ());
+
+  /* several image types are written in one pass */
+  if (_cdio_list_length (sink_list) > 1)
+    image_sink = vcd_image_sink_new_multi (sink_list);
+  else
+    {
+      if (_cdio_list_length (sink_list))
+        image_sink = _cdio_list_node_data (_cdio_list_begin (sink_list));
+      _cdio_list_free (sink_list, false, NULL);
+    }
+
+  if (gl.digest_flag || gl.null_output_flag)
+    {
+      image_sink = vcd_image_sink_new_digest (image_sink);
+      vcd_image_sink_set_arg (image_sink, "digest_format", "xml");
     }
 
   if (!image_sink)
@@ -392,6 +476,24 @@ _create_sink (void)
   return image_sink;
 }
 
+/* last value given for an image option */
+static const char *
+_get_img_opt (const char key[], const char default_val[])
+{
+  const char *retval = default_val;
+  CdioListNode_t *node;
+
+  _CDIO_LIST_FOREACH (node, gl.img_options)
+    {
+      struct key_val_t *_cons = _cdio_list_node_data (node);
+
+      if (!strcmp (_cons->key, key))
+	retval = _cons->val;
+    }
+
+  return retval;
+}
+
 int
 main (int argc, const char *argv[])
 {
@@ -419,6 +521,8 @@ main (int argc, const char *argv[])
   else
     vcd_xml_verbosity = VCD_LOG_INFO;
 
+  vcd_log_set_threshold (vcd_xml_verbosity);
+
   if (gl.gui_flag)
     vcd_xml_gui_mode = true;
 
@@ -470,6 +574,31 @@ main (int argc, const char *argv[])
 
     vcdxml.file_prefix = gl.file_prefix;
 
+    vcdxml.build.manifest_fname = gl.manifest_fname;
+    vcdxml.build.no_scan_index = gl.no_scan_index_flag;
+    vcdxml.build.jobs = gl.jobs > 1 ? gl.jobs : 1;
+    vcdxml.build.stats = gl.stats_flag;
+    vcd_stats_enabled = gl.stats_flag;
+    vcdxml.build.stats_json = gl.stats_json_flag;
+    vcdxml.build.sector_2336 = !strcmp (_get_img_opt ("sector", "2352"),
+					"2336");
+
+    if (gl.prev_image_fname)
+      {
+	/* the image is updated in place, which works for a single bin
+	   file only */
+	if (gl.img_types != IMG_TYPE_BINCUE || gl.digest_flag)
+	  vcd_warn ("--previous-image works with bincue images only"
+		    " -- doing a full build");
+	else
+	  {
+	    vcdxml.build.prev_image_fname = gl.prev_image_fname;
+	    vcdxml.build.prev_manifest_fname = gl.prev_manifest_fname;
+	    vcdxml.build.image_fname =
+	      _get_img_opt ("bin", DEFAULT_BIN_FILE);
+	  }
+      }
+
     create_time = time(NULL);
     if (gl.create_timestr != NULL) {
       if (!strcmp (gl.create_timestr, "TESTING"))
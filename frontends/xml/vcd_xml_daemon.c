@@ -0,0 +1,1527 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* vcdimagerd -- builds images on request, for as long as it runs.
+
+   Clients connect to a local UNIX socket and send one request: a JSON
+   object on a single line.  A build is described either by a videocd
+   XML file as vcdxbuild takes it,
+
+     {"xml-file": "/path/disc.xml", "bin-file": "/path/disc.bin",
+      "cue-file": "/path/disc.cue"}
+
+   or the XML itself ("xml"), or just a list of MPEG tracks as
+   vcdimager takes them,
+
+     {"type": "svcd", "tracks": ["/path/a.mpg", "/path/b.mpg"],
+      "volume-label": "HOLIDAYS", "bin-file": "/path/disc.bin",
+      "cue-file": "/path/disc.cue"}
+
+   "bin-file" and "cue-file" are required; jobs run side by side, there
+   is no name they could share as default.  Relative paths are relative
+   to the working directory of the daemon, or to "file-prefix" if
+   given.  Builds are queued and run on a fixed
+   pool of worker threads; the results of scanning MPEG streams are
+   kept in a cache shared by all of them, so a file used by several
+   jobs is scanned once as long as it doesn't change.
+
+   The daemon answers with one JSON object per line until the build is
+   done and closes the connection:
+
+     {"event": "queued", "job": 7, "position": 0}
+     {"event": "started", "job": 7}
+     {"event": "progress", "operation": "scan", "id": "seq-00", ...}
+     {"event": "log", "level": "warning", "message": "..."}
+     {"event": "progress", "operation": "write", "position": 750, ...}
+     {"event": "done", "result": "ok", "sectors": 9000, "seconds": 1.234}
+
+   {"command": "stats"} is answered with queue depth, job counts,
+   throughput and cache usage right away.
+
+   An error ends the build at the point it occurs, as it ends vcdxbuild;
+   what the job had allocated up to then is freed and its files are
+   closed as the worker thread ends.
+
+   On SIGINT or SIGTERM the daemon stops accepting connections, answers
+   the jobs still queued with an error and exits once the running
+   builds are done. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include <popt.h>
+
+/* We don't want to pull in cdio's config */
+#define __CDIO_CONFIG_H__
+#include <libxml/parserInternals.h>
+#include <libxml/parser.h>
+#include <libxml/valid.h>
+#include <libxml/xmlmemory.h>
+#include <libxml/xmlerror.h>
+
+#include <libvcd/logging.h>
+#include <libvcd/types.h>
+
+/* Private headers */
+#include "image_sink.h"
+#include "stats.h"
+#include "stream_stdio.h"
+#include "util.h"
+
+#include "vcdxml.h"
+#include "vcd_xml_parse.h"
+#include "vcd_xml_master.h"
+#include "vcd_xml_dtd.h"
+#include "vcd_xml_common.h"
+
+#define DEFAULT_SOCKET     "vcdimagerd.sock"
+#define DEFAULT_CACHE_SIZE 64
+#define DEFAULT_VOLUME_ID  "VIDEOCD"
+
+#define MAX_REQUEST_SIZE (16 * 1024 * 1024)
+#define REQUEST_TIMEOUT  10 /* seconds */
+
+/* a build request and its connection */
+typedef struct {
+  unsigned id;
+  int fd;
+  bool lost;     /* client went away */
+  bool done;     /* final event sent */
+  bool error;    /* ended by vcd_error () */
+  bool releasing; /* in _job_release () */
+
+  /* the request */
+  bool verbose;
+  char *xml_fname;
+  char *xml_text;
+  char *type;
+  CdioList_t *tracks; /* char * */
+  char *volume_label;
+  char *bin_fname;
+  char *cue_fname;
+  char *file_prefix;
+
+  /* the build, freed by _job_release () */
+  vcdxml_t *vcdxml;
+  xmlDocPtr doc;
+  vcd_xml_build_state_t state;
+
+  /* progress */
+  const char *scan_id;
+  long last_percent;
+  unsigned sectors;
+  double start;
+} _job_t;
+
+static struct {
+  const char *socket_fname;
+  int workers;
+  int cache_size;
+  int verbose_flag;
+  int quiet_flag;
+  int check_flag;
+} gl;
+
+/* the queue and the numbers reported by {"command": "stats"} */
+static struct {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  pthread_cond_t idle; /* signalled as reading or running goes down */
+  CdioList_t *queue; /* _job_t * */
+  bool closing;      /* shutting down, no more jobs are queued */
+  unsigned reading;  /* connections whose request is being read */
+  unsigned next_id;
+  unsigned running;
+  unsigned completed;
+  unsigned failed;
+  unsigned long sectors;
+  double build_seconds;
+  double start;
+} _pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+             PTHREAD_COND_INITIALIZER, };
+
+/****************************************************************************
+ * scan cache -- scanned streams by file identity, least recently used
+ * ones go first
+ */
+
+typedef struct _cache_entry {
+  char *key;
+  VcdMpegSource_t *source;
+  struct _cache_entry *prev;
+  struct _cache_entry *next;
+} _cache_entry_t;
+
+static struct {
+  pthread_mutex_t lock;
+  VcdHash_t *hash; /* key -> _cache_entry_t */
+  _cache_entry_t *head;
+  _cache_entry_t *tail;
+  unsigned count;
+  unsigned long hits;
+  unsigned long misses;
+} _cache = { PTHREAD_MUTEX_INITIALIZER, };
+
+static void
+_cache_unlink (_cache_entry_t *entry)
+{
+  if (entry->prev)
+    entry->prev->next = entry->next;
+  else
+    _cache.head = entry->next;
+
+  if (entry->next)
+    entry->next->prev = entry->prev;
+  else
+    _cache.tail = entry->prev;
+
+  entry->prev = entry->next = NULL;
+}
+
+static void
+_cache_push (_cache_entry_t *entry)
+{
+  entry->next = _cache.head;
+
+  if (_cache.head)
+    _cache.head->prev = entry;
+  else
+    _cache.tail = entry;
+
+  _cache.head = entry;
+}
+
+/* the file's identity, its size and time of last change, and how it is
+   scanned; NULL if the file can't be stat()ed */
+static char *
+_cache_key (const char fname[], bool strict_aps)
+{
+  struct stat st;
+  char buf[1024];
+
+  if (stat (fname, &st))
+    return NULL;
+
+  snprintf (buf, sizeof (buf), "%lu:%lu:%lld:%ld:%d:%s",
+            (unsigned long) st.st_dev, (unsigned long) st.st_ino,
+            (long long) st.st_size, (long) st.st_mtime, strict_aps, fname);
+
+  return strdup (buf);
+}
+
+static bool
+_cache_lookup (const char key[], VcdMpegSource_t *p_source)
+{
+  _cache_entry_t *entry;
+
+  pthread_mutex_lock (&_cache.lock);
+
+  if ((entry = _vcd_hash_lookup (_cache.hash, key)))
+    {
+      _cache_unlink (entry);
+      _cache_push (entry);
+
+      vcd_mpeg_source_copy_scan (p_source, entry->source);
+      _cache.hits++;
+    }
+  else
+    _cache.misses++;
+
+  pthread_mutex_unlock (&_cache.lock);
+
+  return entry != NULL;
+}
+
+static void
+_cache_insert (char *key, const char fname[], const VcdMpegSource_t *p_source)
+{
+  _cache_entry_t *entry = calloc (1, sizeof (_cache_entry_t));
+
+  entry->key = key;
+  entry->source = vcd_mpeg_source_new (vcd_data_source_new_stdio (fname));
+  vcd_mpeg_source_copy_scan (entry->source, p_source);
+
+  pthread_mutex_lock (&_cache.lock);
+
+  if (!_vcd_hash_insert (_cache.hash, key, entry))
+    {
+      /* scanned by another job meanwhile */
+      vcd_mpeg_source_destroy (entry->source, true);
+      free (entry->key);
+      free (entry);
+      entry = NULL;
+    }
+  else
+    {
+      _cache_push (entry);
+      _cache.count++;
+    }
+
+  while (_cache.count > (unsigned) gl.cache_size)
+    {
+      _cache_entry_t *victim = _cache.tail;
+
+      _cache_unlink (victim);
+      _vcd_hash_remove (_cache.hash, victim->key);
+      _cache.count--;
+
+      vcd_mpeg_source_destroy (victim->source, true);
+      free (victim->key);
+      free (victim);
+    }
+
+  pthread_mutex_unlock (&_cache.lock);
+}
+
+/****************************************************************************
+ * talking to clients
+ */
+
+static bool
+_send_line (int fd, const char format[], ...)
+{
+  char buf[4096];
+  size_t len, pos = 0;
+  va_list args;
+
+  va_start (args, format);
+  vsnprintf (buf, sizeof (buf) - 1, format, args);
+  va_end (args);
+
+  len = strlen (buf);
+  buf[len++] = '\n';
+
+  while (pos < len)
+    {
+      ssize_t n = write (fd, buf + pos, len - pos);
+
+      if (n < 0 && errno == EINTR)
+        continue;
+
+      if (n <= 0)
+        return false;
+
+      pos += n;
+    }
+
+  return true;
+}
+
+#define _job_send(job, ...) \
+  do { \
+    if (!(job)->lost && !_send_line ((job)->fd, __VA_ARGS__)) \
+      (job)->lost = true; \
+  } while (0)
+
+/* str as the contents of a JSON string; truncated to fit into buf */
+static const char *
+_json_escape (char buf[], size_t len, const char str[])
+{
+  size_t n = 0;
+
+  for (; *str && n + 7 < len; str++)
+    {
+      const unsigned char c = *str;
+
+      if (c == '"' || c == '\\')
+        {
+          buf[n++] = '\\';
+          buf[n++] = c;
+        }
+      else if (c == '\n')
+        {
+          buf[n++] = '\\';
+          buf[n++] = 'n';
+        }
+      else if (c < 0x20)
+        n += snprintf (buf + n, len - n, "\\u%.4x", c);
+      else
+        buf[n++] = c;
+    }
+
+  buf[n] = '\0';
+
+  return buf;
+}
+
+static void
+_send_stats (int fd)
+{
+  double uptime;
+  unsigned queued, running, completed, failed;
+  unsigned long sectors, hits, misses;
+  unsigned entries;
+
+  pthread_mutex_lock (&_pool.lock);
+  uptime = _vcd_stats_clock () - _pool.start;
+  queued = _cdio_list_length (_pool.queue);
+  running = _pool.running;
+  completed = _pool.completed;
+  failed = _pool.failed;
+  sectors = _pool.sectors;
+  pthread_mutex_unlock (&_pool.lock);
+
+  pthread_mutex_lock (&_cache.lock);
+  entries = _cache.count;
+  hits = _cache.hits;
+  misses = _cache.misses;
+  pthread_mutex_unlock (&_cache.lock);
+
+  _send_line (fd, "{\"event\": \"stats\", \"workers\": %d, \"queued\": %u,"
+              " \"running\": %u, \"completed\": %u, \"failed\": %u,"
+              " \"uptime\": %.3f, \"sectors\": %lu,"
+              " \"sectors_per_second\": %.1f, \"jobs_per_minute\": %.2f,"
+              " \"cache_entries\": %u, \"cache_size\": %d,"
+              " \"cache_hits\": %lu, \"cache_misses\": %lu}",
+              gl.workers, queued, running, completed, failed, uptime,
+              sectors, uptime > 0 ? sectors / uptime : 0.0,
+              uptime > 0 ? (completed + failed) * 60 / uptime : 0.0,
+              entries, gl.cache_size, hits, misses);
+}
+
+/****************************************************************************
+ * requests
+ */
+
+typedef struct {
+  const char *pos;
+  const char *error;
+} _json_t;
+
+static void
+_json_skip (_json_t *p)
+{
+  while (isspace ((unsigned char) *p->pos))
+    p->pos++;
+}
+
+static bool
+_json_expect (_json_t *p, char c)
+{
+  _json_skip (p);
+
+  if (*p->pos != c)
+    {
+      p->error = "malformed request";
+      return false;
+    }
+
+  p->pos++;
+  return true;
+}
+
+static void
+_json_put (char **s, size_t *n, size_t *cap, char c)
+{
+  if (*n + 1 >= *cap)
+    *s = realloc (*s, *cap *= 2);
+
+  (*s)[(*n)++] = c;
+}
+
+static char *
+_json_string (_json_t *p)
+{
+  size_t n = 0, cap = 64;
+  char *s;
+
+  if (!_json_expect (p, '"'))
+    return NULL;
+
+  s = malloc (cap);
+
+  for (;;)
+    {
+      unsigned v;
+      char c = *p->pos++;
+
+      if (!c || c == '\n')
+        {
+          p->error = "unterminated string";
+          free (s);
+          return NULL;
+        }
+
+      if (c == '"')
+        break;
+
+      if (c != '\\')
+        {
+          _json_put (&s, &n, &cap, c);
+          continue;
+        }
+
+      switch (c = *p->pos++)
+        {
+        case '"':
+        case '\\':
+        case '/':
+          break;
+        case 'b':
+          c = '\b';
+          break;
+        case 'f':
+          c = '\f';
+          break;
+        case 'n':
+          c = '\n';
+          break;
+        case 'r':
+          c = '\r';
+          break;
+        case 't':
+          c = '\t';
+          break;
+        case 'u':
+          if (!isxdigit ((unsigned char) p->pos[0])
+              || !isxdigit ((unsigned char) p->pos[1])
+              || !isxdigit ((unsigned char) p->pos[2])
+              || !isxdigit ((unsigned char) p->pos[3])
+              || sscanf (p->pos, "%4x", &v) != 1 || !v)
+            {
+              p->error = "invalid escape in string";
+              free (s);
+              return NULL;
+            }
+
+          p->pos += 4;
+
+          /* as UTF-8; surrogate pairs are not combined */
+          if (v < 0x80)
+            c = v;
+          else
+            {
+              if (v < 0x800)
+                _json_put (&s, &n, &cap, 0xc0 | (v >> 6));
+              else
+                {
+                  _json_put (&s, &n, &cap, 0xe0 | (v >> 12));
+                  _json_put (&s, &n, &cap, 0x80 | ((v >> 6) & 0x3f));
+                }
+
+              c = 0x80 | (v & 0x3f);
+            }
+          break;
+        default:
+          p->error = "invalid escape in string";
+          free (s);
+          return NULL;
+        }
+
+      _json_put (&s, &n, &cap, c);
+    }
+
+  s[n] = '\0';
+
+  return s;
+}
+
+static bool
+_json_bool (_json_t *p, bool *value)
+{
+  _json_skip (p);
+
+  if (!strncmp (p->pos, "true", 4))
+    *value = true;
+  else if (!strncmp (p->pos, "false", 5))
+    *value = false;
+  else
+    {
+      p->error = "true or false expected";
+      return false;
+    }
+
+  p->pos += *value ? 4 : 5;
+  return true;
+}
+
+static void
+_job_free (_job_t *job)
+{
+  free (job->xml_fname);
+  free (job->xml_text);
+  free (job->type);
+  free (job->volume_label);
+  free (job->bin_fname);
+  free (job->cue_fname);
+  free (job->file_prefix);
+  _cdio_list_free (job->tracks, true, NULL);
+  free (job);
+}
+
+/* parses request text into job; sets *p_stats for a stats request */
+static const char *
+_parse_request (const char text[], _job_t *job, bool *p_stats)
+{
+  static const struct {
+    const char *key;
+    size_t offset;
+  } _str_keys[] = {
+    { "xml-file", offsetof (_job_t, xml_fname) },
+    { "xml", offsetof (_job_t, xml_text) },
+    { "type", offsetof (_job_t, type) },
+    { "volume-label", offsetof (_job_t, volume_label) },
+    { "bin-file", offsetof (_job_t, bin_fname) },
+    { "cue-file", offsetof (_job_t, cue_fname) },
+    { "file-prefix", offsetof (_job_t, file_prefix) },
+    { NULL, 0 }
+  };
+
+  _json_t p = { text, NULL };
+  unsigned descriptions;
+
+  *p_stats = false;
+
+  if (!_json_expect (&p, '{'))
+    return p.error;
+
+  _json_skip (&p);
+
+  while (*p.pos != '}')
+    {
+      char *key;
+      int n;
+
+      if (!(key = _json_string (&p)) || !_json_expect (&p, ':'))
+        {
+          free (key);
+          return p.error;
+        }
+
+      for (n = 0; _str_keys[n].key; n++)
+        if (!strcmp (key, _str_keys[n].key))
+          break;
+
+      if (_str_keys[n].key)
+        {
+          char **field = (char **) ((char *) job + _str_keys[n].offset);
+
+          free (*field);
+          *field = _json_string (&p);
+        }
+      else if (!strcmp (key, "command"))
+        {
+          char *command = _json_string (&p);
+
+          if (command && !strcmp (command, "stats"))
+            *p_stats = true;
+          else if (command && strcmp (command, "build"))
+            p.error = "unknown command";
+
+          free (command);
+        }
+      else if (!strcmp (key, "tracks"))
+        {
+          if (_json_expect (&p, '['))
+            {
+              _json_skip (&p);
+
+              while (!p.error && *p.pos != ']')
+                {
+                  char *track = _json_string (&p);
+
+                  if (track)
+                    _cdio_list_append (job->tracks, track);
+
+                  _json_skip (&p);
+
+                  if (*p.pos == ',')
+                    p.pos++;
+                  else if (*p.pos != ']')
+                    p.error = "malformed request";
+                }
+
+              p.pos++;
+            }
+        }
+      else if (!strcmp (key, "verbose"))
+        _json_bool (&p, &job->verbose);
+      else
+        p.error = "unknown key in request";
+
+      free (key);
+
+      if (p.error)
+        return p.error;
+
+      _json_skip (&p);
+
+      if (*p.pos == ',')
+        p.pos++;
+      else if (*p.pos != '}')
+        return "malformed request";
+
+      _json_skip (&p);
+    }
+
+  p.pos++;
+  _json_skip (&p);
+
+  if (*p.pos)
+    return "trailing garbage after request";
+
+  if (*p_stats)
+    return NULL;
+
+  descriptions = !!job->xml_fname + !!job->xml_text
+    + !!_cdio_list_length (job->tracks);
+
+  if (descriptions != 1)
+    return "one of \"xml-file\", \"xml\" or \"tracks\" is required";
+
+  if (job->type && !_cdio_list_length (job->tracks))
+    return "\"type\" goes with \"tracks\" only";
+
+  if (!job->bin_fname || !job->cue_fname)
+    return "\"bin-file\" and \"cue-file\" are required";
+
+  return NULL;
+}
+
+/* reads a line (or everything until the client shuts down its side) */
+static char *
+_read_request (int fd)
+{
+  size_t len = 0, cap = 4096;
+  char *buf = malloc (cap);
+
+  for (;;)
+    {
+      ssize_t n;
+
+      if (len + 1 == cap)
+        {
+          if (cap >= MAX_REQUEST_SIZE)
+            break;
+
+          buf = realloc (buf, cap *= 2);
+        }
+
+      n = read (fd, buf + len, cap - len - 1);
+
+      if (n < 0 && errno == EINTR)
+        continue;
+
+      if (n <= 0)
+        break;
+
+      len += n;
+
+      if (memchr (buf + len - n, '\n', n))
+        break;
+    }
+
+  buf[len] = '\0';
+
+  if (!len)
+    {
+      free (buf);
+      return NULL;
+    }
+
+  return buf;
+}
+
+/****************************************************************************
+ * building
+ */
+
+static pthread_mutex_t _xml_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *
+_level_str (vcd_log_level_t level)
+{
+  switch (level)
+    {
+    case VCD_LOG_DEBUG:
+      return "debug";
+    case VCD_LOG_INFO:
+      return "information";
+    case VCD_LOG_WARN:
+      return "warning";
+    case VCD_LOG_ERROR:
+      return "error";
+    case VCD_LOG_ASSERT:
+      return "assertion";
+    }
+
+  return "unknown";
+}
+
+static void
+_job_log_handler (vcd_log_level_t level, const char message[],
+                  void *user_data)
+{
+  _job_t *job = user_data;
+  char buf[4096];
+
+  if (level >= VCD_LOG_INFO || job->verbose)
+    _job_send (job, "{\"event\": \"log\", \"level\": \"%s\","
+               " \"message\": \"%s\"}", _level_str (level),
+               _json_escape (buf, sizeof (buf), message));
+
+  switch (level)
+    {
+    case VCD_LOG_ASSERT:
+      /* a bug, not a bad request; the daemon can't go on */
+      fprintf (stderr, "job %u: assertion failed: %s\n", job->id, message);
+      abort ();
+      break;
+
+    case VCD_LOG_ERROR:
+      /* the library does not expect to return from here; the job
+         thread is ended and _worker_cleanup () takes over, unless
+         the error comes from there */
+      if (job->releasing)
+        break;
+
+      job->error = true;
+      pthread_exit (NULL);
+      break;
+
+    default:
+      break;
+    }
+}
+
+static int
+_scan_progress_cb (const vcd_mpeg_prog_info_t *info, void *user_data)
+{
+  _job_t *job = user_data;
+  const long percent = info->length
+    ? (long) ((double) info->current_pos / info->length * 100) : 100;
+  char buf[256];
+
+  if (percent != job->last_percent)
+    {
+      job->last_percent = percent;
+
+      _job_send (job, "{\"event\": \"progress\", \"operation\": \"scan\","
+                 " \"id\": \"%s\", \"position\": %ld, \"size\": %ld}",
+                 _json_escape (buf, sizeof (buf), job->scan_id),
+                 info->current_pos, info->length);
+    }
+
+  return 0;
+}
+
+static void
+_scan_cached (VcdMpegSource_t *p_source, const char fname[], bool strict_aps,
+              bool fix_scan_info, const char id[], void *user_data)
+{
+  _job_t *job = user_data;
+  char *key = gl.cache_size ? _cache_key (fname, strict_aps) : NULL;
+  char buf[256];
+
+  if (key && _cache_lookup (key, p_source))
+    {
+      _job_send (job, "{\"event\": \"progress\", \"operation\": \"scan\","
+                 " \"id\": \"%s\", \"cached\": true}",
+                 _json_escape (buf, sizeof (buf), id ? id : ""));
+      free (key);
+      return;
+    }
+
+  job->scan_id = id ? id : "";
+  job->last_percent = -1;
+
+  vcd_mpeg_source_scan (p_source, strict_aps, fix_scan_info,
+                        _scan_progress_cb, job);
+
+  if (key)
+    _cache_insert (key, fname, p_source);
+}
+
+static int
+_write_progress_cb (const progress_info_t *info, void *user_data)
+{
+  _job_t *job = user_data;
+  const long percent = info->total_sectors
+    ? (long) ((double) info->sectors_written / info->total_sectors * 100)
+    : 100;
+
+  job->sectors = info->total_sectors;
+
+  if (percent != job->last_percent)
+    {
+      job->last_percent = percent;
+
+      _job_send (job, "{\"event\": \"progress\", \"operation\": \"write\","
+                 " \"track\": %d, \"tracks\": %d,"
+                 " \"position\": %ld, \"size\": %ld}",
+                 info->in_track, info->total_tracks,
+                 info->sectors_written, info->total_sectors);
+    }
+
+  /* nobody is waiting for the image anymore */
+  return job->lost ? 1 : 0;
+}
+
+/* the validating parse of vcdxbuild, on a file or on the request's
+   text; libxml's entity loader hook is process-wide, hence the lock */
+static xmlDocPtr
+_parse_xml (const _job_t *job)
+{
+  xmlDocPtr doc = NULL;
+  xmlParserCtxtPtr ctxt;
+  int dtd_loaded;
+
+  pthread_mutex_lock (&_xml_lock);
+
+  dtd_loaded = vcd_xml_dtd_loaded;
+
+  if (job->xml_fname)
+    ctxt = xmlCreateFileParserCtxt (job->xml_fname);
+  else
+    ctxt = xmlCreateMemoryParserCtxt (job->xml_text, strlen (job->xml_text));
+
+  if (ctxt)
+    {
+      char *directory;
+
+      ctxt->pedantic = true;
+      ctxt->validate = true;
+
+      if (ctxt->sax)
+        {
+          ctxt->sax->error = ctxt->sax->fatalError = xmlParserError;
+          ctxt->sax->warning = xmlParserWarning;
+        }
+
+      ctxt->vctxt.error = xmlParserValidityError;
+      ctxt->vctxt.warning = xmlParserValidityWarning;
+      ctxt->vctxt.nodeMax = 0;
+
+      if (job->xml_fname && !ctxt->directory
+          && (directory = xmlParserGetDirectory (job->xml_fname)))
+        ctxt->directory = (char *) xmlStrdup ((xmlChar *) directory);
+
+      xmlParseDocument (ctxt);
+
+      if (ctxt->wellFormed && ctxt->valid && vcd_xml_dtd_loaded > dtd_loaded)
+        doc = ctxt->myDoc;
+      else
+        xmlFreeDoc (ctxt->myDoc);
+
+      ctxt->myDoc = NULL;
+      xmlFreeParserCtxt (ctxt);
+    }
+
+  pthread_mutex_unlock (&_xml_lock);
+
+  return doc;
+}
+
+static bool
+_describe_tracks (_job_t *job, vcdxml_t *p_vcdxml)
+{
+  static const struct {
+    const char *str;
+    vcd_type_t type;
+  } _types[] = {
+    { "vcd11", VCD_TYPE_VCD11 },
+    { "vcd2", VCD_TYPE_VCD2 },
+    { "vcd20", VCD_TYPE_VCD2 },
+    { "svcd", VCD_TYPE_SVCD },
+    { "hqvcd", VCD_TYPE_HQVCD },
+    { NULL, VCD_TYPE_INVALID }
+  };
+
+  CdioListNode_t *node;
+  unsigned n = 0;
+  int i;
+
+  for (i = 0; _types[i].str; i++)
+    if (!strcmp (job->type ? job->type : "vcd2", _types[i].str))
+      break;
+
+  if (!_types[i].str)
+    return false;
+
+  p_vcdxml->vcd_type = _types[i].type;
+  p_vcdxml->info.volume_count = 1;
+  p_vcdxml->info.volume_number = 1;
+  p_vcdxml->pvd.volume_id = strdup (job->volume_label
+                                    ? job->volume_label : DEFAULT_VOLUME_ID);
+
+  _CDIO_LIST_FOREACH (node, job->tracks)
+    {
+      struct sequence_t *p_sequence = calloc (1, sizeof (struct sequence_t));
+      char buf[32];
+
+      snprintf (buf, sizeof (buf), "sequence-%.2u", n++);
+
+      p_sequence->id = strdup (buf);
+      p_sequence->src = strdup (_cdio_list_node_data (node));
+      p_sequence->entry_point_list = _cdio_list_new ();
+      p_sequence->autopause_list = _cdio_list_new ();
+
+      _cdio_list_append (p_vcdxml->sequence_list, p_sequence);
+    }
+
+  return true;
+}
+
+static bool
+_run_job (_job_t *job)
+{
+  /* the date vcdxbuild --create-time TESTING takes */
+  time_t create_time = gl.check_flag ? 269236800L : time (NULL);
+  VcdImageSink_t *image_sink;
+  bool failed;
+
+  job->vcdxml = calloc (1, sizeof (vcdxml_t));
+  vcd_xml_init (job->vcdxml);
+
+  if (job->xml_fname || job->xml_text)
+    {
+      xmlNodePtr root;
+      xmlNsPtr ns;
+
+      if (!(job->doc = _parse_xml (job)))
+        vcd_error ("parsing XML description failed"
+                   " (or doctype declaration missing)");
+
+      if (!(root = xmlDocGetRootElement (job->doc)))
+        vcd_error ("XML document seems to be empty (no root node found)");
+
+      if (!(ns = xmlSearchNsByHref (job->doc, root,
+                                    (const xmlChar *) VIDEOCD_DTD_XMLNS)))
+        vcd_error ("Namespace not found in document");
+
+      if (vcd_xml_parse (job->vcdxml, job->doc, root, ns))
+        vcd_error ("parsing tree failed");
+
+      xmlFreeDoc (job->doc);
+      job->doc = NULL;
+    }
+  else if (!_describe_tracks (job, job->vcdxml))
+    vcd_error ("unknown type '%s'", job->type);
+
+  image_sink = vcd_image_sink_new_bincue ();
+  vcd_image_sink_set_arg (image_sink, "bin", job->bin_fname);
+  vcd_image_sink_set_arg (image_sink, "cue", job->cue_fname);
+
+  job->vcdxml->file_prefix = job->file_prefix;
+
+  job->vcdxml->build.scan_func = _scan_cached;
+  job->vcdxml->build.write_progress_cb = _write_progress_cb;
+  job->vcdxml->build.user_data = job;
+  job->vcdxml->build.state = &job->state;
+
+  job->last_percent = -1;
+
+  failed = vcd_xml_master (job->vcdxml, image_sink, &create_time);
+
+  return !failed && !job->lost;
+}
+
+/* frees the build of job, also what is left of it after vcd_error ()
+   ended it: the VcdObj_t with its sources and the image sink */
+static void
+_job_release (_job_t *job)
+{
+  job->releasing = true;
+
+  vcd_xml_master_cleanup (&job->state);
+
+  if (job->doc)
+    {
+      xmlFreeDoc (job->doc);
+      job->doc = NULL;
+    }
+
+  if (job->vcdxml)
+    {
+      /* not ours to free */
+      job->vcdxml->file_prefix = NULL;
+      vcd_xml_destroy (job->vcdxml);
+      free (job->vcdxml);
+      job->vcdxml = NULL;
+    }
+
+  job->releasing = false;
+}
+
+/****************************************************************************
+ * worker pool
+ */
+
+static void *_worker (void *arg);
+
+/* starts a detached thread; SIGINT and SIGTERM are left to the main
+   thread, their arrival has to interrupt its accept () */
+static int
+_spawn_thread (void *(*start) (void *), void *arg)
+{
+  pthread_t thread;
+  pthread_attr_t attr;
+  sigset_t set, old_set;
+  int rc;
+
+  sigemptyset (&set);
+  sigaddset (&set, SIGINT);
+  sigaddset (&set, SIGTERM);
+  pthread_sigmask (SIG_BLOCK, &set, &old_set);
+
+  pthread_attr_init (&attr);
+  pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+
+  rc = pthread_create (&thread, &attr, start, arg);
+
+  pthread_attr_destroy (&attr);
+  pthread_sigmask (SIG_SETMASK, &old_set, NULL);
+
+  return rc;
+}
+
+static void
+_start_worker (void)
+{
+  int rc;
+
+  if ((rc = _spawn_thread (_worker, NULL)))
+    vcd_error ("failed to create worker thread: %s", strerror (rc));
+}
+
+/* reports the end of the job in *arg, also when it ended by vcd_error () */
+static void
+_worker_cleanup (void *arg)
+{
+  _job_t *job = *(_job_t **) arg;
+  const bool ok = job->done;
+  double elapsed;
+
+  /* a failed build has its files closed before it is reported */
+  _job_release (job);
+
+  elapsed = _vcd_stats_clock () - job->start;
+
+  if (!job->done)
+    _job_send (job, "{\"event\": \"done\", \"job\": %u, \"result\": \"%s\","
+               " \"seconds\": %.3f}", job->id,
+               job->lost ? "aborted" : "error", elapsed);
+
+  close (job->fd);
+
+  vcd_log_set_thread_handler (NULL, NULL);
+
+  pthread_mutex_lock (&_pool.lock);
+  _pool.running--;
+  pthread_cond_broadcast (&_pool.idle);
+
+  if (ok)
+    {
+      _pool.completed++;
+      _pool.sectors += job->sectors;
+    }
+  else
+    _pool.failed++;
+
+  _pool.build_seconds += elapsed;
+  pthread_mutex_unlock (&_pool.lock);
+
+  /* this thread is about to end, keep the pool at full strength */
+  if (job->error)
+    _start_worker ();
+
+  _job_free (job);
+}
+
+static void *
+_worker (void *arg)
+{
+  for (;;)
+    {
+      _job_t *job;
+
+      pthread_mutex_lock (&_pool.lock);
+
+      while (!_cdio_list_length (_pool.queue))
+        pthread_cond_wait (&_pool.cond, &_pool.lock);
+
+      job = _cdio_list_node_data (_cdio_list_begin (_pool.queue));
+      _cdio_list_node_free (_cdio_list_begin (_pool.queue), false, NULL);
+
+      _pool.running++;
+      pthread_mutex_unlock (&_pool.lock);
+
+      pthread_cleanup_push (_worker_cleanup, &job);
+
+      job->start = _vcd_stats_clock ();
+      _job_send (job, "{\"event\": \"started\", \"job\": %u}", job->id);
+
+      vcd_log_set_thread_handler (_job_log_handler, job);
+
+      if (_run_job (job))
+        {
+          job->done = true;
+          _job_send (job, "{\"event\": \"done\", \"job\": %u,"
+                     " \"result\": \"ok\", \"sectors\": %u,"
+                     " \"seconds\": %.3f}", job->id, job->sectors,
+                     _vcd_stats_clock () - job->start);
+        }
+
+      pthread_cleanup_pop (1);
+    }
+
+  return arg;
+}
+
+/****************************************************************************
+ * main
+ */
+
+static volatile sig_atomic_t _quit = 0;
+
+static void
+_quit_handler (int signum)
+{
+  _quit = signum;
+}
+
+/* reads the request on connection fd and queues its job */
+static void
+_serve (int fd)
+{
+  _job_t *job = calloc (1, sizeof (_job_t));
+  struct timeval timeout = { REQUEST_TIMEOUT, 0 };
+  const char *error;
+  char *request;
+  bool stats;
+
+  job->fd = fd;
+  job->tracks = _cdio_list_new ();
+
+  /* a client that doesn't send its request holds only this thread */
+  setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+
+  if (!(request = _read_request (fd)))
+    error = "empty request";
+  else
+    error = _parse_request (request, job, &stats);
+
+  free (request);
+
+  if (error)
+    {
+      char buf[256];
+
+      _send_line (fd, "{\"event\": \"done\", \"result\": \"error\","
+                  " \"message\": \"%s\"}",
+                  _json_escape (buf, sizeof (buf), error));
+      close (fd);
+      _job_free (job);
+      return;
+    }
+
+  if (stats)
+    {
+      _send_stats (fd);
+      close (fd);
+      _job_free (job);
+      return;
+    }
+
+  pthread_mutex_lock (&_pool.lock);
+
+  if (_pool.closing)
+    {
+      pthread_mutex_unlock (&_pool.lock);
+      _send_line (fd, "{\"event\": \"done\", \"result\": \"error\","
+                  " \"message\": \"daemon shutting down\"}");
+      close (fd);
+      _job_free (job);
+      return;
+    }
+
+  job->id = ++_pool.next_id;
+  _job_send (job, "{\"event\": \"queued\", \"job\": %u, \"position\": %u}",
+             job->id, _cdio_list_length (_pool.queue));
+  _cdio_list_append (_pool.queue, job);
+  pthread_cond_signal (&_pool.cond);
+  pthread_mutex_unlock (&_pool.lock);
+}
+
+static void *
+_serve_thread (void *arg)
+{
+  _serve ((intptr_t) arg);
+
+  pthread_mutex_lock (&_pool.lock);
+  _pool.reading--;
+  pthread_cond_broadcast (&_pool.idle);
+  pthread_mutex_unlock (&_pool.lock);
+
+  return NULL;
+}
+
+/* refuses the queued jobs and waits for the running ones; returns the
+   number of jobs refused */
+static unsigned
+_drain (void)
+{
+  unsigned refused = 0;
+
+  pthread_mutex_lock (&_pool.lock);
+
+  _pool.closing = true;
+
+  while (_pool.reading || _cdio_list_length (_pool.queue) || _pool.running)
+    {
+      _job_t *job;
+
+      if (!_cdio_list_length (_pool.queue))
+        {
+          pthread_cond_wait (&_pool.idle, &_pool.lock);
+          continue;
+        }
+
+      job = _cdio_list_node_data (_cdio_list_begin (_pool.queue));
+      _cdio_list_node_free (_cdio_list_begin (_pool.queue), false, NULL);
+
+      _pool.failed++;
+      refused++;
+
+      _job_send (job, "{\"event\": \"done\", \"job\": %u,"
+                 " \"result\": \"error\","
+                 " \"message\": \"daemon shutting down\"}", job->id);
+      close (job->fd);
+      _job_free (job);
+    }
+
+  pthread_mutex_unlock (&_pool.lock);
+
+  return refused;
+}
+
+static int
+_listen (const char fname[])
+{
+  struct sockaddr_un addr;
+  struct stat st;
+  int fd;
+
+  if (strlen (fname) >= sizeof (addr.sun_path))
+    vcd_error ("socket path `%s' too long", fname);
+
+  /* left over from an earlier run */
+  if (!lstat (fname, &st) && S_ISSOCK (st.st_mode))
+    unlink (fname);
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, fname);
+
+  if ((fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0
+      || bind (fd, (struct sockaddr *) &addr, sizeof (addr))
+      || listen (fd, 64))
+    vcd_error ("can't listen on `%s': %s", fname, strerror (errno));
+
+  return fd;
+}
+
+int
+main (int argc, const char *argv[])
+{
+  struct sigaction sa;
+  poptContext optCon;
+  int opt, listen_fd, n;
+  unsigned refused;
+
+  enum {
+    CL_VERSION = 1
+  };
+
+  struct poptOption optionsTable[] = {
+    {"socket", 's', POPT_ARG_STRING, &gl.socket_fname, 0,
+     "listen on UNIX socket FILE (default: '" DEFAULT_SOCKET "')", "FILE"},
+
+    {"workers", 'j', POPT_ARG_INT, &gl.workers, 0,
+     "number of builds to run at once (default: number of processors)",
+     "N"},
+
+    {"cache-size", '\0', POPT_ARG_INT, &gl.cache_size, 0,
+     "number of scanned MPEG streams to keep, 0 disables the cache", "N"},
+
+    {"verbose", 'v', POPT_ARG_NONE, &gl.verbose_flag, 0,
+     "be verbose"},
+
+    {"quiet", 'q', POPT_ARG_NONE, &gl.quiet_flag, 0,
+     "show only critical messages"},
+
+    {"check", '\0', POPT_ARG_NONE | POPT_ARGFLAG_DOC_HIDDEN,
+     &gl.check_flag, 0, "enable check mode (undocumented)"},
+
+    {"version", 'V', POPT_ARG_NONE, NULL, CL_VERSION,
+     "display version and copyright information and exit"},
+
+    POPT_AUTOHELP
+
+    {NULL, 0, 0, NULL, 0}
+  };
+
+  vcd_xml_progname = "vcdimagerd";
+
+  vcd_xml_log_init ();
+
+  gl.socket_fname = DEFAULT_SOCKET;
+  gl.workers = 0;
+  gl.cache_size = DEFAULT_CACHE_SIZE;
+
+  optCon = poptGetContext ("vcdimagerd", argc, argv, optionsTable, 0);
+
+  if (poptReadDefaultConfig (optCon, 0))
+    fprintf (stderr, "warning, reading popt configuration failed\n");
+
+  while ((opt = poptGetNextOpt (optCon)) != -1)
+    switch (opt)
+      {
+      case CL_VERSION:
+        vcd_xml_print_version ();
+        exit (EXIT_SUCCESS);
+        break;
+
+      default:
+        vcd_error ("error while parsing command line - try --help");
+        break;
+      }
+
+  if (poptGetArgs (optCon))
+    vcd_error ("no arguments expected -- try --help");
+
+  poptFreeContext (optCon);
+
+  if (gl.verbose_flag && gl.quiet_flag)
+    vcd_error ("I can't be both, quiet and verbose... either one or another ;-)");
+
+  if (gl.quiet_flag)
+    vcd_xml_verbosity = VCD_LOG_WARN;
+  else if (gl.verbose_flag)
+    vcd_xml_verbosity = VCD_LOG_DEBUG;
+  else
+    vcd_xml_verbosity = VCD_LOG_INFO;
+
+  /* the daemon's own messages go to stdout; clients may ask for debug
+     messages of their job */
+  vcd_loglevel_default = vcd_xml_verbosity;
+  vcd_log_set_threshold (VCD_LOG_DEBUG);
+
+  if (gl.cache_size < 0)
+    vcd_error ("cache size must not be negative");
+
+  if (gl.check_flag)
+    vcd_xml_check_mode = true;
+
+#ifdef _SC_NPROCESSORS_ONLN
+  if (gl.workers <= 0)
+    gl.workers = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+
+  if (gl.workers <= 0)
+    gl.workers = 1;
+
+  xmlInitParser ();
+  xmlKeepBlanksDefaultValue = false;
+  vcd_xml_dtd_init ();
+
+  _pool.queue = _cdio_list_new ();
+  _pool.start = _vcd_stats_clock ();
+  _cache.hash = _vcd_hash_new ();
+
+  memset (&sa, 0, sizeof (sa));
+  sa.sa_handler = SIG_IGN;
+  sigaction (SIGPIPE, &sa, NULL);
+
+  /* no SA_RESTART: accept () has to return */
+  sa.sa_handler = _quit_handler;
+  sigaction (SIGINT, &sa, NULL);
+  sigaction (SIGTERM, &sa, NULL);
+
+  listen_fd = _listen (gl.socket_fname);
+
+  for (n = 0; n < gl.workers; n++)
+    _start_worker ();
+
+  vcd_info ("listening on `%s' with %d workers", gl.socket_fname,
+            gl.workers);
+
+  while (!_quit)
+    {
+      int fd = accept (listen_fd, NULL, NULL);
+
+      if (fd < 0)
+        {
+          if (errno != EINTR && errno != ECONNABORTED)
+            vcd_warn ("accept () failed: %s", strerror (errno));
+          continue;
+        }
+
+      pthread_mutex_lock (&_pool.lock);
+      _pool.reading++;
+      pthread_mutex_unlock (&_pool.lock);
+
+      if ((n = _spawn_thread (_serve_thread, (void *) (intptr_t) fd)))
+        {
+          vcd_warn ("failed to create thread for connection: %s",
+                    strerror (n));
+          close (fd);
+
+          pthread_mutex_lock (&_pool.lock);
+          _pool.reading--;
+          pthread_mutex_unlock (&_pool.lock);
+        }
+    }
+
+  vcd_info ("signal %d received, shutting down", (int) _quit);
+
+  close (listen_fd);
+  unlink (gl.socket_fname);
+
+  if ((refused = _drain ()))
+    {
+      vcd_warn ("%u queued jobs not built", refused);
+      return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
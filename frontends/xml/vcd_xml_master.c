@@ -16,6 +16,11 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
+/* copy_file_range () is a GNU extension */
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+
 /* Private headers */
 #include "image_sink.h"
 #include "stream_stdio.h"
@@ -35,28 +40,338 @@
 #include <stdlib.h>
 #endif
 #include <stdio.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_LINUX_FS_H
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
 
 /* important date to celebrate (for me at least =)
    -- until user customization is implemented... */
 static const time_t _vcd_time = 269222400L;
 
+static char *
+mk_path (const char prefix[], const char pathname[])
+{
+  char *retval;
+
+  vcd_assert (pathname != 0);
+
+  if (!prefix)
+    return strdup (pathname);
+
+  retval = calloc(1, strlen (prefix) + strlen (pathname) + 1);
+  strcpy (retval, prefix);
+  strcat (retval, pathname);
+
+  return retval;
+}
+
 static VcdDataSource_t *
 mk_dsource (const char prefix[], const char pathname[])
 {
-  vcd_assert (pathname != 0);
+  char *tmp = mk_path (prefix, pathname);
+  VcdDataSource_t *retval = vcd_data_source_new_stdio (tmp);
+
+  free (tmp);
+  return retval;
+}
+
+/* scans the stream of item id from file src, through the scan hook of
+   the build if there is one */
+static VcdMpegSource_t *
+_scan_source (const vcdxml_t *p_vcdxml, const char src[], const char id[],
+	      bool strict_aps, bool fix_scan_info)
+{
+  char *fname = mk_path (p_vcdxml->file_prefix, src);
+  VcdDataSource_t *data_source = vcd_data_source_new_stdio (fname);
+  VcdMpegSource_t *mpeg_src;
+
+  vcd_assert (data_source != NULL);
+
+  mpeg_src = vcd_mpeg_source_new (data_source);
+
+  if (p_vcdxml->build.state)
+    p_vcdxml->build.state->mpeg_source = mpeg_src;
+
+  /* vcdxrip --scan-index may have left the scan next to the file */
+  if (!p_vcdxml->build.no_scan_index)
+    vcd_mpeg_source_set_index (mpeg_src, fname);
+
+  if (p_vcdxml->build.scan_func)
+    p_vcdxml->build.scan_func (mpeg_src, fname, strict_aps, fix_scan_info,
+			       id, p_vcdxml->build.user_data);
+  else
+    vcd_mpeg_source_scan (mpeg_src, strict_aps, fix_scan_info,
+			  vcd_xml_show_progress
+			  ? vcd_xml_scan_progress_cb : NULL, (void *) id);
+
+  free (fname);
+
+  return mpeg_src;
+}
+
+static char *
+_strcat_printf (char *str, const char format[], ...)
+{
+  char buf[1024] = { 0, };
+  size_t len = str ? strlen (str) : 0;
+  va_list args;
+
+  va_start (args, format);
+  vsnprintf (buf, sizeof (buf), format, args);
+  va_end (args);
+
+  str = realloc (str, len + strlen (buf) + 1);
+  strcpy (str + len, buf);
+
+  return str;
+}
+
+/* describes everything the sectors of tracks 2 and up are made of --
+   if two builds have the same manifest, only the ISO9660 track
+   differs between their images */
+static char *
+_build_manifest (const vcdxml_t *p_vcdxml, VcdObj_t *p_vcd)
+{
+  char *retval = NULL;
+  CdioListNode_t *node;
+  unsigned track_no = 1;
+  char *_layout;
+
+  retval = _strcat_printf (retval, "# vcdxbuild manifest 2\n");
+  retval = _strcat_printf (retval, "sector %u\n",
+                           p_vcdxml->build.sector_2336 ? 2336 : 2352);
 
-  if (prefix)
+  if (!(_layout = vcd_obj_get_track_layout (p_vcd, track_no)))
+    goto err;
+
+  retval = _strcat_printf (retval, "track %u %s\n", track_no, _layout);
+  free (_layout);
+
+  _CDIO_LIST_FOREACH (node, p_vcdxml->sequence_list)
+    {
+      struct sequence_t *sequence = _cdio_list_node_data (node);
+      struct stat statbuf;
+      unsigned long mtime_nsec = 0;
+
+      track_no++;
+
+      if (!(_layout = vcd_obj_get_track_layout (p_vcd, track_no)))
+        goto err;
+
+      retval = _strcat_printf (retval, "track %u %s\n", track_no, _layout);
+      free (_layout);
+
+      {
+        char *_path =
+          _strcat_printf (p_vcdxml->file_prefix
+                          ? strdup (p_vcdxml->file_prefix) : NULL,
+                          "%s", sequence->src);
+
+        if (stat (_path, &statbuf) == -1)
+          {
+            vcd_warn ("could not stat() file `%s': %s", _path,
+                      strerror (errno));
+            free (_path);
+            goto err;
+          }
+
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+        mtime_nsec = statbuf.st_mtim.tv_nsec;
+#endif
+
+        /* a file replaced by another one of the same size within the
+           same second still differs in inode or nanoseconds */
+        retval = _strcat_printf (retval, "source %u size=%lu mtime=%lu.%09lu"
+                                 " dev=%lu ino=%lu %s\n",
+                                 track_no, (unsigned long) statbuf.st_size,
+                                 (unsigned long) statbuf.st_mtime, mtime_nsec,
+                                 (unsigned long) statbuf.st_dev,
+                                 (unsigned long) statbuf.st_ino, _path);
+        free (_path);
+      }
+    }
+
+  return retval;
+
+ err:
+  free (retval);
+  return NULL;
+}
+
+static char *
+_read_manifest (const char fname[])
+{
+  char *retval = NULL;
+  char buf[1024];
+  FILE *fd;
+
+  if (!(fd = fopen (fname, "r")))
     {
-      VcdDataSource_t *retval = 0;
-      char *tmp = calloc(1, strlen (prefix) + strlen (pathname) + 1);
-      strcpy (tmp, prefix);
-      strcat (tmp, pathname);
-      retval = vcd_data_source_new_stdio (tmp);
-      free (tmp);
-      return retval;
+      vcd_warn ("could not open manifest `%s': %s", fname, strerror (errno));
+      return NULL;
     }
 
-  return vcd_data_source_new_stdio (pathname);
+  while (fgets (buf, sizeof (buf), fd))
+    retval = _strcat_printf (retval, "%s", buf);
+
+  fclose (fd);
+
+  return retval;
+}
+
+static bool
+_write_manifest (const char fname[], const char manifest[])
+{
+  VcdDataSink *snk;
+
+  if (!(snk = vcd_data_sink_new_stdio (fname)))
+    {
+      vcd_warn ("failed to create manifest `%s'", fname);
+      return true;
+    }
+
+  vcd_data_sink_printf (snk, "%s", manifest);
+  vcd_data_sink_close (snk);
+  vcd_data_sink_destroy (snk);
+
+  return false;
+}
+
+/* copies the previous image to where the new one is going to be
+   written; a reflink or in-kernel copy avoids moving the MPEG tracks
+   through user space, where the filesystem supports it */
+static bool
+_copy_image (const char src_fname[], const char dst_fname[])
+{
+  int src_fd, dst_fd;
+  struct stat statbuf;
+  bool retval = true;
+
+  if ((src_fd = open (src_fname, O_RDONLY)) == -1)
+    {
+      vcd_warn ("could not open `%s': %s", src_fname, strerror (errno));
+      return true;
+    }
+
+  if (fstat (src_fd, &statbuf) == -1
+      || (dst_fd = open (dst_fname, O_WRONLY | O_CREAT | O_TRUNC,
+                         0666)) == -1)
+    {
+      vcd_warn ("could not create `%s': %s", dst_fname, strerror (errno));
+      close (src_fd);
+      return true;
+    }
+
+#ifdef HAVE_LINUX_FS_H
+  if (!ioctl (dst_fd, FICLONE, src_fd))
+    {
+      vcd_debug ("cloned `%s' to `%s'", src_fname, dst_fname);
+      retval = false;
+      goto out;
+    }
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+  {
+    off_t left = statbuf.st_size;
+
+    while (left > 0)
+      {
+        ssize_t n = copy_file_range (src_fd, NULL, dst_fd, NULL, left, 0);
+
+        if (n <= 0)
+          break;
+
+        left -= n;
+      }
+
+    if (!left)
+      {
+        retval = false;
+        goto out;
+      }
+
+    /* start over the slow way */
+    if (lseek (src_fd, 0, SEEK_SET) == -1
+        || lseek (dst_fd, 0, SEEK_SET) == -1
+        || ftruncate (dst_fd, 0) == -1)
+      goto out;
+  }
+#endif
+
+  {
+    char buf[64 * 1024];
+    ssize_t n;
+
+    while ((n = read (src_fd, buf, sizeof (buf))) > 0)
+      if (write (dst_fd, buf, n) != n)
+        break;
+
+    retval = n != 0;
+  }
+
+#if defined(HAVE_LINUX_FS_H) || defined(HAVE_COPY_FILE_RANGE)
+ out:
+#endif
+  if (retval)
+    vcd_warn ("copying `%s' to `%s' failed: %s", src_fname, dst_fname,
+              strerror (errno));
+
+  close (src_fd);
+  if (close (dst_fd) == -1)
+    retval = true;
+
+  return retval;
+}
+
+/* returns true if the previous image can be reused; it has been copied
+   to the new image's place then, if necessary */
+static bool
+_reuse_image (const vcdxml_t *p_vcdxml, const char manifest[])
+{
+  char *_prev_manifest;
+  bool _same;
+
+  if (!p_vcdxml->build.prev_image_fname)
+    return false;
+
+  vcd_assert (p_vcdxml->build.prev_manifest_fname != NULL);
+  vcd_assert (p_vcdxml->build.image_fname != NULL);
+
+  if (!manifest
+      || !(_prev_manifest =
+           _read_manifest (p_vcdxml->build.prev_manifest_fname)))
+    {
+      vcd_warn ("doing a full build");
+      return false;
+    }
+
+  _same = !strcmp (manifest, _prev_manifest);
+  free (_prev_manifest);
+
+  if (!_same)
+    {
+      vcd_info ("MPEG tracks have changed since `%s' -- doing a full build",
+                p_vcdxml->build.prev_manifest_fname);
+      return false;
+    }
+
+  if (strcmp (p_vcdxml->build.prev_image_fname, p_vcdxml->build.image_fname)
+      && _copy_image (p_vcdxml->build.prev_image_fname,
+                      p_vcdxml->build.image_fname))
+    {
+      vcd_warn ("doing a full build");
+      return false;
+    }
+
+  return true;
 }
 
 bool
@@ -73,6 +388,12 @@ vcd_xml_master (const vcdxml_t *p_vcdxml, VcdImageSink_t *p_image_sink,
 
   _vcd = vcd_obj_new (p_vcdxml->vcd_type);
 
+  if (p_vcdxml->build.state)
+    {
+      p_vcdxml->build.state->obj = _vcd;
+      p_vcdxml->build.state->image_sink = p_image_sink;
+    }
+
   if (vcd_xml_check_mode)
     vcd_obj_set_param_str (_vcd, VCD_PARM_PREPARER_ID,
 			   "GNU VCDIMAGER CHECK MODE");
@@ -232,24 +553,19 @@ vcd_xml_master (const vcdxml_t *p_vcdxml, VcdImageSink_t *p_image_sink,
   _CDIO_LIST_FOREACH (node, p_vcdxml->segment_list)
     {
       struct segment_t *p_segment = _cdio_list_node_data (node);
-      VcdDataSource_t *_source = mk_dsource (p_vcdxml->file_prefix,
-					   p_segment->src);
       CdioListNode_t *p_node2;
       VcdMpegSource_t *_mpeg_src;
 
       vcd_debug ("adding segment #%d, %s", idx, p_segment->src);
 
-      vcd_assert (_source != NULL);
-
-      _mpeg_src = vcd_mpeg_source_new (_source);
-
-      vcd_mpeg_source_scan (_mpeg_src, !_relaxed_aps, _update_scan_offsets,
-			    vcd_xml_show_progress
-			    ? vcd_xml_scan_progress_cb : NULL,
-			    p_segment->id);
+      _mpeg_src = _scan_source (p_vcdxml, p_segment->src, p_segment->id,
+				!_relaxed_aps, _update_scan_offsets);
 
       vcd_obj_append_segment_play_item (_vcd, _mpeg_src, p_segment->id);
 
+      if (p_vcdxml->build.state)
+	p_vcdxml->build.state->mpeg_source = NULL;
+
       _CDIO_LIST_FOREACH (p_node2, p_segment->autopause_list)
 	{
 	  double *_ap_ts = _cdio_list_node_data (p_node2);
@@ -266,25 +582,20 @@ vcd_xml_master (const vcdxml_t *p_vcdxml, VcdImageSink_t *p_image_sink,
   _CDIO_LIST_FOREACH (node, p_vcdxml->sequence_list)
     {
       struct sequence_t *sequence = _cdio_list_node_data (node);
-      VcdDataSource_t *data_source;
       CdioListNode_t *node2;
       VcdMpegSource_t *_mpeg_src;
 
       vcd_debug ("adding sequence #%d, %s", idx, sequence->src);
 
-      data_source = mk_dsource (p_vcdxml->file_prefix, sequence->src);
-      vcd_assert (data_source != NULL);
-
-      _mpeg_src = vcd_mpeg_source_new (data_source);
-
-      vcd_mpeg_source_scan (_mpeg_src, !_relaxed_aps, _update_scan_offsets,
-			    (vcd_xml_show_progress)
-			    ? vcd_xml_scan_progress_cb : NULL,
-			    sequence->id);
+      _mpeg_src = _scan_source (p_vcdxml, sequence->src, sequence->id,
+				!_relaxed_aps, _update_scan_offsets);
 
       vcd_obj_append_sequence_play_item (_vcd, _mpeg_src, sequence->id,
 					 sequence->default_entry_id);
 
+      if (p_vcdxml->build.state)
+	p_vcdxml->build.state->mpeg_source = NULL;
+
       _CDIO_LIST_FOREACH (node2, sequence->entry_point_list)
 	{
 	  struct entry_point_t *entry = _cdio_list_node_data (node2);
@@ -308,15 +619,76 @@ vcd_xml_master (const vcdxml_t *p_vcdxml, VcdImageSink_t *p_image_sink,
   {
     unsigned sectors;
     char *_tmp;
+    char *_manifest = NULL;
+    int _write_failed;
+
+    if (p_vcdxml->build.jobs > 1)
+      vcd_obj_set_param_uint (_vcd, VCD_PARM_OUTPUT_JOBS,
+			      p_vcdxml->build.jobs);
 
     sectors = vcd_obj_begin_output (_vcd);
 
-    vcd_obj_write_image (_vcd, p_image_sink, vcd_xml_show_progress
-			 ? vcd_xml_write_progress_cb : NULL,
-			 NULL, &_vcd_time);
+    if (p_vcdxml->build.manifest_fname || p_vcdxml->build.prev_image_fname)
+      _manifest = _build_manifest (p_vcdxml, _vcd);
+
+    if (_reuse_image (p_vcdxml, _manifest))
+      {
+	vcd_info ("reusing MPEG tracks of `%s', rewriting the ISO9660 track only",
+		  p_vcdxml->build.prev_image_fname);
+
+	vcd_image_sink_set_arg (p_image_sink, "update", "true");
+	vcd_obj_set_param_bool (_vcd, VCD_PARM_ISO_TRACK_ONLY, true);
+      }
+
+    /* vcd_obj_write_image () takes it over */
+    if (p_vcdxml->build.state)
+      p_vcdxml->build.state->image_sink = NULL;
+
+    if (p_vcdxml->build.write_progress_cb)
+      _write_failed = vcd_obj_write_image (_vcd, p_image_sink,
+					   p_vcdxml->build.write_progress_cb,
+					   p_vcdxml->build.user_data,
+					   &_vcd_time);
+    else
+      _write_failed = vcd_obj_write_image (_vcd, p_image_sink,
+					   vcd_xml_show_progress
+					   ? vcd_xml_write_progress_cb : NULL,
+					   NULL, &_vcd_time);
+
+    if (_write_failed)
+      {
+	vcd_obj_end_output (_vcd);
+	vcd_obj_destroy (_vcd);
+	if (p_vcdxml->build.state)
+	  p_vcdxml->build.state->obj = NULL;
+	free (_manifest);
+	return true;
+      }
 
     vcd_obj_end_output (_vcd);
 
+    if (p_vcdxml->build.manifest_fname)
+      {
+	if (!_manifest)
+	  vcd_warn ("no manifest written");
+	else
+	  _write_manifest (p_vcdxml->build.manifest_fname, _manifest);
+      }
+
+    free (_manifest);
+
+    if (p_vcdxml->build.stats)
+      {
+	VcdStats_t _stats;
+	char *_str;
+
+	vcd_obj_get_stats (_vcd, &_stats);
+
+	fputs (_str = vcd_stats_format (&_stats, p_vcdxml->build.stats_json),
+	       stdout);
+	free (_str);
+      }
+
     vcd_info ("finished ok, image created with %d sectors [%s]",
 	      sectors, _tmp = cdio_lba_to_msf_str (sectors));
 
@@ -325,5 +697,26 @@ vcd_xml_master (const vcdxml_t *p_vcdxml, VcdImageSink_t *p_image_sink,
 
   vcd_obj_destroy (_vcd);
 
+  if (p_vcdxml->build.state)
+    p_vcdxml->build.state->obj = NULL;
+
   return false;
 }
+
+void
+vcd_xml_master_cleanup (vcd_xml_build_state_t *p_state)
+{
+  vcd_assert (p_state != NULL);
+
+  /* ends the output too, closing the sources and the sink */
+  if (p_state->obj)
+    vcd_obj_destroy (p_state->obj);
+
+  if (p_state->mpeg_source)
+    vcd_mpeg_source_destroy (p_state->mpeg_source, true);
+
+  if (p_state->image_sink)
+    vcd_image_sink_destroy (p_state->image_sink);
+
+  memset (p_state, 0, sizeof (vcd_xml_build_state_t));
+}
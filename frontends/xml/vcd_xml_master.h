@@ -27,6 +27,9 @@
 bool vcd_xml_master (const vcdxml_t *p_vcdxml, 
 		     VcdImageSink_t *p_image_sink, time_t *p_create_time);
 
+/* frees what a build left in p_state when vcd_error () ended it */
+void vcd_xml_master_cleanup (vcd_xml_build_state_t *p_state);
+
 #endif /* __VCD_XML_MASTER_H__ */
 
 
@@ -18,6 +18,7 @@
 */
 
 /* Private headers */
+#include "stream_stdio.h"
 #include "vcd_read.h"
 #include "vcdxml.h"
 #include "vcd_xml_dtd.h"
@@ -59,10 +60,21 @@
 #include <unistd.h>
 #endif
 
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
 #include <popt.h>
 
+/* sectors read with one call; devices get the conservative default */
+#define DEFAULT_READ_BATCH_IMAGE  256
+#define DEFAULT_READ_BATCH_DEVICE 15
+
 static int _verbose_flag = 0;
 static int _quiet_flag = 0;
+static int _read_batch = 0;
+static int _jobs = 1;
+static int _scan_index_flag = 0;
 
 static void
 _register_file (vcdxml_t *p_vcdxml, const char *pathname,
@@ -192,14 +204,14 @@ _parse_isofs (vcdxml_t *p_vcdxml, CdIo_t *p_cdio)
 }
 
 static int
-_parse_pvd (vcdxml_t *p_vcdxml, CdIo_t *p_cdio)
+_parse_pvd (vcdxml_t *p_vcdxml, const vcdinfo_obj_t *p_vcdinfo)
 {
   iso9660_pvd_t pvd;
 
   memset (&pvd, 0, sizeof (iso9660_pvd_t));
   vcd_assert (sizeof (iso9660_pvd_t) == ISO_BLOCKSIZE);
 
-  if (!iso9660_fs_read_pvd(p_cdio, &pvd)) {
+  if (!read_pvd(p_vcdinfo, &pvd)) {
     return -1;
   }
 
@@ -213,14 +225,14 @@ _parse_pvd (vcdxml_t *p_vcdxml, CdIo_t *p_cdio)
 }
 
 static int
-_parse_info (vcdxml_t *p_vcdxml, CdIo_t *p_cdio)
+_parse_info (vcdxml_t *p_vcdxml, const vcdinfo_obj_t *p_vcdinfo)
 {
   InfoVcd_t info;
 
   memset (&info, 0, sizeof (InfoVcd_t));
   vcd_assert (sizeof (InfoVcd_t) == ISO_BLOCKSIZE);
 
-  if (!read_info(p_cdio, &info, &(p_vcdxml->vcd_type)))
+  if (!read_info(p_vcdinfo, &info, &(p_vcdxml->vcd_type)))
     return -1;
 
   if (p_vcdxml->vcd_type == VCD_TYPE_INVALID)
@@ -289,7 +301,7 @@ _parse_info (vcdxml_t *p_vcdxml, CdIo_t *p_cdio)
 }
 
 static int
-_parse_entries (vcdxml_t *p_vcdxml, CdIo_t *p_cdio)
+_parse_entries (vcdxml_t *p_vcdxml, const vcdinfo_obj_t *p_vcdinfo)
 {
   EntriesVcd_t entries;
   int idx;
@@ -298,7 +310,7 @@ _parse_entries (vcdxml_t *p_vcdxml, CdIo_t *p_cdio)
   memset (&entries, 0, sizeof (EntriesVcd_t));
   vcd_assert (sizeof (EntriesVcd_t) == ISO_BLOCKSIZE);
 
-  if (!read_entries(p_cdio, &entries)) {
+  if (!read_entries(p_vcdinfo, &entries)) {
     return -1;
   }
 
@@ -769,8 +781,10 @@ _visit_lot (pbc_ctx_t *p_pbc_ctx)
 }
 
 static int
-_parse_pbc (vcdxml_t *p_vcdxml, CdIo_t *p_cdio, bool no_ext_psd)
+_parse_pbc (vcdxml_t *p_vcdxml, const vcdinfo_obj_t *p_vcdinfo,
+	    bool no_ext_psd)
 {
+  CdIo_t *p_cdio = vcdinfo_get_cd_image (p_vcdinfo);
   int n;
   pbc_ctx_t _pbc_ctx;
   CdioListNode_t *node;
@@ -831,8 +845,8 @@ _parse_pbc (vcdxml_t *p_vcdxml, CdIo_t *p_cdio, bool no_ext_psd)
 
   _pbc_ctx.lot = calloc(1, ISO_BLOCKSIZE * LOT_VCD_SIZE);
 
-  if (cdio_read_mode2_sectors (p_cdio, _pbc_ctx.lot, _lot_vcd_sector, false,
-			       LOT_VCD_SIZE)) {
+  if (vcdinfo_read_mode2_sectors (p_vcdinfo, _pbc_ctx.lot, _lot_vcd_sector,
+				  false, LOT_VCD_SIZE)) {
     _cdio_list_free (_pbc_ctx.offset_list, true, NULL);
     free(_pbc_ctx.lot);
     return -1;
@@ -845,7 +859,8 @@ _parse_pbc (vcdxml_t *p_vcdxml, CdIo_t *p_cdio, bool no_ext_psd)
 
   _pbc_ctx.psd = calloc(1, ISO_BLOCKSIZE * n);
 
-  if (cdio_read_mode2_sectors (p_cdio, _pbc_ctx.psd,_psd_vcd_sector, false, n)) {
+  if (vcdinfo_read_mode2_sectors (p_vcdinfo, _pbc_ctx.psd, _psd_vcd_sector,
+				  false, n)) {
     rc = -1;
     goto free_and_return;
   }
@@ -873,117 +888,431 @@ _parse_pbc (vcdxml_t *p_vcdxml, CdIo_t *p_cdio, bool no_ext_psd)
   return rc;
 }
 
-static int
-_rip_isofs (vcdxml_t *p_vcdxml, CdIo_t *p_cdio)
+/****************************************************************************
+ * batched sector reader -- reads _read_batch sectors at a time; with
+ * threads the next batch is read while the current one is processed.
+ * The source must not be used otherwise while a reader is open.
+ */
+
+typedef struct {
+  CdIo_t *p_cdio;
+  bool form2;
+  unsigned sector_size;
+  unsigned batch;
+
+  lsn_t next_lsn; /* next one to read */
+  lsn_t end_lsn;
+
+  struct {
+    uint8_t *data;
+    unsigned count; /* 0 after the end */
+    bool full;
+  } buf[2];
+
+  unsigned cur;   /* buffer handed out last */
+  unsigned pos;   /* next sector in it, for _reader_next () */
+  bool started;
+
+#ifdef HAVE_PTHREAD_H
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  bool quit;
+#endif
+} _rip_reader_t;
+
+/* fills buffer idx with the next batch */
+static void
+_reader_fill (_rip_reader_t *p_reader, unsigned idx)
 {
-  CdioListNode_t *node;
+  const unsigned count = MIN (p_reader->batch,
+                              p_reader->end_lsn - p_reader->next_lsn);
+  uint8_t *data = p_reader->buf[idx].data;
 
-  _CDIO_LIST_FOREACH (node, p_vcdxml->filesystem)
+  memset (data, 0, count * p_reader->sector_size);
+
+  /* some drives don't take large reads; fall back to single sectors */
+  if (count
+      && cdio_read_mode2_sectors (p_reader->p_cdio, data, p_reader->next_lsn,
+                                  p_reader->form2, count)
+      && count > 1)
     {
-      struct filesystem_t *_fs = _cdio_list_node_data (node);
-      int idx;
-      FILE *outfd;
-      const int blocksize = _fs->file_raw ? M2RAW_SECTOR_SIZE : ISO_BLOCKSIZE;
+      unsigned n;
 
-      if (!_fs->file_src)
-	continue;
+      memset (data, 0, count * p_reader->sector_size);
 
-      vcd_info ("extracting %s to %s (lsn %u, size %u, raw %d)",
-		_fs->name, _fs->file_src,
-		(unsigned int) _fs->lsn, (unsigned int) _fs->size,
-		_fs->file_raw);
+      for (n = 0; n < count; n++)
+        cdio_read_mode2_sector (p_reader->p_cdio,
+                                data + n * p_reader->sector_size,
+                                p_reader->next_lsn + n, p_reader->form2);
+    }
+
+  p_reader->next_lsn += count;
+  p_reader->buf[idx].count = count;
+}
+
+#ifdef HAVE_PTHREAD_H
+static void *
+_reader_thread (void *user_data)
+{
+  _rip_reader_t *p_reader = user_data;
+  unsigned idx = 0;
+
+  for (;;)
+    {
+      pthread_mutex_lock (&p_reader->lock);
+
+      while (p_reader->buf[idx].full && !p_reader->quit)
+        pthread_cond_wait (&p_reader->cond, &p_reader->lock);
 
-      if (!(outfd = fopen (_fs->file_src, "wb")))
+      if (p_reader->quit)
         {
-          perror ("fopen()");
-          exit (EXIT_FAILURE);
+          pthread_mutex_unlock (&p_reader->lock);
+          break;
         }
 
-      for (idx = 0; idx < _fs->size; idx += blocksize)
+      pthread_mutex_unlock (&p_reader->lock);
+
+      _reader_fill (p_reader, idx);
+
+      pthread_mutex_lock (&p_reader->lock);
+      p_reader->buf[idx].full = true;
+      pthread_cond_broadcast (&p_reader->cond);
+      pthread_mutex_unlock (&p_reader->lock);
+
+      if (!p_reader->buf[idx].count)
+        break;
+
+      idx ^= 1;
+    }
+
+  return NULL;
+}
+#endif
+
+static _rip_reader_t *
+_reader_new (CdIo_t *p_cdio, lsn_t start_lsn, lsn_t end_lsn, bool form2)
+{
+  _rip_reader_t *p_reader = calloc (1, sizeof (_rip_reader_t));
+  int i;
+
+  p_reader->p_cdio = p_cdio;
+  p_reader->form2 = form2;
+  p_reader->sector_size = form2 ? M2RAW_SECTOR_SIZE : ISO_BLOCKSIZE;
+  p_reader->batch = _read_batch;
+  p_reader->next_lsn = start_lsn;
+  p_reader->end_lsn = MAX (start_lsn, end_lsn);
+
+  for (i = 0; i < 2; i++)
+    p_reader->buf[i].data = malloc (p_reader->batch * p_reader->sector_size);
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_init (&p_reader->lock, NULL);
+  pthread_cond_init (&p_reader->cond, NULL);
+
+  if (pthread_create (&p_reader->thread, NULL, _reader_thread, p_reader))
+    vcd_error ("failed to create reader thread: %s", strerror (errno));
+#endif
+
+  return p_reader;
+}
+
+/* the next batch of sectors, NULL at the end */
+static const uint8_t *
+_reader_next_batch (_rip_reader_t *p_reader, unsigned *p_count)
+{
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock (&p_reader->lock);
+
+  if (p_reader->started)
+    {
+      /* hand the previous one back for reading */
+      p_reader->buf[p_reader->cur].full = false;
+      pthread_cond_broadcast (&p_reader->cond);
+      p_reader->cur ^= 1;
+    }
+
+  p_reader->started = true;
+
+  while (!p_reader->buf[p_reader->cur].full)
+    pthread_cond_wait (&p_reader->cond, &p_reader->lock);
+
+  pthread_mutex_unlock (&p_reader->lock);
+#else
+  p_reader->started = true;
+  _reader_fill (p_reader, p_reader->cur);
+#endif
+
+  p_reader->pos = 0;
+  *p_count = p_reader->buf[p_reader->cur].count;
+
+  return *p_count ? p_reader->buf[p_reader->cur].data : NULL;
+}
+
+/* the next sector, NULL at the end */
+static const uint8_t *
+_reader_next (_rip_reader_t *p_reader)
+{
+  if (!p_reader->started
+      || p_reader->pos == p_reader->buf[p_reader->cur].count)
+    {
+      unsigned count;
+
+      if (!_reader_next_batch (p_reader, &count))
+        return NULL;
+    }
+
+  return p_reader->buf[p_reader->cur].data
+    + p_reader->sector_size * p_reader->pos++;
+}
+
+static void
+_reader_destroy (_rip_reader_t *p_reader)
+{
+  int i;
+
+#ifdef HAVE_PTHREAD_H
+  pthread_mutex_lock (&p_reader->lock);
+  p_reader->quit = true;
+  pthread_cond_broadcast (&p_reader->cond);
+  pthread_mutex_unlock (&p_reader->lock);
+
+  pthread_join (p_reader->thread, NULL);
+
+  pthread_mutex_destroy (&p_reader->lock);
+  pthread_cond_destroy (&p_reader->cond);
+#endif
+
+  for (i = 0; i < 2; i++)
+    free (p_reader->buf[i].data);
+
+  free (p_reader);
+}
+
+/* output in large blocks, one per read batch */
+static FILE *
+_rip_fopen (const char fname[], size_t sector_size)
+{
+  FILE *outfd;
+
+  if (!(outfd = fopen (fname, "wb")))
+    {
+      perror ("fopen()");
+      exit (EXIT_FAILURE);
+    }
+
+  setvbuf (outfd, NULL, _IOFBF, _read_batch * sector_size);
+
+  return outfd;
+}
+
+/* true if the MPEG packet in buf holds nothing but zero bytes */
+static bool
+_rip_zero_p (const uint8_t buf[], unsigned len)
+{
+  unsigned pos;
+
+  for (pos = 0; pos < len && !buf[pos]; pos++);
+
+  return pos == len;
+}
+
+/* cheap look at the PES headers of the pack in buf, to tell whether
+   any of them carries a PTS; only those packets can move last_pts, the
+   rest need not go through vcd_mpeg_parse_packet().  Anything not
+   understood here is answered with true. */
+static bool
+_rip_pts_p (const uint8_t buf[], unsigned len)
+{
+  unsigned pos;
+
+  if (buf[0] || buf[1] || buf[2] != 0x01 || buf[3] != 0xba)
+    return true;
+
+  if (buf[4] >> 4 == 0x2) /* %0010 ISO11172-1 */
+    pos = 12;
+  else if (buf[4] >> 6 == 0x1) /* %01xx ISO13818-1 */
+    pos = 14 + (buf[13] & 0x7);
+  else
+    return true;
+
+  while (pos + 6 <= len)
+    {
+      const uint8_t *pes = buf + pos;
+      unsigned hdr;
+
+      if (pes[0] || pes[1] || pes[2] != 0x01)
+	return !_rip_zero_p (pes, len - pos);
+
+      switch (pes[3])
 	{
-	  char buf[blocksize];
-	  /* some EDG based compilers segfault on the commented out code */
-	  /* memset (buf, 0, sizeof (buf)); */
-	  memset (buf, 0, blocksize);
+	case 0xb9: /* program end */
+	  pos += 4;
+	  continue;
 
-	  cdio_read_mode2_sector (p_cdio, buf, _fs->lsn + (idx / blocksize),
-				  _fs->file_raw);
+	case 0xbb: /* system header */
+	case 0xbe: /* padding */
+	  break;
+
+	case 0xbd: /* private stream 1 */
+	case 0xc0: case 0xc1: case 0xc2:
+	case 0xe0: case 0xe1: case 0xe2:
+	  hdr = pos + 6;
 
-	  fwrite (buf, blocksize, 1, outfd);
+	  if (hdr + 2 > len)
+	    return true;
 
-	  if (ferror (outfd))
+	  if (buf[hdr] >> 6 == 0x2) /* %10 ISO13818-1 */
 	    {
-	      perror ("fwrite()");
-	      exit (EXIT_FAILURE);
+	      if (buf[hdr + 1] & 0x80) /* PTS_DTS_flags */
+		return true;
+	      break;
 	    }
-	}
 
-      fflush (outfd);
-      if (ftruncate (fileno (outfd), _fs->size))
-	perror ("ftruncate()");
+	  while (hdr < len && buf[hdr] == 0xff) /* stuffing */
+	    hdr++;
+
+	  if (hdr < len && buf[hdr] >> 6 == 0x1) /* STD buffer */
+	    hdr += 2;
+
+	  if (hdr >= len || buf[hdr] >> 4 == 0x2 || buf[hdr] >> 4 == 0x3)
+	    return true;
+	  break;
 
-      fclose (outfd);
+	default:
+	  return true;
+	}
 
+      pos += 6 + (pes[4] << 8 | pes[5]);
     }
 
-  return 0;
+  return false;
 }
 
 static int
-_rip_segments (vcdxml_t *p_vcdxml, CdIo_t *p_cdio)
+_entry_point_cmp (struct entry_point_t *p_ep1, struct entry_point_t *p_ep2)
 {
-  CdioListNode_t *node;
-  lsn_t start_extent;
+  if (p_ep1->extent < p_ep2->extent)
+    return -1;
 
-  start_extent = p_vcdxml->info.segments_start;
+  if (p_ep1->extent > p_ep2->extent)
+    return 1;
 
-  vcd_assert (start_extent % CDIO_CD_FRAMES_PER_SEC == 0);
+  return 0;
+}
 
-  _CDIO_LIST_FOREACH (node, p_vcdxml->segment_list)
-    {
-      struct segment_t *p_seg = _cdio_list_node_data (node);
-      uint32_t n;
-      FILE *outfd = NULL;
-      VcdMpegStreamCtx mpeg_ctx;
-      double last_pts = 0;
+/* scans the MPEG file just extracted and leaves its scan index next to
+   it, so vcdxbuild can skip scanning the file */
+static void
+_rip_save_index (const char fname[])
+{
+  VcdMpegSource_t *p_src;
+  struct stat statbuf;
 
-      vcd_assert (p_seg->segments_count > 0);
+  if (stat (fname, &statbuf) || !statbuf.st_size)
+    return;
 
-      memset (&mpeg_ctx, 0, sizeof (VcdMpegStreamCtx));
+  p_src = vcd_mpeg_source_new (vcd_data_source_new_stdio (fname));
 
-      vcd_info ("extracting %s... (start lsn %u, %d segments)",
-		p_seg->src, (unsigned int) start_extent,
-		p_seg->segments_count);
+  /* vcdxbuild scans with strict APS unless told otherwise */
+  vcd_mpeg_source_scan (p_src, true, false, NULL, NULL);
+  vcd_mpeg_source_save_index (p_src, fname);
 
-      if (!(outfd = fopen (p_seg->src, "wb")))
-        {
-          perror ("fopen()");
-          exit (EXIT_FAILURE);
-        }
+  vcd_mpeg_source_destroy (p_src, true);
+}
+
+static void
+_rip_file (struct filesystem_t *_fs, CdIo_t *p_cdio)
+{
+  FILE *outfd;
+  const int blocksize = _fs->file_raw ? M2RAW_SECTOR_SIZE : ISO_BLOCKSIZE;
+  _rip_reader_t *p_reader;
+  const uint8_t *data;
+  unsigned count;
+
+  vcd_info ("extracting %s to %s (lsn %u, size %u, raw %d)",
+	    _fs->name, _fs->file_src,
+	    (unsigned int) _fs->lsn, (unsigned int) _fs->size,
+	    _fs->file_raw);
+
+  if (!(outfd = fopen (_fs->file_src, "wb")))
+    {
+      perror ("fopen()");
+      exit (EXIT_FAILURE);
+    }
 
-      for (n = 0; n < p_seg->segments_count * VCDINFO_SEGMENT_SECTOR_SIZE; n++)
+  /* the sectors come in contiguous, a batch is written at once */
+  p_reader = _reader_new (p_cdio, _fs->lsn,
+			  _fs->lsn + _vcd_len2blocks (_fs->size, blocksize),
+			  _fs->file_raw);
+
+  while ((data = _reader_next_batch (p_reader, &count)))
+    {
+      fwrite (data, blocksize, count, outfd);
+
+      if (ferror (outfd))
 	{
-	  struct m2f2sector
-          {
-            uint8_t subheader[8];
-            uint8_t data[M2F2_SECTOR_SIZE];
-            uint8_t spare[4];
-          }
-          buf;
+	  perror ("fwrite()");
+	  exit (EXIT_FAILURE);
+	}
+    }
 
-	  memset (&buf, 0, sizeof (buf));
-	  cdio_read_mode2_sector (p_cdio, &buf, start_extent + n, true);
+  _reader_destroy (p_reader);
+
+  fflush (outfd);
+  if (ftruncate (fileno (outfd), _fs->size))
+    perror ("ftruncate()");
+
+  fclose (outfd);
+}
+
+static void
+_rip_segment (struct segment_t *p_seg, lsn_t start_extent, CdIo_t *p_cdio)
+{
+  uint32_t n;
+  FILE *outfd = NULL;
+  VcdMpegStreamCtx mpeg_ctx;
+  double last_pts = 0;
+  const uint32_t sectors =
+    p_seg->segments_count * VCDINFO_SEGMENT_SECTOR_SIZE;
+  _rip_reader_t *p_reader;
 
-	  if (!buf.subheader[0]
-              && !buf.subheader[1]
-              && (buf.subheader[2] | SM_FORM2) == SM_FORM2
-              && !buf.subheader[3])
-            {
-              vcd_warn ("no EOF seen, but stream ended");
-              break;
-            }
+  vcd_assert (p_seg->segments_count > 0);
 
-	  vcd_mpeg_parse_packet (buf.data, M2F2_SECTOR_SIZE, false, &mpeg_ctx);
+  memset (&mpeg_ctx, 0, sizeof (VcdMpegStreamCtx));
+
+  vcd_info ("extracting %s... (start lsn %u, %d segments)",
+	    p_seg->src, (unsigned int) start_extent,
+	    p_seg->segments_count);
+
+  outfd = _rip_fopen (p_seg->src, M2F2_SECTOR_SIZE);
+
+  p_reader = _reader_new (p_cdio, start_extent, start_extent + sectors,
+			  true);
+
+  for (n = 0; n < sectors; n++)
+    {
+      const struct m2f2sector
+      {
+	uint8_t subheader[8];
+	uint8_t data[M2F2_SECTOR_SIZE];
+	uint8_t spare[4];
+      }
+      *p_buf = (const struct m2f2sector *) _reader_next (p_reader);
+
+      if (!p_buf->subheader[0]
+	  && !p_buf->subheader[1]
+	  && (p_buf->subheader[2] | SM_FORM2) == SM_FORM2
+	  && !p_buf->subheader[3])
+	{
+	  vcd_warn ("no EOF seen, but stream ended");
+	  break;
+	}
+
+      if (_rip_pts_p (p_buf->data, M2F2_SECTOR_SIZE))
+	{
+	  vcd_mpeg_parse_packet (p_buf->data, M2F2_SECTOR_SIZE, false,
+				 &mpeg_ctx);
 
 	  if (mpeg_ctx.packet.has_pts)
 	    {
@@ -994,166 +1323,146 @@ _rip_segments (vcdxml_t *p_vcdxml, CdIo_t *p_cdio)
 		last_pts = 0;
 	      /* vcd_debug ("pts %f @%d", mpeg_ctx.packet.pts, n); */
 	    }
+	}
 
-	  if (buf.subheader[2] & SM_TRIG)
-	    {
-	      double *_ap_ts = calloc(1, sizeof (double));
-
-	      vcd_debug ("autopause @%u (%f)", (unsigned int) n, last_pts);
-	      *_ap_ts = last_pts;
+      if (p_buf->subheader[2] & SM_TRIG)
+	{
+	  double *_ap_ts = calloc(1, sizeof (double));
 
-	      _cdio_list_append (p_seg->autopause_list, _ap_ts);
-	    }
+	  vcd_debug ("autopause @%u (%f)", (unsigned int) n, last_pts);
+	  *_ap_ts = last_pts;
 
-	  fwrite (buf.data, M2F2_SECTOR_SIZE, 1, outfd);
+	  _cdio_list_append (p_seg->autopause_list, _ap_ts);
+	}
 
-	  if (ferror (outfd))
-            {
-              perror ("fwrite()");
-              exit (EXIT_FAILURE);
-            }
+      fwrite (p_buf->data, M2F2_SECTOR_SIZE, 1, outfd);
 
-	  if (buf.subheader[2] & SM_EOF)
-            break;
+      if (ferror (outfd))
+	{
+	  perror ("fwrite()");
+	  exit (EXIT_FAILURE);
 	}
 
-      fclose (outfd);
-
-      start_extent += p_seg->segments_count * VCDINFO_SEGMENT_SECTOR_SIZE;
+      if (p_buf->subheader[2] & SM_EOF)
+	break;
     }
 
-  return 0;
+  _reader_destroy (p_reader);
+  fclose (outfd);
+
+  if (_scan_index_flag)
+    _rip_save_index (p_seg->src);
 }
 
-static int
-_rip_sequences (vcdxml_t *p_vcdxml, CdIo_t *p_cdio, int i_track)
+static void
+_rip_sequence (struct sequence_t *_seq, uint32_t end_lsn, bool last_track,
+	       CdIo_t *p_cdio)
 {
-  CdioListNode_t *node;
-  int counter=1;
+  FILE *outfd = NULL;
+  bool in_data = false;
+  VcdMpegStreamCtx mpeg_ctx;
+  uint32_t start_lsn, n, last_nonzero, first_data;
+  double last_pts = 0;
+  CdioListNode_t *ep_node;
 
-  _CDIO_LIST_FOREACH (node, p_vcdxml->sequence_list)
-    {
-      struct sequence_t *_seq = _cdio_list_node_data (node);
-      CdioListNode_t *nnode = _cdio_list_node_next (node);
-      struct sequence_t *_nseq = nnode ? _cdio_list_node_data (nnode) : NULL;
-      FILE *outfd = NULL;
-      bool in_data = false;
-      VcdMpegStreamCtx mpeg_ctx;
-      uint32_t start_lsn, end_lsn, n, last_nonzero, first_data;
-      double last_pts = 0;
-
-      _read_progress_t _progress;
+  _read_progress_t _progress;
 
-      struct m2f2sector
-      {
-	uint8_t subheader[CDIO_CD_SUBHEADER_SIZE];
-	uint8_t data[M2F2_SECTOR_SIZE];
-	uint8_t spare[4];
-      }
-      buf[15];
+  _rip_reader_t *p_reader;
 
-      if (i_track > 0 && i_track!=counter++) {
-	vcd_info("Track %d selected, skipping track %d", i_track,counter-1);
-	continue;
-      }
+  const struct m2f2sector
+  {
+    uint8_t subheader[CDIO_CD_SUBHEADER_SIZE];
+    uint8_t data[M2F2_SECTOR_SIZE];
+    uint8_t spare[4];
+  }
+  *p_buf;
 
-      if (i_track < 0 && -i_track==counter++) {
-	vcd_info("Skipping track %d", -i_track);
-	continue;
-      }
+  memset (&mpeg_ctx, 0, sizeof (VcdMpegStreamCtx));
 
-      memset (&mpeg_ctx, 0, sizeof (VcdMpegStreamCtx));
+  start_lsn = _seq->start_extent;
 
-      start_lsn = _seq->start_extent;
-      end_lsn = _nseq ? _nseq->start_extent : cdio_get_disc_last_lsn (p_cdio);
+  /* the entry points get consumed in sector order as the data goes by */
+  _vcd_list_sort (_seq->entry_point_list,
+		  (_cdio_list_cmp_func_t) _entry_point_cmp);
+  ep_node = _cdio_list_begin (_seq->entry_point_list);
 
-      vcd_info ("extracting %s... (start lsn %lu (+%lu))",
-		_seq->src, (long unsigned int) start_lsn,
-		(long unsigned int) (end_lsn - start_lsn));
+  vcd_info ("extracting %s... (start lsn %lu (+%lu))",
+	    _seq->src, (long unsigned int) start_lsn,
+	    (long unsigned int) (end_lsn - start_lsn));
 
-      if (!(outfd = fopen (_seq->src, "wb")))
-        {
-          perror ("fopen()");
-          exit (EXIT_FAILURE);
-        }
+  outfd = _rip_fopen (_seq->src, M2F2_SECTOR_SIZE);
+  p_reader = _reader_new (p_cdio, start_lsn, end_lsn, true);
 
-      last_nonzero = start_lsn - 1;
-      first_data = 0;
+  last_nonzero = start_lsn - 1;
+  first_data = 0;
 
-      _progress.total = end_lsn;
+  _progress.total = end_lsn;
 
-      for (n = start_lsn; n < end_lsn; n++)
+  for (n = start_lsn; n < end_lsn; n++)
+    {
+      if (n - _progress.done > (end_lsn / 100))
 	{
-	  const int buf_idx = (n - start_lsn) % 15;
+	  _progress.done = n;
+	  vcd_xml_read_progress_cb (&_progress, _seq->src);
+	}
 
-	  if (n - _progress.done > (end_lsn / 100))
-	    {
-	      _progress.done = n;
-	      vcd_xml_read_progress_cb (&_progress, _seq->src);
-	    }
+      p_buf = (const struct m2f2sector *) _reader_next (p_reader);
 
-	  if (!buf_idx)
-	    {
-	      const int secs_left = end_lsn - n;
+      if (!last_track && n + CDIO_POSTGAP_SECTORS == end_lsn + 1)
+	vcd_warn ("reading into gap @%u... :-(", (unsigned int) n);
 
-	      memset (buf, 0, sizeof (buf));
-	      cdio_read_mode2_sectors (p_cdio, buf, n, true, (secs_left > 15
-							   ? 15 : secs_left));
-	    }
-
-	  if (_nseq && n + CDIO_POSTGAP_SECTORS == end_lsn + 1)
-	    vcd_warn ("reading into gap @%u... :-(", (unsigned int) n);
+      if (!(p_buf->subheader[2] & SM_FORM2))
+	{
+	  vcd_warn ("encountered non-form2 sector -- leaving loop");
+	  break;
+	}
 
-	  if (!(buf[buf_idx].subheader[2] & SM_FORM2))
+      if (in_data)
+	{ /* end conditions... */
+	  if (!p_buf->subheader[0])
 	    {
-	      vcd_warn ("encountered non-form2 sector -- leaving loop");
+	      vcd_debug ("fn -edge @%u", (unsigned int) n);
 	      break;
 	    }
 
-	  if (in_data)
-	    { /* end conditions... */
-	      if (!buf[buf_idx].subheader[0])
-		{
-		  vcd_debug ("fn -edge @%u", (unsigned int) n);
-		  break;
-		}
-
-	      if (!(buf[buf_idx].subheader[2] & SM_REALT))
-		{
-		  vcd_debug ("subheader: no realtime data anymore @%u",
-			     (unsigned int) n);
-		  break;
-		}
-	    }
-
-	  if (buf[buf_idx].subheader[1] && !in_data)
+	  if (!(p_buf->subheader[2] & SM_REALT))
 	    {
-	      vcd_debug ("cn +edge @%u", (unsigned int) n);
-	      in_data = true;
+	      vcd_debug ("subheader: no realtime data anymore @%u",
+			 (unsigned int) n);
+	      break;
 	    }
+	}
+
+      if (p_buf->subheader[1] && !in_data)
+	{
+	  vcd_debug ("cn +edge @%u", (unsigned int) n);
+	  in_data = true;
+	}
 
 
 #if defined(DEBUG)
-	  if (!in_data)
-	    vcd_debug ("%2.2x %2.2x %2.2x %2.2x",
-		       buf[buf_idx].subheader[0],
-		       buf[buf_idx].subheader[1],
-		       buf[buf_idx].subheader[2],
-		       buf[buf_idx].subheader[3]);
+      if (!in_data)
+	vcd_debug ("%2.2x %2.2x %2.2x %2.2x",
+		   p_buf->subheader[0],
+		   p_buf->subheader[1],
+		   p_buf->subheader[2],
+		   p_buf->subheader[3]);
 #endif
 
-	  if (in_data)
-	    {
-	      CdioListNode_t *_node;
+      if (in_data)
+	{
+	  const bool zero = _rip_zero_p (p_buf->data, M2F2_SECTOR_SIZE);
 
-	      vcd_mpeg_parse_packet (buf[buf_idx].data, M2F2_SECTOR_SIZE,
-				     false, &mpeg_ctx);
+	  if (!zero)
+	    last_nonzero = n;
 
-	      if (!mpeg_ctx.packet.zero)
-		last_nonzero = n;
+	  if (!first_data && !zero)
+	    first_data = n;
 
-	      if (!first_data && !mpeg_ctx.packet.zero)
-		first_data = n;
+	  if (!zero && _rip_pts_p (p_buf->data, M2F2_SECTOR_SIZE))
+	    {
+	      vcd_mpeg_parse_packet (p_buf->data, M2F2_SECTOR_SIZE,
+				     false, &mpeg_ctx);
 
 	      if (mpeg_ctx.packet.has_pts)
 		{
@@ -1164,74 +1473,305 @@ _rip_sequences (vcdxml_t *p_vcdxml, CdIo_t *p_cdio, int i_track)
 		    last_pts = 0;
 		  /* vcd_debug ("pts %f @%d", mpeg_ctx.packet.pts, n); */
 		}
+	    }
 
-	      if (buf[buf_idx].subheader[2] & SM_TRIG)
-		{
-		  double *_ap_ts = calloc(1, sizeof (double));
+	  if (p_buf->subheader[2] & SM_TRIG)
+	    {
+	      double *_ap_ts = calloc(1, sizeof (double));
 
-		  vcd_debug ("autopause @%u (%f)", (unsigned int) n,
-			     last_pts);
-		  *_ap_ts = last_pts;
+	      vcd_debug ("autopause @%u (%f)", (unsigned int) n,
+			 last_pts);
+	      *_ap_ts = last_pts;
 
-		  _cdio_list_append (_seq->autopause_list, _ap_ts);
-		}
+	      _cdio_list_append (_seq->autopause_list, _ap_ts);
+	    }
 
-	      _CDIO_LIST_FOREACH (_node, _seq->entry_point_list)
+	  /* entry points passed outside of the data are left alone */
+	  for (; ep_node; ep_node = _cdio_list_node_next (ep_node))
+	    {
+	      struct entry_point_t *_ep = _cdio_list_node_data (ep_node);
+
+	      if (_ep->extent > n)
+		break;
+
+	      if (_ep->extent == n)
 		{
-		  struct entry_point_t *_ep = _cdio_list_node_data (_node);
-
-		  if (_ep->extent == n)
-		    {
-		      vcd_debug ("entry point @%u (%f)", (unsigned int) n,
-				 last_pts);
-		      _ep->timestamp = last_pts;
-		    }
+		  vcd_debug ("entry point @%u (%f)", (unsigned int) n,
+			     last_pts);
+		  _ep->timestamp = last_pts;
 		}
+	    }
 
-	      if (first_data)
-		{
-		  fwrite (buf[buf_idx].data, M2F2_SECTOR_SIZE, 1, outfd);
+	  if (first_data)
+	    {
+	      fwrite (p_buf->data, M2F2_SECTOR_SIZE, 1, outfd);
 
-		  if (ferror (outfd))
-		    {
-		      perror ("fwrite()");
-		      exit (EXIT_FAILURE);
-		    }
+	      if (ferror (outfd))
+		{
+		  perror ("fwrite()");
+		  exit (EXIT_FAILURE);
 		}
+	    }
+
+	} /* if (in_data) */
+
+      if (p_buf->subheader[2] & SM_EOF)
+	{
+	  vcd_debug ("encountered subheader EOF @%u", (unsigned int) n);
+	  break;
+	}
+    } /* for */
+
+  _reader_destroy (p_reader);
+
+  _progress.done = _progress.total;
+  vcd_xml_read_progress_cb (&_progress, _seq->src);
+
+  if (in_data)
+    {
+      uint32_t length;
 
-	    } /* if (in_data) */
+      if (n == end_lsn)
+	vcd_debug ("stream till end of track");
+
+      length = (1 + last_nonzero) - first_data;
+
+      vcd_debug ("truncating file to %u packets",
+		 (unsigned int) length);
+
+      fflush (outfd);
+      if (ftruncate (fileno (outfd), length * M2F2_SECTOR_SIZE))
+	perror ("ftruncate()");
+    }
+
+  fclose (outfd);
+
+  if (_scan_index_flag)
+    _rip_save_index (_seq->src);
+}
+
+/*
+ * work items -- the files, segments and sequences are independent of
+ * each other; with --jobs they get extracted by several threads, each
+ * reading through its own CdIo_t handle.  The results only go into the
+ * item's own structure, so the XML description is the same whichever
+ * order they complete in.
+ */
+
+typedef enum {
+  RIP_FILE,
+  RIP_SEGMENT,
+  RIP_SEQUENCE
+} _rip_work_type_t;
+
+typedef struct {
+  _rip_work_type_t type;
+  void *p_item;       /* struct filesystem_t, segment_t or sequence_t */
+  lsn_t lsn;          /* start extent of a segment, end of a sequence */
+  bool last_track;
+} _rip_work_t;
+
+static void
+_rip_work_add (CdioList_t *p_work_list, _rip_work_type_t type, void *p_item,
+	       lsn_t lsn, bool last_track)
+{
+  _rip_work_t *p_work = calloc (1, sizeof (_rip_work_t));
+
+  p_work->type = type;
+  p_work->p_item = p_item;
+  p_work->lsn = lsn;
+  p_work->last_track = last_track;
+
+  _cdio_list_append (p_work_list, p_work);
+}
+
+static void
+_rip_work (const _rip_work_t *p_work, CdIo_t *p_cdio)
+{
+  switch (p_work->type)
+    {
+    case RIP_FILE:
+      _rip_file (p_work->p_item, p_cdio);
+      break;
+    case RIP_SEGMENT:
+      _rip_segment (p_work->p_item, p_work->lsn, p_cdio);
+      break;
+    case RIP_SEQUENCE:
+      _rip_sequence (p_work->p_item, p_work->lsn, p_work->last_track, p_cdio);
+      break;
+    }
+}
+
+static int
+_rip_isofs (vcdxml_t *p_vcdxml, CdioList_t *p_work_list)
+{
+  CdioListNode_t *node;
+
+  _CDIO_LIST_FOREACH (node, p_vcdxml->filesystem)
+    {
+      struct filesystem_t *_fs = _cdio_list_node_data (node);
+
+      if (!_fs->file_src)
+	continue;
+
+      _rip_work_add (p_work_list, RIP_FILE, _fs, 0, false);
+    }
+
+  return 0;
+}
+
+static int
+_rip_segments (vcdxml_t *p_vcdxml, CdioList_t *p_work_list)
+{
+  CdioListNode_t *node;
+  lsn_t start_extent;
+
+  start_extent = p_vcdxml->info.segments_start;
 
-	  if (buf[buf_idx].subheader[2] & SM_EOF)
+  vcd_assert (start_extent % CDIO_CD_FRAMES_PER_SEC == 0);
+
+  _CDIO_LIST_FOREACH (node, p_vcdxml->segment_list)
+    {
+      struct segment_t *p_seg = _cdio_list_node_data (node);
+
+      _rip_work_add (p_work_list, RIP_SEGMENT, p_seg, start_extent, false);
+
+      start_extent += p_seg->segments_count * VCDINFO_SEGMENT_SECTOR_SIZE;
+    }
+
+  return 0;
+}
+
+static int
+_rip_sequences (vcdxml_t *p_vcdxml, CdIo_t *p_cdio, int i_track,
+		CdioList_t *p_work_list)
+{
+  CdioListNode_t *node;
+  int counter=1;
+
+  _CDIO_LIST_FOREACH (node, p_vcdxml->sequence_list)
+    {
+      struct sequence_t *_seq = _cdio_list_node_data (node);
+      CdioListNode_t *nnode = _cdio_list_node_next (node);
+      struct sequence_t *_nseq = nnode ? _cdio_list_node_data (nnode) : NULL;
+
+      if (i_track > 0 && i_track!=counter++) {
+	vcd_info("Track %d selected, skipping track %d", i_track,counter-1);
+	continue;
+      }
+
+      if (i_track < 0 && -i_track==counter++) {
+	vcd_info("Skipping track %d", -i_track);
+	continue;
+      }
+
+      _rip_work_add (p_work_list, RIP_SEQUENCE, _seq,
+		     _nseq ? _nseq->start_extent : cdio_get_disc_last_lsn (p_cdio),
+		     !_nseq);
+    }
+
+  return 0;
+}
+
+#ifdef HAVE_PTHREAD_H
+
+typedef struct {
+  pthread_mutex_t lock;
+  CdioListNode_t *next;    /* next work item to hand out */
+} _rip_queue_t;
+
+typedef struct {
+  _rip_queue_t *p_queue;
+  CdIo_t *p_cdio;          /* the job's own handle */
+  pthread_t thread;
+} _rip_job_t;
+
+static void *
+_rip_job_thread (void *arg)
+{
+  _rip_job_t *p_job = arg;
+
+  for (;;)
+    {
+      CdioListNode_t *node;
+
+      pthread_mutex_lock (&p_job->p_queue->lock);
+      if ((node = p_job->p_queue->next))
+	p_job->p_queue->next = _cdio_list_node_next (node);
+      pthread_mutex_unlock (&p_job->p_queue->lock);
+
+      if (!node)
+	break;
+
+      _rip_work (_cdio_list_node_data (node), p_job->p_cdio);
+    }
+
+  return NULL;
+}
+
+#endif /* HAVE_PTHREAD_H */
+
+static void
+_rip_run (CdioList_t *p_work_list, CdIo_t *p_cdio, const char source_name[],
+	  int jobs)
+{
+  CdioListNode_t *node;
+
+#ifdef HAVE_PTHREAD_H
+  if (jobs > 1)
+    {
+      const driver_id_t driver_id = cdio_get_driver_id (p_cdio);
+      _rip_job_t *p_jobs = calloc (jobs, sizeof (_rip_job_t));
+      _rip_queue_t queue;
+      int n, started;
+
+      pthread_mutex_init (&queue.lock, NULL);
+      queue.next = _cdio_list_begin (p_work_list);
+
+      /* all handles are opened here, before any thread runs; the first
+	 job keeps using the one already open */
+      for (n = 0; n < jobs; n++)
+	{
+	  p_jobs[n].p_queue = &queue;
+	  p_jobs[n].p_cdio = n ? cdio_open (source_name, driver_id) : p_cdio;
+
+	  if (!p_jobs[n].p_cdio)
 	    {
-	      vcd_debug ("encountered subheader EOF @%u", (unsigned int) n);
+	      vcd_warn ("could not open `%s' again, using %d jobs",
+			source_name, n);
 	      break;
 	    }
-	} /* for */
+	}
 
-      _progress.done = _progress.total;
-      vcd_xml_read_progress_cb (&_progress, _seq->src);
+      jobs = n;
 
-      if (in_data)
-	{
-	  uint32_t length;
+      for (started = 0; started < jobs; started++)
+	if (pthread_create (&p_jobs[started].thread, NULL, _rip_job_thread,
+			    &p_jobs[started]))
+	  {
+	    vcd_warn ("pthread_create(): %s", strerror (errno));
+	    break;
+	  }
 
-	  if (n == end_lsn)
-	    vcd_debug ("stream till end of track");
+      /* the threads that did start drain the queue anyway */
+      if (!started)
+	_rip_job_thread (&p_jobs[0]);
 
-	  length = (1 + last_nonzero) - first_data;
+      for (n = 0; n < started; n++)
+	pthread_join (p_jobs[n].thread, NULL);
 
-	  vcd_debug ("truncating file to %u packets",
-		     (unsigned int) length);
+      for (n = 1; n < jobs; n++)
+	cdio_destroy (p_jobs[n].p_cdio);
 
-	  fflush (outfd);
-	  if (ftruncate (fileno (outfd), length * M2F2_SECTOR_SIZE))
-	    perror ("ftruncate()");
-	}
+      pthread_mutex_destroy (&queue.lock);
+      free (p_jobs);
 
-      fclose (outfd);
-    } /* _CDIO_LIST_FOREACH */
+      return;
+    }
+#endif
 
-  return 0;
+  _CDIO_LIST_FOREACH (node, p_work_list)
+    _rip_work (_cdio_list_node_data (node), p_cdio);
 }
 
 static vcd_log_handler_t  gl_default_vcd_log_handler = NULL;
@@ -1258,6 +1798,7 @@ int
 main (int argc, const char *argv[])
 {
   CdIo_t *img_src = NULL;
+  vcdinfo_obj_t *p_vcdinfo = NULL;
   vcdxml_t vcdxml;
 
   /* cl params */
@@ -1346,6 +1887,17 @@ main (int argc, const char *argv[])
       {"progress", 'p', POPT_ARG_NONE, &_progress_flag, 0,
        "show progress"},
 
+      {"read-batch", '\0', POPT_ARG_INT, &_read_batch, 0,
+       "number of sectors to read at once"
+       " (default: 256 for images, 15 for devices)", "N"},
+
+      {"jobs", 'j', POPT_ARG_INT, &_jobs, 0,
+       "extract up to N items at once (disk images only)", "N"},
+
+      {"scan-index", '\0', POPT_ARG_NONE, &_scan_index_flag, 0,
+       "write a scan index next to each extracted MPEG file,"
+       " which spares vcdxbuild scanning it"},
+
       { "track", 't', POPT_ARG_INT, &_track_flag, 0,
 	"rip only this track"},
 
@@ -1419,6 +1971,8 @@ main (int argc, const char *argv[])
   else
     vcd_xml_verbosity = VCD_LOG_INFO;
 
+  vcd_log_set_threshold (vcd_xml_verbosity);
+
   if (_gui_flag)
     vcd_xml_gui_mode = true;
 
@@ -1445,29 +1999,69 @@ main (int argc, const char *argv[])
     cdio_free_device_list(cd_drives);
   }
 
-  img_src = cdio_open(source_name, source_type);
-  if (NULL == img_src) {
-    vcd_error ("Error determining place to read from.");
-    exit (EXIT_FAILURE);
-  }
+  /* the disc files are read through the sector cache, the tracks and
+     files ripped straight from img_src */
+  switch (vcdinfo_open_flags (&p_vcdinfo, &source_name,
+			      (driver_id_t) source_type, NULL,
+			      VCDINFO_OPEN_FLAG_CACHE))
+    {
+    case VCDINFO_OPEN_VCD:
+      break;
+    case VCDINFO_OPEN_OTHER:
+      vcd_error ("`%s' doesn't hold a (S)VCD", source_name);
+      exit (EXIT_FAILURE);
+    default:
+      vcd_error ("Error determining place to read from.");
+      exit (EXIT_FAILURE);
+    }
+
+  img_src = vcdinfo_get_cd_image (p_vcdinfo);
+
+  if (_read_batch <= 0)
+    switch (cdio_get_driver_id (img_src))
+      {
+      case DRIVER_BINCUE:
+      case DRIVER_NRG:
+      case DRIVER_CDRDAO:
+	_read_batch = DEFAULT_READ_BATCH_IMAGE;
+	break;
+      default:
+	_read_batch = DEFAULT_READ_BATCH_DEVICE;
+	break;
+      }
 
-  if (NULL == source_name)
-    source_name = cdio_get_default_device(img_src);
+  if (_jobs > 1)
+    switch (cdio_get_driver_id (img_src))
+      {
+      case DRIVER_BINCUE:
+      case DRIVER_NRG:
+      case DRIVER_CDRDAO:
+#ifndef HAVE_PTHREAD_H
+	vcd_warn ("built without thread support, ignoring --jobs");
+	_jobs = 1;
+#endif
+	break;
+      default:
+	/* a drive seeking between several readers only gets slower */
+	vcd_warn ("--jobs only applies to disk images, reading with one job");
+	_jobs = 1;
+	break;
+      }
 
   vcdxml.comment = vcd_xml_dump_cl_comment (argc, argv,
 					      nocommand_comment_flag);
 
   /* start with ISO9660 PVD */
-  _parse_pvd (&vcdxml, img_src);
+  _parse_pvd (&vcdxml, p_vcdinfo);
 
   _parse_isofs (&vcdxml, img_src);
 
   /* needs to be parsed in order */
-  _parse_info (&vcdxml, img_src);
-  _parse_entries (&vcdxml, img_src);
+  _parse_info (&vcdxml, p_vcdinfo);
+  _parse_entries (&vcdxml, p_vcdinfo);
 
   /* needs to be parsed last! */
-  _parse_pbc (&vcdxml, img_src, no_ext_psd_flag);
+  _parse_pbc (&vcdxml, p_vcdinfo, no_ext_psd_flag);
 
   if (_x_track_flag) _track_flag = - _x_track_flag;
 
@@ -1478,14 +2072,20 @@ main (int argc, const char *argv[])
 
   if (!norip_flag)
     {
+      CdioList_t *p_work_list = _cdio_list_new ();
+
       if (!nofile_flag)
-	_rip_isofs (&vcdxml, img_src);
+	_rip_isofs (&vcdxml, p_work_list);
 
       if (!noseg_flag)
-	_rip_segments (&vcdxml, img_src);
+	_rip_segments (&vcdxml, p_work_list);
 
       if (!noseq_flag)
-	_rip_sequences (&vcdxml, img_src, _track_flag);
+	_rip_sequences (&vcdxml, img_src, _track_flag, p_work_list);
+
+      _rip_run (p_work_list, img_src, source_name, _jobs);
+
+      _cdio_list_free (p_work_list, true, NULL);
     }
 
   vcd_info ("Writing XML description to `%s'...", xml_fname);
@@ -1495,7 +2095,7 @@ main (int argc, const char *argv[])
   free(source_name);
   poptFreeContext(optCon);
 
-  cdio_destroy (img_src);
+  vcdinfo_close (p_vcdinfo);
   vcd_info ("done");
   return EXIT_SUCCESS;
 }
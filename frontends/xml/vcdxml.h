@@ -29,12 +29,53 @@
 #include "vcd_assert.h"
 #include "data_structures.h"
 #include "pbc.h"
+#include "vcd.h"
+
+/* scans p_source, the stream in file fname, in place of
+   vcd_mpeg_source_scan (); id names the item for progress reports */
+typedef void (*vcd_xml_scan_func_t) (VcdMpegSource_t *p_source,
+                                     const char fname[], bool strict_aps,
+                                     bool fix_scan_info, const char id[],
+                                     void *user_data);
+
+/* what vcd_xml_master () has allocated and not handed over yet */
+typedef struct {
+  VcdObj_t *obj;
+  VcdMpegSource_t *mpeg_source; /* scanned, not added to obj yet */
+  VcdImageSink_t *image_sink;   /* not passed to obj yet */
+} vcd_xml_build_state_t;
 
 typedef struct vcdxml_tag {
   char *comment; /* just a xml comment... */
 
   char *file_prefix;
 
+  /* incremental rebuild; not part of the xml description */
+  struct {
+    const char *manifest_fname;      /* build manifest to write, or NULL */
+    const char *prev_image_fname;    /* image of the previous build, or NULL */
+    const char *prev_manifest_fname; /* manifest of the previous build */
+    const char *image_fname;         /* bin file the image sink writes to */
+    bool sector_2336;
+
+    bool no_scan_index;              /* always scan, ignore sidecars */
+
+    unsigned jobs;                   /* tracks written in parallel */
+
+    bool stats;                      /* report stats when done */
+    bool stats_json;
+
+    /* used by vcdimagerd; if set they replace scanning and the
+       progress output of vcd_xml_show_progress */
+    vcd_xml_scan_func_t scan_func;
+    progress_callback_t write_progress_cb;
+    void *user_data;
+
+    /* kept up to date if set, so that a build ended by vcd_error ()
+       can be cleaned up with vcd_xml_master_cleanup () */
+    vcd_xml_build_state_t *state;
+  } build;
+
   vcd_type_t vcd_type;
   CdioList_t *option_list;
 
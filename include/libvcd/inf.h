@@ -38,6 +38,13 @@ extern "C" {
 
   const char * vcdinf_area_str (const struct psd_area_t *_area);
 
+  /*!
+    Like vcdinf_area_str, but the string goes to buf of len bytes
+    (VCDINFO_STRBUF_SIZE is enough).  Returns buf or a string constant.
+  */
+  const char * vcdinf_area_str_r (const struct psd_area_t *_area,
+                                  char buf[], size_t len);
+
   /*!
     Return a string containing the VCD album id.
   */
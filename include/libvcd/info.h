@@ -24,6 +24,15 @@
    Things here refer to higher-level structures usually accessed via
    vcdinfo_t. For lower-level access which generally use
    structures other than vcdinfo_t, see inf.h
+
+   Thread safety: different vcdinfo_obj_t's may be used by different
+   threads at the same time; a single one must not be shared without
+   locking, not even for reading, since some of its tables are built on
+   first use.  Functions returning a string not belonging to an object
+   (vcdinfo_pin2str, vcdinfo_ofs2str, vcdinfo_strip_trail, ...) return
+   buffers private to the calling thread, which later calls from the
+   same thread reuse; the _r variants write to a buffer of the caller
+   instead.  See logging.h for log handlers.
 */
 
 
@@ -70,6 +79,12 @@ extern "C" {
 
 /*========== End move somewhere else? ================*/
 
+/*!
+  Size of the buffers for the _r variants of the functions returning
+  strings, like vcdinfo_pin2str_r.
+*/
+#define VCDINFO_STRBUF_SIZE 80
+
 /*!
   Portion of uint16_t which determines whether offset is
   rejected or not.
@@ -190,6 +205,23 @@ extern "C" {
     VCDINFO_OPEN_OTHER           /**< Is not VCD, but something else */
   } vcdinfo_open_return_t;
 
+  /*!
+    Flags for vcdinfo_open_flags().
+  */
+  typedef enum {
+    VCDINFO_OPEN_FLAG_EAGER = 0x01, /**< Read the extended PSD and LOT,
+                                       SEARCH.DAT and SCANDATA.DAT while
+                                       opening instead of on first use */
+    VCDINFO_OPEN_FLAG_CACHE = 0x02  /**< Set up the sector cache with
+                                       VCDINFO_CACHE_SECTORS and
+                                       VCDINFO_CACHE_READAHEAD before the
+                                       first sector is read */
+  } vcdinfo_open_flag_t;
+
+  /*! Sector cache set up by VCDINFO_OPEN_FLAG_CACHE. */
+#define VCDINFO_CACHE_SECTORS   256
+#define VCDINFO_CACHE_READAHEAD 16
+
   typedef struct
   {
 
@@ -235,6 +267,13 @@ extern "C" {
   const char *
   vcdinfo_pin2str (uint16_t itemid);
 
+  /*!
+    Like vcdinfo_pin2str, but the string goes to buf of len bytes
+    (VCDINFO_STRBUF_SIZE is enough).  Returns buf.
+  */
+  const char *
+  vcdinfo_pin2str_r (uint16_t itemid, char buf[], size_t len);
+
   /*!
     \brief Classify i_itemid into the kind of item it is: track #, entry #,
     segment #.
@@ -282,6 +321,50 @@ extern "C" {
   CdIo_t *
   vcdinfo_get_cd_image (const vcdinfo_obj_t *p_vcdinfo);
 
+  /*!
+    Counters of the sector cache set by vcdinfo_set_sector_cache().
+  */
+  typedef struct {
+    unsigned long int hits;      /* sectors found in the cache */
+    unsigned long int misses;    /* sectors that had to be read */
+    unsigned long int readahead; /* sectors read ahead of the request */
+    unsigned long int reads;     /* reads issued to the medium */
+  } vcdinfo_cache_stats_t;
+
+  /*!
+    Keep up to i_sectors of the sectors read by
+    vcdinfo_read_mode2_sectors() in memory, dropping the least recently
+    used ones first. When a read continues where the previous one
+    ended, i_readahead sectors are fetched at once. 0 sectors turns the
+    cache off again.
+
+    False is returned if p_vcdinfo is NULL.
+  */
+  bool
+  vcdinfo_set_sector_cache (vcdinfo_obj_t *p_vcdinfo, unsigned int i_sectors,
+                            unsigned int i_readahead);
+
+  /*!
+    Read i_blocks mode 2 sectors starting at lsn into p_buf, which must
+    hold i_blocks times M2RAW_SECTOR_SIZE bytes if b_form2 is true and
+    ISO_BLOCKSIZE bytes otherwise. Goes through the sector cache if
+    there is one.
+
+    0 is returned on success, otherwise the error of
+    cdio_read_mode2_sectors().
+  */
+  int
+  vcdinfo_read_mode2_sectors (const vcdinfo_obj_t *p_vcdinfo, void *p_buf,
+                              lsn_t lsn, bool b_form2, unsigned int i_blocks);
+
+  /*!
+    Get the counters of the sector cache into p_stats; they are all 0
+    if there is no cache.
+  */
+  void
+  vcdinfo_get_cache_stats (const vcdinfo_obj_t *p_vcdinfo,
+                           vcdinfo_cache_stats_t *p_stats);
+
   /*!
     Return a string containing the default VCD device if none is specified.
     This might be something like "/dev/cdrom" on Linux or
@@ -792,8 +875,16 @@ extern "C" {
 		   bool ext);
 
   /*!
-    Calls recursive routine to populate obj->offset_list or obj->offset_x_list
-    by going through LOT.
+    Like vcdinfo_ofs2str, but the string goes to buf of len bytes
+    (VCDINFO_STRBUF_SIZE is enough).  Returns buf or a string constant.
+  */
+  const char *
+  vcdinfo_ofs2str_r (const vcdinfo_obj_t *p_vcdinfo, unsigned int offset,
+		     bool ext, char buf[], size_t len);
+
+  /*!
+    Calls vcdinf_visit_pbc() to populate obj->offset_list or
+    obj->offset_x_list by going through LOT.
 
     Returns false if there was some error.
   */
@@ -874,6 +965,18 @@ extern "C" {
   vcdinfo_open(vcdinfo_obj_t **p_obj, char *source_name[],
 	       driver_id_t source_type, const char access_mode[]);
 
+  /*!
+    Like vcdinfo_open(), with i_flags a combination of
+    vcdinfo_open_flag_t values. vcdinfo_open() reads the extended PSD
+    and LOT, SEARCH.DAT and SCANDATA.DAT only when they are first asked
+    for; with VCDINFO_OPEN_FLAG_EAGER they are read right away, and
+    failing to read them makes the open fail.
+  */
+  vcdinfo_open_return_t
+  vcdinfo_open_flags(vcdinfo_obj_t **p_obj, char *source_name[],
+		     driver_id_t source_type, const char access_mode[],
+		     unsigned int i_flags);
+
 
   /*!
     Dispose of any resources associated with the vcdinfo structure.
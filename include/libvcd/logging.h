@@ -76,6 +76,91 @@ typedef void (*vcd_log_handler_t) (vcd_log_level_t level,
 vcd_log_handler_t
 vcd_log_set_handler (vcd_log_handler_t new_handler);
 
+/**
+ * This type defines the signature of a log handler for a single
+ * thread, which gets the user data it was installed with as well.
+ *
+ * @see vcd_log_set_thread_handler
+ */
+typedef void (*vcd_log_thread_handler_t) (vcd_log_level_t level,
+                                          const char message[],
+                                          void *user_data);
+
+/**
+ * Set a log handler for the calling thread only, e.g. one per build
+ * or inspection running in a process.  It takes precedence over the
+ * handler set with vcd_log_set_handler; NULL removes it again.
+ *
+ * Threads the library starts on behalf of a thread (the image writer
+ * threads with output jobs) use that thread's handler too, so it may
+ * get called from several threads at once.  Without compiler support
+ * for thread-local storage the handler is process-wide.
+ *
+ * Thread safety: the process-wide handler is only ever called by one
+ * thread at a time; handlers for single threads are called without
+ * any locking.  vcd_loglevel_default is shared by all threads.  A
+ * handler for a single thread may end it with pthread_exit () on an
+ * error; the library does not return from vcd_error ().
+ *
+ * @param new_handler The new log handler or NULL.
+ * @param user_data   Passed on to the handler.
+ * @return The previous log handler of the calling thread.
+ */
+vcd_log_thread_handler_t
+vcd_log_set_thread_handler (vcd_log_thread_handler_t new_handler,
+                            void *user_data);
+
+/**
+ * Return the log handler of the calling thread and, if user_data is
+ * not NULL, the user data it was installed with.
+ *
+ * @see vcd_log_set_thread_handler
+ */
+vcd_log_thread_handler_t
+vcd_log_get_thread_handler (void **user_data);
+
+/**
+ * Set the lowest log level of the messages to be handled; messages
+ * below it are dropped before they get formatted.  The default is
+ * VCD_LOG_DEBUG, i.e. every message reaches the handler.  With the
+ * default handler, messages below vcd_loglevel_default are dropped
+ * early as well.
+ *
+ * @param level The new threshold.
+ * @return The previous threshold.
+ */
+vcd_log_level_t
+vcd_log_set_threshold (vcd_log_level_t level);
+
+/**
+ * Return whether a message of the given level would reach a handler;
+ * for skipping work needed only for composing the message.  Errors
+ * and assertions always do.
+ */
+bool
+vcd_log_enabled (vcd_log_level_t level);
+
+/**
+ * Pass the messages to the process-wide handler from a background
+ * thread instead, through a queue of queue_size messages; logging then
+ * only waits for the handler if the queue is full.  Errors and
+ * assertions are handled right away, once the queue is empty.
+ * Handlers set with vcd_log_set_handler afterwards get called from the
+ * background thread too.
+ *
+ * @param queue_size Number of messages the queue holds.
+ * @return false if not supported (no threads) or already started.
+ */
+bool
+vcd_log_async_start (unsigned queue_size);
+
+/**
+ * Pass on the queued messages, stop the background thread and go back
+ * to calling the handler directly.
+ */
+void
+vcd_log_async_stop (void);
+
 /**
  * Handle an message with the given log level
  *
@@ -99,6 +184,11 @@ vcd_log (vcd_log_level_t level, const char format[], ...) GNUC_PRINTF(2, 3);
 void
 vcd_debug (const char format[], ...) GNUC_PRINTF(1,2);
 
+#ifdef VCD_NO_DEBUG_LOG
+/* debug messages are compiled out, their arguments not evaluated */
+# define vcd_debug(...) ((void) 0)
+#endif
+
 /**
  * Handle an informative message.
  *
@@ -109,6 +109,11 @@ _vcd_make_mode2 (void *raw_sector, const void *data, uint32_t extent,
 void
 _vcd_make_raw_mode2 (void *raw_sector, const void *data, uint32_t extent);
 
+/* readdresses a sector built by _vcd_make_mode2; neither EDC nor ECC
+   of mode 2 sectors cover the header, so nothing else changes */
+void
+_vcd_set_mode2_address (void *raw_sector, uint32_t extent);
+
 #endif /* _VCD_SECTOR_H_ */
 
 
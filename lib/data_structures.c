@@ -53,43 +53,62 @@ struct _CdioListNode
 
 /* impl */
 
-static bool
-_bubble_sort_iteration (CdioList_t *p_list, _cdio_list_cmp_func_t cmp_func)
+/* stable merge sort of a NULL terminated node chain */
+static CdioListNode_t *
+_merge_sort_nodes (CdioListNode_t *p_head, unsigned length,
+                   _cdio_list_cmp_func_t cmp_func)
 {
-  CdioListNode_t **pp_node;
-  bool changed = false;
-
-  for (pp_node = &(p_list->begin);
-       (*pp_node) != NULL && (*pp_node)->next != NULL;
-       pp_node = &((*pp_node)->next))
-    {
-      CdioListNode_t *p_node = *pp_node;
-
-      if (cmp_func (p_node->data, p_node->next->data) <= 0)
-        continue; /* n <= n->next */
-
-      /* exch n n->next */
-      *pp_node = p_node->next;
-      p_node->next = p_node->next->next;
-      (*pp_node)->next = p_node;
-
-      changed = true;
-
-      if (p_node->next == NULL)
-        p_list->end = p_node;
-    }
-
-  return changed;
+  CdioListNode_t *p_left, *p_right, *p_node, **pp_tail;
+  unsigned n;
+
+  if (length < 2)
+    return p_head;
+
+  /* split after length/2 nodes */
+  p_node = p_head;
+  for (n = 1; n < length / 2; n++)
+    p_node = p_node->next;
+
+  p_right = p_node->next;
+  p_node->next = NULL;
+
+  p_left = _merge_sort_nodes (p_head, length / 2, cmp_func);
+  p_right = _merge_sort_nodes (p_right, length - length / 2, cmp_func);
+
+  /* merge, preferring the left side on equality */
+  pp_tail = &p_head;
+
+  while (p_left && p_right)
+    if (cmp_func (p_left->data, p_right->data) <= 0)
+      {
+        *pp_tail = p_left;
+        pp_tail = &p_left->next;
+        p_left = p_left->next;
+      }
+    else
+      {
+        *pp_tail = p_right;
+        pp_tail = &p_right->next;
+        p_right = p_right->next;
+      }
+
+  *pp_tail = p_left ? p_left : p_right;
+
+  return p_head;
 }
 
 void _vcd_list_sort (CdioList_t *list, _cdio_list_cmp_func_t cmp_func)
 {
-  /* fixme -- this is bubble sort -- worst sorting algo... */
+  CdioListNode_t *p_node;
 
   vcd_assert (list != NULL);
   vcd_assert (cmp_func != 0);
 
-  while (_bubble_sort_iteration (list, cmp_func));
+  list->begin = _merge_sort_nodes (list->begin, list->length, cmp_func);
+
+  for (p_node = list->begin; p_node && p_node->next; p_node = p_node->next);
+
+  list->end = p_node;
 }
 
 /* node ops */
@@ -326,6 +345,192 @@ bool _vcd_tree_node_is_root (VcdTreeNode_t *p_node)
   return (p_node->parent == NULL);
 }
 
+/*
+ * string keyed hash table, chained buckets -- grows with its load
+ */
+
+#define _HASH_MIN_BUCKETS 64
+
+typedef struct _VcdHashEntry VcdHashEntry_t;
+
+struct _VcdHashEntry
+{
+  VcdHashEntry_t *next;
+
+  unsigned hash;
+  char *key;
+  void *data;
+};
+
+struct _VcdHash
+{
+  unsigned length;
+  unsigned nbuckets; /* always a power of 2 */
+
+  VcdHashEntry_t **buckets;
+};
+
+static unsigned
+_hash_str (const char key[])
+{
+  unsigned h = 5381;
+
+  while (*key)
+    h = (h << 5) + h + (unsigned char) *key++;
+
+  return h;
+}
+
+static void
+_hash_resize (VcdHash_t *p_hash, unsigned nbuckets)
+{
+  VcdHashEntry_t **buckets = calloc (nbuckets, sizeof (VcdHashEntry_t *));
+  unsigned n;
+
+  for (n = 0; n < p_hash->nbuckets; n++)
+    {
+      VcdHashEntry_t *p_entry = p_hash->buckets[n];
+
+      while (p_entry)
+        {
+          VcdHashEntry_t *p_next = p_entry->next;
+          const unsigned idx = p_entry->hash & (nbuckets - 1);
+
+          p_entry->next = buckets[idx];
+          buckets[idx] = p_entry;
+
+          p_entry = p_next;
+        }
+    }
+
+  free (p_hash->buckets);
+
+  p_hash->buckets = buckets;
+  p_hash->nbuckets = nbuckets;
+}
+
+static VcdHashEntry_t **
+_hash_find (const VcdHash_t *p_hash, const char key[], unsigned hash)
+{
+  VcdHashEntry_t **pp_entry = &p_hash->buckets[hash & (p_hash->nbuckets - 1)];
+
+  for (; *pp_entry; pp_entry = &(*pp_entry)->next)
+    if ((*pp_entry)->hash == hash && !strcmp ((*pp_entry)->key, key))
+      break;
+
+  return pp_entry;
+}
+
+VcdHash_t *
+_vcd_hash_new (void)
+{
+  VcdHash_t *p_new_hash = calloc (1, sizeof (VcdHash_t));
+
+  _hash_resize (p_new_hash, _HASH_MIN_BUCKETS);
+
+  return p_new_hash;
+}
+
+void
+_vcd_hash_destroy (VcdHash_t *p_hash, bool free_data)
+{
+  unsigned n;
+
+  if (!p_hash)
+    return;
+
+  for (n = 0; n < p_hash->nbuckets; n++)
+    {
+      VcdHashEntry_t *p_entry = p_hash->buckets[n];
+
+      while (p_entry)
+        {
+          VcdHashEntry_t *p_next = p_entry->next;
+
+          if (free_data)
+            free (p_entry->data);
+          free (p_entry->key);
+          free (p_entry);
+
+          p_entry = p_next;
+        }
+    }
+
+  free (p_hash->buckets);
+  free (p_hash);
+}
+
+unsigned
+_vcd_hash_length (const VcdHash_t *p_hash)
+{
+  vcd_assert (p_hash != NULL);
+
+  return p_hash->length;
+}
+
+bool
+_vcd_hash_insert (VcdHash_t *p_hash, const char key[], void *p_data)
+{
+  const unsigned hash = _hash_str (key);
+  VcdHashEntry_t **pp_entry;
+
+  vcd_assert (p_hash != NULL);
+  vcd_assert (key != NULL);
+
+  pp_entry = _hash_find (p_hash, key, hash);
+
+  if (*pp_entry) /* key exists already */
+    return false;
+
+  *pp_entry = calloc (1, sizeof (VcdHashEntry_t));
+  (*pp_entry)->hash = hash;
+  (*pp_entry)->key = strdup (key);
+  (*pp_entry)->data = p_data;
+
+  if (++p_hash->length > p_hash->nbuckets)
+    _hash_resize (p_hash, p_hash->nbuckets << 1);
+
+  return true;
+}
+
+void *
+_vcd_hash_lookup (const VcdHash_t *p_hash, const char key[])
+{
+  VcdHashEntry_t **pp_entry;
+
+  vcd_assert (p_hash != NULL);
+  vcd_assert (key != NULL);
+
+  pp_entry = _hash_find (p_hash, key, _hash_str (key));
+
+  return *pp_entry ? (*pp_entry)->data : NULL;
+}
+
+void *
+_vcd_hash_remove (VcdHash_t *p_hash, const char key[])
+{
+  VcdHashEntry_t **pp_entry, *p_entry;
+  void *p_data;
+
+  vcd_assert (p_hash != NULL);
+  vcd_assert (key != NULL);
+
+  pp_entry = _hash_find (p_hash, key, _hash_str (key));
+
+  if (!(p_entry = *pp_entry))
+    return NULL;
+
+  *pp_entry = p_entry->next;
+  p_hash->length--;
+
+  p_data = p_entry->data;
+
+  free (p_entry->key);
+  free (p_entry);
+
+  return p_data;
+}
+
 /* eof */
 
 
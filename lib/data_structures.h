@@ -80,6 +80,24 @@ _vcd_tree_node_traverse_bf (VcdTreeNode_t *p_node,
                             _vcd_tree_node_traversal_func trav_func,
                             void *p_user_data);
 
+/* string keyed hash table; keys are copied, data is not owned */
+
+typedef struct _VcdHash VcdHash_t;
+
+VcdHash_t *_vcd_hash_new (void);
+
+void _vcd_hash_destroy (VcdHash_t *p_hash, bool free_data);
+
+unsigned _vcd_hash_length (const VcdHash_t *p_hash);
+
+/* returns false (and inserts nothing) if key is present already */
+bool _vcd_hash_insert (VcdHash_t *p_hash, const char key[], void *p_data);
+
+void *_vcd_hash_lookup (const VcdHash_t *p_hash, const char key[]);
+
+/* returns data of removed entry, or NULL if key was not found */
+void *_vcd_hash_remove (VcdHash_t *p_hash, const char key[]);
+
 #endif /* __VCD_DATA_STRUCTURES_H__ */
 
 /*
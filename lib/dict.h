@@ -38,6 +38,42 @@ struct _dict_t
   uint8_t flags;
 };
 
+static void
+_dict_map_invalidate (VcdObj_t *obj)
+{
+  free (obj->buffer_dict_map);
+  obj->buffer_dict_map = NULL;
+  obj->buffer_dict_map_len = 0;
+}
+
+static void
+_dict_map_build (VcdObj_t *obj)
+{
+  CdioListNode_t *node;
+  uint32_t len = 0;
+
+  _CDIO_LIST_FOREACH (node, obj->buffer_dict_list)
+    {
+      struct _dict_t *p = _cdio_list_node_data (node);
+
+      len = MAX (len, p->sector + p->length);
+    }
+
+  obj->buffer_dict_map = calloc(MAX (len, 1), sizeof (struct _dict_t *));
+  obj->buffer_dict_map_len = len;
+
+  /* on overlaps the most recently inserted entry wins, as before */
+  _CDIO_LIST_FOREACH (node, obj->buffer_dict_list)
+    {
+      struct _dict_t *p = _cdio_list_node_data (node);
+      uint32_t n;
+
+      for (n = p->sector; n < p->sector + p->length; n++)
+        if (!obj->buffer_dict_map[n])
+          obj->buffer_dict_map[n] = p;
+    }
+}
+
 static void
 _dict_insert (VcdObj_t *obj, const char key[], uint32_t sector, uint32_t length,
               uint8_t end_flags)
@@ -59,6 +95,8 @@ _dict_insert (VcdObj_t *obj, const char key[], uint32_t sector, uint32_t length,
   _new_node->flags = end_flags;
 
   _cdio_list_prepend (obj->buffer_dict_list, _new_node);
+
+  _dict_map_invalidate (obj);
 }
 
 static
@@ -70,15 +108,6 @@ int _dict_key_cmp (struct _dict_t *a, char *b)
   return !strcmp (a->key, b);
 }
 
-static
-int _dict_sector_cmp (struct _dict_t *a, uint32_t *b)
-{
-  vcd_assert (a != NULL);
-  vcd_assert (b != NULL);
-
-  return (a->sector <= *b && (*b - a->sector) < a->length);
-}
-
 static const struct _dict_t *
 _dict_get_bykey (VcdObj_t *obj, const char key[])
 {
@@ -100,17 +129,14 @@ _dict_get_bykey (VcdObj_t *obj, const char key[])
 static const struct _dict_t *
 _dict_get_bysector (VcdObj_t *obj, uint32_t sector)
 {
-  CdioListNode_t *node;
-
   vcd_assert (obj != NULL);
   vcd_assert (sector != SECTOR_NIL);
 
-  node = _cdio_list_find (obj->buffer_dict_list,
-			  (_cdio_list_iterfunc_t) _dict_sector_cmp,
-			  &sector);
+  if (!obj->buffer_dict_map)
+    _dict_map_build (obj);
 
-  if (node)
-    return _cdio_list_node_data (node);
+  if (sector < obj->buffer_dict_map_len)
+    return obj->buffer_dict_map[sector];
 
   return NULL;
 }
@@ -160,6 +186,8 @@ _dict_clean (VcdObj_t *obj)
 
       _cdio_list_node_free (node, true, NULL);
     }
+
+  _dict_map_invalidate (obj);
 }
 
 #endif /* __VCD_DICT_H__ */
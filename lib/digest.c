@@ -0,0 +1,354 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <string.h>
+
+/* We don't want to pull in cdio's config */
+#define __CDIO_CONFIG_H__
+#include <cdio/util.h>
+
+/* Private headers */
+#include "digest.h"
+
+#define ROL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+/*
+ * MD5 (RFC 1321)
+ */
+
+static const uint32_t _md5_k[64] = {
+  0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
+  0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+  0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+  0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+  0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
+  0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+  0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+  0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+  0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+  0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+  0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
+  0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+  0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
+  0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+  0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+  0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const uint8_t _md5_r[64] = {
+  7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+  5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+  4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+  6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+static void
+_md5_block (VcdMd5_t *ctx, const uint8_t block[64])
+{
+  uint32_t w[16], a, b, c, d;
+  unsigned i;
+
+  for (i = 0; i < 16; i++)
+    w[i] = (uint32_t) block[i * 4]
+      | ((uint32_t) block[i * 4 + 1] << 8)
+      | ((uint32_t) block[i * 4 + 2] << 16)
+      | ((uint32_t) block[i * 4 + 3] << 24);
+
+  a = ctx->state[0];
+  b = ctx->state[1];
+  c = ctx->state[2];
+  d = ctx->state[3];
+
+  for (i = 0; i < 64; i++)
+    {
+      uint32_t f, tmp;
+      unsigned g;
+
+      switch (i / 16)
+        {
+        case 0:
+          f = (b & c) | (~b & d);
+          g = i;
+          break;
+        case 1:
+          f = (d & b) | (~d & c);
+          g = (5 * i + 1) % 16;
+          break;
+        case 2:
+          f = b ^ c ^ d;
+          g = (3 * i + 5) % 16;
+          break;
+        default:
+          f = c ^ (b | ~d);
+          g = (7 * i) % 16;
+          break;
+        }
+
+      tmp = d;
+      d = c;
+      c = b;
+      b += ROL32 (a + f + _md5_k[i] + w[g], _md5_r[i]);
+      a = tmp;
+    }
+
+  ctx->state[0] += a;
+  ctx->state[1] += b;
+  ctx->state[2] += c;
+  ctx->state[3] += d;
+}
+
+void
+_vcd_md5_init (VcdMd5_t *ctx)
+{
+  ctx->state[0] = 0x67452301;
+  ctx->state[1] = 0xefcdab89;
+  ctx->state[2] = 0x98badcfe;
+  ctx->state[3] = 0x10325476;
+  ctx->count = 0;
+}
+
+void
+_vcd_md5_update (VcdMd5_t *ctx, const void *data, size_t len)
+{
+  const uint8_t *p = data;
+  unsigned fill = ctx->count % 64;
+
+  ctx->count += len;
+
+  if (fill)
+    {
+      const unsigned n = MIN (len, 64 - fill);
+
+      memcpy (ctx->buf + fill, p, n);
+      p += n;
+      len -= n;
+
+      if (fill + n < 64)
+        return;
+
+      _md5_block (ctx, ctx->buf);
+    }
+
+  for (; len >= 64; p += 64, len -= 64)
+    _md5_block (ctx, p);
+
+  memcpy (ctx->buf, p, len);
+}
+
+void
+_vcd_md5_final (VcdMd5_t *ctx, uint8_t digest[MD5_DIGEST_SIZE])
+{
+  static const uint8_t pad[64] = { 0x80, };
+  const uint64_t bits = ctx->count * 8;
+  uint8_t len[8];
+  unsigned i;
+
+  for (i = 0; i < 8; i++)
+    len[i] = bits >> (i * 8);
+
+  _vcd_md5_update (ctx, pad, 1 + (119 - ctx->count % 64) % 64);
+  _vcd_md5_update (ctx, len, 8);
+
+  for (i = 0; i < MD5_DIGEST_SIZE; i++)
+    digest[i] = ctx->state[i / 4] >> ((i % 4) * 8);
+}
+
+/*
+ * SHA-256 (FIPS 180-2)
+ */
+
+static const uint32_t _sha256_k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+  0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+  0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+  0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static void
+_sha256_block (VcdSha256_t *ctx, const uint8_t block[64])
+{
+  uint32_t w[64], s[8];
+  unsigned i;
+
+  for (i = 0; i < 16; i++)
+    w[i] = ((uint32_t) block[i * 4] << 24)
+      | ((uint32_t) block[i * 4 + 1] << 16)
+      | ((uint32_t) block[i * 4 + 2] << 8)
+      | (uint32_t) block[i * 4 + 3];
+
+  for (; i < 64; i++)
+    {
+      const uint32_t s0 =
+        ROR32 (w[i - 15], 7) ^ ROR32 (w[i - 15], 18) ^ (w[i - 15] >> 3);
+      const uint32_t s1 =
+        ROR32 (w[i - 2], 17) ^ ROR32 (w[i - 2], 19) ^ (w[i - 2] >> 10);
+
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+  memcpy (s, ctx->state, sizeof (s));
+
+  for (i = 0; i < 64; i++)
+    {
+      const uint32_t S1 = ROR32 (s[4], 6) ^ ROR32 (s[4], 11) ^ ROR32 (s[4], 25);
+      const uint32_t ch = (s[4] & s[5]) ^ (~s[4] & s[6]);
+      const uint32_t t1 = s[7] + S1 + ch + _sha256_k[i] + w[i];
+      const uint32_t S0 = ROR32 (s[0], 2) ^ ROR32 (s[0], 13) ^ ROR32 (s[0], 22);
+      const uint32_t maj = (s[0] & s[1]) ^ (s[0] & s[2]) ^ (s[1] & s[2]);
+      const uint32_t t2 = S0 + maj;
+
+      s[7] = s[6];
+      s[6] = s[5];
+      s[5] = s[4];
+      s[4] = s[3] + t1;
+      s[3] = s[2];
+      s[2] = s[1];
+      s[1] = s[0];
+      s[0] = t1 + t2;
+    }
+
+  for (i = 0; i < 8; i++)
+    ctx->state[i] += s[i];
+}
+
+void
+_vcd_sha256_init (VcdSha256_t *ctx)
+{
+  static const uint32_t _init[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+
+  memcpy (ctx->state, _init, sizeof (_init));
+  ctx->count = 0;
+}
+
+void
+_vcd_sha256_update (VcdSha256_t *ctx, const void *data, size_t len)
+{
+  const uint8_t *p = data;
+  unsigned fill = ctx->count % 64;
+
+  ctx->count += len;
+
+  if (fill)
+    {
+      const unsigned n = MIN (len, 64 - fill);
+
+      memcpy (ctx->buf + fill, p, n);
+      p += n;
+      len -= n;
+
+      if (fill + n < 64)
+        return;
+
+      _sha256_block (ctx, ctx->buf);
+    }
+
+  for (; len >= 64; p += 64, len -= 64)
+    _sha256_block (ctx, p);
+
+  memcpy (ctx->buf, p, len);
+}
+
+void
+_vcd_sha256_final (VcdSha256_t *ctx, uint8_t digest[SHA256_DIGEST_SIZE])
+{
+  static const uint8_t pad[64] = { 0x80, };
+  const uint64_t bits = ctx->count * 8;
+  uint8_t len[8];
+  unsigned i;
+
+  for (i = 0; i < 8; i++)
+    len[i] = bits >> ((7 - i) * 8);
+
+  _vcd_sha256_update (ctx, pad, 1 + (119 - ctx->count % 64) % 64);
+  _vcd_sha256_update (ctx, len, 8);
+
+  for (i = 0; i < SHA256_DIGEST_SIZE; i++)
+    digest[i] = ctx->state[i / 4] >> ((3 - i % 4) * 8);
+}
+
+/*
+ * CRC32 (reflected polynomial 0xedb88320), half a byte at a time
+ */
+
+static const uint32_t _crc32_tab[16] = {
+  0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+  0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+  0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+  0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+};
+
+uint32_t
+_vcd_crc32 (uint32_t crc, const void *data, size_t len)
+{
+  const uint8_t *p = data;
+
+  crc = ~crc;
+
+  while (len--)
+    {
+      crc ^= *p++;
+      crc = (crc >> 4) ^ _crc32_tab[crc & 0xf];
+      crc = (crc >> 4) ^ _crc32_tab[crc & 0xf];
+    }
+
+  return ~crc;
+}
+
+char *
+_vcd_digest_to_hex (char buf[], const uint8_t digest[], size_t len)
+{
+  static const char _hex[] = "0123456789abcdef";
+  size_t i;
+
+  for (i = 0; i < len; i++)
+    {
+      buf[i * 2] = _hex[digest[i] >> 4];
+      buf[i * 2 + 1] = _hex[digest[i] & 0xf];
+    }
+
+  buf[len * 2] = '\0';
+
+  return buf;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,76 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* message digests (MD5, SHA-256) and CRC32 */
+
+#ifndef _DIGEST_H_
+#define _DIGEST_H_
+
+#include <stddef.h>
+#include <libvcd/types.h>
+
+#define MD5_DIGEST_SIZE    16
+#define SHA256_DIGEST_SIZE 32
+
+typedef struct {
+  uint32_t state[4];
+  uint64_t count; /* bytes */
+  uint8_t buf[64];
+} VcdMd5_t;
+
+typedef struct {
+  uint32_t state[8];
+  uint64_t count; /* bytes */
+  uint8_t buf[64];
+} VcdSha256_t;
+
+void
+_vcd_md5_init (VcdMd5_t *ctx);
+
+void
+_vcd_md5_update (VcdMd5_t *ctx, const void *data, size_t len);
+
+void
+_vcd_md5_final (VcdMd5_t *ctx, uint8_t digest[MD5_DIGEST_SIZE]);
+
+void
+_vcd_sha256_init (VcdSha256_t *ctx);
+
+void
+_vcd_sha256_update (VcdSha256_t *ctx, const void *data, size_t len);
+
+void
+_vcd_sha256_final (VcdSha256_t *ctx, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+/* IEEE 802.3 CRC32 as used by zip and cksfv; start with crc = 0 */
+uint32_t
+_vcd_crc32 (uint32_t crc, const void *data, size_t len);
+
+/* writes len bytes as lowercase hex into buf, which must have room
+   for 2 * len + 1 characters */
+char *
+_vcd_digest_to_hex (char buf[], const uint8_t digest[], size_t len);
+
+#endif /* _DIGEST_H_ */
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -47,6 +47,8 @@ typedef struct
   uint32_t extent;
   uint32_t size;
   unsigned pt_id;
+  VcdHash_t *children; /* directories only; name -> VcdDirNode_t */
+  bool sorted; /* children are in ISO9660 order */
 } data_t;
 
 typedef VcdTreeNode_t VcdDirNode_t;
@@ -187,6 +189,8 @@ _vcd_directory_new (void)
   data->name = _vcd_memdup("\0", 2);
   data->xa_attributes = XA_FORM1_DIR;
   data->xa_filenum = 0x00;
+  data->children = _vcd_hash_new ();
+  data->sorted = true;
 
   return dir;
 }
@@ -197,6 +201,7 @@ traverse_vcd_directory_done (VcdDirNode_t *node, void *data)
   data_t *dirdata = DATAP (node);
 
   free (dirdata->name);
+  _vcd_hash_destroy (dirdata->children, false);
 }
 
 void
@@ -213,17 +218,12 @@ _vcd_directory_destroy (VcdDirectory_t *dir)
 static VcdDirNode_t *
 lookup_child (VcdDirNode_t *node, const char name[])
 {
-  VcdDirNode_t *child;
-
-  _VCD_CHILD_FOREACH (child, node)
-    {
-      data_t *d = DATAP(child);
+  data_t *d = DATAP(node);
 
-      if (!strcmp (d->name, name))
-        return child;
-    }
+  if (!d->children)
+    return NULL;
 
-  return child; /* NULL */
+  return _vcd_hash_lookup (d->children, name);
 }
 
 static int
@@ -238,49 +238,135 @@ _iso_dir_cmp (VcdDirNode_t *node1, VcdDirNode_t *node2)
   return result;
 }
 
+static void
+traverse_sort_children (VcdDirNode_t *node, void *data)
+{
+  data_t *d = DATAP(node);
+
+  if (d->is_dir && !d->sorted)
+    {
+      _vcd_tree_node_sort_children (node, _iso_dir_cmp);
+      d->sorted = true;
+    }
+}
+
+/* children get sorted only once all entries are known */
+static void
+sort_children (VcdDirectory_t *dir)
+{
+  _vcd_tree_node_traverse (_vcd_tree_root (dir), traverse_sort_children,
+                           NULL);
+}
+
+static VcdDirNode_t *
+append_child (VcdDirNode_t *pdir, data_t *data)
+{
+  VcdDirNode_t *node = _vcd_tree_node_append_child (pdir, data);
+
+  if (!_vcd_hash_insert (DATAP(pdir)->children, data->name, node))
+    vcd_assert_not_reached ();
+
+  DATAP(pdir)->sorted = false;
+
+  return node;
+}
+
+static data_t *
+new_dir_data (const char name[])
+{
+  data_t *data = calloc(1, sizeof (data_t));
+
+  data->is_dir = true;
+  data->name = strdup (name);
+  data->xa_attributes = XA_FORM1_DIR;
+  data->xa_filenum = 0x00;
+  data->children = _vcd_hash_new ();
+  data->sorted = true;
+
+  return data;
+}
+
+/* walks down to the directory containing the last component of path,
+   which gets returned in *pp_name; path is used as scratch buffer */
+static VcdDirNode_t *
+lookup_parent (VcdDirectory_t *dir, char path[], const char pathname[],
+               bool autocreate, char **pp_name)
+{
+  VcdDirNode_t *pdir = _vcd_tree_root (dir);
+  char *name = path, *sep;
+  size_t len = strlen (path);
+
+  /* empty components are ignored, just like _vcd_strsplit() does */
+  while (len > 0 && path[len - 1] == '/')
+    path[--len] = '\0';
+
+  while ((sep = strchr (name, '/')))
+    {
+      VcdDirNode_t *child;
+
+      if (sep == name)
+        {
+          name++;
+          continue;
+        }
+
+      *sep = '\0';
+
+      if (!(child = lookup_child (pdir, name)))
+        {
+          if (!autocreate)
+            {
+              vcd_error ("mkdir: parent dir `%s' for `%s' missing!",
+                         path, pathname);
+              return NULL;
+            }
+
+          vcd_info ("autocreating directory `%s' for file `%s'",
+                    path, pathname);
+
+          child = append_child (pdir, new_dir_data (name));
+        }
+      else if (!DATAP(child)->is_dir)
+        {
+          vcd_error ("`%s' not a directory", path);
+          return NULL;
+        }
+
+      *sep = '/';
+      pdir = child;
+      name = sep + 1;
+    }
+
+  vcd_assert (*name != '\0');
+
+  *pp_name = name;
+
+  return pdir;
+}
+
 int
 _vcd_directory_mkdir (VcdDirectory_t *dir, const char pathname[])
 {
-  char **splitpath;
-  unsigned level, n;
-  VcdDirNode_t *pdir = _vcd_tree_root (dir);
+  char *path, *name;
+  VcdDirNode_t *pdir;
 
   vcd_assert (dir != NULL);
   vcd_assert (pathname != NULL);
 
-  splitpath = _vcd_strsplit (pathname, '/');
-
-  level = _vcd_strlenv (splitpath);
+  path = strdup (pathname);
 
-  for (n = 0; n < level-1; n++)
-    if (!(pdir = lookup_child(pdir, splitpath[n])))
-      {
-        vcd_error("mkdir: parent dir `%s' (level=%d) for `%s' missing!",
-                  splitpath[n], n, pathname);
-        vcd_assert_not_reached ();
-      }
+  if (!(pdir = lookup_parent (dir, path, pathname, false, &name)))
+    vcd_assert_not_reached ();
 
-  if (lookup_child (pdir, splitpath[level-1]))
+  if (lookup_child (pdir, name))
     {
       vcd_error ("mkdir: `%s' already exists", pathname);
       vcd_assert_not_reached ();
     }
 
-  {
-    data_t *data = calloc(1, sizeof (data_t));
+  append_child (pdir, new_dir_data (name));
 
-    _vcd_tree_node_append_child (pdir, data);
-
-    data->is_dir = true;
-    data->name = strdup(splitpath[level-1]);
-    data->xa_attributes = XA_FORM1_DIR;
-    data->xa_filenum = 0x00;
-    /* .. */
-  }
-
-  _vcd_tree_node_sort_children (pdir, _iso_dir_cmp);
-
-  _vcd_strfreev (splitpath);
+  free (path);
 
   return 0;
 }
@@ -290,8 +376,7 @@ _vcd_directory_mkfile (VcdDirectory_t *dir, const char pathname[],
                        uint32_t start, uint32_t size,
                        bool form2_flag, uint8_t filenum)
 {
-  char **splitpath;
-  unsigned level, n;
+  char *path, *name;
   const int file_version = 1;
 
   VcdDirNode_t *pdir = NULL;
@@ -299,67 +384,37 @@ _vcd_directory_mkfile (VcdDirectory_t *dir, const char pathname[],
   vcd_assert (dir != NULL);
   vcd_assert (pathname != NULL);
 
-  splitpath = _vcd_strsplit (pathname, '/');
-
-  level = _vcd_strlenv (splitpath);
+  path = strdup (pathname);
 
-  while (!pdir)
+  if (!(pdir = lookup_parent (dir, path, pathname, true, &name)))
     {
-      pdir = _vcd_tree_root (dir);
-
-      for (n = 0; n < level-1; n++)
-        if (!(pdir = lookup_child (pdir, splitpath[n])))
-          {
-            char *newdir = _vcd_strjoin (splitpath, n+1, "/");
-
-            vcd_info ("autocreating directory `%s' for file `%s'",
-                      newdir, pathname);
-
-            _vcd_directory_mkdir (dir, newdir);
-
-            free (newdir);
-
-            vcd_assert (pdir == NULL);
-
-            break;
-          }
-        else if (!DATAP(pdir)->is_dir)
-          {
-            char *newdir = _vcd_strjoin (splitpath, n+1, "/");
-
-            vcd_error ("mkfile: `%s' not a directory", newdir);
-
-            free (newdir);
-
-            return -1;
-          }
-
+      free (path);
+      return -1;
     }
 
-  if (lookup_child (pdir, splitpath[level-1]))
+  if (lookup_child (pdir, name))
     {
       vcd_error ("mkfile: `%s' already exists", pathname);
+      free (path);
       return -1;
     }
 
   {
     data_t *data = calloc(1, sizeof (data_t));
 
-    _vcd_tree_node_append_child (pdir, data);
-
     data->is_dir = false;
-    data->name = strdup (splitpath[level-1]);
+    data->name = strdup (name);
     data->version = file_version;
     data->xa_attributes = form2_flag ? XA_FORM2_FILE : XA_FORM1_FILE;
     data->xa_filenum = filenum;
     data->size = size;
     data->extent = start;
     /* .. */
-  }
 
-  _vcd_tree_node_sort_children (pdir, _iso_dir_cmp);
+    append_child (pdir, data);
+  }
 
-  _vcd_strfreev (splitpath);
+  free (path);
 
   return 0;
 }
@@ -369,6 +424,7 @@ _vcd_directory_get_size (VcdDirectory_t *dir)
 {
   vcd_assert (dir != NULL);
 
+  sort_children (dir);
   update_sizes (dir);
   return get_dirsizes (_vcd_tree_root (dir));
 }
@@ -426,6 +482,7 @@ _vcd_directory_dump_entries (VcdDirectory_t *dir, void *buf, uint32_t extent)
 {
   vcd_assert (dir != NULL);
 
+  sort_children (dir);
   update_sizes (dir); /* better call it one time more than one less */
   update_dirextents (dir, extent);
 
@@ -482,6 +539,8 @@ _vcd_directory_dump_pathtables (VcdDirectory_t *dir, void *ptl, void *ptm)
 
   vcd_assert (dir != NULL);
 
+  sort_children (dir);
+
   iso9660_pathtable_init (ptl);
   iso9660_pathtable_init (ptm);
 
@@ -56,6 +56,7 @@ typedef struct {
   char *bin_fname;
   char *cue_fname;
 
+  bool update_flag; /* bin file holds an image to be partly replaced */
   bool init;
 } _img_bincue_snk_t;
 
@@ -65,7 +66,9 @@ _sink_init (_img_bincue_snk_t *_obj)
   if (_obj->init)
     return;
 
-  if (!(_obj->bin_snk = vcd_data_sink_new_stdio (_obj->bin_fname)))
+  if (!(_obj->bin_snk = (_obj->update_flag
+                         ? vcd_data_sink_new_stdio_update (_obj->bin_fname)
+                         : vcd_data_sink_new_stdio (_obj->bin_fname))))
     vcd_error ("init failed");
 
   if (!(_obj->cue_snk = vcd_data_sink_new_stdio (_obj->cue_fname)))
@@ -79,8 +82,11 @@ _sink_free (void *user_data)
 {
   _img_bincue_snk_t *_obj = user_data;
 
-  vcd_data_sink_destroy (_obj->bin_snk);
-  vcd_data_sink_destroy (_obj->cue_snk);
+  /* created with the cue sheet, so not there if it wasn't set */
+  if (_obj->bin_snk)
+    vcd_data_sink_destroy (_obj->bin_snk);
+  if (_obj->cue_snk)
+    vcd_data_sink_destroy (_obj->cue_snk);
   free (_obj->bin_fname);
   free (_obj->cue_fname);
   free (_obj);
@@ -230,6 +236,17 @@ _sink_set_arg (void *user_data, const char key[], const char value[])
       else
 	return -2;
     }
+  else if (!strcmp (key, "update"))
+    {
+      if (!value)
+	return -2;
+      else if (!strcmp (value, "true"))
+	_obj->update_flag = true;
+      else if (!strcmp (value, "false"))
+	_obj->update_flag = false;
+      else
+	return -2;
+    }
   else
     return -1;
 
@@ -46,18 +46,33 @@
  * writer
  */
 
+/* a track (or pregap) image file currently open for writing */
+typedef struct {
+  int track_idx;
+  bool pregap;
+  uint32_t sectors_left; /* closed as soon as this drops to zero */
+  VcdDataSink *bin_snk;
+} _img_cdrdao_file_t;
+
 typedef struct {
   bool sector_2336_flag;
   char *toc_fname;
   char *img_base;
 
-  VcdDataSink *last_bin_snk;
-  int last_snk_idx;
-  bool last_pause;
+  /* tracks may be written in any order, hence more than one file
+     can be open at a time */
+  CdioList_t *bin_file_list; /* _img_cdrdao_file_t */
 
   CdioList_t *vcd_cue_list;
 } _img_cdrdao_snk_t;
 
+static void
+_file_free (_img_cdrdao_file_t *_file)
+{
+  vcd_data_sink_destroy (_file->bin_snk);
+  free (_file);
+}
+
 static void
 _sink_free (void *user_data)
 {
@@ -65,7 +80,7 @@ _sink_free (void *user_data)
 
   /* fixme -- destroy cue list */
 
-  vcd_data_sink_destroy (_obj->last_bin_snk);
+  _cdio_list_free (_obj->bin_file_list, true, (CdioDataFree_t) _file_free);
   free (_obj->toc_fname);
   free (_obj->img_base);
   free (_obj);
@@ -174,12 +189,14 @@ _vcd_image_cdrdao_write (void *user_data, const void *data, lsn_t lsn)
 {
   const char *buf = data;
   _img_cdrdao_snk_t *_obj = user_data;
+  _img_cdrdao_file_t *_file = NULL;
   long offset;
 
   {
     CdioListNode_t *node;
     uint32_t _last = 0;
     uint32_t _ofs = 0;
+    uint32_t _end = 0;
     bool _lpregap = false;
     bool _pregap = false;
 
@@ -198,6 +215,7 @@ _vcd_image_cdrdao_write (void *user_data, const void *data, lsn_t lsn)
 		vcd_assert (in_track == 0);
 		in_track = num;
 		_ofs = _last;
+		_end = _cue->lsn;
 		_pregap = _lpregap;
 	      }
 
@@ -215,15 +233,21 @@ _vcd_image_cdrdao_write (void *user_data, const void *data, lsn_t lsn)
       }
 
     vcd_assert (in_track != 0);
-    vcd_assert (_obj->last_snk_idx <= in_track);
 
-    if (_obj->last_snk_idx != in_track
-	|| _obj->last_pause != _pregap)
+    _CDIO_LIST_FOREACH (node, _obj->bin_file_list)
       {
-	char buf[4096] = { 0, };
+	_img_cdrdao_file_t *_f = _cdio_list_node_data (node);
 
-	if (_obj->last_bin_snk)
-	  vcd_data_sink_destroy (_obj->last_bin_snk);
+	if (_f->track_idx == in_track && _f->pregap == _pregap)
+	  {
+	    _file = _f;
+	    break;
+	  }
+      }
+
+    if (!_file)
+      {
+	char buf[4096] = { 0, };
 
 	snprintf (buf, sizeof (buf),
 		  "%s_%.2d%s.img",
@@ -231,9 +255,13 @@ _vcd_image_cdrdao_write (void *user_data, const void *data, lsn_t lsn)
 		  (_pregap ? in_track + 1 : in_track),
 		  (_pregap ? "_pregap" : ""));
 
-	_obj->last_bin_snk = vcd_data_sink_new_stdio (buf);
-	_obj->last_snk_idx = in_track;
-	_obj->last_pause = _pregap;
+	_file = calloc(1, sizeof (_img_cdrdao_file_t));
+	_file->track_idx = in_track;
+	_file->pregap = _pregap;
+	_file->sectors_left = _end - _ofs;
+	_file->bin_snk = vcd_data_sink_new_stdio (buf);
+
+	_cdio_list_append (_obj->bin_file_list, _file);
       }
 
     vcd_assert (lsn >= _ofs);
@@ -242,12 +270,27 @@ _vcd_image_cdrdao_write (void *user_data, const void *data, lsn_t lsn)
 
   offset *= _obj->sector_2336_flag ? M2RAW_SECTOR_SIZE : CDIO_CD_FRAMESIZE_RAW;
 
-  vcd_data_sink_seek(_obj->last_bin_snk, offset);
+  vcd_data_sink_seek(_file->bin_snk, offset);
 
   if (_obj->sector_2336_flag)
-    vcd_data_sink_write(_obj->last_bin_snk, buf + 12 + 4, M2RAW_SECTOR_SIZE, 1);
+    vcd_data_sink_write(_file->bin_snk, buf + 12 + 4, M2RAW_SECTOR_SIZE, 1);
   else
-    vcd_data_sink_write(_obj->last_bin_snk, buf, CDIO_CD_FRAMESIZE_RAW, 1);
+    vcd_data_sink_write(_file->bin_snk, buf, CDIO_CD_FRAMESIZE_RAW, 1);
+
+  if (_file->sectors_left)
+    _file->sectors_left--;
+
+  if (!_file->sectors_left)
+    {
+      CdioListNode_t *node;
+
+      _CDIO_LIST_FOREACH (node, _obj->bin_file_list)
+	if (_cdio_list_node_data (node) == _file)
+	  {
+	    _cdio_list_node_free (node, true, (CdioDataFree_t) _file_free);
+	    break;
+	  }
+    }
 
   return 0;
 }
@@ -306,6 +349,7 @@ vcd_image_sink_new_cdrdao (void)
 
   _data->toc_fname = strdup ("videocd.toc");
   _data->img_base = strdup ("videocd");
+  _data->bin_file_list = _cdio_list_new ();
 
   return vcd_image_sink_new (_data, &_funcs);
 }
@@ -0,0 +1,360 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* We don't want to pull in cdio's config */
+#define __CDIO_CONFIG_H__
+#include <cdio/cdio.h>
+
+/* Public headers */
+#include <libvcd/sector.h>
+#include <libvcd/logging.h>
+
+/* Private headers */
+#include "vcd_assert.h"
+#include "digest.h"
+#include "image_sink.h"
+#include "stream_stdio.h"
+
+/****************************************************************************
+ * writer -- computes MD5 and SHA-256 of the whole image and a CRC32 of
+ * each track while the sectors pass through on their way to another
+ * sink, or to nowhere at all
+ */
+
+typedef struct {
+  lsn_t start_lsn;
+  lsn_t end_lsn; /* next pregap or lead-out */
+  uint32_t crc;
+} _track_digest_t;
+
+typedef struct {
+  VcdImageSink_t *sink; /* NULL if nothing gets written */
+
+  bool sector_2336_flag;
+  bool xml_flag;
+  char *digest_fname;
+
+  VcdMd5_t md5;
+  VcdSha256_t sha256;
+
+  _track_digest_t *tracks;
+  unsigned track_count;
+  unsigned cur_track;
+
+  lsn_t next_lsn;
+  lsn_t end_lsn;
+
+  /* sectors written ahead of next_lsn (with parallel writing), keyed
+     by lsn; the writer keeps these within a window of a few thousand
+     sectors */
+  VcdHash_t *pending;
+} _img_digest_snk_t;
+
+static void
+_digest_sector (_img_digest_snk_t *_obj, const uint8_t *buf)
+{
+  const uint8_t *data = buf;
+  unsigned len = CDIO_CD_FRAMESIZE_RAW;
+
+  if (_obj->sector_2336_flag)
+    {
+      data = buf + 12 + 4;
+      len = M2RAW_SECTOR_SIZE;
+    }
+
+  _vcd_md5_update (&_obj->md5, data, len);
+  _vcd_sha256_update (&_obj->sha256, data, len);
+
+  while (_obj->cur_track < _obj->track_count
+         && _obj->next_lsn >= _obj->tracks[_obj->cur_track].end_lsn)
+    _obj->cur_track++;
+
+  if (_obj->cur_track < _obj->track_count
+      && _obj->next_lsn >= _obj->tracks[_obj->cur_track].start_lsn)
+    {
+      _track_digest_t *_track = &_obj->tracks[_obj->cur_track];
+
+      _track->crc = _vcd_crc32 (_track->crc, data, len);
+    }
+
+  _obj->next_lsn++;
+}
+
+static void
+_report (_img_digest_snk_t *_obj)
+{
+  VcdDataSink *snk = NULL;
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  char hex[SHA256_DIGEST_SIZE * 2 + 1];
+  char line[256];
+  unsigned n;
+
+  if (_vcd_hash_length (_obj->pending) || _obj->next_lsn != _obj->end_lsn)
+    vcd_warn ("image was not written completely"
+              " -- digests are not valid (%u/%u sectors)",
+              (unsigned) _obj->next_lsn, (unsigned) _obj->end_lsn);
+
+  if (_obj->digest_fname
+      && !(snk = vcd_data_sink_new_stdio (_obj->digest_fname)))
+    vcd_error ("failed to create digest file `%s'", _obj->digest_fname);
+
+#define EMIT(...) \
+  do { \
+    snprintf (line, sizeof (line), __VA_ARGS__); \
+    if (!snk) \
+      vcd_info ("%s", line); \
+    else if (_obj->xml_flag) \
+      vcd_data_sink_printf (snk, "<!-- %s -->\n", line); \
+    else \
+      vcd_data_sink_printf (snk, "%s\n", line); \
+  } while (0)
+
+  if (_obj->xml_flag)
+    EMIT ("image of %u sectors with %u bytes each",
+          (unsigned) _obj->end_lsn,
+          _obj->sector_2336_flag ? M2RAW_SECTOR_SIZE : CDIO_CD_FRAMESIZE_RAW);
+
+  _vcd_md5_final (&_obj->md5, digest);
+  EMIT ("MD5 (image) = %s", _vcd_digest_to_hex (hex, digest, MD5_DIGEST_SIZE));
+
+  _vcd_sha256_final (&_obj->sha256, digest);
+  EMIT ("SHA256 (image) = %s",
+        _vcd_digest_to_hex (hex, digest, SHA256_DIGEST_SIZE));
+
+  for (n = 0; n < _obj->track_count; n++)
+    EMIT ("CRC32 (track %.2u) = %.8x", n + 1,
+          (unsigned) _obj->tracks[n].crc);
+
+#undef EMIT
+
+  if (snk)
+    {
+      vcd_data_sink_close (snk);
+      vcd_data_sink_destroy (snk);
+    }
+}
+
+static void
+_sink_free (void *user_data)
+{
+  _img_digest_snk_t *_obj = user_data;
+
+  _report (_obj);
+
+  if (_obj->sink)
+    vcd_image_sink_destroy (_obj->sink);
+
+  _vcd_hash_destroy (_obj->pending, true);
+  free (_obj->tracks);
+  free (_obj->digest_fname);
+  free (_obj);
+}
+
+static int
+_set_cuesheet (void *user_data, const CdioList_t *vcd_cue_list)
+{
+  _img_digest_snk_t *_obj = user_data;
+  CdioListNode_t *node;
+  unsigned n = 0;
+
+  _CDIO_LIST_FOREACH (node, (CdioList_t *) vcd_cue_list)
+    {
+      const vcd_cue_t *_cue = _cdio_list_node_data (node);
+
+      if (_cue->type == VCD_CUE_TRACK_START)
+        n++;
+    }
+
+  free (_obj->tracks);
+  _obj->tracks = calloc (MAX (n, 1), sizeof (_track_digest_t));
+  _obj->track_count = 0;
+
+  _CDIO_LIST_FOREACH (node, (CdioList_t *) vcd_cue_list)
+    {
+      const vcd_cue_t *_cue = _cdio_list_node_data (node);
+
+      switch (_cue->type)
+        {
+        case VCD_CUE_PREGAP_START:
+        case VCD_CUE_TRACK_START:
+        case VCD_CUE_END:
+          if (_obj->track_count
+              && !_obj->tracks[_obj->track_count - 1].end_lsn)
+            _obj->tracks[_obj->track_count - 1].end_lsn = _cue->lsn;
+
+          if (_cue->type == VCD_CUE_TRACK_START)
+            _obj->tracks[_obj->track_count++].start_lsn = _cue->lsn;
+
+          if (_cue->type == VCD_CUE_END)
+            _obj->end_lsn = _cue->lsn;
+          break;
+
+        default:
+          /* noop */
+          break;
+        }
+    }
+
+  if (_obj->sink)
+    return vcd_image_sink_set_cuesheet (_obj->sink, vcd_cue_list);
+
+  return 0;
+}
+
+static int
+_vcd_image_digest_write (void *user_data, const void *data, lsn_t lsn)
+{
+  _img_digest_snk_t *_obj = user_data;
+  char key[16];
+
+  if (lsn == _obj->next_lsn)
+    {
+      _digest_sector (_obj, data);
+
+      /* catch up with sectors that came in early */
+      for (;;)
+        {
+          uint8_t *buf;
+
+          snprintf (key, sizeof (key), "%u", (unsigned) _obj->next_lsn);
+
+          if (!(buf = _vcd_hash_remove (_obj->pending, key)))
+            break;
+
+          _digest_sector (_obj, buf);
+          free (buf);
+        }
+    }
+  else if (lsn > _obj->next_lsn)
+    {
+      uint8_t *buf = malloc (CDIO_CD_FRAMESIZE_RAW);
+
+      memcpy (buf, data, CDIO_CD_FRAMESIZE_RAW);
+
+      snprintf (key, sizeof (key), "%u", (unsigned) lsn);
+
+      if (!_vcd_hash_insert (_obj->pending, key, buf))
+        {
+          vcd_warn ("sector %u written twice -- digests are not valid",
+                    (unsigned) lsn);
+          free (buf);
+        }
+    }
+  else
+    vcd_warn ("sector %u written twice -- digests are not valid",
+              (unsigned) lsn);
+
+  if (_obj->sink)
+    return vcd_image_sink_write (_obj->sink, (void *) data, lsn);
+
+  return 0;
+}
+
+/* digest_file and digest_format are handled here; everything else is
+   for the underlying sink, sector size is of interest for both */
+static int
+_sink_set_arg (void *user_data, const char key[], const char value[])
+{
+  _img_digest_snk_t *_obj = user_data;
+
+  if (!strcmp (key, "digest_file"))
+    {
+      free (_obj->digest_fname);
+      _obj->digest_fname = NULL;
+
+      if (!value)
+        return -2;
+
+      _obj->digest_fname = strdup (value);
+
+      return 0;
+    }
+  else if (!strcmp (key, "digest_format"))
+    {
+      if (!value)
+        return -2;
+      else if (!strcmp (value, "text"))
+        _obj->xml_flag = false;
+      else if (!strcmp (value, "xml"))
+        _obj->xml_flag = true;
+      else
+        return -2;
+
+      return 0;
+    }
+  else if (!strcmp (key, "sector"))
+    {
+      if (!value)
+        return -2;
+      else if (!strcmp (value, "2336"))
+        _obj->sector_2336_flag = true;
+      else if (!strcmp (value, "2352"))
+        _obj->sector_2336_flag = false;
+      else
+        return -2;
+
+      if (_obj->sink
+          && vcd_image_sink_set_arg (_obj->sink, key, value) == -2)
+        return -2;
+
+      return 0;
+    }
+
+  if (_obj->sink)
+    return vcd_image_sink_set_arg (_obj->sink, key, value);
+
+  return -1;
+}
+
+VcdImageSink_t *
+vcd_image_sink_new_digest (VcdImageSink_t *p_sink)
+{
+  _img_digest_snk_t *_data;
+
+  vcd_image_sink_funcs _funcs = {
+    .set_cuesheet = _set_cuesheet,
+    .write        = _vcd_image_digest_write,
+    .free         = _sink_free,
+    .set_arg      = _sink_set_arg
+  };
+
+  _data = calloc(1, sizeof (_img_digest_snk_t));
+
+  _data->sink = p_sink;
+  _data->pending = _vcd_hash_new ();
+
+  _vcd_md5_init (&_data->md5);
+  _vcd_sha256_init (&_data->sha256);
+
+  return vcd_image_sink_new (_data, &_funcs);
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
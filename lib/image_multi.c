@@ -0,0 +1,150 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+
+/* We don't want to pull in cdio's config */
+#define __CDIO_CONFIG_H__
+#include <cdio/cdio.h>
+
+/* Public headers */
+#include <libvcd/logging.h>
+
+/* Private headers */
+#include "vcd_assert.h"
+#include "image_sink.h"
+
+/****************************************************************************
+ * writer -- forwards everything to a list of image sinks, so that a
+ * single pass creates several image formats
+ */
+
+typedef struct {
+  CdioList_t *sink_list; /* VcdImageSink_t */
+} _img_multi_snk_t;
+
+static void
+_sink_free (void *user_data)
+{
+  _img_multi_snk_t *_obj = user_data;
+
+  _cdio_list_free (_obj->sink_list, true,
+                   (CdioDataFree_t) vcd_image_sink_destroy);
+  free (_obj);
+}
+
+static int
+_set_cuesheet (void *user_data, const CdioList_t *vcd_cue_list)
+{
+  _img_multi_snk_t *_obj = user_data;
+  CdioListNode_t *node;
+  int retval = 0;
+
+  _CDIO_LIST_FOREACH (node, _obj->sink_list)
+    {
+      VcdImageSink_t *p_sink = _cdio_list_node_data (node);
+      int _ret = vcd_image_sink_set_cuesheet (p_sink, vcd_cue_list);
+
+      if (_ret && !retval)
+        retval = _ret;
+    }
+
+  return retval;
+}
+
+static int
+_vcd_image_multi_write (void *user_data, const void *data, lsn_t lsn)
+{
+  _img_multi_snk_t *_obj = user_data;
+  CdioListNode_t *node;
+  int retval = 0;
+
+  _CDIO_LIST_FOREACH (node, _obj->sink_list)
+    {
+      VcdImageSink_t *p_sink = _cdio_list_node_data (node);
+      int _ret = vcd_image_sink_write (p_sink, (void *) data, lsn);
+
+      if (_ret && !retval)
+        retval = _ret;
+    }
+
+  return retval;
+}
+
+/* an argument is passed on to every sink; it is only an unknown key
+   if none of the sinks knows about it */
+static int
+_sink_set_arg (void *user_data, const char key[], const char value[])
+{
+  _img_multi_snk_t *_obj = user_data;
+  CdioListNode_t *node;
+  int retval = -1;
+
+  _CDIO_LIST_FOREACH (node, _obj->sink_list)
+    {
+      VcdImageSink_t *p_sink = _cdio_list_node_data (node);
+
+      switch (vcd_image_sink_set_arg (p_sink, key, value))
+        {
+        case 0:
+          if (retval == -1)
+            retval = 0;
+          break;
+
+        case -1:
+          break;
+
+        default:
+          retval = -2;
+          break;
+        }
+    }
+
+  return retval;
+}
+
+VcdImageSink_t *
+vcd_image_sink_new_multi (CdioList_t *p_sink_list)
+{
+  _img_multi_snk_t *_data;
+
+  vcd_image_sink_funcs _funcs = {
+    .set_cuesheet = _set_cuesheet,
+    .write        = _vcd_image_multi_write,
+    .free         = _sink_free,
+    .set_arg      = _sink_set_arg
+  };
+
+  vcd_assert (p_sink_list != NULL);
+
+  _data = calloc(1, sizeof (_img_multi_snk_t));
+  _data->sink_list = p_sink_list;
+
+  return vcd_image_sink_new (_data, &_funcs);
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -133,7 +133,8 @@ _sink_free (void *user_data)
   _img_nrg_snk_t *_obj = user_data;
 
   free (_obj->nrg_fname);
-  vcd_data_sink_destroy (_obj->nrg_snk);
+  if (_obj->nrg_snk)
+    vcd_data_sink_destroy (_obj->nrg_snk);
 
   free (_obj);
 }
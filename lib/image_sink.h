@@ -78,4 +78,23 @@ VcdImageSink_t * vcd_image_sink_new_nrg (void);
 VcdImageSink_t * vcd_image_sink_new_bincue (void);
 VcdImageSink_t * vcd_image_sink_new_cdrdao (void);
 
+/*!
+  Creates a sink writing to all sinks in p_sink_list at once; the
+  list and the sinks in it are owned by the new sink from then on.
+*/
+VcdImageSink_t * vcd_image_sink_new_multi (CdioList_t *p_sink_list);
+
+/*!
+  Creates a sink computing MD5 and SHA-256 digests of the whole image
+  and CRC32 checksums of each track, passing all sectors on to p_sink
+  (which it owns from then on). If p_sink is NULL, nothing but the
+  digests is written.
+
+  The digests go to the file given by the "digest_file" arg, as plain
+  text or -- with "digest_format" set to "xml" -- as XML comments;
+  without a file they are logged. The "sector" arg selects whether
+  2336 or 2352 bytes of each sector are digested.
+*/
+VcdImageSink_t * vcd_image_sink_new_digest (VcdImageSink_t *p_sink);
+
 #endif /* __VCD_IMAGE_SINK_H__ */
@@ -59,16 +59,18 @@
 /* Private headers */
 #include "info_private.h"
 #include "pbc.h"
+#include "util.h"
 
 #define BUF_COUNT 16
-#define BUF_SIZE 80
+#define BUF_SIZE VCDINFO_STRBUF_SIZE
 
-/* Return a pointer to a internal free buffer */
+/* Return a pointer to a internal free buffer; every thread has its own
+   set of them */
 static char *
 _getbuf (void)
 {
-  static char _buf[BUF_COUNT][BUF_SIZE];
-  static int _num = -1;
+  static VCD_THREAD_LOCAL char _buf[BUF_COUNT][BUF_SIZE];
+  static VCD_THREAD_LOCAL int _num = -1;
 
   _num++;
   _num %= BUF_COUNT;
@@ -81,17 +83,19 @@ _getbuf (void)
 const char *
 vcdinf_area_str (const struct psd_area_t *_area)
 {
-  char *buf;
+  return vcdinf_area_str_r (_area, _getbuf (), BUF_SIZE);
+}
 
+const char *
+vcdinf_area_str_r (const struct psd_area_t *_area, char buf[], size_t len)
+{
   if (!_area->x1
       && !_area->y1
       && !_area->x2
       && !_area->y2)
     return "disabled";
 
-  buf = _getbuf ();
-
-  snprintf (buf, BUF_SIZE, "[%3d,%3d] - [%3d,%3d]",
+  snprintf (buf, len, "[%3d,%3d] - [%3d,%3d]",
             _area->x1, _area->y1,
             _area->x2, _area->y2);
 
@@ -58,14 +58,15 @@
 #include <errno.h>
 
 #define BUF_COUNT 16
-#define BUF_SIZE 80
+#define BUF_SIZE VCDINFO_STRBUF_SIZE
 
-/* Return a pointer to a internal free buffer */
+/* Return a pointer to a internal free buffer; every thread has its own
+   set of them */
 static char *
 _getbuf (void)
 {
-  static char _buf[BUF_COUNT][BUF_SIZE];
-  static int _num = -1;
+  static VCD_THREAD_LOCAL char _buf[BUF_COUNT][BUF_SIZE];
+  static VCD_THREAD_LOCAL int _num = -1;
 
   _num++;
   _num %= BUF_COUNT;
@@ -75,6 +76,11 @@ _getbuf (void)
   return _buf[_num];
 }
 
+/* read on first use unless opened with VCDINFO_OPEN_FLAG_EAGER */
+static bool _vcdinfo_load_pbc_x (vcdinfo_obj_t *p_obj);
+static bool _vcdinfo_load_search (vcdinfo_obj_t *p_obj);
+static bool _vcdinfo_load_scandata (vcdinfo_obj_t *p_obj);
+
 /*
    Initialize/allocate segment portion of vcdinfo_obj_t.
 
@@ -337,31 +343,36 @@ vcdinfo_classify_itemid (uint16_t i_itemid,
 const char *
 vcdinfo_pin2str (uint16_t i_itemid)
 {
-  char *buf = _getbuf ();
+  return vcdinfo_pin2str_r (i_itemid, _getbuf (), BUF_SIZE);
+}
+
+const char *
+vcdinfo_pin2str_r (uint16_t i_itemid, char buf[], size_t len)
+{
   vcdinfo_itemid_t itemid;
 
   vcdinfo_classify_itemid(i_itemid, &itemid);
-  strcpy (buf, "??");
+  snprintf (buf, len, "??");
 
   switch(itemid.type) {
   case VCDINFO_ITEM_TYPE_NOTFOUND:
-    snprintf (buf, BUF_SIZE, "play nothing (0x%4.4x)", itemid.num);
+    snprintf (buf, len, "play nothing (0x%4.4x)", itemid.num);
     break;
   case VCDINFO_ITEM_TYPE_TRACK:
-    snprintf (buf, BUF_SIZE, "SEQUENCE[%d] (0x%4.4x)", itemid.num-1,
+    snprintf (buf, len, "SEQUENCE[%d] (0x%4.4x)", itemid.num-1,
               i_itemid);
     break;
   case VCDINFO_ITEM_TYPE_ENTRY:
-    snprintf (buf, BUF_SIZE, "ENTRY[%d] (0x%4.4x)", itemid.num, i_itemid);
+    snprintf (buf, len, "ENTRY[%d] (0x%4.4x)", itemid.num, i_itemid);
     break;
   case VCDINFO_ITEM_TYPE_SEGMENT:
-    snprintf (buf, BUF_SIZE, "SEGMENT[%d] (0x%4.4x)", itemid.num, i_itemid);
+    snprintf (buf, len, "SEGMENT[%d] (0x%4.4x)", itemid.num, i_itemid);
     break;
   case VCDINFO_ITEM_TYPE_LID:
-    snprintf (buf, BUF_SIZE, "spare id (0x%4.4x)", itemid.num);
+    snprintf (buf, len, "spare id (0x%4.4x)", itemid.num);
     break;
   case VCDINFO_ITEM_TYPE_SPAREID2:
-    snprintf (buf, BUF_SIZE, "spare id2 (0x%4.4x)", itemid.num);
+    snprintf (buf, len, "spare id2 (0x%4.4x)", itemid.num);
     break;
   }
 
@@ -789,6 +800,7 @@ void *
 vcdinfo_get_scandata (vcdinfo_obj_t *p_obj)
 {
   if (!p_obj) return NULL;
+  _vcdinfo_load_scandata (p_obj);
   return p_obj->scandata_buf;
 }
 
@@ -796,6 +808,7 @@ void *
 vcdinfo_get_searchDat (vcdinfo_obj_t *p_obj)
 {
   if (!p_obj) return NULL;
+  _vcdinfo_load_search (p_obj);
   return p_obj->search_buf;
 }
 
@@ -851,6 +864,7 @@ LotVcd_t *
 vcdinfo_get_lot_x(const vcdinfo_obj_t *p_obj)
 {
   if (!p_obj) return NULL;
+  _vcdinfo_load_pbc_x ((vcdinfo_obj_t *) p_obj);
   return p_obj->lot_x;
 }
 
@@ -927,6 +941,8 @@ _vcdinfo_get_offset_t (const vcdinfo_obj_t *p_obj, unsigned int offset,
 {
   CdioListNode_t *node;
   CdioList_t *offset_list = ext ? p_obj->offset_x_list : p_obj->offset_list;
+  vcdinfo_offset_t **offset_index =
+    ext ? p_obj->offset_x_index : p_obj->offset_index;
 
   switch (offset) {
   case PSD_OFS_DISABLED:
@@ -936,6 +952,12 @@ _vcdinfo_get_offset_t (const vcdinfo_obj_t *p_obj, unsigned int offset,
   default: ;
   }
 
+  if (offset_index) {
+    const unsigned int size =
+      ext ? p_obj->offset_x_index_size : p_obj->offset_index_size;
+    return offset < size ? offset_index[offset] : NULL;
+  }
+
   _CDIO_LIST_FOREACH (node, offset_list)
     {
       vcdinfo_offset_t *p_ofs = _cdio_list_node_data (node);
@@ -1016,6 +1038,7 @@ uint8_t *
 vcdinfo_get_psd_x(const vcdinfo_obj_t *p_obj)
 {
   if ( !p_obj ) return NULL;
+  _vcdinfo_load_pbc_x ((vcdinfo_obj_t *) p_obj);
   return p_obj->psd_x;
 }
 
@@ -1036,6 +1059,7 @@ uint32_t
 vcdinfo_get_psd_x_size (const vcdinfo_obj_t *p_obj)
 {
   if ( !p_obj ) return 0;
+  _vcdinfo_load_pbc_x ((vcdinfo_obj_t *) p_obj);
   return p_obj->psd_x_size;
 }
 
@@ -1205,7 +1229,7 @@ vcdinfo_get_seg_msf(const vcdinfo_obj_t *p_obj, segnum_t i_seg)
     return NULL;
   else {
     lsn_t lsn = vcdinfo_get_seg_lsn(p_obj, i_seg);
-    static msf_t msf;
+    static VCD_THREAD_LOCAL msf_t msf;
     cdio_lsn_to_msf(lsn, &msf);
     return &msf;
   }
@@ -1334,6 +1358,68 @@ vcdinfo_get_track_audio_type(const vcdinfo_obj_t *p_obj, track_t i_track)
   return(tracks2->contents[i_track-1].audio);
 }
 
+/* reads the TOC once, so that the track functions below need not ask
+   the driver each time; on failure they fall back to asking it */
+static void
+_vcdinfo_read_toc (vcdinfo_obj_t *p_obj)
+{
+  const track_t i_first_track = cdio_get_first_track_num (p_obj->img);
+  const track_t i_tracks = cdio_get_num_tracks (p_obj->img);
+  unsigned int i;
+
+  if (CDIO_INVALID_TRACK == i_first_track || CDIO_INVALID_TRACK == i_tracks
+      || !i_tracks)
+    return;
+
+  p_obj->i_first_track = i_first_track;
+  p_obj->i_tracks = i_tracks;
+
+  /* one more for the leadout */
+  p_obj->track_lsn = calloc (i_tracks + 1, sizeof (lsn_t));
+  p_obj->track_last_lsn = calloc (i_tracks + 1, sizeof (lsn_t));
+  p_obj->track_sect_count = calloc (i_tracks + 1, sizeof (unsigned int));
+  p_obj->track_size = calloc (i_tracks + 1, sizeof (unsigned int));
+
+  for (i = 0; i <= i_tracks; i++)
+    {
+      const track_t i_track = i < i_tracks
+        ? i_first_track + i : CDIO_CDROM_LEADOUT_TRACK;
+
+      p_obj->track_lsn[i] = cdio_get_track_lsn (p_obj->img, i_track);
+      p_obj->track_last_lsn[i] = i < i_tracks
+        ? cdio_get_track_last_lsn (p_obj->img, i_track) : VCDINFO_NULL_LSN;
+      p_obj->track_sect_count[i] = (unsigned int) -1;
+      p_obj->track_size[i] = (unsigned int) -1;
+    }
+}
+
+/* index of CdIo track i_cdio_track into the TOC read by
+   _vcdinfo_read_toc(), -1 if it is not there */
+static int
+_vcdinfo_toc_index (const vcdinfo_obj_t *p_obj, unsigned int i_cdio_track)
+{
+  if (!p_obj->track_lsn)
+    return -1;
+
+  if (CDIO_CDROM_LEADOUT_TRACK == i_cdio_track)
+    return p_obj->i_tracks;
+
+  if (i_cdio_track < p_obj->i_first_track
+      || i_cdio_track > p_obj->i_first_track + p_obj->i_tracks)
+    return -1;
+
+  return i_cdio_track - p_obj->i_first_track;
+}
+
+static void
+_vcdinfo_free_toc (vcdinfo_obj_t *p_obj)
+{
+  CDIO_FREE_IF_NOT_NULL(p_obj->track_lsn);
+  CDIO_FREE_IF_NOT_NULL(p_obj->track_last_lsn);
+  CDIO_FREE_IF_NOT_NULL(p_obj->track_sect_count);
+  CDIO_FREE_IF_NOT_NULL(p_obj->track_size);
+}
+
 /*!
   Return the highest track number in the current medium.
 
@@ -1348,6 +1434,9 @@ vcdinfo_get_num_tracks(const vcdinfo_obj_t *p_obj)
 {
   if (!p_obj || !p_obj->img) return 0;
 
+  if (p_obj->track_lsn)
+    return p_obj->i_tracks-1;
+
   return cdio_get_num_tracks(p_obj->img)-1;
 }
 
@@ -1366,11 +1455,16 @@ vcdinfo_get_num_tracks(const vcdinfo_obj_t *p_obj)
 lba_t
 vcdinfo_get_track_lba(const vcdinfo_obj_t *p_obj, track_t i_track)
 {
+  int i;
+
   if (!p_obj || !p_obj->img)
     return VCDINFO_NULL_LBA;
 
-
   /* CdIo tracks start at 1 rather than 0. */
+  i = _vcdinfo_toc_index(p_obj, i_track+1);
+  if (i >= 0 && p_obj->track_lsn[i] != VCDINFO_NULL_LSN)
+    return cdio_lsn_to_lba(p_obj->track_lsn[i]);
+
   return cdio_get_track_lba(p_obj->img, i_track+1);
 }
 
@@ -1388,10 +1482,16 @@ vcdinfo_get_track_lba(const vcdinfo_obj_t *p_obj, track_t i_track)
 lsn_t
 vcdinfo_get_track_lsn(const vcdinfo_obj_t *p_obj, track_t i_track)
 {
+  int i;
+
   if (!p_obj || !p_obj->img)
     return VCDINFO_NULL_LSN;
 
   /* CdIo tracks start at 1 rather than 0. */
+  i = _vcdinfo_toc_index(p_obj, i_track+1);
+  if (i >= 0)
+    return p_obj->track_lsn[i];
+
   return cdio_get_track_lsn(p_obj->img, i_track+1);
 }
 
@@ -1401,10 +1501,16 @@ vcdinfo_get_track_lsn(const vcdinfo_obj_t *p_obj, track_t i_track)
 */
 lsn_t vcdinfo_get_track_last_lsn(const vcdinfo_obj_t *p_obj, track_t i_track)
 {
+  int i;
+
   if (!p_obj || !p_obj->img)
     return VCDINFO_NULL_LSN;
 
   /* CdIo tracks start at 1 rather than 0. */
+  i = _vcdinfo_toc_index(p_obj, i_track+1);
+  if (i >= 0 && i < p_obj->i_tracks)
+    return p_obj->track_last_lsn[i];
+
   return cdio_get_track_last_lsn(p_obj->img, i_track+1);
 }
 
@@ -1453,25 +1559,36 @@ unsigned int
 vcdinfo_get_track_sect_count(const vcdinfo_obj_t *p_obj,
                              const track_t i_track)
 {
+  int i;
+
   if (!p_obj || VCDINFO_INVALID_TRACK == i_track)
     return 0;
 
+  /* searching the filesystem is expensive, remember the answer */
+  i = _vcdinfo_toc_index(p_obj, i_track+1);
+  if (i >= 0 && p_obj->track_sect_count[i] != (unsigned int) -1)
+    return p_obj->track_sect_count[i];
+
   {
     iso9660_stat_t *p_statbuf;
     const lsn_t lsn = vcdinfo_get_track_lsn(p_obj, i_track);
+    unsigned int secsize;
 
     /* Try to get the sector count from the ISO 9660 filesystem */
     if (p_obj->has_xa && (p_statbuf = iso9660_find_fs_lsn(p_obj->img, lsn))) {
-      unsigned int secsize = p_statbuf->secsize;
+      secsize = p_statbuf->secsize;
       free(p_statbuf);
-      return secsize;
     } else {
       const lsn_t next_lsn=vcdinfo_get_track_lsn(p_obj, i_track+1);
       /* Failed on ISO 9660 filesystem. Use track information.  */
-      return next_lsn > lsn ? next_lsn - lsn : 0;
+      secsize = next_lsn > lsn ? next_lsn - lsn : 0;
     }
+
+    if (i >= 0)
+      p_obj->track_sect_count[i] = secsize;
+
+    return secsize;
   }
-  return 0;
 }
 
 /*!
@@ -1486,9 +1603,15 @@ vcdinfo_get_track_sect_count(const vcdinfo_obj_t *p_obj,
 unsigned int
 vcdinfo_get_track_size(const vcdinfo_obj_t *p_obj, track_t i_track)
 {
+  int i;
+
   if (NULL == p_obj || VCDINFO_INVALID_TRACK == i_track)
     return 0;
 
+  i = _vcdinfo_toc_index(p_obj, i_track+1);
+  if (i >= 0 && p_obj->track_size[i] != (unsigned int) -1)
+    return p_obj->track_size[i];
+
   {
     const lsn_t lsn = cdio_lba_to_lsn(vcdinfo_get_track_lba(p_obj,
                                                             i_track));
@@ -1496,8 +1619,17 @@ vcdinfo_get_track_size(const vcdinfo_obj_t *p_obj, track_t i_track)
     /* Try to get the sector count from the ISO 9660 filesystem */
     if (p_obj->has_xa) {
       iso9660_stat_t *p_statbuf;
-      p_statbuf = iso9660_find_fs_lsn(p_obj->img, lsn);
-      return p_statbuf->size;
+      unsigned int size = 0;
+
+      if ((p_statbuf = iso9660_find_fs_lsn(p_obj->img, lsn))) {
+        size = p_statbuf->size;
+        free(p_statbuf);
+      }
+
+      if (i >= 0)
+        p_obj->track_size[i] = size;
+
+      return size;
     }
 #if 0
     else {
@@ -1556,7 +1688,7 @@ vcdinfo_get_volume_count(const vcdinfo_obj_t *p_obj)
 const char *
 vcdinfo_get_volume_id(const vcdinfo_obj_t *p_obj)
 {
-  static char psz_vol_id[ISO_MAX_VOLUME_ID+1] = {'\0'};
+  static VCD_THREAD_LOCAL char psz_vol_id[ISO_MAX_VOLUME_ID+1] = {'\0'};
   char *psz_vol_id2;
   if ( NULL == p_obj || NULL == &p_obj->pvd ) return (NULL);
   psz_vol_id2 = iso9660_get_volume_id(&p_obj->pvd);
@@ -1572,7 +1704,7 @@ vcdinfo_get_volume_id(const vcdinfo_obj_t *p_obj)
 const char *
 vcdinfo_get_volumeset_id(const vcdinfo_obj_t *p_obj)
 {
-  static char volume_set_id[ISO_MAX_VOLUMESET_ID+1] = {'\0'};
+  static VCD_THREAD_LOCAL char volume_set_id[ISO_MAX_VOLUMESET_ID+1] = {'\0'};
   if ( NULL == p_obj || NULL == &p_obj->pvd ) return (NULL);
   strncpy(volume_set_id, p_obj->pvd.volume_set_id, ISO_MAX_VOLUMESET_ID);
   return vcdinfo_strip_trail(volume_set_id, ISO_MAX_VOLUMESET_ID);
@@ -1642,9 +1774,15 @@ vcdinfo_inc_msf (uint8_t *p_min, uint8_t *p_sec, int8_t *p_frame)
 
 const char *
 vcdinfo_ofs2str (const vcdinfo_obj_t *p_obj, unsigned int offset, bool ext)
+{
+  return vcdinfo_ofs2str_r (p_obj, offset, ext, _getbuf (), BUF_SIZE);
+}
+
+const char *
+vcdinfo_ofs2str_r (const vcdinfo_obj_t *p_obj, unsigned int offset, bool ext,
+                   char buf[], size_t len)
 {
   vcdinfo_offset_t *ofs;
-  char *buf;
 
   switch (offset) {
   case PSD_OFS_DISABLED:
@@ -1656,17 +1794,16 @@ vcdinfo_ofs2str (const vcdinfo_obj_t *p_obj, unsigned int offset, bool ext)
   default: ;
   }
 
-  buf = _getbuf ();
   ofs = _vcdinfo_get_offset_t(p_obj, offset, ext);
   if (ofs != NULL) {
     if (ofs->lid)
-      snprintf (buf, BUF_SIZE, "LID[%d] @0x%4.4x",
+      snprintf (buf, len, "LID[%d] @0x%4.4x",
                 ofs->lid, ofs->offset);
     else
-      snprintf (buf, BUF_SIZE, "PSD[?] @0x%4.4x",
+      snprintf (buf, len, "PSD[?] @0x%4.4x",
                 ofs->offset);
   } else {
-    snprintf (buf, BUF_SIZE, "? @0x%4.4x", offset);
+    snprintf (buf, len, "? @0x%4.4x", offset);
   }
   return buf;
 }
@@ -1690,13 +1827,14 @@ vcdinfo_read_psd (vcdinfo_obj_t *p_obj)
       p_obj->psd = calloc(1, ISO_BLOCKSIZE * _vcd_len2blocks (psd_size,
                                                                ISO_BLOCKSIZE));
 
-      if (cdio_read_mode2_sectors (p_obj->img, (void *) p_obj->lot, LOT_VCD_SECTOR,
-                                   false, LOT_VCD_SIZE))
+      if (vcdinfo_read_mode2_sectors (p_obj, (void *) p_obj->lot,
+                                      LOT_VCD_SECTOR, false, LOT_VCD_SIZE))
         return false;
 
-      if (cdio_read_mode2_sectors (p_obj->img, (void *) p_obj->psd, PSD_VCD_SECTOR,
-                                   false, _vcd_len2blocks (psd_size,
-                                                           ISO_BLOCKSIZE)))
+      if (vcdinfo_read_mode2_sectors (p_obj, (void *) p_obj->psd,
+                                      PSD_VCD_SECTOR, false,
+                                      _vcd_len2blocks (psd_size,
+                                                       ISO_BLOCKSIZE)))
         return false;
 
     } else {
@@ -1717,8 +1855,8 @@ vcdinfo_track_get_entry(const vcdinfo_obj_t *p_obj, track_t i_track)
 }
 
 /*!
-   Calls recursive routine to populate obj->offset_list or obj->offset_x_list
-   by going through LOT.
+   Calls vcdinf_visit_pbc() to populate obj->offset_list or
+   obj->offset_x_list by going through LOT.
 
    Returns false if there was some error.
 */
@@ -1728,12 +1866,17 @@ vcdinfo_visit_lot (vcdinfo_obj_t *p_obj, bool extended)
   struct _vcdinf_pbc_ctx pbc_ctx;
   bool ret;
 
+  if (extended)
+    _vcdinfo_load_pbc_x (p_obj);
+
   pbc_ctx.psd_size      = vcdinfo_get_psd_size (p_obj);
   pbc_ctx.psd_x_size    = p_obj->psd_x_size;
   pbc_ctx.offset_mult   = 8;
   pbc_ctx.maximum_lid   = vcdinfo_get_num_LIDs(p_obj);
   pbc_ctx.offset_x_list = NULL;
   pbc_ctx.offset_list   = NULL;
+  pbc_ctx.offset_x_index = NULL;
+  pbc_ctx.offset_index  = NULL;
   pbc_ctx.psd           = p_obj->psd;
   pbc_ctx.psd_x         = p_obj->psd_x;
   pbc_ctx.lot           = p_obj->lot;
@@ -1747,6 +1890,12 @@ vcdinfo_visit_lot (vcdinfo_obj_t *p_obj, bool extended)
   if (NULL != p_obj->offset_list)
     _cdio_list_free(p_obj->offset_list, true, NULL);
   p_obj->offset_list = pbc_ctx.offset_list;
+  CDIO_FREE_IF_NOT_NULL(p_obj->offset_x_index);
+  p_obj->offset_x_index = pbc_ctx.offset_x_index;
+  p_obj->offset_x_index_size = pbc_ctx.psd_x_size / pbc_ctx.offset_mult;
+  CDIO_FREE_IF_NOT_NULL(p_obj->offset_index);
+  p_obj->offset_index = pbc_ctx.offset_index;
+  p_obj->offset_index_size = pbc_ctx.psd_size / pbc_ctx.offset_mult;
   return ret;
 }
 
@@ -1757,7 +1906,7 @@ vcdinfo_visit_lot (vcdinfo_obj_t *p_obj, bool extended)
 const char *
 vcdinfo_strip_trail (const char str[], size_t n)
 {
-  static char buf[1024];
+  static VCD_THREAD_LOCAL char buf[1024];
   int j;
 
   vcd_assert (n < 1024);
@@ -1786,6 +1935,240 @@ vcdinfo_is_rejected(uint16_t offset)
   return (offset & VCDINFO_REJECTED_MASK) != 0;
 }
 
+/* a directory of the disc as listed by iso9660_fs_readdir(); entries is
+   NULL for directories not found */
+struct _vcdinfo_dir
+{
+  char *name;
+  CdioList_t *entries;
+};
+
+/*!
+   Return the entry of pathname, a file or directory in the root
+   directory or one level below it, or NULL if there is none.  Each
+   directory is read once and kept in p_obj->dir_list, as opening a
+   disc looks up several files in the same few directories.  The entry
+   returned belongs to p_obj and must not be freed.
+*/
+static const iso9660_stat_t *
+_vcdinfo_stat (vcdinfo_obj_t *p_obj, const char pathname[])
+{
+  const char *fname = strchr (pathname, '/');
+  char dirname[16] = "/";
+  struct _vcdinfo_dir *p_dir = NULL;
+  CdioListNode_t *node;
+
+  if (fname)
+    {
+      vcd_assert ((size_t) (fname - pathname) < sizeof (dirname));
+      strncpy (dirname, pathname, fname - pathname);
+      dirname[fname - pathname] = '\0';
+      fname++;
+    }
+  else
+    fname = pathname;
+
+  if (!p_obj->dir_list)
+    p_obj->dir_list = _cdio_list_new ();
+
+  _CDIO_LIST_FOREACH (node, p_obj->dir_list)
+    {
+      struct _vcdinfo_dir *_dir = _cdio_list_node_data (node);
+
+      if (!strcmp (_dir->name, dirname))
+        {
+          p_dir = _dir;
+          break;
+        }
+    }
+
+  if (!p_dir)
+    {
+      p_dir = calloc (1, sizeof (struct _vcdinfo_dir));
+      p_dir->name = strdup (dirname);
+      p_dir->entries = iso9660_fs_readdir (p_obj->img, dirname);
+
+      _cdio_list_append (p_obj->dir_list, p_dir);
+    }
+
+  if (p_dir->entries)
+    _CDIO_LIST_FOREACH (node, p_dir->entries)
+      {
+        const iso9660_stat_t *statbuf = _cdio_list_node_data (node);
+
+        if (!strcmp (statbuf->filename, fname))
+          return statbuf;
+      }
+
+  return NULL;
+}
+
+static void
+_vcdinfo_free_dirs (vcdinfo_obj_t *p_obj)
+{
+  CdioListNode_t *node;
+
+  if (!p_obj->dir_list)
+    return;
+
+  _CDIO_LIST_FOREACH (node, p_obj->dir_list)
+    {
+      struct _vcdinfo_dir *p_dir = _cdio_list_node_data (node);
+
+      if (p_dir->entries)
+        _cdio_list_free (p_dir->entries, true, NULL);
+      free (p_dir->name);
+    }
+
+  _cdio_list_free (p_obj->dir_list, true, NULL);
+  p_obj->dir_list = NULL;
+}
+
+/* reads /EXT/PSD_X.VCD and /EXT/LOT_X.VCD of a VCD 2.0; false if they
+   are there but cannot be read */
+static bool
+_vcdinfo_load_pbc_x (vcdinfo_obj_t *p_obj)
+{
+  const iso9660_stat_t *statbuf;
+
+  if (p_obj->pbc_x_loaded)
+    return true;
+
+  p_obj->pbc_x_loaded = true;
+
+  if (p_obj->vcd_type != VCD_TYPE_VCD2)
+    return true;
+
+  statbuf = _vcdinfo_stat (p_obj, "EXT/PSD_X.VCD;1");
+  if (NULL != statbuf) {
+    lsn_t lsn        = statbuf->lsn;
+    uint32_t secsize = statbuf->secsize;
+
+    p_obj->psd_x       = calloc(1, ISO_BLOCKSIZE * secsize);
+    p_obj->psd_x_size  = statbuf->size;
+
+    vcd_debug ("found /EXT/PSD_X.VCD at sector %lu",
+               (long unsigned int) lsn);
+
+    if (vcdinfo_read_mode2_sectors (p_obj, p_obj->psd_x, lsn, false,
+                                    secsize))
+      goto err_return;
+  }
+
+  statbuf = _vcdinfo_stat (p_obj, "EXT/LOT_X.VCD;1");
+  if (NULL != statbuf) {
+    lsn_t lsn        = statbuf->lsn;
+    uint32_t secsize = statbuf->secsize;
+    p_obj->lot_x       = calloc(1, ISO_BLOCKSIZE * secsize);
+
+    vcd_debug ("found /EXT/LOT_X.VCD at sector %lu",
+               (unsigned long int) lsn);
+
+    if (statbuf->size != LOT_VCD_SIZE * ISO_BLOCKSIZE)
+      vcd_warn ("LOT_X.VCD size != 65535");
+
+    if (vcdinfo_read_mode2_sectors (p_obj, p_obj->lot_x, lsn, false,
+                                    secsize))
+      goto err_return;
+  }
+
+  return true;
+
+ err_return:
+  vcd_warn ("error reading the extended PSD or LOT");
+  CDIO_FREE_IF_NOT_NULL(p_obj->psd_x);
+  CDIO_FREE_IF_NOT_NULL(p_obj->lot_x);
+  p_obj->psd_x_size = 0;
+  return false;
+}
+
+/* reads /SVCD/SEARCH.DAT of a SVCD or HQVCD; false if it is there but
+   cannot be read */
+static bool
+_vcdinfo_load_search (vcdinfo_obj_t *p_obj)
+{
+  const iso9660_stat_t *statbuf;
+  lsn_t    lsn;
+  uint32_t secsize;
+  uint32_t size;
+
+  if (p_obj->search_loaded)
+    return true;
+
+  p_obj->search_loaded = true;
+
+  if (p_obj->vcd_type != VCD_TYPE_SVCD && p_obj->vcd_type != VCD_TYPE_HQVCD)
+    return true;
+
+  if (!(statbuf = _vcdinfo_stat (p_obj, "SVCD/SEARCH.DAT;1")))
+    return true;
+
+  lsn     = statbuf->lsn;
+  secsize = statbuf->secsize;
+
+  vcd_debug ("found SEARCH.DAT at sector %lu", (unsigned long int) lsn);
+
+  p_obj->search_buf = calloc(1, ISO_BLOCKSIZE * secsize);
+
+  if (vcdinfo_read_mode2_sectors (p_obj, p_obj->search_buf, lsn, false,
+                                  secsize))
+    goto err_return;
+
+  size = (3 * uint16_from_be (((SearchDat_t *)p_obj->search_buf)->scan_points))
+    + sizeof (SearchDat_t);
+
+  if (size > statbuf->size) {
+    vcd_warn ("number of scanpoints leads to bigger size than "
+              "file size of SEARCH.DAT! -- rereading");
+
+    free (p_obj->search_buf);
+    p_obj->search_buf = calloc(1, ISO_BLOCKSIZE
+                                   * _vcd_len2blocks(size, ISO_BLOCKSIZE));
+
+    if (vcdinfo_read_mode2_sectors (p_obj, p_obj->search_buf, lsn, false,
+                                    secsize))
+      goto err_return;
+  }
+
+  return true;
+
+ err_return:
+  vcd_warn ("error reading SEARCH.DAT");
+  CDIO_FREE_IF_NOT_NULL(p_obj->search_buf);
+  return false;
+}
+
+/* reads /EXT/SCANDATA.DAT; false if it is there but cannot be read */
+static bool
+_vcdinfo_load_scandata (vcdinfo_obj_t *p_obj)
+{
+  const iso9660_stat_t *statbuf;
+
+  if (p_obj->scandata_loaded)
+    return true;
+
+  p_obj->scandata_loaded = true;
+
+  statbuf = _vcdinfo_stat (p_obj, "EXT/SCANDATA.DAT;1");
+  if (statbuf != NULL) {
+    lsn_t    lsn       = statbuf->lsn;
+    uint32_t secsize   = statbuf->secsize;
+
+    vcd_debug ("found /EXT/SCANDATA.DAT at sector %u", (unsigned int) lsn);
+
+    p_obj->scandata_buf = calloc(1, ISO_BLOCKSIZE * secsize);
+
+    if (vcdinfo_read_mode2_sectors (p_obj, p_obj->scandata_buf, lsn, false,
+                                    secsize)) {
+      vcd_warn ("error reading SCANDATA.DAT");
+      CDIO_FREE_IF_NOT_NULL(p_obj->scandata_buf);
+      return false;
+    }
+  }
+
+  return true;
+}
+
 /*!
    Nulls/zeros vcdinfo_obj_t structures; The caller should have
    ensured that p_obj != NULL.
@@ -1840,10 +2223,36 @@ vcdinfo_init(vcdinfo_obj_t *p_obj)
 vcdinfo_open_return_t
 vcdinfo_open(vcdinfo_obj_t **pp_obj, char *source_name[],
              driver_id_t source_type, const char access_mode[])
+{
+  return vcdinfo_open_flags(pp_obj, source_name, source_type, access_mode, 0);
+}
+
+/* Like read_pvd(), without complaining: a mode 1 disc has its PVD
+   somewhere else, which iso9660_fs_read_pvd() finds. */
+static bool
+_vcdinfo_probe_pvd(const vcdinfo_obj_t *p_obj, iso9660_pvd_t *p_pvd)
+{
+  if (vcdinfo_read_mode2_sectors(p_obj, p_pvd, ISO_PVD_SECTOR, false, 1))
+    return false;
+
+  return p_pvd->type == ISO_VD_PRIMARY
+    && !memcmp(p_pvd->id, ISO_STANDARD_ID, sizeof(ISO_STANDARD_ID));
+}
+
+/*!
+   Like vcdinfo_open(), with i_flags a combination of vcdinfo_open_flag_t
+   values.  Unless VCDINFO_OPEN_FLAG_EAGER is given, the extended PSD
+   and LOT, SEARCH.DAT and SCANDATA.DAT are read by the functions
+   returning them the first time they are called.
+*/
+vcdinfo_open_return_t
+vcdinfo_open_flags(vcdinfo_obj_t **pp_obj, char *source_name[],
+                   driver_id_t source_type, const char access_mode[],
+                   unsigned int i_flags)
 {
   CdIo_t *p_cdio;
   vcdinfo_obj_t *p_obj = calloc(1, sizeof(vcdinfo_obj_t));
-  iso9660_stat_t *statbuf;
+  const iso9660_stat_t *statbuf;
   bool free_source_name = false;
 
   /* If we don't specify a driver_id or a source_name, scan the
@@ -1884,7 +2293,16 @@ vcdinfo_open(vcdinfo_obj_t **pp_obj, char *source_name[],
   memset (p_obj, 0, sizeof (vcdinfo_obj_t));
   p_obj->img = p_cdio;  /* Note we do this after the above wipeout! */
 
-  if (!iso9660_fs_read_pvd(p_obj->img, &(p_obj->pvd))) {
+  _vcdinfo_read_toc(p_obj);
+
+  if (i_flags & VCDINFO_OPEN_FLAG_CACHE)
+    vcdinfo_set_sector_cache(p_obj, VCDINFO_CACHE_SECTORS,
+                             VCDINFO_CACHE_READAHEAD);
+
+  /* iso9660_fs_read_pvd() also finds the PVD of a mode 1 disc, which
+     is no VCD but not an error either */
+  if (!_vcdinfo_probe_pvd(p_obj, &(p_obj->pvd))
+      && !iso9660_fs_read_pvd(p_obj->img, &(p_obj->pvd))) {
     goto err_return;
   }
 
@@ -1898,13 +2316,13 @@ vcdinfo_open(vcdinfo_obj_t **pp_obj, char *source_name[],
                            strlen (ISO_XA_MARKER_STRING));
   }
 
-  if (!read_info(p_obj->img, &(p_obj->info), &(p_obj->vcd_type)))
+  if (!read_info(p_obj, &(p_obj->info), &(p_obj->vcd_type)))
     goto other_return;
 
   if (vcdinfo_get_format_version (p_obj) == VCD_TYPE_INVALID)
     goto other_return;
 
-  if (!read_entries(p_obj->img, &(p_obj->entries)))
+  if (!read_entries(p_obj, &(p_obj->entries)))
     goto other_return;
 
   {
@@ -1914,15 +2332,13 @@ vcdinfo_open(vcdinfo_obj_t **pp_obj, char *source_name[],
   }
 
   if (p_obj->vcd_type == VCD_TYPE_SVCD || p_obj->vcd_type == VCD_TYPE_HQVCD) {
-    statbuf = iso9660_fs_stat (p_obj->img, "MPEGAV");
+    statbuf = _vcdinfo_stat (p_obj, "MPEGAV");
 
-    if (NULL != statbuf) {
+    if (NULL != statbuf)
       vcd_warn ("non compliant /MPEGAV folder detected!");
-      free(statbuf);
-    }
 
 
-    statbuf = iso9660_fs_stat (p_obj->img, "SVCD/TRACKS.SVD;1");
+    statbuf = _vcdinfo_stat (p_obj, "SVCD/TRACKS.SVD;1");
     if (NULL != statbuf) {
       lsn_t lsn = statbuf->lsn;
       if (statbuf->size != ISO_BLOCKSIZE)
@@ -1930,8 +2346,7 @@ vcdinfo_open(vcdinfo_obj_t **pp_obj, char *source_name[],
 
       p_obj->tracks_buf = calloc(1, ISO_BLOCKSIZE);
 
-      free(statbuf);
-      if (cdio_read_mode2_sector (p_obj->img, p_obj->tracks_buf, lsn, false))
+      if (vcdinfo_read_mode2_sectors (p_obj, p_obj->tracks_buf, lsn, false, 1))
         goto err_return;
     }
   }
@@ -1939,120 +2354,33 @@ vcdinfo_open(vcdinfo_obj_t **pp_obj, char *source_name[],
   _init_segments (p_obj);
 
   switch (p_obj->vcd_type) {
-  case VCD_TYPE_VCD2: {
-    /* FIXME: Can reduce CD reads by using
-       iso9660_fs_readdir(img, "EXT", true) and then scanning for
-       the files listed below.
-    */
-    statbuf = iso9660_fs_stat (p_cdio, "EXT/PSD_X.VCD;1");
-    if (NULL != statbuf) {
-      lsn_t lsn        = statbuf->lsn;
-      uint32_t secsize = statbuf->secsize;
-
-      p_obj->psd_x       = calloc(1, ISO_BLOCKSIZE * secsize);
-      p_obj->psd_x_size  = statbuf->size;
-
-      vcd_debug ("found /EXT/PSD_X.VCD at sector %lu",
-                 (long unsigned int) lsn);
-
-      free(statbuf);
-      if (cdio_read_mode2_sectors (p_cdio, p_obj->psd_x, lsn, false, secsize))
-        goto err_return;
-    }
-
-    statbuf = iso9660_fs_stat (p_cdio, "EXT/LOT_X.VCD;1");
-    if (NULL != statbuf) {
-      lsn_t lsn        = statbuf->lsn;
-      uint32_t secsize = statbuf->secsize;
-      p_obj->lot_x       = calloc(1, ISO_BLOCKSIZE * secsize);
-
-      vcd_debug ("found /EXT/LOT_X.VCD at sector %lu",
-                 (unsigned long int) lsn);
-
-      if (statbuf->size != LOT_VCD_SIZE * ISO_BLOCKSIZE)
-        vcd_warn ("LOT_X.VCD size != 65535");
-
-      free(statbuf);
-      if (cdio_read_mode2_sectors (p_cdio, p_obj->lot_x, lsn, false, secsize))
-        goto err_return;
-
-    }
-    break;
-  }
   case VCD_TYPE_SVCD:
   case VCD_TYPE_HQVCD: {
-    /* FIXME: Can reduce CD reads by using
-       iso9660_fs_readdir(p_cdio, "SVCD", true) and then scanning for
-       the files listed below.
-    */
-    statbuf = iso9660_fs_stat (p_cdio, "MPEGAV");
-    if (NULL != statbuf) {
+    statbuf = _vcdinfo_stat (p_obj, "MPEGAV");
+    if (NULL != statbuf)
       vcd_warn ("non compliant /MPEGAV folder detected!");
-      free(statbuf);
-    }
 
-    statbuf = iso9660_fs_stat (p_cdio, "SVCD/TRACKS.SVD;1");
+    statbuf = _vcdinfo_stat (p_obj, "SVCD/TRACKS.SVD;1");
     if (NULL == statbuf)
       vcd_warn ("mandatory /SVCD/TRACKS.SVD not found!");
     else {
       vcd_debug ("found TRACKS.SVD signature at sector %lu",
                  (unsigned long int) statbuf->lsn);
-      free(statbuf);
     }
 
-    statbuf = iso9660_fs_stat (p_cdio, "SVCD/SEARCH.DAT;1");
+    statbuf = _vcdinfo_stat (p_obj, "SVCD/SEARCH.DAT;1");
     if (NULL == statbuf)
       vcd_warn ("mandatory /SVCD/SEARCH.DAT not found!");
-    else {
-      lsn_t    lsn       = statbuf->lsn;
-      uint32_t secsize   = statbuf->secsize;
-      uint32_t stat_size = statbuf->size;
-      uint32_t size;
-
-      vcd_debug ("found SEARCH.DAT at sector %lu", (unsigned long int) lsn);
-
-      p_obj->search_buf = calloc(1, ISO_BLOCKSIZE * secsize);
-
-      if (cdio_read_mode2_sectors (p_cdio, p_obj->search_buf, lsn, false, secsize))
-        goto err_return;
-
-      size = (3 * uint16_from_be (((SearchDat_t *)p_obj->search_buf)->scan_points))
-        + sizeof (SearchDat_t);
-
-      free(statbuf);
-      if (size > stat_size) {
-        vcd_warn ("number of scanpoints leads to bigger size than "
-                  "file size of SEARCH.DAT! -- rereading");
-
-        free (p_obj->search_buf);
-        p_obj->search_buf = calloc(1, ISO_BLOCKSIZE
-                                       * _vcd_len2blocks(size, ISO_BLOCKSIZE));
-
-        if (cdio_read_mode2_sectors (p_cdio, p_obj->search_buf, lsn, false,
-                                     secsize))
-          goto err_return;
-      }
-    }
     break;
     }
   default:
     ;
   }
 
-  statbuf = iso9660_fs_stat (p_cdio, "EXT/SCANDATA.DAT;1");
-  if (statbuf != NULL) {
-    lsn_t    lsn       = statbuf->lsn;
-    uint32_t secsize   = statbuf->secsize;
-
-    vcd_debug ("found /EXT/SCANDATA.DAT at sector %u", (unsigned int) lsn);
-
-    p_obj->scandata_buf = calloc(1, ISO_BLOCKSIZE * secsize);
-
-    free(statbuf);
-    if (cdio_read_mode2_sectors (p_cdio, p_obj->scandata_buf, lsn, false,
-                                 secsize))
-      return VCDINFO_OPEN_ERROR;
-  }
+  if (i_flags & VCDINFO_OPEN_FLAG_EAGER)
+    if (!_vcdinfo_load_pbc_x (p_obj) || !_vcdinfo_load_search (p_obj)
+        || !_vcdinfo_load_scandata (p_obj))
+      goto err_return;
 
   return VCDINFO_OPEN_VCD;
 
@@ -2082,6 +2410,8 @@ vcdinfo_close(vcdinfo_obj_t *p_obj)
       _cdio_list_free(p_obj->offset_list, true, NULL);
     if (p_obj->offset_x_list != NULL)
       _cdio_list_free(p_obj->offset_x_list, true, NULL);
+    CDIO_FREE_IF_NOT_NULL(p_obj->offset_index);
+    CDIO_FREE_IF_NOT_NULL(p_obj->offset_x_index);
     CDIO_FREE_IF_NOT_NULL(p_obj->seg_sizes);
     CDIO_FREE_IF_NOT_NULL(p_obj->lot);
     CDIO_FREE_IF_NOT_NULL(p_obj->lot_x);
@@ -2091,6 +2421,9 @@ vcdinfo_close(vcdinfo_obj_t *p_obj)
     CDIO_FREE_IF_NOT_NULL(p_obj->tracks_buf);
     CDIO_FREE_IF_NOT_NULL(p_obj->search_buf);
     CDIO_FREE_IF_NOT_NULL(p_obj->source_name);
+    _vcdinfo_free_dirs(p_obj);
+    _vcdinfo_free_toc(p_obj);
+    _vcdinfo_cache_free(p_obj);
 
     if (p_obj->img != NULL) cdio_destroy (p_obj->img);
     _vcdinfo_zero(p_obj);
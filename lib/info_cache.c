@@ -0,0 +1,322 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Foundation
+    Software, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+/*
+   Sector cache of a vcdinfo_obj_t -- the most recently read sectors
+   are kept in memory, looked up by sector number through a hash and
+   evicted least recently used first.  A read continuing where the
+   previous one ended is taken as sequential access, and the sectors
+   following it are fetched along with it.
+*/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+/* Private headers */
+#include "info_private.h"
+#include "data_structures.h"
+#include "vcd_assert.h"
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <stdio.h>
+
+#include <cdio/cdio.h>
+
+#include <libvcd/info.h>
+#include <libvcd/logging.h>
+
+typedef struct _vcdinfo_sector
+{
+  char key[24];
+  struct _vcdinfo_sector *prev;
+  struct _vcdinfo_sector *next;
+  uint8_t data[M2RAW_SECTOR_SIZE];
+} _vcdinfo_sector_t;
+
+struct _vcdinfo_cache
+{
+  unsigned int i_sectors;   /* sectors kept at most */
+  unsigned int i_readahead; /* sectors fetched ahead on sequential reads */
+
+  VcdHash_t *hash;          /* key -> _vcdinfo_sector_t */
+  _vcdinfo_sector_t *head;  /* most recently used */
+  _vcdinfo_sector_t *tail;
+
+  lsn_t next_lsn;           /* the sector after the last read */
+  bool next_form2;
+
+  vcdinfo_cache_stats_t stats;
+};
+
+static void
+_cache_key (char key[24], lsn_t lsn, bool b_form2)
+{
+  snprintf (key, 24, "%lu/%d", (unsigned long int) lsn, b_form2);
+}
+
+static void
+_cache_unlink (struct _vcdinfo_cache *p_cache, _vcdinfo_sector_t *p_sector)
+{
+  if (p_sector->prev)
+    p_sector->prev->next = p_sector->next;
+  else
+    p_cache->head = p_sector->next;
+
+  if (p_sector->next)
+    p_sector->next->prev = p_sector->prev;
+  else
+    p_cache->tail = p_sector->prev;
+
+  p_sector->prev = p_sector->next = NULL;
+}
+
+static void
+_cache_push (struct _vcdinfo_cache *p_cache, _vcdinfo_sector_t *p_sector)
+{
+  p_sector->next = p_cache->head;
+
+  if (p_cache->head)
+    p_cache->head->prev = p_sector;
+  else
+    p_cache->tail = p_sector;
+
+  p_cache->head = p_sector;
+}
+
+/* copies sector lsn into p_buf and makes it the most recently used one;
+   false if it is not cached */
+static bool
+_cache_get (struct _vcdinfo_cache *p_cache, lsn_t lsn, bool b_form2,
+            uint8_t *p_buf, size_t blocksize)
+{
+  _vcdinfo_sector_t *p_sector;
+  char key[24];
+
+  _cache_key (key, lsn, b_form2);
+
+  if (!(p_sector = _vcd_hash_lookup (p_cache->hash, key)))
+    return false;
+
+  _cache_unlink (p_cache, p_sector);
+  _cache_push (p_cache, p_sector);
+
+  memcpy (p_buf, p_sector->data, blocksize);
+
+  return true;
+}
+
+static void
+_cache_put (struct _vcdinfo_cache *p_cache, lsn_t lsn, bool b_form2,
+            const uint8_t *p_data, size_t blocksize)
+{
+  _vcdinfo_sector_t *p_sector;
+  char key[24];
+
+  _cache_key (key, lsn, b_form2);
+
+  if (_vcd_hash_lookup (p_cache->hash, key))
+    return;
+
+  if (_vcd_hash_length (p_cache->hash) < p_cache->i_sectors)
+    p_sector = calloc (1, sizeof (_vcdinfo_sector_t));
+  else
+    {
+      /* reuse the least recently used one */
+      p_sector = p_cache->tail;
+      _cache_unlink (p_cache, p_sector);
+      _vcd_hash_remove (p_cache->hash, p_sector->key);
+    }
+
+  strcpy (p_sector->key, key);
+  memcpy (p_sector->data, p_data, blocksize);
+
+  _vcd_hash_insert (p_cache->hash, p_sector->key, p_sector);
+  _cache_push (p_cache, p_sector);
+}
+
+void
+_vcdinfo_cache_free (vcdinfo_obj_t *p_obj)
+{
+  struct _vcdinfo_cache *p_cache = p_obj->cache;
+
+  if (!p_cache)
+    return;
+
+  /* the sectors are all in the hash */
+  _vcd_hash_destroy (p_cache->hash, true);
+  free (p_cache);
+
+  p_obj->cache = NULL;
+}
+
+/*!
+  Keep up to i_sectors of the sectors read by vcdinfo_read_mode2_sectors()
+  in memory, and fetch i_readahead sectors at once when reading
+  sequentially.  0 sectors turns the cache off again.
+*/
+bool
+vcdinfo_set_sector_cache (vcdinfo_obj_t *p_obj, unsigned int i_sectors,
+                          unsigned int i_readahead)
+{
+  if (!p_obj)
+    return false;
+
+  _vcdinfo_cache_free (p_obj);
+
+  if (!i_sectors)
+    return true;
+
+  p_obj->cache = calloc (1, sizeof (struct _vcdinfo_cache));
+  p_obj->cache->i_sectors = i_sectors;
+  p_obj->cache->i_readahead = MIN (i_readahead, i_sectors);
+  p_obj->cache->hash = _vcd_hash_new ();
+  p_obj->cache->next_lsn = VCDINFO_NULL_LSN;
+
+  return true;
+}
+
+/*!
+  Get the counters of the sector cache; they are all zero without one.
+*/
+void
+vcdinfo_get_cache_stats (const vcdinfo_obj_t *p_obj,
+                         vcdinfo_cache_stats_t *p_stats)
+{
+  vcd_assert (p_stats != NULL);
+
+  if (p_obj && p_obj->cache)
+    *p_stats = p_obj->cache->stats;
+  else
+    memset (p_stats, 0, sizeof (vcdinfo_cache_stats_t));
+}
+
+/*!
+  Read i_blocks mode 2 sectors from lsn on into p_buf, through the
+  sector cache if there is one.  0 is returned on success, otherwise
+  the error of cdio_read_mode2_sectors().
+*/
+int
+vcdinfo_read_mode2_sectors (const vcdinfo_obj_t *p_obj, void *p_buf,
+                            lsn_t lsn, bool b_form2, unsigned int i_blocks)
+{
+  const size_t blocksize = b_form2 ? M2RAW_SECTOR_SIZE : ISO_BLOCKSIZE;
+  struct _vcdinfo_cache *p_cache;
+  uint8_t *p_out = p_buf;
+  unsigned int i = 0;
+
+  if (!p_obj || !p_obj->img)
+    return DRIVER_OP_UNINIT;
+
+  if (!(p_cache = p_obj->cache))
+    return cdio_read_mode2_sectors (p_obj->img, p_buf, lsn, b_form2, i_blocks);
+
+  while (i < i_blocks)
+    {
+      const bool sequential = (lsn + i == p_cache->next_lsn
+                               && b_form2 == p_cache->next_form2);
+      unsigned int i_miss, i_fetch, n;
+      uint8_t *p_fetch;
+      int rc;
+
+      if (_cache_get (p_cache, lsn + i, b_form2,
+                      p_out + i * blocksize, blocksize))
+        {
+          p_cache->stats.hits++;
+          i++;
+          continue;
+        }
+
+      /* the run of sectors not cached, read with one call */
+      for (i_miss = 1; i + i_miss < i_blocks; i_miss++)
+        {
+          char key[24];
+
+          _cache_key (key, lsn + i + i_miss, b_form2);
+          if (_vcd_hash_lookup (p_cache->hash, key))
+            break;
+        }
+
+      i_fetch = i_miss;
+
+      if (sequential && i + i_miss == i_blocks
+          && i_fetch < p_cache->i_readahead)
+        {
+          const lsn_t end_lsn = cdio_get_disc_last_lsn (p_obj->img);
+
+          i_fetch = p_cache->i_readahead;
+
+          if (end_lsn != CDIO_INVALID_LSN
+              && lsn + i + i_fetch > end_lsn + 1)
+            i_fetch = MAX (end_lsn + 1 - (lsn + i), i_miss);
+        }
+
+      p_fetch = i_fetch > i_miss ? malloc (i_fetch * blocksize)
+        : p_out + i * blocksize;
+
+      rc = cdio_read_mode2_sectors (p_obj->img, p_fetch, lsn + i, b_form2,
+                                    i_fetch);
+
+      if (rc && i_fetch > i_miss)
+        {
+          /* the read-ahead may have run past the readable area */
+          free (p_fetch);
+          p_fetch = p_out + i * blocksize;
+          i_fetch = i_miss;
+
+          rc = cdio_read_mode2_sectors (p_obj->img, p_fetch, lsn + i,
+                                        b_form2, i_fetch);
+        }
+
+      if (rc)
+        return rc;
+
+      for (n = 0; n < i_fetch; n++)
+        _cache_put (p_cache, lsn + i + n, b_form2, p_fetch + n * blocksize,
+                    blocksize);
+
+      if (p_fetch != p_out + i * blocksize)
+        {
+          memcpy (p_out + i * blocksize, p_fetch, i_miss * blocksize);
+          free (p_fetch);
+        }
+
+      p_cache->stats.misses += i_miss;
+      p_cache->stats.readahead += i_fetch - i_miss;
+      p_cache->stats.reads++;
+
+      i += i_miss;
+    }
+
+  p_cache->next_lsn = lsn + i_blocks;
+  p_cache->next_form2 = b_form2;
+
+  return 0;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -66,55 +66,35 @@
   "rejected" LOT entries, some of these might not have gotten filled
   in while scanning PBC (if in fact there even was a PBC).
 
-  Note: We assume that an unassigned LID is one whose value is 0.
+  Note: We assume that an unassigned LID is one whose value is 0.  As
+  the table is sorted by LID with the unassigned ones last, these get
+  the numbers following the highest LID assigned.
  */
 static void
 vcdinf_update_offset_list(struct _vcdinf_pbc_ctx *obj, bool extended)
 {
+  CdioListNode_t *node;
+  CdioList_t *offset_list;
+  lid_t max_seen_lid=0;
+
   if (NULL==obj) return;
-  {
-    CdioListNode_t *node;
-    CdioList_t *unused_lids = _cdio_list_new();
-    CdioListNode_t *next_unused_node = _cdio_list_begin(unused_lids);
 
-    unsigned int last_lid=0;
-    CdioList_t *offset_list = extended ? obj->offset_x_list : obj->offset_list;
+  offset_list = extended ? obj->offset_x_list : obj->offset_list;
 
-    lid_t max_seen_lid=0;
+  _CDIO_LIST_FOREACH (node, offset_list)
+    {
+      vcdinfo_offset_t *ofs = _cdio_list_node_data (node);
 
-    _CDIO_LIST_FOREACH (node, offset_list)
-      {
-        vcdinfo_offset_t *ofs = _cdio_list_node_data (node);
-        if (!ofs->lid) {
-          /* We have a customer! Assign a LID from the free pool
-             or take one from the end if no skipped LIDs.
-          */
-          CdioListNode_t *node=_cdio_list_node_next(next_unused_node);
-          if (node != NULL) {
-            lid_t *next_unused_lid=_cdio_list_node_data(node);
-            ofs->lid = *next_unused_lid;
-            next_unused_node=node;
-          } else {
-            max_seen_lid++;
-            ofs->lid = max_seen_lid;
-          }
-        } else {
-          /* See if we've skipped any LID numbers. */
-          while (last_lid != ofs->lid ) {
-            lid_t * lid=calloc(1, sizeof(lid_t));
-            *lid = last_lid++;
-            _cdio_list_append(unused_lids, lid);
-          }
-          if (last_lid > max_seen_lid) max_seen_lid=last_lid;
-        }
-      }
-    _cdio_list_free(unused_lids, true, NULL);
-  }
+      if (!ofs->lid)
+        ofs->lid = ++max_seen_lid;
+      else if (ofs->lid > max_seen_lid)
+        max_seen_lid = ofs->lid;
+    }
 }
 
 /*!
-   Calls recursive routine to populate obj->offset_list or obj->offset_x_list
-   by going through LOT.
+   Calls vcdinf_visit_pbc() to populate obj->offset_list or
+   obj->offset_x_list by going through LOT.
 
    Returns false if there was some error.
 */
@@ -143,25 +123,57 @@ vcdinf_visit_lot (struct _vcdinf_pbc_ctx *obj)
   return ret;
 }
 
-/*!
-   Recursive routine to populate obj->offset_list or obj->offset_x_list
-   by reading playback control entries referred to via lid.
+/* offsets still to be visited by vcdinf_visit_pbc() */
+struct _vcdinf_pbc_stack {
+  unsigned int *offsets;
+  unsigned int depth;
+  unsigned int size;
+};
 
-   Returns false if there was some error.
-*/
-bool
-vcdinf_visit_pbc (struct _vcdinf_pbc_ctx *obj, lid_t lid, unsigned int offset,
-                  bool in_lot)
+static void
+_vcdinf_pbc_push (struct _vcdinf_pbc_stack *stack,
+                  vcdinfo_offset_t * const *offset_index,
+                  unsigned int index_size, unsigned int offset)
+{
+  switch (offset)
+    {
+    case PSD_OFS_DISABLED:
+    case PSD_OFS_MULTI_DEF:
+    case PSD_OFS_MULTI_DEF_NO_NUM:
+      return;
+
+    default:
+      break;
+    }
+
+  /* been there already */
+  if (offset < index_size && offset_index[offset])
+    return;
+
+  if (stack->depth == stack->size)
+    {
+      stack->size = stack->size ? 2 * stack->size : 64;
+      stack->offsets = realloc (stack->offsets,
+                                stack->size * sizeof (unsigned int));
+    }
+
+  stack->offsets[stack->depth++] = offset;
+}
+
+/* adds the entry at offset to the offset table unless it is there
+   already, and pushes the offsets it refers to onto stack */
+static bool
+_vcdinf_visit_pbc_entry (struct _vcdinf_pbc_ctx *obj, lid_t lid,
+                         unsigned int offset, bool in_lot,
+                         struct _vcdinf_pbc_stack *stack)
 {
-  CdioListNode_t *node;
   vcdinfo_offset_t *ofs;
   unsigned int psd_size  = obj->extended ? obj->psd_x_size : obj->psd_size;
   const uint8_t *psd = obj->extended ? obj->psd_x : obj->psd;
+  const unsigned int index_size = psd_size / obj->offset_mult;
   unsigned int _rofs = offset * obj->offset_mult;
   CdioList_t *offset_list;
-  bool ret=true;
-
-  vcd_assert (psd_size % 8 == 0);
+  vcdinfo_offset_t **offset_index;
 
   switch (offset)
     {
@@ -192,30 +204,32 @@ vcdinf_visit_pbc (struct _vcdinf_pbc_ctx *obj, lid_t lid, unsigned int offset,
 
   if (obj->extended) {
     offset_list = obj->offset_x_list;
-  } else
+    if (!obj->offset_x_index)
+      obj->offset_x_index = calloc (index_size, sizeof (vcdinfo_offset_t *));
+    offset_index = obj->offset_x_index;
+  } else {
     offset_list = obj->offset_list;
+    if (!obj->offset_index)
+      obj->offset_index = calloc (index_size, sizeof (vcdinfo_offset_t *));
+    offset_index = obj->offset_index;
+  }
 
-  _CDIO_LIST_FOREACH (node, offset_list)
+  if ((ofs = offset_index[offset]))
     {
-      ofs = _cdio_list_node_data (node);
-
-      if (offset == ofs->offset)
-        {
-          if (in_lot)
-            ofs->in_lot = true;
-
-          if (lid) {
-            /* Our caller thinks she knows what our LID is.
-               This should help out getting the LID for end descriptors
-               if not other things as well.
-             */
-            ofs->lid = lid;
-          }
+      if (in_lot)
+        ofs->in_lot = true;
+
+      if (lid) {
+        /* Our caller thinks she knows what our LID is.
+           This should help out getting the LID for end descriptors
+           if not other things as well.
+         */
+        ofs->lid = lid;
+      }
 
-          ofs->ext = obj->extended;
+      ofs->ext = obj->extended;
 
-          return true; /* already been there... */
-        }
+      return true; /* already been there... */
     }
 
   ofs = calloc(1, sizeof (vcdinfo_offset_t));
@@ -226,10 +240,11 @@ vcdinf_visit_pbc (struct _vcdinf_pbc_ctx *obj, lid_t lid, unsigned int offset,
   ofs->offset = offset;
   ofs->type   = psd[_rofs];
 
+  /* the offsets referred to are pushed last to first, so that they are
+     visited first to last */
   switch (ofs->type)
     {
     case PSD_TYPE_PLAY_LIST:
-      _cdio_list_append (offset_list, ofs);
       {
         const PsdPlayListDescriptor_t *d = (const void *) (psd + _rofs);
         const lid_t lid = vcdinf_pld_get_lid(d);
@@ -241,16 +256,19 @@ vcdinf_visit_pbc (struct _vcdinf_pbc_ctx *obj, lid_t lid, unsigned int offset,
             vcd_warn ("LOT entry assigned LID %d, but descriptor has LID %d",
                       ofs->lid, lid);
 
-        ret &= vcdinf_visit_pbc (obj, 0, vcdinf_pld_get_prev_offset(d), false);
-        ret &= vcdinf_visit_pbc (obj, 0, vcdinf_pld_get_next_offset(d), false);
-        ret &= vcdinf_visit_pbc (obj, 0, vcdinf_pld_get_return_offset(d),
-                                 false);
+        offset_index[offset] = ofs;
+
+        _vcdinf_pbc_push (stack, offset_index, index_size,
+                          vcdinf_pld_get_return_offset(d));
+        _vcdinf_pbc_push (stack, offset_index, index_size,
+                          vcdinf_pld_get_next_offset(d));
+        _vcdinf_pbc_push (stack, offset_index, index_size,
+                          vcdinf_pld_get_prev_offset(d));
       }
       break;
 
     case PSD_TYPE_EXT_SELECTION_LIST:
     case PSD_TYPE_SELECTION_LIST:
-      _cdio_list_append (offset_list, ofs);
       {
         const PsdSelectionListDescriptor_t *d =
           (const void *) (psd + _rofs);
@@ -264,23 +282,27 @@ vcdinf_visit_pbc (struct _vcdinf_pbc_ctx *obj, lid_t lid, unsigned int offset,
             vcd_warn ("LOT entry assigned LID %d, but descriptor has LID %d",
                       ofs->lid, uint16_from_be (d->lid) & 0x7fff);
 
-        ret &= vcdinf_visit_pbc (obj, 0, vcdinf_psd_get_prev_offset(d), false);
-        ret &= vcdinf_visit_pbc (obj, 0, vcdinf_psd_get_next_offset(d), false);
-        ret &= vcdinf_visit_pbc (obj, 0, vcdinf_psd_get_return_offset(d),
-                                 false);
-        ret &= vcdinf_visit_pbc (obj, 0, vcdinf_psd_get_default_offset(d),
-                                 false);
-        ret &= vcdinf_visit_pbc (obj, 0, uint16_from_be (d->timeout_ofs),
-                                 false);
-
-        for (idx = 0; idx < vcdinf_get_num_selections(d); idx++)
-          ret &= vcdinf_visit_pbc (obj, 0, vcdinf_psd_get_offset(d, idx),
-                                   false);
+        offset_index[offset] = ofs;
+
+        for (idx = vcdinf_get_num_selections(d) - 1; idx >= 0; idx--)
+          _vcdinf_pbc_push (stack, offset_index, index_size,
+                            vcdinf_psd_get_offset(d, idx));
+
+        _vcdinf_pbc_push (stack, offset_index, index_size,
+                          uint16_from_be (d->timeout_ofs));
+        _vcdinf_pbc_push (stack, offset_index, index_size,
+                          vcdinf_psd_get_default_offset(d));
+        _vcdinf_pbc_push (stack, offset_index, index_size,
+                          vcdinf_psd_get_return_offset(d));
+        _vcdinf_pbc_push (stack, offset_index, index_size,
+                          vcdinf_psd_get_next_offset(d));
+        _vcdinf_pbc_push (stack, offset_index, index_size,
+                          vcdinf_psd_get_prev_offset(d));
       }
       break;
 
     case PSD_TYPE_END_LIST:
-      _cdio_list_append (offset_list, ofs);
+      offset_index[offset] = ofs;
       break;
 
     default:
@@ -289,6 +311,36 @@ vcdinf_visit_pbc (struct _vcdinf_pbc_ctx *obj, lid_t lid, unsigned int offset,
       return false;
       break;
     }
+
+  _cdio_list_append (offset_list, ofs);
+  return true;
+}
+
+/*!
+   Populate obj->offset_list or obj->offset_x_list by reading the
+   playback control entry at offset and all entries reachable from it.
+   Each entry is visited once, found through obj->offset_index or
+   obj->offset_x_index.
+
+   Returns false if there was some error.
+*/
+bool
+vcdinf_visit_pbc (struct _vcdinf_pbc_ctx *obj, lid_t lid, unsigned int offset,
+                  bool in_lot)
+{
+  struct _vcdinf_pbc_stack stack = { NULL, 0, 0 };
+  unsigned int psd_size  = obj->extended ? obj->psd_x_size : obj->psd_size;
+  bool ret;
+
+  vcd_assert (psd_size % 8 == 0);
+
+  ret = _vcdinf_visit_pbc_entry (obj, lid, offset, in_lot, &stack);
+
+  while (stack.depth)
+    ret &= _vcdinf_visit_pbc_entry (obj, 0, stack.offsets[--stack.depth],
+                                    false, &stack);
+
+  free (stack.offsets);
   return ret;
 }
 
@@ -38,6 +38,7 @@
 #include <cdio/iso9660.h>
 #include <libvcd/types.h>
 #include <libvcd/files_private.h>
+#include <libvcd/info.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -55,6 +56,11 @@ extern "C" {
 
     CdioList_t *offset_list;
     CdioList_t *offset_x_list;
+    /* offset -> entry of offset_list or offset_x_list */
+    vcdinfo_offset_t **offset_index;
+    vcdinfo_offset_t **offset_x_index;
+    unsigned int offset_index_size;
+    unsigned int offset_x_index_size;
     uint32_t *seg_sizes;
     lsn_t   first_segment_lsn;
 
@@ -71,8 +77,28 @@ extern "C" {
     void *search_buf;
     void *scandata_buf;
 
+    /* psd_x, lot_x, search_buf and scandata_buf are read on first use;
+       these tell whether that has been tried already */
+    bool pbc_x_loaded;
+    bool search_loaded;
+    bool scandata_loaded;
+
     char *source_name; /* VCD device or file currently open */
 
+    /* directory listings read while opening, see _vcdinfo_stat() */
+    CdioList_t *dir_list;
+
+    /* sectors kept by vcdinfo_read_mode2_sectors(), see info_cache.c */
+    struct _vcdinfo_cache *cache;
+
+    /* the TOC as read while opening; index i_tracks is the leadout */
+    track_t i_first_track;
+    track_t i_tracks;
+    lsn_t *track_lsn;
+    lsn_t *track_last_lsn;
+    unsigned int *track_sect_count;  /* filled on first use */
+    unsigned int *track_size;        /* filled on first use */
+
   };
 
   /*!  Return the starting MSF (minutes/secs/frames) for sequence
@@ -82,12 +108,21 @@ extern "C" {
   const msf_t * vcdinf_get_entry_msf(const EntriesVcd_t *entries,
 				     unsigned int entry_num);
 
+  /*!
+     Free the sector cache of p_obj, if any.
+  */
+  void _vcdinfo_cache_free (struct _VcdInfo *p_obj);
+
   struct _vcdinf_pbc_ctx {
     unsigned int psd_size;
     lid_t maximum_lid;
     unsigned offset_mult;
     CdioList_t *offset_x_list;
     CdioList_t *offset_list;
+    /* offset -> entry of offset_list or offset_x_list, with
+       psd_size / offset_mult slots, resp. psd_x_size / offset_mult */
+    vcdinfo_offset_t **offset_index;
+    vcdinfo_offset_t **offset_x_index;
 
     LotVcd_t *lot;
     LotVcd_t *lot_x;
@@ -98,16 +133,16 @@ extern "C" {
   };
 
   /*!
-     Calls recursive routine to populate obj->offset_list or obj->offset_x_list
-     by going through LOT.
+     Calls vcdinf_visit_pbc() to populate obj->offset_list or
+     obj->offset_x_list by going through LOT.
 
      Returns false if there was some error.
   */
   bool vcdinf_visit_lot (struct _vcdinf_pbc_ctx *obj);
 
   /*!
-     Recursive routine to populate obj->offset_list or obj->offset_x_list
-     by reading playback control entries referred to via lid.
+     Populate obj->offset_list or obj->offset_x_list by reading the
+     playback control entry at offset and all entries reachable from it.
 
      Returns false if there was some error.
   */
@@ -24,12 +24,26 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
+
+#ifdef HAVE_PTHREAD_H
+# include <pthread.h>
+# ifndef VCD_THREAD_LOCAL
+/* the handler and the recursion guard are shared by all threads, so
+   every message is handled under the lock */
+#  define _LOG_SHARED
+# endif
+#endif
 
 /* Public headers */
 #include <libvcd/logging.h>
 
 /* Private headers */
 #include "vcd_assert.h"
+#include "util.h"
+
+/* defined here even if the call sites are compiled out */
+#undef vcd_debug
 
 vcd_log_level_t vcd_loglevel_default = VCD_LOG_WARN;
 
@@ -77,38 +91,204 @@ default_vcd_log_handler (vcd_log_level_t level, const char message[])
 
 static vcd_log_handler_t _handler = default_vcd_log_handler;
 
+/* messages below are dropped before being formatted */
+static vcd_log_level_t _threshold = VCD_LOG_DEBUG;
+
+#ifdef HAVE_PTHREAD_H
+
+#define ASYNC_MSG_SIZE 1024
+
+/* the asynchronous handler: a ring of formatted messages, which a
+   background thread hands to the handler it replaced */
+static struct {
+  bool running;
+  vcd_log_handler_t target;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t changed;     /* signalled on every put and take */
+
+  struct {
+    vcd_log_level_t level;
+    char message[ASYNC_MSG_SIZE];
+  } *ring;
+  unsigned size, head, count;
+  bool busy;                  /* thread is passing on a message */
+} _async = {
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+  .changed = PTHREAD_COND_INITIALIZER
+};
+
+#endif /* HAVE_PTHREAD_H */
+
+/* the handler the process-wide messages end up in */
+static vcd_log_handler_t
+_sink_handler (void)
+{
+#ifdef HAVE_PTHREAD_H
+  if (_async.running)
+    return _async.target;
+#endif
+
+  return _handler;
+}
+
+/* a handler installed for the calling thread takes precedence */
+static VCD_THREAD_LOCAL vcd_log_thread_handler_t _thread_handler = NULL;
+static VCD_THREAD_LOCAL void *_thread_user_data = NULL;
+static VCD_THREAD_LOCAL int in_recursion = 0;
+
 vcd_log_handler_t
 vcd_log_set_handler (vcd_log_handler_t new_handler)
 {
-  vcd_log_handler_t old_handler = _handler;
+  vcd_log_handler_t old_handler;
+
+  if (!new_handler)
+    new_handler = default_vcd_log_handler;
 
+#ifdef HAVE_PTHREAD_H
+  if (_async.running)
+    {
+      pthread_mutex_lock (&_async.lock);
+      old_handler = _async.target;
+      _async.target = new_handler;
+      pthread_mutex_unlock (&_async.lock);
+
+      return old_handler;
+    }
+#endif
+
+  old_handler = _handler;
   _handler = new_handler;
 
   return old_handler;
 }
 
+vcd_log_level_t
+vcd_log_set_threshold (vcd_log_level_t level)
+{
+  vcd_log_level_t old_level = _threshold;
+
+  _threshold = level;
+
+  return old_level;
+}
+
+bool
+vcd_log_enabled (vcd_log_level_t level)
+{
+  /* errors terminate the program, never drop them */
+  if (level >= VCD_LOG_ERROR)
+    return true;
+
+  if (level < _threshold)
+    return false;
+
+  /* the default handler would drop it anyway */
+  if (!_thread_handler && level < vcd_loglevel_default
+      && _sink_handler () == default_vcd_log_handler)
+    return false;
+
+  return true;
+}
+
+vcd_log_thread_handler_t
+vcd_log_set_thread_handler (vcd_log_thread_handler_t new_handler,
+                            void *user_data)
+{
+  vcd_log_thread_handler_t old_handler = _thread_handler;
+
+  _thread_handler = new_handler;
+  _thread_user_data = user_data;
+
+  return old_handler;
+}
+
+vcd_log_thread_handler_t
+vcd_log_get_thread_handler (void **user_data)
+{
+  if (user_data)
+    *user_data = _thread_user_data;
+
+  return _thread_handler;
+}
+
+#ifdef HAVE_PTHREAD_H
+/* the process-wide handler may be called from several threads;
+   messages are handed to it one at a time */
+static pthread_mutex_t _log_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+#ifdef _LOG_SHARED
+static pthread_t _log_owner;
+#endif
+
+#ifdef HAVE_PTHREAD_H
+/* ends a message, also when a thread handler ends the thread */
+static void
+_vcd_logv_done (void *arg)
+{
+  in_recursion = 0;
+
+#ifdef _LOG_SHARED
+  pthread_mutex_unlock (&_log_mutex);
+#endif
+}
+#endif
+
 static void
 vcd_logv (vcd_log_level_t level, const char format[], va_list args)
 {
   char buf[1024] = { 0, };
-  static int in_recursion = 0;
 
+#ifdef _LOG_SHARED
+  if (in_recursion && pthread_equal (_log_owner, pthread_self ()))
+    vcd_assert_not_reached ();
+
+  pthread_mutex_lock (&_log_mutex);
+  _log_owner = pthread_self ();
+#else
   if (in_recursion)
     vcd_assert_not_reached ();
+#endif
 
   in_recursion = 1;
 
+#ifdef HAVE_PTHREAD_H
+  pthread_cleanup_push (_vcd_logv_done, NULL);
+#endif
+
   vsnprintf(buf, sizeof(buf)-1, format, args);
 
-  _handler(level, buf);
+  if (_thread_handler)
+    _thread_handler (level, buf, _thread_user_data);
+  else
+    {
+#if defined HAVE_PTHREAD_H && !defined _LOG_SHARED
+      pthread_mutex_lock (&_log_mutex);
+#endif
+
+      _handler(level, buf);
 
+#if defined HAVE_PTHREAD_H && !defined _LOG_SHARED
+      pthread_mutex_unlock (&_log_mutex);
+#endif
+    }
+
+#ifdef HAVE_PTHREAD_H
+  pthread_cleanup_pop (1);
+#else
   in_recursion = 0;
+#endif
 }
 
 void
 vcd_log (vcd_log_level_t level, const char format[], ...)
 {
   va_list args;
+
+  if (!vcd_log_enabled (level))
+    return;
+
   va_start (args, format);
   vcd_logv (level, format, args);
   va_end (args);
@@ -119,6 +299,8 @@ void \
 vcd_ ## level (const char format[], ...) \
 { \
   va_list args; \
+  if (!vcd_log_enabled (VCD_LOG_ ## LEVEL)) \
+    return; \
   va_start (args, format); \
   vcd_logv (VCD_LOG_ ## LEVEL, format, args); \
   va_end (args); \
@@ -131,6 +313,149 @@ VCD_LOG_TEMPLATE(error, ERROR)
 
 #undef VCD_LOG_TEMPLATE
 
+#ifdef HAVE_PTHREAD_H
+
+static void *
+_async_thread (void *user_data)
+{
+  char message[ASYNC_MSG_SIZE];
+  vcd_log_level_t level;
+
+  pthread_mutex_lock (&_async.lock);
+
+  for (;;)
+    {
+      while (!_async.count && _async.running)
+        pthread_cond_wait (&_async.changed, &_async.lock);
+
+      if (!_async.count)
+        break;
+
+      level = _async.ring[_async.head].level;
+      strcpy (message, _async.ring[_async.head].message);
+      _async.head = (_async.head + 1) % _async.size;
+      _async.count--;
+      _async.busy = true;
+      pthread_cond_broadcast (&_async.changed);
+
+      pthread_mutex_unlock (&_async.lock);
+      _async.target (level, message);
+      pthread_mutex_lock (&_async.lock);
+
+      _async.busy = false;
+      pthread_cond_broadcast (&_async.changed);
+    }
+
+  pthread_mutex_unlock (&_async.lock);
+
+  return NULL;
+}
+
+/* waits until all queued messages have been passed on; call with the
+   lock held */
+static void
+_async_drain (void)
+{
+  while (_async.count || _async.busy)
+    pthread_cond_wait (&_async.changed, &_async.lock);
+}
+
+/* installed as the process-wide handler; calls to it are serialized
+   by vcd_logv */
+static void
+_async_handler (vcd_log_level_t level, const char message[])
+{
+  pthread_mutex_lock (&_async.lock);
+
+  if (level >= VCD_LOG_ERROR)
+    {
+      /* may terminate the program, so everything before it has to be
+         out first and it can't wait for the thread */
+      _async_drain ();
+      pthread_mutex_unlock (&_async.lock);
+
+      _async.target (level, message);
+      return;
+    }
+
+  while (_async.count == _async.size)
+    pthread_cond_wait (&_async.changed, &_async.lock);
+
+  {
+    const unsigned tail = (_async.head + _async.count) % _async.size;
+
+    _async.ring[tail].level = level;
+    strncpy (_async.ring[tail].message, message, ASYNC_MSG_SIZE - 1);
+    _async.ring[tail].message[ASYNC_MSG_SIZE - 1] = '\0';
+    _async.count++;
+  }
+
+  pthread_cond_broadcast (&_async.changed);
+  pthread_mutex_unlock (&_async.lock);
+}
+
+bool
+vcd_log_async_start (unsigned queue_size)
+{
+  if (_async.running || !queue_size)
+    return false;
+
+  _async.ring = calloc (queue_size, sizeof (_async.ring[0]));
+  _async.size = queue_size;
+  _async.head = _async.count = 0;
+  _async.target = _handler;
+  _async.running = true;
+
+  if (pthread_create (&_async.thread, NULL, _async_thread, NULL))
+    {
+      _async.running = false;
+      free (_async.ring);
+      _async.ring = NULL;
+
+      return false;
+    }
+
+  _handler = _async_handler;
+
+  return true;
+}
+
+void
+vcd_log_async_stop (void)
+{
+  if (!_async.running)
+    return;
+
+  pthread_mutex_lock (&_log_mutex);
+  _handler = _async.target;
+  pthread_mutex_unlock (&_log_mutex);
+
+  pthread_mutex_lock (&_async.lock);
+  _async.running = false;
+  pthread_cond_broadcast (&_async.changed);
+  pthread_mutex_unlock (&_async.lock);
+
+  pthread_join (_async.thread, NULL);
+
+  free (_async.ring);
+  _async.ring = NULL;
+}
+
+#else /* !HAVE_PTHREAD_H */
+
+bool
+vcd_log_async_start (unsigned queue_size)
+{
+  return false;
+}
+
+void
+vcd_log_async_stop (void)
+{
+}
+
+#endif /* !HAVE_PTHREAD_H */
+
 
 /*
  * Local variables:
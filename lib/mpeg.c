@@ -560,7 +560,7 @@ _analyze_audio_pes (uint8_t streamid, const uint8_t *buf, int len, bool only_pts
   bitpos = _analyze_pes_header (buf, len, state);
 
   /* if only pts extraction was needed, we are done here... */
-  if (only_pts)
+  if (only_pts || state->stream.layout_only)
     return;
 
   if (state->stream.ahdr[aud_idx].seen)
@@ -704,7 +704,7 @@ _analyze_video_pes (uint8_t streamid, const uint8_t *buf, int len, bool only_pts
 
 	case MPEG_USER_CODE:
 	  pos += 4;
-          if (pos + 4 > len)
+          if (pos + 4 > len || state->stream.layout_only)
             break;
           _parse_user_data (streamid, buf + pos, len - pos, pos, state);
 	  break;
@@ -1097,7 +1097,8 @@ vcd_mpeg_parse_packet (const void *_buf, unsigned buflen, bool parse_pes,
               break;
 
             case MPEG_PRIVATE_1_CODE:
-              _analyze_private_1_stream (buf + pos, size, ctx);
+              if (!ctx->stream.layout_only)
+                _analyze_private_1_stream (buf + pos, size, ctx);
               break;
 	    }
 
@@ -131,6 +131,10 @@ typedef struct {
 
     unsigned scan_data;
     unsigned scan_data_warnings;
+
+    /* reduced scan, only packets, timestamps and APS are gathered --
+       audio, OGT and scan data information is left out */
+    bool layout_only;
   } stream;
 } VcdMpegStreamCtx;
 
@@ -24,6 +24,16 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include <cdio/cdio.h>
 #include <cdio/bytesex.h>
@@ -36,6 +46,7 @@
 #include "mpeg_stream.h"
 #include "data_structures.h"
 #include "mpeg.h"
+#include "stats.h"
 #include "util.h"
 
 struct _VcdMpegSource
@@ -43,11 +54,21 @@ struct _VcdMpegSource
   VcdDataSource_t *data_source;
 
   bool scanned;
+  bool strict_aps; /* what the APS lists were gathered with */
+
+  /* file the scan index is looked up for, or NULL */
+  char *index_mpeg_fname;
 
   /* _get_packet cache */
   unsigned _read_pkt_pos;
   unsigned _read_pkt_no;
 
+  /* stream byte offset of each packet, recorded while scanning */
+  unsigned *packet_offsets;
+
+  VcdStat_t scan_stat;
+  VcdStat_t parse_stat;
+
   struct vcd_mpeg_stream_info info;
 };
 
@@ -83,9 +104,25 @@ vcd_mpeg_source_destroy (VcdMpegSource_t *obj, bool destroy_file_obj)
     if (obj->info.shdr[i].aps_list)
       _cdio_list_free (obj->info.shdr[i].aps_list, true, NULL);
 
+  free (obj->packet_offsets);
+  free (obj->index_mpeg_fname);
   free (obj);
 }
 
+void
+_vcd_mpeg_source_add_stats (const VcdMpegSource_t *obj, VcdStats_t *p_stats)
+{
+  VcdStats_t _stats;
+
+  vcd_assert (obj != NULL);
+
+  memset (&_stats, 0, sizeof (_stats));
+  _stats.stage[VCD_STAT_SCAN] = obj->scan_stat;
+  _stats.stage[VCD_STAT_PARSE] = obj->parse_stat;
+
+  _vcd_stats_merge (p_stats, &_stats);
+}
+
 const struct vcd_mpeg_stream_info *
 vcd_mpeg_source_get_info (VcdMpegSource_t *obj)
 {
@@ -105,32 +142,338 @@ vcd_mpeg_source_stat (VcdMpegSource_t *obj)
   return obj->info.packets * 2324;
 }
 
+/*
+ * scan index
+ */
+
+#define INDEX_MAGIC   "VCDSCAN"
+#define INDEX_VERSION 2 /* 1 had no mpeg_mtime_nsec */
+
+struct _index_header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;   /* 0x01020304, as written by the host */
+  uint32_t info_size;    /* sizeof (struct vcd_mpeg_stream_info) */
+  uint32_t strict_aps;
+
+  /* the MPEG file the scan was made of */
+  uint64_t mpeg_size;
+  int64_t mpeg_mtime;
+  uint32_t mpeg_mtime_nsec; /* 0 where stat () gives whole seconds */
+
+  uint32_t packets;
+  uint32_t aligned;      /* packet n starts at n * MPEG_PACKET_SIZE */
+  uint32_t aps_count[3];
+};
+
+/* after the header come the stream info, the APS entries of each
+   sequence header and, unless aligned, the packet offsets */
+
+/* the part of the modification time below a second; an edit within
+   the same second changing nothing else would go unnoticed otherwise */
+static uint32_t
+_index_mtime_nsec (const struct stat *p_statbuf)
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+  return p_statbuf->st_mtim.tv_nsec;
+#else
+  return 0;
+#endif
+}
+
+static char *
+_index_fname (const char mpeg_fname[])
+{
+  char *fname = malloc (strlen (mpeg_fname)
+                        + strlen (VCD_MPEG_INDEX_SUFFIX) + 1);
+
+  strcpy (fname, mpeg_fname);
+  strcat (fname, VCD_MPEG_INDEX_SUFFIX);
+
+  return fname;
+}
+
+static bool
+_load_index (VcdMpegSource_t *obj, bool strict_aps)
+{
+  char *fname = _index_fname (obj->index_mpeg_fname);
+  struct vcd_mpeg_stream_info info;
+  struct _index_header hdr;
+  unsigned *offsets = NULL;
+  struct stat statbuf;
+  FILE *fd = NULL;
+  int i;
+
+  memset (&info, 0, sizeof (info));
+
+  if (stat (obj->index_mpeg_fname, &statbuf)
+      || !(fd = fopen (fname, "rb")))
+    goto fail;
+
+  if (fread (&hdr, sizeof (hdr), 1, fd) != 1
+      || memcmp (hdr.magic, INDEX_MAGIC, sizeof (hdr.magic))
+      || hdr.version > INDEX_VERSION
+      || hdr.byte_order != 0x01020304
+      || hdr.info_size != sizeof (info))
+    {
+      vcd_warn ("ignoring scan index `%s' of unknown format", fname);
+      goto fail;
+    }
+
+  if (hdr.version != INDEX_VERSION
+      || hdr.strict_aps != strict_aps
+      || hdr.mpeg_size != statbuf.st_size
+      || hdr.mpeg_mtime != statbuf.st_mtime
+      || hdr.mpeg_mtime_nsec != _index_mtime_nsec (&statbuf))
+    {
+      vcd_debug ("scan index `%s' is out of date", fname);
+      goto fail;
+    }
+
+  {
+    const bool ok = fread (&info, sizeof (info), 1, fd) == 1;
+
+    /* the lists follow separately */
+    for (i = 0; i < 3; i++)
+      info.shdr[i].aps_list = NULL;
+
+    if (!ok || info.packets != hdr.packets || info.layout_only)
+      goto corrupt;
+  }
+
+  for (i = 0; i < 3; i++)
+    {
+      uint32_t n;
+
+      if (!hdr.aps_count[i])
+        continue;
+
+      info.shdr[i].aps_list = _cdio_list_new ();
+
+      for (n = 0; n < hdr.aps_count[i]; n++)
+        {
+          struct aps_data *_data = malloc (sizeof (struct aps_data));
+
+          _cdio_list_append (info.shdr[i].aps_list, _data);
+
+          if (fread (_data, sizeof (struct aps_data), 1, fd) != 1
+              || _data->packet_no >= info.packets)
+            goto corrupt;
+        }
+    }
+
+  if (info.packets)
+    {
+      offsets = malloc (info.packets * sizeof (unsigned));
+
+      if (hdr.aligned)
+        {
+          unsigned n;
+
+          for (n = 0; n < info.packets; n++)
+            offsets[n] = n * MPEG_PACKET_SIZE;
+        }
+      else if (fread (offsets, sizeof (unsigned), info.packets, fd)
+               != info.packets)
+        goto corrupt;
+
+      /* packets are read at these offsets later on, so they must
+         ascend and stay within the MPEG file */
+      {
+        unsigned n;
+
+        for (n = 0; n < info.packets; n++)
+          if ((n && offsets[n] <= offsets[n - 1])
+              || offsets[n] >= (uint64_t) statbuf.st_size)
+            goto corrupt;
+      }
+    }
+
+  fclose (fd);
+
+  free (obj->packet_offsets);
+  obj->packet_offsets = offsets;
+  obj->_read_pkt_pos = obj->_read_pkt_no = 0;
+
+  obj->info = info;
+  obj->strict_aps = strict_aps;
+  obj->scanned = true;
+
+  vcd_debug ("loaded scan of `%s' from `%s' (%u packets)",
+             obj->index_mpeg_fname, fname, info.packets);
+
+  free (fname);
+
+  return true;
+
+ corrupt:
+  vcd_warn ("scan index `%s' is damaged, ignoring it", fname);
+
+ fail:
+  for (i = 0; i < 3; i++)
+    if (info.shdr[i].aps_list)
+      _cdio_list_free (info.shdr[i].aps_list, true, NULL);
+
+  free (offsets);
+  free (fname);
+
+  if (fd)
+    fclose (fd);
+
+  return false;
+}
+
 void
-vcd_mpeg_source_scan (VcdMpegSource_t *obj, bool strict_aps, bool fix_scan_info,
-                      vcd_mpeg_prog_cb_t callback, void *user_data)
+vcd_mpeg_source_set_index (VcdMpegSource_t *obj, const char mpeg_fname[])
+{
+  vcd_assert (obj != NULL);
+
+  free (obj->index_mpeg_fname);
+  obj->index_mpeg_fname = mpeg_fname ? strdup (mpeg_fname) : NULL;
+}
+
+int
+vcd_mpeg_source_save_index (const VcdMpegSource_t *obj,
+                            const char mpeg_fname[])
+{
+  char *fname;
+  struct vcd_mpeg_stream_info info;
+  struct _index_header hdr;
+  struct stat statbuf;
+  FILE *fd;
+  unsigned n;
+  int i;
+
+  vcd_assert (obj != NULL);
+  vcd_assert (mpeg_fname != NULL);
+  vcd_assert (obj->scanned && !obj->info.layout_only);
+
+  if (stat (mpeg_fname, &statbuf))
+    {
+      vcd_warn ("stat(`%s'): %s", mpeg_fname, strerror (errno));
+      return -1;
+    }
+
+  memset (&hdr, 0, sizeof (hdr));
+  memcpy (hdr.magic, INDEX_MAGIC, sizeof (hdr.magic));
+  hdr.version = INDEX_VERSION;
+  hdr.byte_order = 0x01020304;
+  hdr.info_size = sizeof (info);
+  hdr.strict_aps = obj->strict_aps;
+  hdr.mpeg_size = statbuf.st_size;
+  hdr.mpeg_mtime = statbuf.st_mtime;
+  hdr.mpeg_mtime_nsec = _index_mtime_nsec (&statbuf);
+  hdr.packets = obj->info.packets;
+
+  hdr.aligned = true;
+  for (n = 0; n < obj->info.packets && hdr.aligned; n++)
+    if (obj->packet_offsets[n] != n * MPEG_PACKET_SIZE)
+      hdr.aligned = false;
+
+  info = obj->info;
+
+  for (i = 0; i < 3; i++)
+    {
+      hdr.aps_count[i] = info.shdr[i].aps_list
+        ? _cdio_list_length (info.shdr[i].aps_list) : 0;
+      info.shdr[i].aps_list = NULL;
+    }
+
+  fname = _index_fname (mpeg_fname);
+
+  if (!(fd = fopen (fname, "wb")))
+    {
+      vcd_warn ("fopen(`%s'): %s", fname, strerror (errno));
+      free (fname);
+      return -1;
+    }
+
+  fwrite (&hdr, sizeof (hdr), 1, fd);
+  fwrite (&info, sizeof (info), 1, fd);
+
+  for (i = 0; i < 3; i++)
+    if (obj->info.shdr[i].aps_list)
+      {
+        CdioListNode_t *node;
+
+        _CDIO_LIST_FOREACH (node, obj->info.shdr[i].aps_list)
+          fwrite (_cdio_list_node_data (node), sizeof (struct aps_data), 1,
+                  fd);
+      }
+
+  if (!hdr.aligned)
+    fwrite (obj->packet_offsets, sizeof (unsigned), obj->info.packets, fd);
+
+  if (ferror (fd) | fclose (fd))
+    {
+      vcd_warn ("writing scan index `%s' failed", fname);
+      unlink (fname);
+      free (fname);
+      return -1;
+    }
+
+  free (fname);
+
+  return 0;
+}
+
+static void
+_mpeg_source_scan (VcdMpegSource_t *obj, bool strict_aps, bool fix_scan_info,
+                   bool layout_only, vcd_mpeg_prog_cb_t callback,
+                   void *user_data)
 {
   unsigned length = 0;
   unsigned pos = 0;
   unsigned pno = 0;
   unsigned padbytes = 0;
   unsigned padpackets = 0;
+  unsigned offsets_len = 0;
   VcdMpegStreamCtx state;
   CdioListNode_t *n;
   vcd_mpeg_prog_info_t _progress = { 0, };
+  double _scan_start = _vcd_stat_start ();
 
   vcd_assert (obj != NULL);
 
   if (obj->scanned)
     {
-      vcd_debug ("already scanned... not rescanning");
-      return;
+      if (layout_only || !obj->info.layout_only)
+        {
+          vcd_debug ("already scanned... not rescanning");
+          return;
+        }
+
+      /* a layout-only scan lacks information for writing, start over */
+      vcd_debug ("upgrading layout-only scan to full scan");
+
+      {
+        int i;
+
+        for (i = 0; i < 3; i++)
+          if (obj->info.shdr[i].aps_list)
+            _cdio_list_free (obj->info.shdr[i].aps_list, true, NULL);
+      }
+
+      memset (&(obj->info), 0, sizeof (obj->info));
+      obj->scanned = false;
     }
 
+  if (!layout_only && obj->index_mpeg_fname
+      && _load_index (obj, strict_aps))
+    return;
+
+  free (obj->packet_offsets);
+  obj->packet_offsets = NULL;
+  obj->_read_pkt_pos = obj->_read_pkt_no = 0;
+
   vcd_assert (!obj->scanned);
 
   memset (&state, 0, sizeof (state));
 
-  if (fix_scan_info)
+  state.stream.layout_only = layout_only;
+
+  if (fix_scan_info || layout_only)
     state.stream.scan_data_warnings = VCD_MPEG_SCAN_DATA_WARNS + 1;
 
   vcd_data_source_seek (obj->data_source, 0);
@@ -151,7 +494,13 @@ vcd_mpeg_source_scan (VcdMpegSource_t *obj, bool strict_aps, bool fix_scan_info,
 
       read_len = vcd_data_source_read (obj->data_source, buf, read_len, 1);
 
-      pkt_len = vcd_mpeg_parse_packet (buf, read_len, true, &state);
+      {
+        double _start = _vcd_stat_start ();
+
+        pkt_len = vcd_mpeg_parse_packet (buf, read_len, true, &state);
+
+        _vcd_stat_add (&obj->parse_stat, _start, pkt_len);
+      }
 
       if (!pkt_len)
         {
@@ -204,6 +553,15 @@ vcd_mpeg_source_scan (VcdMpegSource_t *obj, bool strict_aps, bool fix_scan_info,
           break;
         }
 
+      if (pno == offsets_len)
+        {
+          offsets_len = offsets_len ? offsets_len * 2 : 1024;
+          obj->packet_offsets = realloc (obj->packet_offsets,
+                                         offsets_len * sizeof (unsigned));
+        }
+
+      obj->packet_offsets[pno] = pos;
+
       pos += pkt_len;
       pno++;
 
@@ -233,6 +591,7 @@ vcd_mpeg_source_scan (VcdMpegSource_t *obj, bool strict_aps, bool fix_scan_info,
 
   obj->info = state.stream;
   obj->scanned = true;
+  obj->strict_aps = strict_aps;
 
   obj->info.playing_time = obj->info.max_pts - obj->info.min_pts;
 
@@ -242,7 +601,8 @@ vcd_mpeg_source_scan (VcdMpegSource_t *obj, bool strict_aps, bool fix_scan_info,
 
   vcd_debug ("playing time %f", obj->info.playing_time);
 
-  if (!state.stream.scan_data && state.stream.version == MPEG_VERS_MPEG2)
+  if (!state.stream.scan_data && state.stream.version == MPEG_VERS_MPEG2
+      && !layout_only)
     vcd_warn ("mpeg stream contained no scan information (user) data");
 
   {
@@ -264,6 +624,66 @@ vcd_mpeg_source_scan (VcdMpegSource_t *obj, bool strict_aps, bool fix_scan_info,
               padbytes, padpackets, state.stream.packets);
 
   obj->info.version = state.stream.version;
+
+  _vcd_stat_add (&obj->scan_stat, _scan_start, length);
+}
+
+void
+vcd_mpeg_source_scan (VcdMpegSource_t *obj, bool strict_aps, bool fix_scan_info,
+                      vcd_mpeg_prog_cb_t callback, void *user_data)
+{
+  _mpeg_source_scan (obj, strict_aps, fix_scan_info, false,
+                     callback, user_data);
+}
+
+void
+vcd_mpeg_source_scan_layout (VcdMpegSource_t *obj, bool strict_aps,
+                             vcd_mpeg_prog_cb_t callback, void *user_data)
+{
+  _mpeg_source_scan (obj, strict_aps, false, true, callback, user_data);
+}
+
+void
+vcd_mpeg_source_copy_scan (VcdMpegSource_t *obj, const VcdMpegSource_t *src)
+{
+  int i;
+
+  vcd_assert (obj != NULL);
+  vcd_assert (src != NULL);
+  vcd_assert (!obj->scanned);
+  vcd_assert (src->scanned && !src->info.layout_only);
+
+  obj->info = src->info;
+  obj->strict_aps = src->strict_aps;
+
+  for (i = 0; i < 3; i++)
+    if (src->info.shdr[i].aps_list)
+      {
+        CdioListNode_t *n;
+
+        obj->info.shdr[i].aps_list = _cdio_list_new ();
+
+        _CDIO_LIST_FOREACH (n, src->info.shdr[i].aps_list)
+          {
+            struct aps_data *_data = malloc (sizeof (struct aps_data));
+
+            *_data = *(struct aps_data *) _cdio_list_node_data (n);
+            _cdio_list_append (obj->info.shdr[i].aps_list, _data);
+          }
+      }
+
+  free (obj->packet_offsets);
+  obj->packet_offsets = NULL;
+
+  if (src->packet_offsets)
+    {
+      obj->packet_offsets = malloc (src->info.packets * sizeof (unsigned));
+      memcpy (obj->packet_offsets, src->packet_offsets,
+              src->info.packets * sizeof (unsigned));
+    }
+
+  obj->_read_pkt_pos = obj->_read_pkt_no = 0;
+  obj->scanned = true;
 }
 
 static double
@@ -382,7 +802,13 @@ vcd_mpeg_source_get_packet (VcdMpegSource_t *obj, unsigned long packet_no,
       return -1;
     }
 
-  if (packet_no < obj->_read_pkt_no)
+  if (packet_no != obj->_read_pkt_no && obj->packet_offsets)
+    {
+      /* random access, go straight to the packet */
+      obj->_read_pkt_no = packet_no;
+      obj->_read_pkt_pos = obj->packet_offsets[packet_no];
+    }
+  else if (packet_no < obj->_read_pkt_no)
     {
       vcd_warn ("rewinding mpeg stream...");
       obj->_read_pkt_no = 0;
@@ -408,8 +834,14 @@ vcd_mpeg_source_get_packet (VcdMpegSource_t *obj, unsigned long packet_no,
 
       vcd_data_source_read (obj->data_source, buf, read_len, 1);
 
-      pkt_len = vcd_mpeg_parse_packet (buf, read_len,
-                                       fix_scan_info, &state);
+      {
+        double _start = _vcd_stat_start ();
+
+        pkt_len = vcd_mpeg_parse_packet (buf, read_len,
+                                         fix_scan_info, &state);
+
+        _vcd_stat_add (&obj->parse_stat, _start, pkt_len);
+      }
 
       vcd_assert (pkt_len > 0);
 
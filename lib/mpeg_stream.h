@@ -27,6 +27,7 @@
 #include "stream.h"
 #include "data_structures.h"
 #include "mpeg.h"
+#include "stats.h"
 
 #define MPEG_PACKET_SIZE 2324
 
@@ -88,7 +89,36 @@ vcd_mpeg_source_scan (VcdMpegSource_t *obj, bool strict_aps,
                       bool fix_scan_info, vcd_mpeg_prog_cb_t callback, 
                       void *user_data);
 
-/* gets the packet at given position */
+/* reduced scan for size estimation; only packet count, playing time
+   and access points are determined -- a later vcd_mpeg_source_scan()
+   will rescan the stream completely */
+void
+vcd_mpeg_source_scan_layout (VcdMpegSource_t *obj, bool strict_aps,
+                             vcd_mpeg_prog_cb_t callback, void *user_data);
+
+/* takes over the results of a completed vcd_mpeg_source_scan() of src,
+   which has to refer to the same stream, instead of scanning obj */
+void
+vcd_mpeg_source_copy_scan (VcdMpegSource_t *obj, const VcdMpegSource_t *src);
+
+/* scan index -- the results of a complete scan, kept in a file next
+   to the MPEG file so later scans of the unchanged file can load them
+   instead.  It is written in the host's format, as a cache. */
+#define VCD_MPEG_INDEX_SUFFIX ".scan"
+
+/* lets vcd_mpeg_source_scan() load the index of mpeg_fname, the file
+   obj reads, if there is one matching the file and the scan options */
+void
+vcd_mpeg_source_set_index (VcdMpegSource_t *obj, const char mpeg_fname[]);
+
+/* writes the index of a completed scan of obj, which reads the file
+   mpeg_fname; returns 0 on success */
+int
+vcd_mpeg_source_save_index (const VcdMpegSource_t *obj,
+                            const char mpeg_fname[]);
+
+/* gets the packet at given position; packets are located through an
+   offset index built while scanning, so any order of access is fine */
 int
 vcd_mpeg_source_get_packet (VcdMpegSource_t *obj, unsigned long packet_no,
 			    void *packet_buf, 
@@ -107,6 +137,10 @@ vcd_mpeg_source_stat (VcdMpegSource_t *obj);
 void
 vcd_mpeg_source_destroy (VcdMpegSource_t *obj, bool destroy_file_obj);
 
+/* adds the scan and parse counters of obj to p_stats */
+void
+_vcd_mpeg_source_add_stats (const VcdMpegSource_t *obj, VcdStats_t *p_stats);
+
 #endif /* __VCD_MPEG_STREAM__ */
 
 /* 
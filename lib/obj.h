@@ -58,6 +58,10 @@ typedef struct {
 
   /* computed on sector allocation */
   unsigned relative_start_extent; /* relative to iso data end */
+
+  /* packets carrying a pause trigger, for vcd_obj_read_sector () */
+  uint32_t *trigger_packets;
+  unsigned trigger_count;
 } mpeg_sequence_t;
 
 /* work in progress -- fixme rename all occurences */
@@ -79,9 +83,30 @@ typedef struct {
 
   /* computed on sector allocation */
   unsigned start_extent;
+
+  /* packets carrying a pause trigger, for vcd_obj_read_sector () */
+  uint32_t *trigger_packets;
+  unsigned trigger_count;
 } mpeg_segment_t;
 
 
+/* item id index; all ids share one namespace */
+typedef struct {
+  enum {
+    _ID_SEQUENCE = 1,
+    _ID_ENTRY,
+    _ID_SEGMENT,
+    _ID_PBC
+  } type;
+
+  void *data; /* mpeg_sequence_t, entry_t, mpeg_segment_t or pbc_t */
+  mpeg_sequence_t *sequence; /* sequence an entry belongs to */
+
+  /* computed by _vcd_obj_id_lookup () if requested */
+  uint16_t pin; /* play item number, 0 for pbc nodes */
+  unsigned lid; /* list id, 0 for play items */
+} id_ref_t;
+
 typedef struct {
   char *iso_pathname;
   VcdDataSource_t *file;
@@ -92,6 +117,21 @@ typedef struct {
   uint32_t sectors;
 } custom_file_t;
 
+/* the sectors of one item, for vcd_obj_read_sector () */
+typedef struct {
+  uint32_t start; /* first sector */
+  uint32_t end;   /* first sector past the item */
+
+  enum {
+    _EXTENT_SEGMENT = 1,
+    _EXTENT_CUSTOM_FILE,
+    _EXTENT_SEQUENCE
+  } type;
+
+  void *data; /* mpeg_segment_t, custom_file_t or mpeg_sequence_t */
+  int track_idx; /* of a sequence */
+} read_extent_t;
+
 struct _VcdObj {
   vcd_type_t type;
 
@@ -103,6 +143,7 @@ struct _VcdObj {
 
   bool update_scan_offsets;
   bool relaxed_aps;
+  bool layout_scan;
 
   unsigned leadout_pregap;
   unsigned track_pregap;
@@ -111,6 +152,8 @@ struct _VcdObj {
 
   /* output */
   VcdImageSink_t *image_sink;
+  unsigned output_jobs;
+  bool iso_track_only; /* other tracks are in the image sink already */
 
   /* ... */
   unsigned iso_size;
@@ -136,6 +179,9 @@ struct _VcdObj {
 
   /* PBC */
   CdioList_t *pbc_list; /* pbc_t */
+
+  VcdHash_t *id_index; /* id_ref_t */
+  bool id_index_renumber; /* pin/lid numbers are outdated */
   unsigned psd_size;
   unsigned psdx_size;
 
@@ -148,6 +194,10 @@ struct _VcdObj {
   /* dictionary */
   CdioList_t *buffer_dict_list;
 
+  /* sector -> buffer_dict_list entry, built on demand */
+  struct _dict_t **buffer_dict_map;
+  uint32_t buffer_dict_map_len;
+
   /* aggregates */
   VcdSalloc *iso_bitmap;
 
@@ -155,14 +205,35 @@ struct _VcdObj {
 
   /* state info */
   bool in_output;
+  bool in_read; /* vcd_obj_begin_read () was called */
+
+  /* what vcd_obj_read_sector () reads from, ordered by start */
+  read_extent_t *read_extents;
+  unsigned read_extent_count;
 
   unsigned sectors_written;
   unsigned in_track;
 
   long last_cb_call;
 
+  /* encoded all-zero sectors (pregaps, margins, padding), see
+     _make_zero_mode2 */
+  struct {
+    bool valid;
+    uint8_t fnum, cnum, sm, ci;
+    uint8_t sector[CDIO_CD_FRAMESIZE_RAW];
+  } zero_sectors[4];
+  unsigned zero_sectors_next;
+
   progress_callback_t progress_callback;
   void *callback_user_data;
+
+  /* timing and counters of the stages run by this object; the MPEG
+     sources keep their own */
+  VcdStats_t stats;
+
+  /* set in the per-thread copies used for parallel writing */
+  struct _write_jobs *write_jobs;
 };
 
 /* private functions */
@@ -176,6 +247,11 @@ _vcd_obj_get_sequence_by_entry_id (VcdObj_t *obj, const char entry_id[]);
 mpeg_segment_t *
 _vcd_obj_get_segment_by_id (VcdObj_t *obj, const char segment_id[]);
 
+/* looks up item id in the index; pin and lid numbers are only
+   guaranteed to be valid if numbers is set */
+const id_ref_t *
+_vcd_obj_id_lookup (const VcdObj_t *obj, const char id[], bool numbers);
+
 enum vcd_capability_t {
   _CAP_VALID,
   _CAP_MPEG1,
@@ -75,15 +75,10 @@ _wtime (int seconds)
 static pbc_t *
 _vcd_pbc_byid(const VcdObj_t *obj, const char item_id[])
 {
-  CdioListNode_t *p_node;
+  const id_ref_t *p_ref = _vcd_obj_id_lookup (obj, item_id, false);
 
-  _CDIO_LIST_FOREACH (p_node, obj->pbc_list)
-    {
-      pbc_t *_pbc = _cdio_list_node_data (p_node);
-
-      if (_pbc->id && !strcmp (item_id, _pbc->id))
-	return _pbc;
-    }
+  if (p_ref && p_ref->type == _ID_PBC)
+    return p_ref->data;
 
   /* not found */
   return NULL;
@@ -92,20 +87,10 @@ _vcd_pbc_byid(const VcdObj_t *obj, const char item_id[])
 unsigned
 _vcd_pbc_lid_lookup (const VcdObj_t *obj, const char item_id[])
 {
-  CdioListNode_t *p_node;
-  unsigned n = 1;
-
-  _CDIO_LIST_FOREACH (p_node, obj->pbc_list)
-    {
-      pbc_t *_pbc = _cdio_list_node_data (p_node);
-
-      vcd_assert (n < 0x8000);
+  const id_ref_t *p_ref = _vcd_obj_id_lookup (obj, item_id, true);
 
-      if (_pbc->id && !strcmp (item_id, _pbc->id))
-	return n;
-
-      n++;
-    }
+  if (p_ref && p_ref->type == _ID_PBC)
+    return p_ref->lid;
 
   /* not found */
   return 0;
@@ -136,25 +121,27 @@ _set_area_helper (pbc_area_t *dest, const pbc_area_t *src, const char sel_id[])
 enum item_type_t
 _vcd_pbc_lookup (const VcdObj_t *obj, const char item_id[])
 {
-  unsigned id;
+  const id_ref_t *p_ref;
 
   vcd_assert (item_id != NULL);
 
-  if ((id = _vcd_pbc_pin_lookup (obj, item_id)))
+  if (!(p_ref = _vcd_obj_id_lookup (obj, item_id, false)))
+    return ITEM_TYPE_NOTFOUND;
+
+  switch (p_ref->type)
     {
-      if (id < 2)
-	return ITEM_TYPE_NOTFOUND;
-      else if (id < MIN_ENCODED_TRACK_NUM)
-	return ITEM_TYPE_TRACK;
-      else if (id < 600)
-	return ITEM_TYPE_ENTRY;
-      else if (id <= MAX_ENCODED_SEGMENT_NUM)
-	return ITEM_TYPE_SEGMENT;
-      else
-	vcd_assert_not_reached ();
+    case _ID_SEQUENCE:
+      return ITEM_TYPE_TRACK;
+    case _ID_ENTRY:
+      return ITEM_TYPE_ENTRY;
+    case _ID_SEGMENT:
+      return ITEM_TYPE_SEGMENT;
+    case _ID_PBC:
+      return ITEM_TYPE_PBC;
+    default:
+      vcd_assert_not_reached ();
+      break;
     }
-  else if (_vcd_pbc_lid_lookup (obj, item_id))
-    return ITEM_TYPE_PBC;
 
   return ITEM_TYPE_NOTFOUND;
 }
@@ -162,71 +149,15 @@ _vcd_pbc_lookup (const VcdObj_t *obj, const char item_id[])
 uint16_t
 _vcd_pbc_pin_lookup (const VcdObj_t *obj, const char item_id[])
 {
-  int n;
-  CdioListNode_t *p_node;
+  const id_ref_t *p_ref;
 
   if (!item_id)
     return 0;
 
-  /* check sequence items */
-
-  n = 0;
-  _CDIO_LIST_FOREACH (p_node, obj->mpeg_sequence_list)
-    {
-      mpeg_sequence_t *_sequence = _cdio_list_node_data (p_node);
-
-      vcd_assert (n < 98);
-
-      if (_sequence->id && !strcmp (item_id, _sequence->id))
-	return n + 2;
-
-      n++;
-    }
-
-  /* check entry points */
-
-  n = 0;
-  _CDIO_LIST_FOREACH (p_node, obj->mpeg_sequence_list)
-    {
-      mpeg_sequence_t *_sequence = _cdio_list_node_data (p_node);
-      CdioListNode_t *p_node2;
-
-      /* default entry point */
-
-      if (_sequence->default_entry_id
-	  && !strcmp (item_id, _sequence->default_entry_id))
-	return n + 100;
-      n++;
+  p_ref = _vcd_obj_id_lookup (obj, item_id, true);
 
-      /* additional entry points */
-
-      _CDIO_LIST_FOREACH (p_node2, _sequence->entry_list)
-	{
-	  entry_t *_entry = _cdio_list_node_data (p_node2);
-
-	  vcd_assert (n < 500);
-
-	  if (_entry->id && !strcmp (item_id, _entry->id))
-	    return n + 100;
-
-	  n++;
-	}
-    }
-
-  /* check sequence items */
-
-  n = 0;
-  _CDIO_LIST_FOREACH (p_node, obj->mpeg_segment_list)
-    {
-      mpeg_segment_t *_segment = _cdio_list_node_data (p_node);
-
-      vcd_assert (n < 1980);
-
-      if (_segment->id && !strcmp (item_id, _segment->id))
-	return n + MIN_ENCODED_SEGMENT_NUM;
-
-      n += _segment->segment_count;
-    }
+  if (p_ref && p_ref->type != _ID_PBC)
+    return p_ref->pin;
 
   return 0;
 }
@@ -301,7 +232,7 @@ _vcd_pbc_node_length (const VcdObj_t *obj, const pbc_t *p_pbc, bool extended)
 static uint16_t
 _lookup_psd_offset (const VcdObj_t *obj, const char item_id[], bool extended)
 {
-  CdioListNode_t *node;
+  pbc_t *p_pbc;
 
   if (extended)
     vcd_assert (_vcd_obj_has_cap_p (obj, _CAP_PBC_X));
@@ -310,15 +241,9 @@ _lookup_psd_offset (const VcdObj_t *obj, const char item_id[], bool extended)
   if (!item_id)
     return PSD_OFS_DISABLED;
 
-  _CDIO_LIST_FOREACH (node, obj->pbc_list)
-    {
-      pbc_t *p_pbc = _cdio_list_node_data (node);
-
-      if (!p_pbc->id || strcmp (item_id, p_pbc->id))
-	continue;
-
-      return (extended ? p_pbc->offset_ext : p_pbc->offset) / INFO_OFFSET_MULT;
-    }
+  /* offsets have been assigned by _vcd_pbc_finalize () */
+  if ((p_pbc = _vcd_pbc_byid (obj, item_id)))
+    return (extended ? p_pbc->offset_ext : p_pbc->offset) / INFO_OFFSET_MULT;
 
   vcd_error ("PSD: referenced PSD '%s' not found", item_id);
 
@@ -241,6 +241,15 @@ _vcd_make_mode2 (void *raw_sector, const void *data, uint32_t extent,
     }
 }
 
+void
+_vcd_set_mode2_address (void *raw_sector, uint32_t extent)
+{
+  vcd_assert (raw_sector != NULL);
+  vcd_assert (extent != SECTOR_NIL);
+
+  build_address (raw_sector, MODE_2, extent+CDIO_PREGAP_SECTORS);
+}
+
 void
 _vcd_make_raw_mode2 (void *raw_sector, const void *data, uint32_t extent)
 {
@@ -0,0 +1,166 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifndef HAVE_CLOCK_GETTIME
+#include <sys/time.h>
+#endif
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+
+/* Private headers */
+#include "vcd_assert.h"
+#include "stats.h"
+
+static const char *const _stage_names[VCD_STAT_STAGES] = {
+  "scan",
+  "parse",
+  "mode2",
+  "write",
+  "pbc",
+  "image"
+};
+
+bool vcd_stats_enabled = false;
+
+double
+_vcd_stats_clock (void)
+{
+#ifdef HAVE_CLOCK_GETTIME
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+#else
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+
+  return tv.tv_sec + tv.tv_usec / 1e6;
+#endif
+}
+
+void
+_vcd_stats_merge (VcdStats_t *p_stats, const VcdStats_t *p_other)
+{
+  unsigned n;
+
+  vcd_assert (p_stats != NULL);
+  vcd_assert (p_other != NULL);
+
+  for (n = 0; n < VCD_STAT_STAGES; n++)
+    {
+      p_stats->stage[n].seconds += p_other->stage[n].seconds;
+      p_stats->stage[n].calls += p_other->stage[n].calls;
+      p_stats->stage[n].bytes += p_other->stage[n].bytes;
+    }
+
+  if (p_other->peak_rss > p_stats->peak_rss)
+    p_stats->peak_rss = p_other->peak_rss;
+}
+
+unsigned long
+_vcd_stats_peak_rss (void)
+{
+#ifdef HAVE_SYS_RESOURCE_H
+  struct rusage usage;
+
+  if (!getrusage (RUSAGE_SELF, &usage))
+    return usage.ru_maxrss; /* KiB on Linux and the BSDs */
+#endif
+
+  return 0;
+}
+
+const char *
+vcd_stats_stage_name (vcd_stat_stage_t stage)
+{
+  vcd_assert (stage < VCD_STAT_STAGES);
+
+  return _stage_names[stage];
+}
+
+/* MiB/s, 0 if nothing was measured */
+static double
+_throughput (const VcdStat_t *p_stat)
+{
+  if (p_stat->seconds <= 0)
+    return 0;
+
+  return p_stat->bytes / p_stat->seconds / (1024 * 1024);
+}
+
+char *
+vcd_stats_format (const VcdStats_t *p_stats, bool json)
+{
+  char *retval = calloc (1, 256 * (VCD_STAT_STAGES + 2));
+  size_t len = 0;
+  unsigned n;
+
+  vcd_assert (p_stats != NULL);
+
+  if (json)
+    len += sprintf (retval + len, "{\n  \"stages\": {\n");
+
+  for (n = 0; n < VCD_STAT_STAGES; n++)
+    {
+      const VcdStat_t *_stat = &p_stats->stage[n];
+
+      if (json)
+        len += sprintf (retval + len,
+                        "    \"%s\": { \"seconds\": %.6f, \"calls\": %llu,"
+                        " \"bytes\": %llu, \"mib_per_second\": %.2f }%s\n",
+                        _stage_names[n], _stat->seconds,
+                        (unsigned long long) _stat->calls,
+                        (unsigned long long) _stat->bytes,
+                        _throughput (_stat),
+                        n + 1 < VCD_STAT_STAGES ? "," : "");
+      else
+        len += sprintf (retval + len,
+                        "%-6s %10.3f s %12llu calls %14llu bytes"
+                        " %9.2f MiB/s\n",
+                        _stage_names[n], _stat->seconds,
+                        (unsigned long long) _stat->calls,
+                        (unsigned long long) _stat->bytes,
+                        _throughput (_stat));
+    }
+
+  if (json)
+    sprintf (retval + len, "  },\n  \"peak_rss_kib\": %lu\n}\n",
+             p_stats->peak_rss);
+  else
+    sprintf (retval + len, "peak RSS %lu KiB\n", p_stats->peak_rss);
+
+  return retval;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,97 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* per-stage timing and counters of an image build */
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <libvcd/types.h>
+
+typedef enum {
+  VCD_STAT_SCAN = 0,  /* vcd_mpeg_source_scan (), bytes of MPEG input */
+  VCD_STAT_PARSE,     /* vcd_mpeg_parse_packet (), while scanning and
+                         while writing */
+  VCD_STAT_MODE2,     /* mode 2 sector encoding, including EDC/ECC */
+  VCD_STAT_WRITE,     /* vcd_image_sink_write () */
+  VCD_STAT_PBC,       /* PBC finalization, bytes of PSD */
+  VCD_STAT_IMAGE,     /* vcd_obj_write_image () as a whole */
+  VCD_STAT_STAGES
+} vcd_stat_stage_t;
+
+typedef struct {
+  double seconds;     /* monotonic time, summed over all threads */
+  uint64_t calls;
+  uint64_t bytes;
+} VcdStat_t;
+
+typedef struct {
+  VcdStat_t stage[VCD_STAT_STAGES];
+  unsigned long peak_rss; /* KiB, 0 if unknown */
+} VcdStats_t;
+
+/* whether the stages are timed and counted at all; off by default,
+   frontends turn it on before building if they report the numbers */
+extern bool vcd_stats_enabled;
+
+/* seconds since some fixed point in the past */
+double
+_vcd_stats_clock (void);
+
+/* the start of a call to account for with _vcd_stat_add () */
+static inline double
+_vcd_stat_start (void)
+{
+  return vcd_stats_enabled ? _vcd_stats_clock () : 0;
+}
+
+/* accounts for one call that began at _vcd_stat_start () == start */
+static inline void
+_vcd_stat_add (VcdStat_t *p_stat, double start, uint64_t bytes)
+{
+  if (!vcd_stats_enabled)
+    return;
+
+  p_stat->seconds += _vcd_stats_clock () - start;
+  p_stat->calls++;
+  p_stat->bytes += bytes;
+}
+
+void
+_vcd_stats_merge (VcdStats_t *p_stats, const VcdStats_t *p_other);
+
+/* peak resident set size of the process in KiB, 0 if unknown */
+unsigned long
+_vcd_stats_peak_rss (void);
+
+const char *
+vcd_stats_stage_name (vcd_stat_stage_t stage);
+
+/* returns a report (a line per stage, or a JSON object) to be freed
+   by the caller */
+char *
+vcd_stats_format (const VcdStats_t *p_stats, bool json);
+
+#endif /* _STATS_H_ */
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
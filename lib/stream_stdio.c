@@ -42,6 +42,7 @@ typedef struct {
   FILE *fd;
   char *fd_buf;
   off_t st_size; /* used only for source */
+  bool update; /* used only for sink, keep the existing contents */
 } _UserData;
 
 static int
@@ -63,7 +64,7 @@ _stdio_open_sink (void *user_data)
 {
   _UserData *const ud = user_data;
 
-  if ((ud->fd = fopen (ud->pathname, "wb")))
+  if ((ud->fd = fopen (ud->pathname, ud->update ? "r+b" : "wb")))
     {
       ud->fd_buf = calloc(1, VCD_STREAM_STDIO_BUFSIZE);
       setvbuf (ud->fd, ud->fd_buf, _IOFBF, VCD_STREAM_STDIO_BUFSIZE);
@@ -222,6 +223,38 @@ vcd_data_sink_new_stdio(const char pathname[])
   return new_obj;
 }
 
+VcdDataSink*
+vcd_data_sink_new_stdio_update(const char pathname[])
+{
+  VcdDataSink *new_obj = NULL;
+  vcd_data_sink_io_functions funcs;
+  _UserData *ud = NULL;
+  struct stat statbuf;
+
+  if (stat (pathname, &statbuf) == -1)
+    {
+      vcd_error ("could not stat() file `%s': %s", pathname, strerror (errno));
+      return NULL;
+    }
+
+  ud = calloc(1, sizeof (_UserData));
+
+  memset (&funcs, 0, sizeof (funcs));
+
+  ud->pathname = strdup (pathname);
+  ud->update = true;
+
+  funcs.open = _stdio_open_sink;
+  funcs.seek = _stdio_seek;
+  funcs.write = _stdio_write;
+  funcs.close = _stdio_close;
+  funcs.free = _stdio_free;
+
+  new_obj = vcd_data_sink_new (ud, &funcs);
+
+  return new_obj;
+}
+
 
 /*
  * Local variables:
@@ -28,6 +28,11 @@
 VcdDataSink*
 vcd_data_sink_new_stdio(const char pathname[]);
 
+/* like vcd_data_sink_new_stdio (), but the file must exist already and
+   is not truncated; only what gets written is replaced */
+VcdDataSink*
+vcd_data_sink_new_stdio_update(const char pathname[]);
+
 VcdDataSource_t *
 vcd_data_source_new_stdio(const char pathname[]);
 
@@ -24,6 +24,12 @@
 #include <stdlib.h>
 #include <libvcd/types.h>
 
+/* without thread-local storage, state kept per thread is shared by
+   the whole process */
+#ifndef VCD_THREAD_LOCAL
+# define VCD_THREAD_LOCAL
+#endif
+
 static inline unsigned
 _vcd_len2blocks (unsigned len, int blocksize)
 {
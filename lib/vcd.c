@@ -27,6 +27,10 @@
 #include <ctype.h>
 #include <math.h>
 
+#ifdef HAVE_PTHREAD_H
+# include <pthread.h>
+#endif
+
 #define _VCD_INFO_PRIVATE_H
 /* We don't want to pull in cdio's config */
 #define __CDIO_CONFIG_H__
@@ -72,24 +76,173 @@ static void cue_data_free(vcd_cue_t *data)
 }
 
 
+/* item id index
+ */
+
+static bool
+_vcd_obj_id_register (VcdObj_t *p_obj, const char id[], int type,
+                      void *data, mpeg_sequence_t *p_sequence)
+{
+  id_ref_t *p_ref;
+
+  if (!id)
+    return true;
+
+  p_ref = calloc(1, sizeof (id_ref_t));
+  p_ref->type = type;
+  p_ref->data = data;
+  p_ref->sequence = p_sequence;
+
+  p_obj->id_index_renumber = true;
+
+  if (!_vcd_hash_insert (p_obj->id_index, id, p_ref))
+    {
+      free (p_ref);
+      return false;
+    }
+
+  return true;
+}
+
+static void
+_vcd_obj_id_unregister (VcdObj_t *p_obj, const char id[])
+{
+  if (!id)
+    return;
+
+  free (_vcd_hash_remove (p_obj->id_index, id));
+
+  p_obj->id_index_renumber = true;
+}
+
+static void
+_vcd_obj_id_set_number (VcdObj_t *p_obj, const char id[],
+                        uint16_t pin, unsigned lid)
+{
+  id_ref_t *p_ref;
+
+  if (!id || !(p_ref = _vcd_hash_lookup (p_obj->id_index, id)))
+    return;
+
+  p_ref->pin = pin;
+  p_ref->lid = lid;
+}
+
+/* the numbering follows list order, which is why it has to be
+   redone for all items whenever an item gets added or removed */
+static void
+_vcd_obj_id_renumber (VcdObj_t *p_obj)
+{
+  CdioListNode_t *p_node;
+  unsigned n;
+
+  /* sequence items */
+
+  n = 0;
+  _CDIO_LIST_FOREACH (p_node, p_obj->mpeg_sequence_list)
+    {
+      mpeg_sequence_t *_sequence = _cdio_list_node_data (p_node);
+
+      vcd_assert (n < 98);
+
+      _vcd_obj_id_set_number (p_obj, _sequence->id, n + 2, 0);
+
+      n++;
+    }
+
+  /* entry points */
+
+  n = 0;
+  _CDIO_LIST_FOREACH (p_node, p_obj->mpeg_sequence_list)
+    {
+      mpeg_sequence_t *_sequence = _cdio_list_node_data (p_node);
+      CdioListNode_t *p_node2;
+
+      /* default entry point */
+
+      _vcd_obj_id_set_number (p_obj, _sequence->default_entry_id, n + 100, 0);
+      n++;
+
+      /* additional entry points */
+
+      _CDIO_LIST_FOREACH (p_node2, _sequence->entry_list)
+        {
+          entry_t *_entry = _cdio_list_node_data (p_node2);
+
+          vcd_assert (n < 500);
+
+          _vcd_obj_id_set_number (p_obj, _entry->id, n + 100, 0);
+
+          n++;
+        }
+    }
+
+  /* segment items */
+
+  n = 0;
+  _CDIO_LIST_FOREACH (p_node, p_obj->mpeg_segment_list)
+    {
+      mpeg_segment_t *_segment = _cdio_list_node_data (p_node);
+
+      vcd_assert (n < 1980);
+
+      _vcd_obj_id_set_number (p_obj, _segment->id,
+                              n + MIN_ENCODED_SEGMENT_NUM, 0);
+
+      n += _segment->segment_count;
+    }
+
+  /* pbc list ids */
+
+  n = 1;
+  _CDIO_LIST_FOREACH (p_node, p_obj->pbc_list)
+    {
+      pbc_t *_pbc = _cdio_list_node_data (p_node);
+      id_ref_t *p_ref;
+
+      vcd_assert (n < 0x8000);
+
+      /* on duplicate ids only the first node is indexed */
+      if (_pbc->id
+          && (p_ref = _vcd_hash_lookup (p_obj->id_index, _pbc->id))
+          && p_ref->data == _pbc)
+        p_ref->lid = n;
+
+      n++;
+    }
+
+  p_obj->id_index_renumber = false;
+}
+
 /* exported private functions
  */
 
+const id_ref_t *
+_vcd_obj_id_lookup (const VcdObj_t *p_obj, const char id[], bool numbers)
+{
+  vcd_assert (p_obj != NULL);
+
+  if (!id)
+    return NULL;
+
+  if (numbers && p_obj->id_index_renumber)
+    _vcd_obj_id_renumber ((VcdObj_t *) p_obj);
+
+  return _vcd_hash_lookup (p_obj->id_index, id);
+}
+
 mpeg_sequence_t *
 _vcd_obj_get_sequence_by_id (VcdObj_t *p_obj, const char sequence_id[])
 {
-  CdioListNode_t *node;
+  const id_ref_t *p_ref;
 
   vcd_assert (sequence_id != NULL);
   vcd_assert (p_obj != NULL);
 
-  _CDIO_LIST_FOREACH (node, p_obj->mpeg_sequence_list)
-    {
-      mpeg_sequence_t *_sequence = _cdio_list_node_data (node);
+  p_ref = _vcd_obj_id_lookup (p_obj, sequence_id, false);
 
-      if (_sequence->id && !strcmp (sequence_id, _sequence->id))
-        return _sequence;
-    }
+  if (p_ref && p_ref->type == _ID_SEQUENCE)
+    return p_ref->data;
 
   return NULL;
 }
@@ -97,31 +250,15 @@ _vcd_obj_get_sequence_by_id (VcdObj_t *p_obj, const char sequence_id[])
 mpeg_sequence_t *
 _vcd_obj_get_sequence_by_entry_id (VcdObj_t *p_obj, const char entry_id[])
 {
-  CdioListNode_t *node;
+  const id_ref_t *p_ref;
 
   vcd_assert (entry_id != NULL);
   vcd_assert (p_obj != NULL);
 
-  _CDIO_LIST_FOREACH (node, p_obj->mpeg_sequence_list)
-    {
-      mpeg_sequence_t *_sequence = _cdio_list_node_data (node);
-      CdioListNode_t *node2;
-
-      /* default entry point */
-      if (_sequence->default_entry_id
-          && !strcmp (entry_id, _sequence->default_entry_id))
-        return _sequence;
-
-      /* additional entry points */
-      _CDIO_LIST_FOREACH (node2, _sequence->entry_list)
-	{
-	  entry_t *_entry = _cdio_list_node_data (node2);
+  p_ref = _vcd_obj_id_lookup (p_obj, entry_id, false);
 
-	  if (_entry->id
-              && !strcmp (entry_id, _entry->id))
-	    return _sequence;
-	}
-    }
+  if (p_ref && p_ref->type == _ID_ENTRY)
+    return p_ref->sequence;
 
   /* not found */
 
@@ -131,18 +268,15 @@ _vcd_obj_get_sequence_by_entry_id (VcdObj_t *p_obj, const char entry_id[])
 mpeg_segment_t *
 _vcd_obj_get_segment_by_id (VcdObj_t *p_obj, const char segment_id[])
 {
-  CdioListNode_t *node;
+  const id_ref_t *p_ref;
 
   vcd_assert (segment_id != NULL);
   vcd_assert (p_obj != NULL);
 
-  _CDIO_LIST_FOREACH (node, p_obj->mpeg_segment_list)
-    {
-      mpeg_segment_t *_segment = _cdio_list_node_data (node);
+  p_ref = _vcd_obj_id_lookup (p_obj, segment_id, false);
 
-      if (_segment->id && !strcmp (segment_id, _segment->id))
-        return _segment;
-    }
+  if (p_ref && p_ref->type == _ID_SEGMENT)
+    return p_ref->data;
 
   return NULL;
 }
@@ -310,6 +444,8 @@ vcd_obj_new (vcd_type_t vcd_type)
 
   p_new_obj->pbc_list = _cdio_list_new ();
 
+  p_new_obj->id_index = _vcd_hash_new ();
+
   /* gap's defined by IEC-10149 / ECMA-130 */
 
   /* pre-gap's for tracks but the first one */
@@ -317,6 +453,8 @@ vcd_obj_new (vcd_type_t vcd_type)
   /* post-gap after last track */
   p_new_obj->leadout_pregap = CDIO_POSTGAP_SECTORS;
 
+  p_new_obj->output_jobs = 1;
+
   if (_vcd_obj_has_cap_p (p_new_obj, _CAP_TRACK_MARGINS))
     {
       p_new_obj->track_front_margin = 30;
@@ -354,6 +492,17 @@ _vcd_obj_remove_mpeg_track (VcdObj_t *p_vcdobj, int track_id)
 
   track = (mpeg_sequence_t *) _cdio_list_node_data (node);
 
+  _vcd_obj_id_unregister (p_vcdobj, track->id);
+  _vcd_obj_id_unregister (p_vcdobj, track->default_entry_id);
+
+  {
+    CdioListNode_t *node2;
+
+    _CDIO_LIST_FOREACH (node2, track->entry_list)
+      _vcd_obj_id_unregister (p_vcdobj,
+                              ((entry_t *) _cdio_list_node_data (node2))->id);
+  }
+
   vcd_mpeg_source_destroy (track->source, true);
 
   length = track->info ? track->info->packets : 0;
@@ -405,8 +554,12 @@ vcd_obj_append_segment_play_item (VcdObj_t *p_vcdobj,
   vcd_info ("scanning mpeg segment item #%d for scanpoints...",
             _cdio_list_length (p_vcdobj->mpeg_segment_list));
 
-  vcd_mpeg_source_scan (p_mpeg_source, !p_vcdobj->relaxed_aps,
-                        p_vcdobj->update_scan_offsets, NULL, NULL);
+  if (p_vcdobj->layout_scan)
+    vcd_mpeg_source_scan_layout (p_mpeg_source, !p_vcdobj->relaxed_aps,
+                                 NULL, NULL);
+  else
+    vcd_mpeg_source_scan (p_mpeg_source, !p_vcdobj->relaxed_aps,
+                          p_vcdobj->update_scan_offsets, NULL, NULL);
 
   if (vcd_mpeg_source_get_info (p_mpeg_source)->packets == 0)
     {
@@ -433,6 +586,8 @@ vcd_obj_append_segment_play_item (VcdObj_t *p_vcdobj,
 
   _cdio_list_append (p_vcdobj->mpeg_segment_list, segment);
 
+  _vcd_obj_id_register (p_vcdobj, segment->id, _ID_SEGMENT, segment, NULL);
+
   return 0;
 }
 
@@ -468,8 +623,12 @@ vcd_obj_append_sequence_play_item (VcdObj_t *p_vcdobj,
     }
 
   vcd_info ("scanning mpeg sequence item #%d for scanpoints...", track_no);
-  vcd_mpeg_source_scan (p_mpeg_source, !p_vcdobj->relaxed_aps,
-                        p_vcdobj->update_scan_offsets, NULL, NULL);
+  if (p_vcdobj->layout_scan)
+    vcd_mpeg_source_scan_layout (p_mpeg_source, !p_vcdobj->relaxed_aps,
+                                 NULL, NULL);
+  else
+    vcd_mpeg_source_scan (p_mpeg_source, !p_vcdobj->relaxed_aps,
+                          p_vcdobj->update_scan_offsets, NULL, NULL);
 
   sequence = calloc(1, sizeof (mpeg_sequence_t));
 
@@ -516,6 +675,8 @@ vcd_obj_append_sequence_play_item (VcdObj_t *p_vcdobj,
       || sequence->info->shdr[2].seen)
     vcd_warn ("sequence items should contain a motion video stream!");
 
+  /* audio headers are not examined by layout-only scans */
+  if (!sequence->info->layout_only)
   {
     int i;
 
@@ -550,6 +711,10 @@ vcd_obj_append_sequence_play_item (VcdObj_t *p_vcdobj,
 
   _cdio_list_append (p_vcdobj->mpeg_sequence_list, sequence);
 
+  _vcd_obj_id_register (p_vcdobj, sequence->id, _ID_SEQUENCE, sequence, NULL);
+  _vcd_obj_id_register (p_vcdobj, sequence->default_entry_id, _ID_ENTRY,
+                        NULL, sequence);
+
   return track_no;
 }
 
@@ -698,6 +863,8 @@ vcd_obj_add_sequence_entry (VcdObj_t *p_obj, const char sequence_id[],
     _entry->time = entry_time;
 
     _cdio_list_append (p_sequence->entry_list, _entry);
+
+    _vcd_obj_id_register (p_obj, _entry->id, _ID_ENTRY, _entry, p_sequence);
   }
 
   _vcd_list_sort (p_sequence->entry_list,
@@ -712,7 +879,10 @@ vcd_obj_destroy (VcdObj_t *p_obj)
   CdioListNode_t *p_node;
 
   vcd_assert (p_obj != NULL);
-  vcd_assert (!p_obj->in_output);
+
+  /* left in output by an error */
+  if (p_obj->in_output)
+    vcd_obj_end_output (p_obj);
 
   free (p_obj->iso_volume_label);
   free (p_obj->iso_application_id);
@@ -721,6 +891,7 @@ vcd_obj_destroy (VcdObj_t *p_obj)
     {
       custom_file_t *p = _cdio_list_node_data (p_node);
 
+      vcd_data_source_destroy (p->file);
       free (p->iso_pathname);
     }
 
@@ -728,10 +899,24 @@ vcd_obj_destroy (VcdObj_t *p_obj)
 
   _cdio_list_free (p_obj->custom_dir_list, true, NULL);
 
+  _CDIO_LIST_FOREACH (p_node, p_obj->mpeg_segment_list)
+    {
+      mpeg_segment_t *p_segment = _cdio_list_node_data (p_node);
+
+      vcd_mpeg_source_destroy (p_segment->source, true);
+      free (p_segment->id);
+      free (p_segment->trigger_packets);
+      _cdio_list_free (p_segment->pause_list, true, NULL);
+    }
+
+  _cdio_list_free (p_obj->mpeg_segment_list, true, NULL);
+
   while (_cdio_list_length (p_obj->mpeg_sequence_list))
     _vcd_obj_remove_mpeg_track (p_obj, 0);
   _cdio_list_free (p_obj->mpeg_sequence_list, true, (CdioDataFree_t) &sequence_free);
 
+  _vcd_hash_destroy (p_obj->id_index, true);
+
   free (p_obj);
 }
 
@@ -834,6 +1019,18 @@ vcd_obj_set_param_uint (VcdObj_t *p_obj, vcd_parm_t param, unsigned arg)
       vcd_debug ("changed rear margin to %u", p_obj->track_rear_margin);
       break;
 
+    case VCD_PARM_OUTPUT_JOBS:
+      p_obj->output_jobs = MAX (arg, 1);
+#ifndef HAVE_PTHREAD_H
+      if (p_obj->output_jobs > 1)
+        {
+          vcd_warn ("parallel writing not supported, using a single job");
+          p_obj->output_jobs = 1;
+        }
+#endif
+      vcd_debug ("changed output jobs to %u", p_obj->output_jobs);
+      break;
+
     default:
       vcd_assert_not_reached ();
       break;
@@ -925,6 +1122,16 @@ vcd_obj_set_param_bool (VcdObj_t *p_obj, vcd_parm_t param, bool arg)
       vcd_debug ("changing 'relaxed aps' to %d", p_obj->relaxed_aps);
       break;
 
+    case VCD_PARM_LAYOUT_SCAN:
+      p_obj->layout_scan = arg ? true : false;
+      vcd_debug ("changing 'layout scan' to %d", p_obj->layout_scan);
+      break;
+
+    case VCD_PARM_ISO_TRACK_ONLY:
+      p_obj->iso_track_only = arg ? true : false;
+      vcd_debug ("changing 'iso track only' to %d", p_obj->iso_track_only);
+      break;
+
     case VCD_PARM_NEXT_VOL_LID2:
       p_obj->info_use_lid2 = arg ? true : false;
       vcd_debug ("changing 'next volume use lid 2' to %d",
@@ -1014,11 +1221,9 @@ vcd_obj_add_dir (VcdObj_t *p_obj, const char iso_pathname[])
       return 1;
     }
 
+  /* gets sorted when the filesystem is built */
   _cdio_list_append (p_obj->custom_dir_list, _iso_pathname);
 
-  _vcd_list_sort (p_obj->custom_dir_list,
-                  (_cdio_list_cmp_func_t) strcmp);
-
   return 0;
 }
 
@@ -1373,7 +1578,10 @@ _finalize_vcd_iso_track_filesystem (VcdObj_t *p_obj)
                              get_scandata_dat_size (p_obj), false, 0);
     }
 
-  /* custom files/dirs */
+  /* custom files/dirs -- sorted, so parents get created first */
+  _vcd_list_sort (p_obj->custom_dir_list,
+                  (_cdio_list_cmp_func_t) strcmp);
+
   _CDIO_LIST_FOREACH (p_node, p_obj->custom_dir_list)
     {
       char *p = _cdio_list_node_data (p_node);
@@ -1487,11 +1695,103 @@ _finalize_vcd_iso_track_filesystem (VcdObj_t *p_obj)
 static void
 _finalize_vcd_iso_track (VcdObj_t *p_obj)
 {
+  double _start = _vcd_stat_start ();
+
   _vcd_pbc_finalize (p_obj);
+  _vcd_stat_add (&p_obj->stats.stage[VCD_STAT_PBC], _start,
+                 p_obj->psd_size);
+
   _finalize_vcd_iso_track_allocation (p_obj);
   _finalize_vcd_iso_track_filesystem (p_obj);
 }
 
+#ifdef HAVE_PTHREAD_H
+
+/* shared state of the threads writing the tracks of an image in
+   parallel; each thread writes whole tracks through its own copy of
+   the VcdObj_t, with write_jobs pointing here */
+struct _write_jobs {
+  VcdObj_t view;              /* template for the per-thread copies */
+  const time_t *create_time;
+
+  pthread_mutex_t lock;       /* protects the members below and the
+                                 image sink */
+  pthread_cond_t progress;
+  pthread_cond_t window;      /* signalled when the write frontier
+                                 moves */
+
+  unsigned tracks;            /* including the ISO9660 track */
+  unsigned next_track;
+  bool *track_done;
+  uint32_t *track_next;       /* next extent to write, per track */
+  unsigned first_open;        /* first track not done yet */
+  unsigned window_waiters;
+  unsigned running;           /* threads not finished yet */
+
+  unsigned sectors_written;   /* sum over all threads */
+  bool abort;
+
+  VcdStats_t stats;           /* sum over all threads */
+
+  /* log handler of the calling thread, for the writer threads */
+  vcd_log_thread_handler_t log_handler;
+  void *log_user_data;
+};
+
+/* sectors a thread may write ahead of the first sector not written
+   yet; this bounds what sinks needing the sectors in order (digest)
+   have to hold back */
+#define WRITE_JOBS_WINDOW 4096
+
+/* all sectors before the returned extent have been written; the lock
+   must be held */
+static uint32_t
+_write_jobs_frontier (const struct _write_jobs *jobs)
+{
+  if (jobs->first_open >= jobs->tracks)
+    return UINT32_MAX;
+
+  return jobs->track_next[jobs->first_open];
+}
+
+/* marks track as done and moves the frontier on; the lock must be
+   held */
+static void
+_write_jobs_track_done (struct _write_jobs *jobs, unsigned track)
+{
+  jobs->track_done[track] = true;
+
+  while (jobs->first_open < jobs->tracks
+         && jobs->track_done[jobs->first_open])
+    jobs->first_open++;
+
+  if (jobs->window_waiters)
+    pthread_cond_broadcast (&jobs->window);
+}
+
+/* hands the sectors written since the last call over to the thread
+   reporting the progress */
+static int
+_write_jobs_progress (VcdObj_t *p_obj)
+{
+  struct _write_jobs *jobs = p_obj->write_jobs;
+  int retval;
+
+  pthread_mutex_lock (&jobs->lock);
+
+  jobs->sectors_written += p_obj->sectors_written - p_obj->last_cb_call;
+  retval = jobs->abort;
+
+  pthread_cond_signal (&jobs->progress);
+  pthread_mutex_unlock (&jobs->lock);
+
+  p_obj->last_cb_call = p_obj->sectors_written;
+
+  return retval;
+}
+
+#endif
+
 static int
 _callback_wrapper (VcdObj_t *p_obj, int force)
 {
@@ -1500,6 +1800,11 @@ _callback_wrapper (VcdObj_t *p_obj, int force)
   if (p_obj->last_cb_call + cb_frequency > p_obj->sectors_written && !force)
     return 0;
 
+#ifdef HAVE_PTHREAD_H
+  if (p_obj->write_jobs)
+    return _write_jobs_progress (p_obj);
+#endif
+
   p_obj->last_cb_call = p_obj->sectors_written;
 
   if (p_obj->progress_callback) {
@@ -1516,17 +1821,113 @@ _callback_wrapper (VcdObj_t *p_obj, int force)
     return 0;
 }
 
+static void
+_image_sink_write (VcdObj_t *obj, void *buf, uint32_t extent)
+{
+  double _start;
+
+#ifdef HAVE_PTHREAD_H
+  if (obj->write_jobs)
+    {
+      struct _write_jobs *jobs = obj->write_jobs;
+      const unsigned track = obj->in_track - 1;
+
+      pthread_mutex_lock (&jobs->lock);
+
+      /* tracks later on the disc wait for the earlier ones to catch
+         up; the first open track is always inside the window */
+      while (extent >= _write_jobs_frontier (jobs)
+             && extent - _write_jobs_frontier (jobs) >= WRITE_JOBS_WINDOW
+             && !jobs->abort)
+        {
+          jobs->window_waiters++;
+          pthread_cond_wait (&jobs->window, &jobs->lock);
+          jobs->window_waiters--;
+        }
+
+      _start = _vcd_stat_start ();
+      vcd_image_sink_write (obj->image_sink, buf, extent);
+      _vcd_stat_add (&obj->stats.stage[VCD_STAT_WRITE], _start,
+                     CDIO_CD_FRAMESIZE_RAW);
+
+      jobs->track_next[track] = extent + 1;
+      if (track == jobs->first_open && jobs->window_waiters)
+        pthread_cond_broadcast (&jobs->window);
+
+      pthread_mutex_unlock (&jobs->lock);
+      return;
+    }
+#endif
+
+  _start = _vcd_stat_start ();
+  vcd_image_sink_write (obj->image_sink, buf, extent);
+  _vcd_stat_add (&obj->stats.stage[VCD_STAT_WRITE], _start,
+                 CDIO_CD_FRAMESIZE_RAW);
+}
+
+/* the encoded form of an all-zero sector only depends on its
+   subheader and address, and the address is not covered by EDC and
+   ECC; so zero sectors are copied from a template and readdressed */
+static void
+_make_zero_mode2 (VcdObj_t *obj, void *buf, uint32_t extent,
+                  uint8_t fnum, uint8_t cnum, uint8_t sm, uint8_t ci)
+{
+  const unsigned count = sizeof (obj->zero_sectors)
+    / sizeof (obj->zero_sectors[0]);
+  unsigned n;
+
+  for (n = 0; n < count; n++)
+    if (obj->zero_sectors[n].valid
+        && obj->zero_sectors[n].fnum == fnum
+        && obj->zero_sectors[n].cnum == cnum
+        && obj->zero_sectors[n].sm == sm
+        && obj->zero_sectors[n].ci == ci)
+      break;
+
+  if (n == count)
+    {
+      n = obj->zero_sectors_next++ % count;
+
+      _vcd_make_mode2 (obj->zero_sectors[n].sector, zero, extent,
+                       fnum, cnum, sm, ci);
+
+      obj->zero_sectors[n].valid = true;
+      obj->zero_sectors[n].fnum = fnum;
+      obj->zero_sectors[n].cnum = cnum;
+      obj->zero_sectors[n].sm = sm;
+      obj->zero_sectors[n].ci = ci;
+    }
+
+  memcpy (buf, obj->zero_sectors[n].sector, CDIO_CD_FRAMESIZE_RAW);
+  _vcd_set_mode2_address (buf, extent);
+}
+
+static void
+_make_m2_sector (VcdObj_t *obj, void *buf, const void *data, uint32_t extent,
+                 uint8_t fnum, uint8_t cnum, uint8_t sm, uint8_t ci)
+{
+  double _start = _vcd_stat_start ();
+
+  if (data == zero)
+    _make_zero_mode2 (obj, buf, extent, fnum, cnum, sm, ci);
+  else
+    _vcd_make_mode2 (buf, data, extent, fnum, cnum, sm, ci);
+
+  _vcd_stat_add (&obj->stats.stage[VCD_STAT_MODE2], _start,
+                 CDIO_CD_FRAMESIZE_RAW);
+}
+
 static int
 _write_m2_image_sector (VcdObj_t *obj, const void *data, uint32_t extent,
                         uint8_t fnum, uint8_t cnum, uint8_t sm, uint8_t ci)
 {
-  char buf[CDIO_CD_FRAMESIZE_RAW] = { 0, };
+  char buf[CDIO_CD_FRAMESIZE_RAW];
 
   vcd_assert (extent == obj->sectors_written);
 
-  _vcd_make_mode2(buf, data, extent, fnum, cnum, sm, ci);
+  _make_m2_sector (obj, buf, data, extent, fnum, cnum, sm, ci);
 
-  vcd_image_sink_write (obj->image_sink, buf, extent);
+  _image_sink_write (obj, buf, extent);
 
   obj->sectors_written++;
 
@@ -1537,37 +1938,67 @@ static int
 _write_m2_raw_image_sector (VcdObj_t *obj, const void *data, uint32_t extent)
 {
   char buf[CDIO_CD_FRAMESIZE_RAW] = { 0, };
+  double _start = _vcd_stat_start ();
 
   vcd_assert (extent == obj->sectors_written);
 
   _vcd_make_raw_mode2(buf, data, extent);
+  _vcd_stat_add (&obj->stats.stage[VCD_STAT_MODE2], _start,
+                 CDIO_CD_FRAMESIZE_RAW);
 
-  vcd_image_sink_write (obj->image_sink, buf, extent);
+  _image_sink_write (obj, buf, extent);
 
   obj->sectors_written++;
 
   return _callback_wrapper (obj, false);
 }
 
+/* custom files are read this many sectors at a time */
+#define SOURCE_READ_SECTORS 64
+
+/* reads up to count sectors of sector_size bytes; whatever the source
+   does not deliver is zero filled */
+static void
+_read_source_sectors (VcdDataSource_t *source, char *buf, uint32_t len,
+                      uint32_t count, unsigned sector_size)
+{
+  long read_len = vcd_data_source_read (source, buf, len, 1);
+
+  if (read_len < 0)
+    read_len = 0;
+
+  memset (buf + read_len, 0, count * sector_size - read_len);
+}
+
 static void
 _write_source_mode2_raw (VcdObj_t *obj, VcdDataSource_t *source,
                          uint32_t extent)
 {
-  int n;
-  uint32_t sectors;
+  uint32_t n, sectors;
+  char *buf;
 
   sectors = vcd_data_source_stat (source) / M2RAW_SECTOR_SIZE;
 
+  buf = malloc (SOURCE_READ_SECTORS * M2RAW_SECTOR_SIZE);
+
   vcd_data_source_seek (source, 0);
 
-  for (n = 0;n < sectors;n++) {
-    char buf[M2RAW_SECTOR_SIZE] = { 0, };
+  for (n = 0; n < sectors;)
+    {
+      const uint32_t count = MIN (sectors - n, SOURCE_READ_SECTORS);
+      uint32_t i;
 
-    vcd_data_source_read (source, buf, M2RAW_SECTOR_SIZE, 1);
+      _read_source_sectors (source, buf, count * M2RAW_SECTOR_SIZE,
+                            count, M2RAW_SECTOR_SIZE);
 
-    if (_write_m2_raw_image_sector (obj, buf, extent+n))
-      break;
-  }
+      for (i = 0; i < count; i++, n++)
+        if (_write_m2_raw_image_sector (obj, buf + i * M2RAW_SECTOR_SIZE,
+                                        extent + n))
+          goto out;
+    }
+
+ out:
+  free (buf);
 
   vcd_data_source_close (source);
 }
@@ -1576,67 +2007,284 @@ static void
 _write_source_mode2_form1 (VcdObj_t *obj, VcdDataSource_t *source,
                            uint32_t extent)
 {
-  int n;
-  uint32_t sectors, size, last_block_size;
+  uint32_t n, sectors, size;
+  char *buf;
 
   size = vcd_data_source_stat (source);
 
   sectors = _vcd_len2blocks (size, CDIO_CD_FRAMESIZE);
 
-  last_block_size = size % CDIO_CD_FRAMESIZE;
-  if (!last_block_size)
-    last_block_size = CDIO_CD_FRAMESIZE;
+  buf = malloc (SOURCE_READ_SECTORS * CDIO_CD_FRAMESIZE);
 
   vcd_data_source_seek (source, 0);
 
-  for (n = 0;n < sectors;n++) {
-    char buf[CDIO_CD_FRAMESIZE] = { 0, };
-
-    vcd_data_source_read (source, buf,
-                          ((n + 1 == sectors)
-                           ? last_block_size
-                           : CDIO_CD_FRAMESIZE), 1);
+  for (n = 0; n < sectors;)
+    {
+      const uint32_t count = MIN (sectors - n, SOURCE_READ_SECTORS);
+      const uint32_t len = MIN (size - n * CDIO_CD_FRAMESIZE,
+                                count * CDIO_CD_FRAMESIZE);
+      uint32_t i;
+
+      _read_source_sectors (source, buf, len, count, CDIO_CD_FRAMESIZE);
+
+      for (i = 0; i < count; i++, n++)
+        if (_write_m2_image_sector (obj, buf + i * CDIO_CD_FRAMESIZE,
+                                    extent + n, 1, 0,
+                                    ((n + 1 < sectors)
+                                     ? SM_DATA
+                                     : SM_DATA | SM_EOF),
+                                    0))
+          goto out;
+    }
 
-    if (_write_m2_image_sector (obj, buf, extent+n, 1, 0,
-                                ((n+1 < sectors)
-                                 ? SM_DATA
-                                 : SM_DATA |SM_EOF),
-                                0))
-      break;
-  }
+ out:
+  free (buf);
 
   vcd_data_source_close (source);
 }
 
+/* moves *p_pause_node past all pauses which are due at the packet
+   described by pkt_flags; returns true if there were any, i.e. the
+   packet gets a trigger */
+static bool
+_pause_trigger_p (CdioListNode_t **p_pause_node,
+                  const struct vcd_mpeg_packet_info *pkt_flags,
+                  unsigned packet_no)
+{
+  bool set_trigger = false;
+
+  while (*p_pause_node)
+    {
+      pause_t *_pause = _cdio_list_node_data (*p_pause_node);
+
+      if (!pkt_flags->has_pts)
+        break; /* no pts */
+
+      if (pkt_flags->pts < _pause->time)
+        break; /* our time has not come yet */
+
+      /* seems it's time to trigger! */
+      set_trigger = true;
+
+      vcd_debug ("setting auto pause trigger for time %f (pts %f) @%d",
+                 _pause->time, pkt_flags->pts, packet_no);
+
+      *p_pause_node = _cdio_list_node_next (*p_pause_node);
+    }
+
+  return set_trigger;
+}
+
+typedef struct {
+  int audio;
+  int video;
+  int zero;
+  int ogt;
+  int unknown;
+} _packet_stats_t;
+
+/* computes the subheader of a sequence track packet; returns != 0 for
+   invalid packets */
 static int
-_write_sequence (VcdObj_t *p_obj, int track_idx)
+_sequence_subheader (const VcdObj_t *p_obj, const mpeg_sequence_t *track,
+                     int track_idx, unsigned packet_no,
+                     const struct vcd_mpeg_packet_info *pkt_flags,
+                     bool set_trigger, _packet_stats_t *stats,
+                     uint8_t *fnum, uint8_t *cnum, uint8_t *sm, uint8_t *ci)
 {
-  mpeg_sequence_t *track =
-    _cdio_list_node_data (_vcd_list_at (p_obj->mpeg_sequence_list, track_idx));
-  CdioListNode_t *pause_node;
-  int n, lastsect = p_obj->sectors_written;
-  char buf[2324];
-  struct {
-    int audio;
-    int video;
-    int zero;
-    int ogt;
-    int unknown;
-  } mpeg_packets = {0, };
+  _packet_stats_t _stats = { 0, };
 
+  if (!stats)
+    stats = &_stats;
 
-  {
-    char *norm_str = NULL;
-    const struct vcd_mpeg_stream_vid_info *_info = &track->info->shdr[0];
+  *fnum = track_idx + 1;
 
-    switch (vcd_mpeg_get_norm (_info)) {
-    case MPEG_NORM_PAL:
-      norm_str = strdup ("PAL SIF (352x288/25fps)");
+  switch (vcd_mpeg_packet_get_type (pkt_flags))
+    {
+    case PKT_TYPE_VIDEO:
+      stats->video++;
+      *sm = SM_FORM2|SM_REALT|SM_VIDEO;
+      *ci = CI_VIDEO;
+      *cnum = CN_VIDEO;
       break;
-    case MPEG_NORM_NTSC:
-      norm_str = strdup ("NTSC SIF (352x240/29.97fps)");
+
+    case PKT_TYPE_OGT:
+      stats->ogt++;
+      *sm = SM_FORM2|SM_REALT|SM_VIDEO;
+      *ci = CI_OGT;
+      *cnum = CN_OGT;
       break;
-    case MPEG_NORM_FILM:
+
+    case PKT_TYPE_AUDIO:
+      stats->audio++;
+      *sm = SM_FORM2|SM_REALT|SM_AUDIO;
+      *ci = CI_AUDIO;
+      *cnum = CN_AUDIO;
+      if (pkt_flags->audio[1] || pkt_flags->audio[2])
+        {
+          *ci = CI_AUDIO2;
+          *cnum = CN_AUDIO2;
+        }
+      break;
+
+    case PKT_TYPE_ZERO:
+      stats->zero++;
+      stats->unknown--;
+    case PKT_TYPE_EMPTY:
+      stats->unknown++;
+      *sm = SM_FORM2|SM_REALT;
+      *ci = CI_EMPTY;
+      *cnum = CN_EMPTY;
+      break;
+
+    case PKT_TYPE_INVALID:
+      vcd_error ("invalid mpeg packet found at packet# %d"
+                 " -- please fix this mpeg file!", packet_no);
+      return 1;
+      break;
+
+    default:
+      vcd_assert_not_reached ();
+    }
+
+  if (packet_no == track->info->packets - 1)
+    {
+      *sm |= SM_EOR;
+      if (!p_obj->track_rear_margin) /* if no rear margin... */
+        *sm |= SM_EOF;
+    }
+
+  if (set_trigger)
+    *sm |= SM_TRIG;
+
+  if (_vcd_obj_has_cap_p (p_obj, _CAP_4C_SVCD)
+      && !p_obj->svcd_vcd3_mpegav) /* IEC62107 SVCDs have a
+                                      simplified subheader */
+    {
+      *fnum = 1;
+      *ci = CI_MPEG2;
+    }
+
+  return 0;
+}
+
+/* computes the subheader of a segment sector; pkt_flags is NULL for
+   the padding following the last packet */
+static void
+_segment_subheader (const VcdObj_t *p_obj, const mpeg_segment_t *p_segment,
+                    unsigned packet_no, const uint8_t *buf,
+                    const struct vcd_mpeg_packet_info *pkt_flags,
+                    bool set_trigger,
+                    uint8_t *fn, uint8_t *cn, uint8_t *sm, uint8_t *ci)
+{
+  bool _need_eor = false;
+
+  *fn = 1;
+  *cn = CN_EMPTY;
+  *sm = SM_FORM2 | SM_REALT;
+  *ci = CI_EMPTY;
+
+  if (!pkt_flags)
+    {
+      if (_vcd_obj_has_cap_p (p_obj, _CAP_4C_SVCD))
+        {
+          *fn = 0;
+          *sm = SM_FORM2;
+        }
+
+      return;
+    }
+
+  switch (vcd_mpeg_packet_get_type (pkt_flags))
+    {
+    case PKT_TYPE_VIDEO:
+      *sm = SM_FORM2 | SM_REALT | SM_VIDEO;
+
+      *ci = CI_VIDEO;
+      *cn = CN_VIDEO;
+
+      if (pkt_flags->video[1])
+        *ci = CI_STILL, *cn = CN_STILL;
+      else if (pkt_flags->video[2])
+        *ci = CI_STILL2, *cn = CN_STILL2;
+
+      if (pkt_flags->video[1] || pkt_flags->video[2])
+        { /* search for endcode -- hack */
+          int idx;
+
+          for (idx = 0; idx <= 2320; idx++)
+            if (buf[idx] == 0x00
+                && buf[idx + 1] == 0x00
+                && buf[idx + 2] == 0x01
+                && buf[idx + 3] == 0xb7)
+              {
+                _need_eor = true;
+                break;
+              }
+        }
+      break;
+
+    case PKT_TYPE_AUDIO:
+      *sm = SM_FORM2 | SM_REALT | SM_AUDIO;
+
+      *ci = CI_AUDIO;
+      *cn = CN_AUDIO;
+      break;
+
+    case PKT_TYPE_EMPTY:
+      *ci = CI_EMPTY;
+      *cn = CN_EMPTY;
+      break;
+
+    default:
+      /* fixme -- check.... */
+      break;
+    }
+
+  if (_vcd_obj_has_cap_p (p_obj, _CAP_4C_SVCD))
+    {
+      *cn = 1;
+      *sm = SM_FORM2 | SM_REALT | SM_VIDEO;
+      *ci = CI_MPEG2;
+    }
+
+  if (packet_no + 1 == p_segment->info->packets)
+    *sm |= SM_EOF;
+
+  if (set_trigger)
+    *sm |= SM_TRIG;
+
+  if (_need_eor)
+    {
+      vcd_debug ("setting EOR for SeqEnd at packet# %d ('%s')",
+                 packet_no, p_segment->id);
+      *sm |= SM_EOR;
+    }
+}
+
+static int
+_write_sequence (VcdObj_t *p_obj, int track_idx)
+{
+  mpeg_sequence_t *track =
+    _cdio_list_node_data (_vcd_list_at (p_obj->mpeg_sequence_list, track_idx));
+  CdioListNode_t *pause_node;
+  int n, lastsect = p_obj->sectors_written;
+  char buf[2324];
+  _packet_stats_t mpeg_packets = {0, };
+
+
+  {
+    char *norm_str = NULL;
+    const struct vcd_mpeg_stream_vid_info *_info = &track->info->shdr[0];
+
+    switch (vcd_mpeg_get_norm (_info)) {
+    case MPEG_NORM_PAL:
+      norm_str = strdup ("PAL SIF (352x288/25fps)");
+      break;
+    case MPEG_NORM_NTSC:
+      norm_str = strdup ("NTSC SIF (352x240/29.97fps)");
+      break;
+    case MPEG_NORM_FILM:
       norm_str = strdup ("FILM SIF (352x240/24fps)");
       break;
     case MPEG_NORM_PAL_S:
@@ -1718,100 +2366,21 @@ _write_sequence (VcdObj_t *p_obj, int track_idx)
   pause_node = _cdio_list_begin (track->pause_list);
 
   for (n = 0; n < track->info->packets; n++) {
-    int ci = 0, sm = 0, cnum = 0, fnum = 0;
+    uint8_t ci, sm, cnum, fnum;
     struct vcd_mpeg_packet_info pkt_flags;
-    bool set_trigger = false;
+    bool set_trigger;
 
     vcd_mpeg_source_get_packet (track->source, n, buf, &pkt_flags,
                                 p_obj->update_scan_offsets);
 
-    while (pause_node)
-      {
-        pause_t *_pause = _cdio_list_node_data (pause_node);
-
-        if (!pkt_flags.has_pts)
-          break; /* no pts */
-
-        if (pkt_flags.pts < _pause->time)
-          break; /* our time has not come yet */
-
-        /* seems it's time to trigger! */
-        set_trigger = true;
-
-        vcd_debug ("setting auto pause trigger for time %f (pts %f) @%d",
-                   _pause->time, pkt_flags.pts, n);
-
-        pause_node = _cdio_list_node_next (pause_node);
-      }
-
-    switch (vcd_mpeg_packet_get_type (&pkt_flags))
-      {
-    case PKT_TYPE_VIDEO:
-      mpeg_packets.video++;
-      sm = SM_FORM2|SM_REALT|SM_VIDEO;
-      ci = CI_VIDEO;
-      cnum = CN_VIDEO;
-      break;
-
-    case PKT_TYPE_OGT:
-      mpeg_packets.ogt++;
-      sm = SM_FORM2|SM_REALT|SM_VIDEO;
-      ci = CI_OGT;
-      cnum = CN_OGT;
-      break;
-
-    case PKT_TYPE_AUDIO:
-      mpeg_packets.audio++;
-      sm = SM_FORM2|SM_REALT|SM_AUDIO;
-      ci = CI_AUDIO;
-      cnum = CN_AUDIO;
-      if (pkt_flags.audio[1] || pkt_flags.audio[2])
-        {
-          ci = CI_AUDIO2;
-          cnum = CN_AUDIO2;
-        }
-      break;
-
-
-    case PKT_TYPE_ZERO:
-      mpeg_packets.zero++;
-      mpeg_packets.unknown--;
-    case PKT_TYPE_EMPTY:
-      mpeg_packets.unknown++;
-      sm = SM_FORM2|SM_REALT;
-      ci = CI_EMPTY;
-      cnum = CN_EMPTY;
-      break;
+    set_trigger = _pause_trigger_p (&pause_node, &pkt_flags, n);
 
-    case PKT_TYPE_INVALID:
-      vcd_error ("invalid mpeg packet found at packet# %d"
-                 " -- please fix this mpeg file!", n);
-      vcd_mpeg_source_close (track->source);
-      return 1;
-      break;
-
-    default:
-      vcd_assert_not_reached ();
-    }
-
-    if (n == track->info->packets - 1)
-      {
-        sm |= SM_EOR;
-        if (!p_obj->track_rear_margin) /* if no rear margin... */
-          sm |= SM_EOF;
-      }
-
-    if (set_trigger)
-      sm |= SM_TRIG;
-
-    fnum = track_idx + 1;
-
-    if (_vcd_obj_has_cap_p (p_obj, _CAP_4C_SVCD)
-        && !p_obj->svcd_vcd3_mpegav) /* IEC62107 SVCDs have a
-                                        simplified subheader */
+    if (_sequence_subheader (p_obj, track, track_idx, n, &pkt_flags,
+                             set_trigger, &mpeg_packets,
+                             &fnum, &cnum, &sm, &ci))
       {
-        fnum = 1;
-        ci = CI_MPEG2;
+        vcd_mpeg_source_close (track->source);
+        return 1;
       }
 
     if (_write_m2_image_sector (p_obj, buf, lastsect++, fnum, cnum, sm, ci))
@@ -1860,119 +2429,25 @@ _write_segment (VcdObj_t *p_obj, mpeg_segment_t *p_segment)
       if (packet_no < p_segment->info->packets)
         {
           struct vcd_mpeg_packet_info pkt_flags;
-          bool set_trigger = false;
-          bool _need_eor = false;
+          bool set_trigger;
 
           vcd_mpeg_source_get_packet (p_segment->source, packet_no,
                                       buf, &pkt_flags,
                                       p_obj->update_scan_offsets);
 
-          fn = 1;
-          cn = CN_EMPTY;
-          sm = SM_FORM2 | SM_REALT;
-          ci = CI_EMPTY;
-
-          while (pause_node)
-            {
-              pause_t *_pause = _cdio_list_node_data (pause_node);
-
-              if (!pkt_flags.has_pts)
-                break; /* no pts */
-
-              if (pkt_flags.pts < _pause->time)
-                break; /* our time has not come yet */
-
-              /* seems it's time to trigger! */
-              set_trigger = true;
-
-              vcd_debug ("setting auto pause trigger for time %f (pts %f) @%d",
-                         _pause->time, pkt_flags.pts, n);
-
-              pause_node = _cdio_list_node_next (pause_node);
-            }
-
-          switch (vcd_mpeg_packet_get_type (&pkt_flags))
-            {
-            case PKT_TYPE_VIDEO:
-              sm = SM_FORM2 | SM_REALT | SM_VIDEO;
-
-              ci = CI_VIDEO;
-              cn = CN_VIDEO;
-
-              if (pkt_flags.video[1])
-                ci = CI_STILL, cn = CN_STILL;
-              else if (pkt_flags.video[2])
-                ci = CI_STILL2, cn = CN_STILL2;
-
-              if (pkt_flags.video[1] || pkt_flags.video[2])
-                { /* search for endcode -- hack */
-                  int idx;
-
-                  for (idx = 0; idx <= 2320; idx++)
-                    if (buf[idx] == 0x00
-                        && buf[idx + 1] == 0x00
-                        && buf[idx + 2] == 0x01
-                        && buf[idx + 3] == 0xb7)
-                      {
-                        _need_eor = true;
-                        break;
-                      }
-                }
-              break;
-
-            case PKT_TYPE_AUDIO:
-              sm = SM_FORM2 | SM_REALT | SM_AUDIO;
-
-              ci = CI_AUDIO;
-              cn = CN_AUDIO;
-              break;
-
-            case PKT_TYPE_EMPTY:
-              ci = CI_EMPTY;
-              cn = CN_EMPTY;
-              break;
-
-            default:
-              /* fixme -- check.... */
-              break;
-            }
-
-          if (_vcd_obj_has_cap_p (p_obj, _CAP_4C_SVCD))
-            {
-              cn = 1;
-              sm = SM_FORM2 | SM_REALT | SM_VIDEO;
-              ci = CI_MPEG2;
-            }
-
-          if (packet_no + 1 == p_segment->info->packets)
-            sm |= SM_EOF;
+          set_trigger = _pause_trigger_p (&pause_node, &pkt_flags, packet_no);
 
-          if (set_trigger)
-            sm |= SM_TRIG;
-
-          if (_need_eor)
-            {
-              vcd_debug ("setting EOR for SeqEnd at packet# %d ('%s')",
-                         packet_no, p_segment->id);
-              sm |= SM_EOR;
-            }
+          _segment_subheader (p_obj, p_segment, packet_no, buf, &pkt_flags,
+                              set_trigger, &fn, &cn, &sm, &ci);
         }
       else
-        {
-          fn = 1;
-          cn = CN_EMPTY;
-          sm = SM_FORM2 | SM_REALT;
-          ci = CI_EMPTY;
-
-          if (_vcd_obj_has_cap_p (p_obj, _CAP_4C_SVCD))
-            {
-              fn = 0;
-              sm = SM_FORM2;
-            }
-
-        }
+        _segment_subheader (p_obj, p_segment, packet_no, NULL, NULL, false,
+                            &fn, &cn, &sm, &ci);
 
-      _write_m2_image_sector (p_obj, buf, n, fn, cn, sm, ci);
+      _write_m2_image_sector (p_obj,
+                              (packet_no < p_segment->info->packets
+                               ? (const void *) buf : zero),
+                              n, fn, cn, sm, ci);
 
       n++;
     }
@@ -2049,12 +2524,11 @@ _update_entry_points (VcdObj_t *p_obj)
     }
 }
 
-static int
-_write_vcd_iso_track (VcdObj_t *p_obj, const time_t *p_create_time)
+/* fills the ISO9660 track's buffers, i.e. everything but the
+   segments and custom files */
+static void
+_prepare_vcd_iso_track (VcdObj_t *p_obj, const time_t *p_create_time)
 {
-  CdioListNode_t *node;
-  int n;
-
   /* generate dir sectors */
 
   _vcd_directory_dump_entries (p_obj->dir,
@@ -2106,6 +2580,15 @@ _write_vcd_iso_track (VcdObj_t *p_obj, const time_t *p_create_time)
       set_search_dat (p_obj, _dict_get_bykey (p_obj, "search")->buf);
       set_scandata_dat (p_obj, _dict_get_bykey (p_obj, "scandata")->buf);
     }
+}
+
+static int
+_write_vcd_iso_track (VcdObj_t *p_obj, const time_t *p_create_time)
+{
+  CdioListNode_t *node;
+  int n;
+
+  _prepare_vcd_iso_track (p_obj, p_create_time);
 
   /* start actually writing stuff */
 
@@ -2186,18 +2669,212 @@ _write_vcd_iso_track (VcdObj_t *p_obj, const time_t *p_create_time)
 }
 
 
+#ifdef HAVE_PTHREAD_H
+
+static void *
+_write_jobs_thread (void *user_data)
+{
+  struct _write_jobs *jobs = user_data;
+
+  vcd_log_set_thread_handler (jobs->log_handler, jobs->log_user_data);
+
+  for (;;)
+    {
+      VcdObj_t view = jobs->view;
+      unsigned track;
+      int result;
+
+      pthread_mutex_lock (&jobs->lock);
+      track = jobs->next_track++;
+      if (jobs->abort)
+        track = jobs->tracks;
+      pthread_mutex_unlock (&jobs->lock);
+
+      if (track >= jobs->tracks)
+        break;
+
+      view.in_track = track + 1;
+
+      if (!track)
+        result = _write_vcd_iso_track (&view, jobs->create_time);
+      else
+        {
+          const mpeg_sequence_t *p_sequence =
+            _cdio_list_node_data (_vcd_list_at (view.mpeg_sequence_list,
+                                                track - 1));
+
+          view.sectors_written = view.iso_size - view.track_pregap
+            + p_sequence->relative_start_extent;
+          view.last_cb_call = view.sectors_written;
+
+          result = _write_sequence (&view, track - 1);
+        }
+
+      _callback_wrapper (&view, true);
+
+      pthread_mutex_lock (&jobs->lock);
+      _vcd_stats_merge (&jobs->stats, &view.stats);
+      _write_jobs_track_done (jobs, track);
+      if (result)
+        jobs->abort = true;
+      pthread_mutex_unlock (&jobs->lock);
+    }
+
+  pthread_mutex_lock (&jobs->lock);
+  jobs->running--;
+  pthread_cond_signal (&jobs->progress);
+  pthread_mutex_unlock (&jobs->lock);
+
+  return NULL;
+}
+
+/* writes the ISO9660 track and all sequence tracks with up to
+   output_jobs threads; the progress callback is only ever invoked
+   from the calling thread */
+static int
+_write_tracks_parallel (VcdObj_t *p_obj, const time_t *p_create_time)
+{
+  struct _write_jobs jobs;
+  pthread_t *threads;
+  unsigned n, nthreads;
+
+  memset (&jobs, 0, sizeof (jobs));
+
+  /* the sector map is built on demand, so build it before it gets
+     shared */
+  if (!p_obj->buffer_dict_map)
+    _dict_map_build (p_obj);
+
+  jobs.view = *p_obj;
+  jobs.view.write_jobs = &jobs;
+  memset (&jobs.view.stats, 0, sizeof (VcdStats_t));
+  jobs.view.sectors_written = 0;
+  jobs.view.last_cb_call = 0;
+  jobs.create_time = p_create_time;
+  jobs.log_handler = vcd_log_get_thread_handler (&jobs.log_user_data);
+
+  jobs.tracks = _cdio_list_length (p_obj->mpeg_sequence_list) + 1;
+  jobs.track_done = calloc (jobs.tracks, sizeof (bool));
+  jobs.track_next = calloc (jobs.tracks, sizeof (uint32_t));
+
+  for (n = 1; n < jobs.tracks; n++)
+    {
+      const mpeg_sequence_t *p_sequence =
+        _cdio_list_node_data (_vcd_list_at (p_obj->mpeg_sequence_list,
+                                            n - 1));
+
+      jobs.track_next[n] = p_obj->iso_size - p_obj->track_pregap
+        + p_sequence->relative_start_extent;
+    }
+
+  pthread_mutex_init (&jobs.lock, NULL);
+  pthread_cond_init (&jobs.progress, NULL);
+  pthread_cond_init (&jobs.window, NULL);
+
+  nthreads = MIN (p_obj->output_jobs, jobs.tracks);
+  threads = calloc (nthreads, sizeof (pthread_t));
+
+  jobs.running = nthreads;
+
+  for (n = 0; n < nthreads; n++)
+    if (pthread_create (&threads[n], NULL, _write_jobs_thread, &jobs))
+      {
+        vcd_warn ("could not create writer thread #%u", n + 1);
+
+        pthread_mutex_lock (&jobs.lock);
+        jobs.running -= nthreads - n;
+        pthread_mutex_unlock (&jobs.lock);
+
+        nthreads = n;
+        break;
+      }
+
+  if (!nthreads)
+    {
+      jobs.running = 1;
+      _write_jobs_thread (&jobs);
+    }
+
+  pthread_mutex_lock (&jobs.lock);
+
+  while (jobs.running)
+    {
+      pthread_cond_wait (&jobs.progress, &jobs.lock);
+
+      p_obj->sectors_written = jobs.sectors_written;
+
+      /* report the first track not finished yet */
+      for (n = 0; n < jobs.tracks - 1 && jobs.track_done[n]; n++)
+        ;
+      p_obj->in_track = n + 1;
+
+      if (!jobs.abort)
+        {
+          int retval;
+
+          pthread_mutex_unlock (&jobs.lock);
+          retval = _callback_wrapper (p_obj, false);
+          pthread_mutex_lock (&jobs.lock);
+
+          if (retval)
+            {
+              jobs.abort = true;
+              pthread_cond_broadcast (&jobs.window);
+            }
+        }
+    }
+
+  pthread_mutex_unlock (&jobs.lock);
+
+  for (n = 0; n < nthreads; n++)
+    pthread_join (threads[n], NULL);
+
+  free (threads);
+  free (jobs.track_done);
+  free (jobs.track_next);
+
+  _vcd_stats_merge (&p_obj->stats, &jobs.stats);
+
+  pthread_cond_destroy (&jobs.window);
+  pthread_cond_destroy (&jobs.progress);
+  pthread_mutex_destroy (&jobs.lock);
+
+  p_obj->sectors_written = p_obj->relative_end_extent + p_obj->iso_size;
+  p_obj->in_track = jobs.tracks;
+
+  return jobs.abort ? 1 : 0;
+}
+
+#endif
+
 long
 vcd_obj_get_image_size (VcdObj_t *p_obj)
 {
   long size_sectors = -1;
 
+  vcd_assert (p_obj != NULL);
   vcd_assert (!p_obj->in_output);
 
   if (_cdio_list_length (p_obj->mpeg_sequence_list) > 0)
     {
-      /* fixme -- make this efficient */
-      size_sectors = vcd_obj_begin_output (p_obj);
-      vcd_obj_end_output (p_obj);
+      /* the sector allocation alone determines the size; no need to
+         build the filesystem or update entry points for that */
+      p_obj->iso_bitmap = _vcd_salloc_new ();
+      p_obj->buffer_dict_list = _cdio_list_new ();
+
+      _vcd_pbc_finalize (p_obj);
+      _finalize_vcd_iso_track_allocation (p_obj);
+
+      size_sectors = p_obj->relative_end_extent + p_obj->iso_size;
+      size_sectors += p_obj->leadout_pregap;
+
+      _vcd_salloc_destroy (p_obj->iso_bitmap);
+      p_obj->iso_bitmap = NULL;
+
+      _dict_clean (p_obj);
+      _cdio_list_free (p_obj->buffer_dict_list, true,
+                       (CdioDataFree_t) &dict_free);
+      p_obj->buffer_dict_list = NULL;
     }
 
   return size_sectors;
@@ -2257,6 +2934,51 @@ vcd_obj_end_output (VcdObj_t *p_obj)
   vcd_assert (p_obj->in_output);
   p_obj->in_output = false;
 
+  if (p_obj->in_read)
+    {
+      CdioListNode_t *node;
+
+      _CDIO_LIST_FOREACH (node, p_obj->mpeg_segment_list)
+        {
+          mpeg_segment_t *p_segment = _cdio_list_node_data (node);
+
+          free (p_segment->trigger_packets);
+          p_segment->trigger_packets = NULL;
+          p_segment->trigger_count = 0;
+          vcd_mpeg_source_close (p_segment->source);
+        }
+
+      _CDIO_LIST_FOREACH (node, p_obj->mpeg_sequence_list)
+        {
+          mpeg_sequence_t *p_track = _cdio_list_node_data (node);
+
+          free (p_track->trigger_packets);
+          p_track->trigger_packets = NULL;
+          p_track->trigger_count = 0;
+          vcd_mpeg_source_close (p_track->source);
+        }
+
+      _CDIO_LIST_FOREACH (node, p_obj->custom_file_list)
+        {
+          custom_file_t *p = _cdio_list_node_data (node);
+
+          vcd_data_source_close (p->file);
+        }
+
+      free (p_obj->read_extents);
+      p_obj->read_extents = NULL;
+      p_obj->read_extent_count = 0;
+
+      p_obj->in_read = false;
+    }
+
+  /* vcd_obj_write_image () failed or was aborted */
+  if (p_obj->image_sink)
+    {
+      vcd_image_sink_destroy (p_obj->image_sink);
+      p_obj->image_sink = NULL;
+    }
+
   _vcd_directory_destroy (p_obj->dir);
   _vcd_salloc_destroy (p_obj->iso_bitmap);
 
@@ -2284,15 +3006,128 @@ vcd_obj_append_pbc_node (VcdObj_t *p_obj, struct _pbc_t *p_pbc)
 
   _cdio_list_append (p_obj->pbc_list, p_pbc);
 
+  _vcd_obj_id_register (p_obj, p_pbc->id, _ID_PBC, p_pbc, NULL);
+
   return 0;
 }
 
-int
-vcd_obj_write_image (VcdObj_t *p_obj, VcdImageSink_t *p_image_sink,
-                     progress_callback_t callback, void *user_data,
-                     const time_t *p_create_time)
+/* image writing and sector synthesis both need full scan information */
+static bool
+_vcd_obj_layout_only_p (const VcdObj_t *p_obj)
+{
+  CdioListNode_t *node;
+
+  _CDIO_LIST_FOREACH (node, p_obj->mpeg_sequence_list)
+    {
+      mpeg_sequence_t *p_track = _cdio_list_node_data (node);
+
+      if (p_track->info->layout_only)
+        return true;
+    }
+
+  _CDIO_LIST_FOREACH (node, p_obj->mpeg_segment_list)
+    {
+      mpeg_segment_t *p_segment = _cdio_list_node_data (node);
+
+      if (p_segment->info->layout_only)
+        return true;
+    }
+
+  return false;
+}
+
+char *
+vcd_obj_get_track_layout (VcdObj_t *p_obj, unsigned track_no)
 {
+  char buf[1024] = { 0, };
+  const mpeg_sequence_t *track;
   CdioListNode_t *node;
+  int len;
+
+  vcd_assert (p_obj != NULL);
+  vcd_assert (p_obj->in_output);
+
+  if (!track_no || track_no > _cdio_list_length (p_obj->mpeg_sequence_list) + 1)
+    return NULL;
+
+  if (track_no == 1)
+    {
+      /* the sectors of the later tracks are addressed relative to the
+         image start, so they depend on the ISO9660 track size */
+      snprintf (buf, sizeof (buf), "lsn=0 sectors=%u image=%u",
+                p_obj->iso_size,
+                p_obj->iso_size + p_obj->relative_end_extent
+                + p_obj->leadout_pregap);
+
+      return strdup (buf);
+    }
+
+  track = _cdio_list_node_data (_vcd_list_at (p_obj->mpeg_sequence_list,
+                                              track_no - 2));
+
+  len = snprintf (buf, sizeof (buf),
+                  "lsn=%u packets=%u type=%d pregap=%u front=%u rear=%u"
+                  " mpegav=%d scan-offsets=%d relaxed-aps=%d pauses=",
+                  p_obj->iso_size + track->relative_start_extent
+                  - p_obj->track_pregap,
+                  track->info->packets, p_obj->type, p_obj->track_pregap,
+                  p_obj->track_front_margin, p_obj->track_rear_margin,
+                  p_obj->svcd_vcd3_mpegav, p_obj->update_scan_offsets,
+                  p_obj->relaxed_aps);
+
+  _CDIO_LIST_FOREACH (node, track->pause_list)
+    {
+      pause_t *_pause = _cdio_list_node_data (node);
+
+      if (len < sizeof (buf))
+        len += snprintf (buf + len, sizeof (buf) - len, "%s%f",
+                         node == _cdio_list_begin (track->pause_list)
+                         ? "" : ",", _pause->time);
+    }
+
+  if (len >= sizeof (buf))
+    {
+      vcd_warn ("too many pauses in track %u", track_no);
+      return NULL;
+    }
+
+  return strdup (buf);
+}
+
+void
+vcd_obj_get_stats (const VcdObj_t *p_obj, VcdStats_t *p_stats)
+{
+  CdioListNode_t *node;
+
+  vcd_assert (p_obj != NULL);
+  vcd_assert (p_stats != NULL);
+
+  *p_stats = p_obj->stats;
+
+  _CDIO_LIST_FOREACH (node, p_obj->mpeg_sequence_list)
+    {
+      const mpeg_sequence_t *_sequence = _cdio_list_node_data (node);
+
+      _vcd_mpeg_source_add_stats (_sequence->source, p_stats);
+    }
+
+  _CDIO_LIST_FOREACH (node, p_obj->mpeg_segment_list)
+    {
+      const mpeg_segment_t *_segment = _cdio_list_node_data (node);
+
+      _vcd_mpeg_source_add_stats (_segment->source, p_stats);
+    }
+
+  p_stats->peak_rss = _vcd_stats_peak_rss ();
+}
+
+int
+vcd_obj_write_cuesheet (VcdObj_t *p_obj, VcdImageSink_t *p_image_sink)
+{
+  CdioListNode_t *node;
+  CdioList_t *p_cue_list;
+  vcd_cue_t *p_cue;
+  int retval;
 
   vcd_assert (p_obj != NULL);
   vcd_assert (p_obj->in_output);
@@ -2300,74 +3135,98 @@ vcd_obj_write_image (VcdObj_t *p_obj, VcdImageSink_t *p_image_sink,
   if (!p_image_sink)
     return -1;
 
-  /* start with meta info */
+  p_cue_list = _cdio_list_new ();
 
-  {
-    CdioList_t *p_cue_list;
-    vcd_cue_t *p_cue;
+  _cdio_list_append (p_cue_list, (p_cue = calloc(1, sizeof (vcd_cue_t))));
 
-    p_cue_list = _cdio_list_new ();
+  p_cue->lsn = 0;
+  p_cue->type = VCD_CUE_TRACK_START;
 
-    _cdio_list_append (p_cue_list, (p_cue = calloc(1, sizeof (vcd_cue_t))));
+  _CDIO_LIST_FOREACH (node, p_obj->mpeg_sequence_list)
+    {
+      mpeg_sequence_t *p_track = _cdio_list_node_data (node);
+      CdioListNode_t *p_entry_node;
 
-    p_cue->lsn = 0;
-    p_cue->type = VCD_CUE_TRACK_START;
+      _cdio_list_append (p_cue_list,
+                         (p_cue = calloc(1, sizeof (vcd_cue_t))));
 
-    _CDIO_LIST_FOREACH (node, p_obj->mpeg_sequence_list)
-      {
-        mpeg_sequence_t *p_track = _cdio_list_node_data (node);
-        CdioListNode_t *p_entry_node;
+      p_cue->lsn = p_track->relative_start_extent + p_obj->iso_size;
+      p_cue->lsn -= p_obj->track_pregap;
+      p_cue->type = VCD_CUE_PREGAP_START;
 
-        _cdio_list_append (p_cue_list,
-                           (p_cue = calloc(1, sizeof (vcd_cue_t))));
+      _cdio_list_append (p_cue_list,
+                         (p_cue = calloc(1, sizeof (vcd_cue_t))));
 
-        p_cue->lsn = p_track->relative_start_extent + p_obj->iso_size;
-        p_cue->lsn -= p_obj->track_pregap;
-        p_cue->type = VCD_CUE_PREGAP_START;
+      p_cue->lsn = p_track->relative_start_extent + p_obj->iso_size;
+      p_cue->type = VCD_CUE_TRACK_START;
 
-        _cdio_list_append (p_cue_list,
-                           (p_cue = calloc(1, sizeof (vcd_cue_t))));
+      _CDIO_LIST_FOREACH (p_entry_node, p_track->entry_list)
+        {
+          entry_t *_entry = _cdio_list_node_data (p_entry_node);
 
-        p_cue->lsn = p_track->relative_start_extent + p_obj->iso_size;
-        p_cue->type = VCD_CUE_TRACK_START;
+          _cdio_list_append (p_cue_list,
+                             (p_cue = calloc(1, sizeof (vcd_cue_t))));
 
-        _CDIO_LIST_FOREACH (p_entry_node, p_track->entry_list)
-          {
-            entry_t *_entry = _cdio_list_node_data (p_entry_node);
+          p_cue->lsn = p_obj->iso_size;
+          p_cue->lsn += p_track->relative_start_extent;
+          p_cue->lsn += p_obj->track_front_margin;
+          p_cue->lsn += _entry->aps.packet_no;
 
-            _cdio_list_append (p_cue_list,
-                               (p_cue = calloc(1, sizeof (vcd_cue_t))));
+          p_cue->type = VCD_CUE_SUBINDEX;
+        }
+    }
 
-            p_cue->lsn = p_obj->iso_size;
-            p_cue->lsn += p_track->relative_start_extent;
-            p_cue->lsn += p_obj->track_front_margin;
-            p_cue->lsn += _entry->aps.packet_no;
+  /* add last one... */
 
-            p_cue->type = VCD_CUE_SUBINDEX;
-          }
-      }
+  _cdio_list_append (p_cue_list, (p_cue = calloc(1, sizeof (vcd_cue_t))));
 
-    /* add last one... */
+  p_cue->lsn = p_obj->relative_end_extent + p_obj->iso_size;
 
-    _cdio_list_append (p_cue_list, (p_cue = calloc(1, sizeof (vcd_cue_t))));
+  p_cue->lsn += p_obj->leadout_pregap;
 
-    p_cue->lsn = p_obj->relative_end_extent + p_obj->iso_size;
+  p_cue->type = VCD_CUE_END;
 
-    p_cue->lsn += p_obj->leadout_pregap;
+  /* send it to image object */
 
-    p_cue->type = VCD_CUE_END;
+  retval = vcd_image_sink_set_cuesheet (p_image_sink, p_cue_list);
 
-    /* send it to image object */
+  _cdio_list_free (p_cue_list, true, (CdioDataFree_t) &cue_data_free);
 
-    vcd_image_sink_set_cuesheet (p_image_sink, p_cue_list);
+  return retval;
+}
 
-    _cdio_list_free (p_cue_list, true, (CdioDataFree_t) &cue_data_free);
-  }
+int
+vcd_obj_write_image (VcdObj_t *p_obj, VcdImageSink_t *p_image_sink,
+                     progress_callback_t callback, void *user_data,
+                     const time_t *p_create_time)
+{
+  vcd_assert (p_obj != NULL);
+  vcd_assert (p_obj->in_output);
+
+  if (!p_image_sink)
+    return -1;
+
+  /* ours from here on; if the write doesn't get to the end,
+     vcd_obj_end_output () destroys it */
+  p_obj->image_sink = p_image_sink;
+
+  if (_vcd_obj_layout_only_p (p_obj))
+    {
+      vcd_error ("mpeg items were scanned for layout only"
+                 " -- cannot write image");
+      return -1;
+    }
+
+  /* start with meta info */
+
+  vcd_obj_write_cuesheet (p_obj, p_image_sink);
 
   /* and now for the pay load */
 
   {
     unsigned int track;
+    double _start = _vcd_stat_start ();
+    uint64_t _bytes = p_obj->stats.stage[VCD_STAT_WRITE].bytes;
 
     vcd_assert (p_obj != NULL);
     vcd_assert (p_obj->sectors_written == 0);
@@ -2376,32 +3235,57 @@ vcd_obj_write_image (VcdObj_t *p_obj, VcdImageSink_t *p_image_sink,
 
     p_obj->progress_callback = callback;
     p_obj->callback_user_data = user_data;
-    p_obj->image_sink = p_image_sink;
 
     if (_callback_wrapper (p_obj, true))
       return 1;
 
-    if (_write_vcd_iso_track (p_obj, p_create_time))
-      return 1;
+    if (p_obj->iso_track_only)
+      {
+        vcd_info ("keeping tracks 2 to %d of the image",
+                  _cdio_list_length (p_obj->mpeg_sequence_list) + 1);
 
-    if (p_obj->update_scan_offsets)
-      vcd_info ("'update scan offsets' option enabled for "
-                "the following tracks!");
+        if (_write_vcd_iso_track (p_obj, p_create_time))
+          return 1;
 
-    for (track = 0;
-         track < _cdio_list_length (p_obj->mpeg_sequence_list);
-         track++)
+        p_obj->sectors_written = p_obj->relative_end_extent + p_obj->iso_size;
+        p_obj->in_track = _cdio_list_length (p_obj->mpeg_sequence_list) + 1;
+      }
+    else
+#ifdef HAVE_PTHREAD_H
+    if (p_obj->output_jobs > 1)
       {
-        p_obj->in_track++;
+        if (p_obj->update_scan_offsets)
+          vcd_info ("'update scan offsets' option enabled for "
+                    "the sequence tracks!");
 
-        if (_callback_wrapper (p_obj, true))
+        if (_write_tracks_parallel (p_obj, p_create_time))
           return 1;
-
-        if (_write_sequence (p_obj, track))
+      }
+    else
+#endif
+      {
+        if (_write_vcd_iso_track (p_obj, p_create_time))
           return 1;
+
+        if (p_obj->update_scan_offsets)
+          vcd_info ("'update scan offsets' option enabled for "
+                    "the following tracks!");
+
+        for (track = 0;
+             track < _cdio_list_length (p_obj->mpeg_sequence_list);
+             track++)
+          {
+            p_obj->in_track++;
+
+            if (_callback_wrapper (p_obj, true))
+              return 1;
+
+            if (_write_sequence (p_obj, track))
+              return 1;
+          }
       }
 
-    if (p_obj->leadout_pregap)
+    if (p_obj->leadout_pregap && !p_obj->iso_track_only)
       {
         int n, lastsect = p_obj->sectors_written;
 
@@ -2418,10 +3302,430 @@ vcd_obj_write_image (VcdObj_t *p_obj, VcdImageSink_t *p_image_sink,
 
     vcd_image_sink_destroy (p_image_sink);
 
+    /* sink destruction flushes the image, so it's part of the time */
+    _vcd_stat_add (&p_obj->stats.stage[VCD_STAT_IMAGE], _start,
+                   p_obj->stats.stage[VCD_STAT_WRITE].bytes - _bytes);
+
     return 0; /* ok */
   }
 }
 
+/*
+ * on-demand sector synthesis
+ */
+
+/* finds the packets a pause trigger is set on, going through the
+   packets in order just like the writer does */
+static unsigned
+_find_pause_triggers (VcdMpegSource_t *source, unsigned packets,
+                      const CdioList_t *pause_list, uint32_t **p_triggers)
+{
+  CdioListNode_t *pause_node = _cdio_list_begin (pause_list);
+  unsigned packet_no, count = 0;
+
+  *p_triggers = NULL;
+
+  for (packet_no = 0; pause_node && packet_no < packets; packet_no++)
+    {
+      uint8_t buf[M2F2_SECTOR_SIZE];
+      struct vcd_mpeg_packet_info pkt_flags;
+
+      vcd_mpeg_source_get_packet (source, packet_no, buf, &pkt_flags, false);
+
+      if (_pause_trigger_p (&pause_node, &pkt_flags, packet_no))
+        {
+          *p_triggers = realloc (*p_triggers, (count + 1) * sizeof (uint32_t));
+          (*p_triggers)[count++] = packet_no;
+        }
+    }
+
+  return count;
+}
+
+static bool
+_trigger_packet_p (const uint32_t triggers[], unsigned count,
+                   unsigned packet_no)
+{
+  unsigned lo = 0, hi = count;
+
+  while (lo < hi)
+    {
+      const unsigned mid = (lo + hi) / 2;
+
+      if (triggers[mid] == packet_no)
+        return true;
+
+      if (triggers[mid] < packet_no)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return false;
+}
+
+static int
+_read_extent_cmp (const void *a, const void *b)
+{
+  const read_extent_t *p_a = a, *p_b = b;
+
+  if (p_a->start < p_b->start)
+    return -1;
+
+  return p_a->start > p_b->start;
+}
+
+static void
+_read_extent_add (VcdObj_t *p_obj, uint32_t start, uint32_t end, int type,
+                  void *data, int track_idx)
+{
+  read_extent_t *p;
+
+  /* an empty one would hide the item starting at the same sector */
+  if (start >= end)
+    return;
+
+  p = &p_obj->read_extents[p_obj->read_extent_count++];
+  p->start = start;
+  p->end = end;
+  p->type = type;
+  p->data = data;
+  p->track_idx = track_idx;
+}
+
+/* indexes the segments, custom files and sequence tracks by their
+   sectors, so a read doesn't have to walk the lists */
+static void
+_read_extents_build (VcdObj_t *p_obj)
+{
+  const uint32_t end = p_obj->iso_size + p_obj->relative_end_extent;
+  CdioListNode_t *node;
+  int n = 0;
+
+  p_obj->read_extent_count = 0;
+  p_obj->read_extents =
+    calloc (_cdio_list_length (p_obj->mpeg_segment_list)
+            + _cdio_list_length (p_obj->custom_file_list)
+            + _cdio_list_length (p_obj->mpeg_sequence_list) + 1,
+            sizeof (read_extent_t));
+
+  _CDIO_LIST_FOREACH (node, p_obj->mpeg_segment_list)
+    {
+      mpeg_segment_t *p_segment = _cdio_list_node_data (node);
+
+      _read_extent_add (p_obj, p_segment->start_extent,
+                        p_segment->start_extent
+                        + p_segment->segment_count
+                        * VCDINFO_SEGMENT_SECTOR_SIZE,
+                        _EXTENT_SEGMENT, p_segment, -1);
+    }
+
+  _CDIO_LIST_FOREACH (node, p_obj->custom_file_list)
+    {
+      custom_file_t *p = _cdio_list_node_data (node);
+
+      _read_extent_add (p_obj, p->start_extent, p->start_extent + p->sectors,
+                        _EXTENT_CUSTOM_FILE, p, -1);
+    }
+
+  /* a track runs from its pregap to the pregap of the next one */
+  _CDIO_LIST_FOREACH (node, p_obj->mpeg_sequence_list)
+    {
+      mpeg_sequence_t *p_track = _cdio_list_node_data (node);
+      CdioListNode_t *next = _cdio_list_node_next (node);
+      uint32_t track_end = end;
+
+      if (next)
+        track_end = p_obj->iso_size - p_obj->track_pregap
+          + ((mpeg_sequence_t *) _cdio_list_node_data (next))
+          ->relative_start_extent;
+
+      _read_extent_add (p_obj, p_obj->iso_size - p_obj->track_pregap
+                        + p_track->relative_start_extent, track_end,
+                        _EXTENT_SEQUENCE, p_track, n++);
+    }
+
+  qsort (p_obj->read_extents, p_obj->read_extent_count,
+         sizeof (read_extent_t), _read_extent_cmp);
+}
+
+/* the item sector lsn belongs to, NULL if none */
+static const read_extent_t *
+_read_extent_find (const VcdObj_t *p_obj, uint32_t lsn)
+{
+  unsigned lo = 0, hi = p_obj->read_extent_count;
+
+  /* the last one starting at or before lsn */
+  while (lo < hi)
+    {
+      const unsigned mid = (lo + hi) / 2;
+
+      if (p_obj->read_extents[mid].start <= lsn)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  if (!lo || lsn >= p_obj->read_extents[lo - 1].end)
+    return NULL;
+
+  return &p_obj->read_extents[lo - 1];
+}
+
+int
+vcd_obj_begin_read (VcdObj_t *p_obj, const time_t *p_create_time)
+{
+  CdioListNode_t *node;
+
+  vcd_assert (p_obj != NULL);
+  vcd_assert (p_obj->in_output);
+  vcd_assert (!p_obj->in_read);
+
+  if (_vcd_obj_layout_only_p (p_obj))
+    {
+      vcd_error ("mpeg items were scanned for layout only"
+                 " -- cannot read sectors");
+      return -1;
+    }
+
+  _prepare_vcd_iso_track (p_obj, p_create_time);
+
+  if (!p_obj->buffer_dict_map)
+    _dict_map_build (p_obj);
+
+  /* pause triggers depend on all the packets before; only items with
+     pauses need this pass */
+  _CDIO_LIST_FOREACH (node, p_obj->mpeg_segment_list)
+    {
+      mpeg_segment_t *p_segment = _cdio_list_node_data (node);
+
+      p_segment->trigger_count =
+        _find_pause_triggers (p_segment->source, p_segment->info->packets,
+                              p_segment->pause_list,
+                              &p_segment->trigger_packets);
+    }
+
+  _CDIO_LIST_FOREACH (node, p_obj->mpeg_sequence_list)
+    {
+      mpeg_sequence_t *p_track = _cdio_list_node_data (node);
+
+      p_track->trigger_count =
+        _find_pause_triggers (p_track->source, p_track->info->packets,
+                              p_track->pause_list,
+                              &p_track->trigger_packets);
+    }
+
+  _read_extents_build (p_obj);
+
+  p_obj->in_read = true;
+
+  return 0;
+}
+
+static void
+_read_segment_sector (VcdObj_t *p_obj, mpeg_segment_t *p_segment,
+                      uint32_t lsn, void *buf)
+{
+  const unsigned packet_no = lsn - p_segment->start_extent;
+  uint8_t fn, cn, sm, ci;
+
+  if (packet_no < p_segment->info->packets)
+    {
+      uint8_t data[M2F2_SECTOR_SIZE];
+      struct vcd_mpeg_packet_info pkt_flags;
+
+      vcd_mpeg_source_get_packet (p_segment->source, packet_no,
+                                  data, &pkt_flags,
+                                  p_obj->update_scan_offsets);
+
+      _segment_subheader (p_obj, p_segment, packet_no, data, &pkt_flags,
+                          _trigger_packet_p (p_segment->trigger_packets,
+                                             p_segment->trigger_count,
+                                             packet_no),
+                          &fn, &cn, &sm, &ci);
+
+      _make_m2_sector (p_obj, buf, data, lsn, fn, cn, sm, ci);
+    }
+  else
+    {
+      _segment_subheader (p_obj, p_segment, packet_no, NULL, NULL, false,
+                          &fn, &cn, &sm, &ci);
+
+      _make_m2_sector (p_obj, buf, zero, lsn, fn, cn, sm, ci);
+    }
+}
+
+static void
+_read_custom_file_sector (VcdObj_t *p_obj, const custom_file_t *p,
+                          uint32_t lsn, void *buf)
+{
+  const uint32_t n = lsn - p->start_extent;
+
+  if (p->raw_flag)
+    {
+      char data[M2RAW_SECTOR_SIZE];
+
+      vcd_data_source_seek (p->file, n * M2RAW_SECTOR_SIZE);
+      _read_source_sectors (p->file, data, M2RAW_SECTOR_SIZE,
+                            1, M2RAW_SECTOR_SIZE);
+
+      _vcd_make_raw_mode2 (buf, data, lsn);
+    }
+  else
+    {
+      char data[CDIO_CD_FRAMESIZE];
+
+      vcd_data_source_seek (p->file, n * CDIO_CD_FRAMESIZE);
+      _read_source_sectors (p->file, data,
+                            MIN (p->size - n * CDIO_CD_FRAMESIZE,
+                                 CDIO_CD_FRAMESIZE),
+                            1, CDIO_CD_FRAMESIZE);
+
+      _make_m2_sector (p_obj, buf, data, lsn, 1, 0,
+                       ((n + 1 < p->sectors)
+                        ? SM_DATA
+                        : SM_DATA | SM_EOF),
+                       0);
+    }
+}
+
+/* the ISO9660 track, laid out as by _write_vcd_iso_track () */
+static void
+_read_iso_sector (VcdObj_t *p_obj, uint32_t lsn, void *buf)
+{
+  const read_extent_t *p_extent;
+
+  if (lsn < p_obj->mpeg_segment_start_extent
+      || (lsn >= p_obj->ext_file_start_extent
+          && lsn < p_obj->custom_file_start_extent))
+    {
+      const void *content = _dict_get_sector (p_obj, lsn);
+      uint8_t flags = SM_DATA | _dict_get_sector_flags (p_obj, lsn);
+      uint8_t fileno = 0;
+
+      if (lsn >= p_obj->ext_file_start_extent)
+        fileno = _vcd_obj_has_cap_p (p_obj, _CAP_4C_SVCD) ? 0 : 1;
+
+      if (content == NULL)
+        content = zero;
+
+      _make_m2_sector (p_obj, buf, content, lsn, fileno, 0, flags, 0);
+      return;
+    }
+
+  if ((p_extent = _read_extent_find (p_obj, lsn)))
+    switch (p_extent->type)
+      {
+      case _EXTENT_SEGMENT:
+        _read_segment_sector (p_obj, p_extent->data, lsn, buf);
+        return;
+
+      case _EXTENT_CUSTOM_FILE:
+        _read_custom_file_sector (p_obj, p_extent->data, lsn, buf);
+        return;
+
+      default:
+        vcd_assert_not_reached ();
+        break;
+      }
+
+  /* blank unalloced sectors */
+  _make_m2_sector (p_obj, buf, zero, lsn, 0, 0, SM_DATA, 0);
+}
+
+static int
+_read_sequence_sector (VcdObj_t *p_obj, mpeg_sequence_t *track,
+                       int track_idx, uint32_t lsn, void *buf)
+{
+  const uint32_t start = p_obj->iso_size + track->relative_start_extent;
+  uint32_t n;
+
+  if (lsn < start)
+    {
+      _make_m2_sector (p_obj, buf, zero, lsn, 0, 0, SM_FORM2, 0);
+      return 0;
+    }
+
+  n = lsn - start;
+
+  if (n < p_obj->track_front_margin)
+    {
+      _make_m2_sector (p_obj, buf, zero, lsn, track_idx + 1,
+                       0, SM_FORM2|SM_REALT, 0);
+      return 0;
+    }
+
+  n -= p_obj->track_front_margin;
+
+  if (n < track->info->packets)
+    {
+      char data[2324];
+      uint8_t ci, sm, cnum, fnum;
+      struct vcd_mpeg_packet_info pkt_flags;
+
+      vcd_mpeg_source_get_packet (track->source, n, data, &pkt_flags,
+                                  p_obj->update_scan_offsets);
+
+      if (_sequence_subheader (p_obj, track, track_idx, n, &pkt_flags,
+                               _trigger_packet_p (track->trigger_packets,
+                                                  track->trigger_count, n),
+                               NULL, &fnum, &cnum, &sm, &ci))
+        return -1;
+
+      _make_m2_sector (p_obj, buf, data, lsn, fnum, cnum, sm, ci);
+      return 0;
+    }
+
+  n -= track->info->packets;
+
+  {
+    uint8_t sm = SM_FORM2 | SM_REALT;
+
+    if (n + 1 == p_obj->track_rear_margin)
+      sm |= SM_EOF;
+
+    _make_m2_sector (p_obj, buf, zero, lsn, track_idx + 1, 0, sm, 0);
+  }
+
+  return 0;
+}
+
+int
+vcd_obj_read_sector (VcdObj_t *p_obj, lsn_t lsn, void *buf)
+{
+  const uint32_t end = p_obj->iso_size + p_obj->relative_end_extent;
+  const read_extent_t *p_extent;
+
+  vcd_assert (p_obj != NULL);
+  vcd_assert (p_obj->in_read);
+  vcd_assert (buf != NULL);
+
+  if (lsn < 0 || lsn >= end + p_obj->leadout_pregap)
+    return -1;
+
+  if (lsn < p_obj->iso_size)
+    {
+      _read_iso_sector (p_obj, lsn, buf);
+      return 0;
+    }
+
+  if (lsn >= end)
+    {
+      /* post-gap ('leadout pregap') */
+      _make_m2_sector (p_obj, buf, zero, lsn, 0, 0, SM_FORM2, 0);
+      return 0;
+    }
+
+  /* the track lsn is in, pregap included */
+  p_extent = _read_extent_find (p_obj, lsn);
+
+  vcd_assert (p_extent != NULL);
+  vcd_assert (p_extent->type == _EXTENT_SEQUENCE);
+
+  return _read_sequence_sector (p_obj, p_extent->data, p_extent->track_idx,
+                                lsn, buf);
+}
+
 const char *
 vcd_version_string (bool full_text)
 {
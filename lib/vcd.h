@@ -18,7 +18,12 @@
     Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
-/* libvcd main header */
+/* libvcd main header
+
+   Thread safety: a VcdObj_t, the sources and the image sink added to
+   it belong to one thread at a time; different objects may be built
+   by different threads concurrently.  Messages go to the log handler
+   of the thread calling into the library (see logging.h).  */
 
 #ifndef __VCD_H__
 #define __VCD_H__
@@ -26,6 +31,7 @@
 /* Private headers */
 #include "image_sink.h"
 #include "mpeg_stream.h"
+#include "stats.h"
 #include "stream.h"
 
 #include <libvcd/types.h>
@@ -61,7 +67,10 @@ extern "C" {
     VCD_PARM_LEADOUT_PREGAP,      /**< unsigned        [0..300] */
     VCD_PARM_TRACK_PREGAP,        /**< unsigned        [1..300] */
     VCD_PARM_TRACK_FRONT_MARGIN,  /**< unsigned        [0..150] */
-    VCD_PARM_TRACK_REAR_MARGIN    /**< unsigned        [0..150] */
+    VCD_PARM_TRACK_REAR_MARGIN,   /**< unsigned        [0..150] */
+    VCD_PARM_LAYOUT_SCAN,         /**< bool            size only, no output */
+    VCD_PARM_OUTPUT_JOBS,         /**< unsigned        [1..] track writers */
+    VCD_PARM_ISO_TRACK_ONLY       /**< bool            write track 1 only */
   } vcd_parm_t;
   
   /** sets VideoCD parameter */
@@ -122,7 +131,8 @@ extern "C" {
   int 
   vcd_obj_remove_item (VcdObj_t *p_vcdobj, const char id[]);
   
-  /** returns image size in sectors */
+  /** returns image size in sectors; does not require the image to be
+      writable, i.e. works with VCD_PARM_LAYOUT_SCAN as well */
   long 
   vcd_obj_get_image_size (VcdObj_t *p_vcdobj);
   
@@ -146,19 +156,54 @@ extern "C" {
                                       void *user_data);
   
   /** writes the actual bin image file; a return value != 0 means the
-      action was aborted by user or some other error has occured... */
+      action was aborted by user or some other error has occured...
+      p_image_sink is taken over and destroyed, when the write fails by
+      vcd_obj_end_output () */
   int
   vcd_obj_write_image (VcdObj_t *p_vcdobj, VcdImageSink_t *p_image_sink,
                        progress_callback_t callback, void *p_user_data,
                        const time_t *p_create_time);
   
+  /** describes all that track track_no (1 = ISO9660 track) of the
+      image depends on but the mpeg data itself: its position and size
+      and the parameters that go into its sectors. As long as this and
+      the mpeg data stay the same, the track is written identically.
+      Valid after vcd_obj_begin_output (); the string is to be freed by
+      the caller */
+  char *
+  vcd_obj_get_track_layout (VcdObj_t *p_vcdobj, unsigned track_no);
+  
+  /** fills in the time spent and the amount of data handled in each
+      stage of building the image so far, including the scanning of
+      the mpeg items, and the peak memory usage of the process */
+  void
+  vcd_obj_get_stats (const VcdObj_t *p_vcdobj, VcdStats_t *p_stats);
+  
+  /** passes the cue sheet of the image to p_image_sink, without
+      writing any sectors; vcd_obj_write_image () does this on its own */
+  int
+  vcd_obj_write_cuesheet (VcdObj_t *p_vcdobj, VcdImageSink_t *p_image_sink);
+  
+  /** prepares for vcd_obj_read_sector (); to be called after
+      vcd_obj_begin_output () instead of writing the image. returns
+      != 0 if the mpeg items were scanned for layout only */
+  int
+  vcd_obj_begin_read (VcdObj_t *p_vcdobj, const time_t *p_create_time);
+  
+  /** generates the raw 2352 byte sector at lsn of the image that
+      vcd_obj_write_image () would write, in any order; returns != 0
+      if lsn is beyond the image or its data is invalid */
+  int
+  vcd_obj_read_sector (VcdObj_t *p_vcdobj, lsn_t lsn, void *buf);
+  
   /** this should be called writing the bin and/or cue file is done---even if 
       an error occurred */
   void 
   vcd_obj_end_output (VcdObj_t *p_vcdobj);
   
   /** destructor for VideoCD objects; call this to destory a VideoCD
-      object created by vcd_obj_new () */
+      object created by vcd_obj_new (), along with the sources added to
+      it; output an error left open is ended first */
   void 
   vcd_obj_destroy (VcdObj_t *p_vcdobj);
   
@@ -31,9 +31,9 @@
 #endif
 
 bool 
-read_pvd(CdIo_t *cdio, iso9660_pvd_t *pvd) 
+read_pvd(const vcdinfo_obj_t *p_vcdinfo, iso9660_pvd_t *pvd) 
 {
-  if (cdio_read_mode2_sector (cdio, pvd, ISO_PVD_SECTOR, false)) {
+  if (vcdinfo_read_mode2_sectors (p_vcdinfo, pvd, ISO_PVD_SECTOR, false, 1)) {
     vcd_error ("error reading PVD sector (%d)", ISO_PVD_SECTOR);
     return false;
   }
@@ -53,9 +53,10 @@ read_pvd(CdIo_t *cdio, iso9660_pvd_t *pvd)
 }
 
 bool 
-read_entries(CdIo_t *cdio, EntriesVcd_t *entries) 
+read_entries(const vcdinfo_obj_t *p_vcdinfo, EntriesVcd_t *entries) 
 {
-  if (cdio_read_mode2_sector (cdio, entries, ENTRIES_VCD_SECTOR, false)) {
+  if (vcdinfo_read_mode2_sectors (p_vcdinfo, entries, ENTRIES_VCD_SECTOR,
+                                  false, 1)) {
     vcd_error ("error reading Entries sector (%d)", ENTRIES_VCD_SECTOR);
     return false;
   }
@@ -74,9 +75,11 @@ read_entries(CdIo_t *cdio, EntriesVcd_t *entries)
 }
 
 bool 
-read_info(CdIo_t *cdio, InfoVcd_t *info, vcd_type_t *vcd_type) 
+read_info(const vcdinfo_obj_t *p_vcdinfo, InfoVcd_t *info,
+          vcd_type_t *vcd_type) 
 {
-  if (cdio_read_mode2_sector (cdio, info, INFO_VCD_SECTOR, false)) {
+  if (vcdinfo_read_mode2_sectors (p_vcdinfo, info, INFO_VCD_SECTOR,
+                                  false, 1)) {
     vcd_warn ("error reading Info sector (%d)", INFO_VCD_SECTOR);
     return false;
   }
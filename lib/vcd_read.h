@@ -27,12 +27,16 @@
 #include <cdio/cdio.h>
 #include <cdio/iso9660.h>
 
+#include <libvcd/info.h>
+
 /* FIXME: make this really private: */
 #include <libvcd/files_private.h>
 
-bool read_pvd(CdIo_t *p_cdio, iso9660_pvd_t *pvd);
-bool read_entries(CdIo_t *p_cdio, EntriesVcd_t *entries);
-bool read_info(CdIo_t *p_cdio, InfoVcd_t *info, vcd_type_t *vcd_type);
+/* these read through the sector cache of p_vcdinfo, if it has one */
+bool read_pvd(const vcdinfo_obj_t *p_vcdinfo, iso9660_pvd_t *pvd);
+bool read_entries(const vcdinfo_obj_t *p_vcdinfo, EntriesVcd_t *entries);
+bool read_info(const vcdinfo_obj_t *p_vcdinfo, InfoVcd_t *info,
+               vcd_type_t *vcd_type);
 
 
 
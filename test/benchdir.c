@@ -0,0 +1,109 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Builds an ISO9660 directory tree with many files (default 50000)
+   through the internal directory API and reports the time spent. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <cdio/cdio.h>
+#include <cdio/iso9660.h>
+
+#include <libvcd/logging.h>
+
+/* Private headers */
+#include "vcd_assert.h"
+#include "directory.h"
+
+#define DEFAULT_FILES    50000
+#define FILES_PER_DIR    500
+
+static double
+_elapsed (clock_t start)
+{
+  return (double) (clock () - start) / CLOCKS_PER_SEC;
+}
+
+int
+main (int argc, const char *argv[])
+{
+  VcdDirectory_t *dir;
+  unsigned files = DEFAULT_FILES, n;
+  uint32_t dirs_size;
+  void *dirs_buf, *ptl, *ptm;
+  clock_t start;
+
+  if (argc > 1)
+    files = atoi (argv[1]);
+
+  vcd_assert (files > 0);
+
+  dir = _vcd_directory_new ();
+
+  start = clock ();
+
+  /* files are added in reverse order, so every directory needs sorting */
+  for (n = files; n > 0; n--)
+    {
+      char pathname[64];
+
+      snprintf (pathname, sizeof (pathname), "DATA/D%04u/F%06u.DAT",
+                (n - 1) / FILES_PER_DIR, n - 1);
+
+      if (_vcd_directory_mkfile (dir, pathname, 1000 + n, ISO_BLOCKSIZE,
+                                 false, 1))
+        vcd_error ("mkfile `%s' failed", pathname);
+    }
+
+  printf ("mkfile:     %u files in %.3f s\n", files, _elapsed (start));
+
+  start = clock ();
+  dirs_size = _vcd_directory_get_size (dir);
+  printf ("get_size:   %u sectors in %.3f s\n",
+          (unsigned) dirs_size, _elapsed (start));
+
+  dirs_buf = calloc (dirs_size, ISO_BLOCKSIZE);
+  ptl = calloc (1, ISO_BLOCKSIZE);
+  ptm = calloc (1, ISO_BLOCKSIZE);
+
+  start = clock ();
+  _vcd_directory_dump_entries (dir, dirs_buf, 18);
+  _vcd_directory_dump_pathtables (dir, ptl, ptm);
+  printf ("dump:       %.3f s\n", _elapsed (start));
+
+  free (dirs_buf);
+  free (ptl);
+  free (ptm);
+
+  _vcd_directory_destroy (dir);
+
+  return 0;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,115 @@
+#!/bin/sh
+#$Id$
+
+if test -z $srcdir ; then
+  srcdir=`pwd`
+fi
+
+. ${srcdir}/check_common_fn
+. ${srcdir}/check_vcdxbuild_fn
+
+VCDIMAGERD="../frontends/xml/vcdimagerd"
+SOCK=daemon.sock
+
+if [ ! -x "${VCDIMAGERD}" ]; then
+  echo "$0: ${VCDIMAGERD} missing, check not possible"
+  exit 77
+fi
+
+if socat -V > /dev/null 2>&1; then
+  :
+else
+  echo "$0: socat not found, check not possible"
+  exit 77
+fi
+
+# sends request $1 to the daemon; its answer goes to $2
+send_request() {
+  echo "$1" | socat -t 300 - UNIX-CONNECT:$SOCK > $2
+}
+
+test_vcdxbuild ${srcdir}/check_vcd20.xml
+RC=$?
+if test $RC -ne 0 ; then
+  test_vcdxbuild_cleanup
+  exit $RC
+fi
+
+rm -f $SOCK daemon.bin daemon.cue daemon.out
+
+# one worker, so the job after the failing one runs on the worker
+# started in place of the ended thread
+${VCDIMAGERD} --socket=$SOCK --workers=1 --check --quiet &
+DAEMON_PID=$!
+
+# check_result exits on the first failure
+trap 'kill $DAEMON_PID 2> /dev/null' 0
+
+n=0
+while test ! -S $SOCK; do
+  n=`expr $n + 1`
+  if test $n -gt 10; then
+    echo "$0: $SOCK didn't show up"
+    exit 1
+  fi
+  sleep 1
+done
+
+send_request '{"tracks": ["no_such_track.mpg"' daemon.out
+if grep '"result": "error", "message"' daemon.out > /dev/null; then
+  RC=0
+else
+  echo "$0: malformed request not refused:"
+  cat daemon.out
+  RC=1
+fi
+check_result $RC 'vcdimagerd malformed request test'
+
+send_request '{"tracks": ["no_such_track.mpg"], "bin-file": "daemon.bin", "cue-file": "daemon.cue"}' daemon.out
+if grep '"event": "started"' daemon.out > /dev/null && \
+   grep '"level": "error"' daemon.out > /dev/null && \
+   grep '"result": "error"' daemon.out > /dev/null; then
+  RC=0
+else
+  echo "$0: failing build not reported:"
+  cat daemon.out
+  RC=1
+fi
+check_result $RC 'vcdimagerd failing build test'
+
+send_request "{\"xml-file\": \"${srcdir}/check_vcd20.xml\", \"file-prefix\": \"${srcdir}/\", \"bin-file\": \"daemon.bin\", \"cue-file\": \"daemon.cue\"}" daemon.out
+if grep '"event": "queued"' daemon.out > /dev/null && \
+   grep '"event": "started"' daemon.out > /dev/null && \
+   grep '"result": "ok"' daemon.out > /dev/null; then
+  if cmp videocd.bin daemon.bin && \
+     sed -e 's/daemon\.bin/videocd.bin/' daemon.cue | cmp videocd.cue -; then
+    RC=0
+  else
+    echo "$0: image built by vcdimagerd differs from vcdxbuild's"
+    RC=1
+  fi
+else
+  echo "$0: build failed:"
+  cat daemon.out
+  RC=1
+fi
+check_result $RC 'vcdimagerd build test'
+
+kill $DAEMON_PID
+wait $DAEMON_PID
+RC=$?
+trap - 0
+if test $RC -ne 0; then
+  echo "$0: vcdimagerd exited with $RC"
+fi
+check_result $RC 'vcdimagerd shutdown test'
+
+rm -f $SOCK daemon.bin daemon.cue daemon.out
+test_vcdxbuild_cleanup
+
+exit 0
+
+#;;; Local Variables: ***
+#;;; mode:shell-script ***
+#;;; eval: (sh-set-shell "bash") ***
+#;;; End: ***
@@ -0,0 +1,101 @@
+#!/bin/sh
+#$Id$
+
+if test -z $srcdir ; then
+  srcdir=`pwd`
+fi
+
+. ${srcdir}/check_common_fn
+. ${srcdir}/check_vcdimager_fn
+
+VCDIMAGER_FUSE="../frontends/cli/vcdimager-fuse"
+MNT=fuse_mnt
+
+if [ ! -x "${VCDIMAGER_FUSE}" ]; then
+  echo "$0: ${VCDIMAGER_FUSE} missing, check not possible"
+  exit 77
+fi
+
+if fusermount -V > /dev/null 2>&1 && test -w /dev/fuse; then
+  :
+else
+  echo "$0: FUSE not usable, check not possible"
+  exit 77
+fi
+
+# waits up to 10 seconds for the mount on $MNT to show the bin file
+wait_mounted() {
+  n=0
+  while test ! -f $MNT/videocd.bin; do
+    n=`expr $n + 1`
+    if test $n -gt 10; then
+      echo "$0: $MNT/videocd.bin didn't show up"
+      return 1
+    fi
+    sleep 1
+  done
+
+  return 0
+}
+
+# compares the files served at $MNT with the image vcdimager wrote
+cmp_mounted() {
+  if cmp videocd.bin $MNT/videocd.bin && cmp videocd.cue $MNT/videocd.cue; then
+    RC=0
+  else
+    echo "$0: sectors read through $MNT differ from videocd.bin"
+    RC=1
+  fi
+
+  fusermount -u $MNT
+  return $RC
+}
+
+test_vcdimager --type=vcd20 ${srcdir}/avseq00.m1p
+RC=$?
+if test $RC -ne 0 ; then
+  test_vcdimager_cleanup
+  exit $RC
+fi
+
+rm -rf $MNT
+mkdir $MNT
+
+${VCDIMAGER_FUSE} -f --type=vcd20 --create-time TESTING --check --quiet \
+  $MNT ${srcdir}/avseq00.m1p &
+
+if wait_mounted; then
+  cmp_mounted
+  RC=$?
+else
+  fusermount -u $MNT > /dev/null 2>&1
+  RC=1
+fi
+wait
+check_result $RC 'vcdimager-fuse foreground image test'
+
+# detached, vcdimager-fuse runs in / -- a relative track name must
+# still be found
+cp ${srcdir}/avseq00.m1p fuse_track.m1p
+
+if ${VCDIMAGER_FUSE} --type=vcd20 --create-time TESTING --check --quiet \
+    $MNT fuse_track.m1p && wait_mounted; then
+  cmp_mounted
+  RC=$?
+else
+  fusermount -u $MNT > /dev/null 2>&1
+  RC=1
+fi
+check_result $RC 'vcdimager-fuse detached image test'
+
+rm -f fuse_track.m1p
+
+rm -rf $MNT
+test_vcdimager_cleanup
+
+exit 0
+
+#;;; Local Variables: ***
+#;;; mode:shell-script ***
+#;;; eval: (sh-set-shell "bash") ***
+#;;; End: ***
@@ -0,0 +1,41 @@
+#!/bin/sh
+#$Id$
+
+# Builds, rips and dumps images at the limits of the format: 98 tracks
+# with 500 entry points, 1980 segment items, 0x7fff list ids and a full
+# LOT.  Run with `make stress'; STRESS_TIME and STRESS_MEMORY set the
+# budgets (see check_stress_fn), GNU time measures the memory.  Needs
+# about 1 GB of free disk space.
+
+if test -z $srcdir ; then
+  srcdir=`pwd`
+fi
+
+. ${srcdir}/check_common_fn
+. ${srcdir}/check_stress_fn
+
+if [ ! -x ./mpeggen ]; then
+    echo "$0: ./mpeggen missing, check not possible"
+    exit 77
+fi
+
+./mpeggen --seconds=4 stress_seq.mpg || exit 1
+./mpeggen --mpeg2 --seconds=4 stress_seq2.mpg || exit 1
+./mpeggen --mpeg2 --seconds=1 stress_seg2.mpg || exit 1
+
+for scenario in tracks segments lids lot; do
+    test_stress $scenario
+    RC=$?
+    if test $RC -ne 0; then
+	test_stress_cleanup
+    fi
+    check_result $RC "stress test $scenario"
+done
+
+test_stress_cleanup
+exit 0
+
+#;;; Local Variables: ***
+#;;; mode:shell-script ***
+#;;; eval: (sh-set-shell "bash") ***
+#;;; End: ***
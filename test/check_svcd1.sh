@@ -86,12 +86,20 @@ fi
 
 echo "$0: vcdxbuild cksum(1) checksums matched :-)"
 
+test_vcdxbuild_jobs ${srcdir}/$BASE.xml
+RC=$?
+check_result $RC 'vcdxbuild jobs test'
+
 test_vcdxrip \
   '--norip --no-command-comment -c videocd.cue --output-file svcd1_test1.xml' \
   svcd1_test1.xml ${srcdir}/svcd1_test1.xml-right
 RC=$?
 check_result $RC 'vcdxrip test 1'
 
+test_vcdxrip_jobs
+RC=$?
+check_result $RC 'vcdxrip jobs test'
+
 test_vcdinfo '--no-banner -i videocd.cue' \
     svcd1_test1.dump ${srcdir}/svcd1_test1.right
 RC=$?
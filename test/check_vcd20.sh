@@ -45,6 +45,14 @@ EOF
     fi
 
     echo "$0: vcdimager cksum(1) checksums matched :-)"
+
+    test_vcdimager_digest --type=vcd20 ${srcdir}/avseq00.m1p
+    RC=$?
+    check_result $RC 'vcdimager digest test'
+
+    test_vcdimager_jobs --type=vcd20 ${srcdir}/avseq00.m1p
+    RC=$?
+    check_result $RC 'vcdimager jobs test'
     
     test_vcdinfo '-B -i videocd.cue ' \
 	vcd20_test0.dump ${srcdir}/vcd20_test0.right
@@ -87,12 +95,28 @@ fi
 
 echo "$0: vcdxbuild cksum(1) checksums matched :-)"
 
+test_vcdxbuild_incremental ${srcdir}/${BASE}.xml
+RC=$?
+check_result $RC 'vcdxbuild incremental test'
+
+test_vcdxbuild_jobs ${srcdir}/${BASE}.xml
+RC=$?
+check_result $RC 'vcdxbuild jobs test'
+
 test_vcdxrip \
   '--norip --no-command-comment --cue-file videocd.cue -o vcd20_test1.xml' \
   vcd20_test1.xml ${srcdir}/vcd20_test1.xml-right
 RC=$?
 check_result $RC 'vcdxrip test 1'
 
+test_vcdxrip_scan_index
+RC=$?
+check_result $RC 'vcdxrip scan index test'
+
+test_vcdxrip_jobs
+RC=$?
+check_result $RC 'vcdxrip jobs test'
+
 test_vcdinfo '-B --cue-file videocd.cue ' \
     vcd20_test1.dump ${srcdir}/vcd20_test1.right
 RC=$?
@@ -108,6 +132,10 @@ test_vcdinfo '-B --bin-file videocd.bin --debug 4 -f -L -S --show-pvd vol' \
 RC=$?
 check_result $RC 'vcd-info test 3'
 
+test_vcdinfo_cache
+RC=$?
+check_result $RC 'libvcdinfo sector cache test'
+
 # if we got this far, everything should be ok
 test_vcdxbuild_cleanup
 exit 0
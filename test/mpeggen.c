@@ -0,0 +1,653 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Writes a synthetic MPEG-1 (VCD) or MPEG-2 (SVCD) program stream with
+   one video and one audio stream, for benchmarking.  All headers are
+   well-formed and the packs are multiplexed at a constant rate; the
+   coded picture and audio data is random filler, so the stream is of
+   no use to a decoder. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libvcd/types.h>
+
+#define DEFAULT_SECONDS    60
+#define DEFAULT_GOP        15
+#define DEFAULT_PACK_SIZE  2324
+
+#define AUDIO_BITRATE      224000
+#define AUDIO_SAMPFREQ     44100
+#define AUDIO_FRAME_LEN    1152 /* samples */
+
+#define PTS_DELAY          (90000 / 2) /* startup delay of the decoder */
+
+#define SEQUENCE_CODE      0x000001b3
+#define EXT_CODE           0x000001b5
+#define GOP_CODE           0x000001b8
+#define PICTURE_CODE       0x00000100
+#define SLICE_CODE         0x00000101
+#define PACK_CODE          0x000001ba
+#define SYSTEM_HEADER_CODE 0x000001bb
+#define PAD_CODE           0x000001be
+#define AUDIO_CODE         0x000001c0
+#define VIDEO_CODE         0x000001e0
+#define PROGRAM_END_CODE   0x000001b9
+
+static struct {
+  bool mpeg2;
+  bool pal;
+  unsigned seconds;
+  unsigned bitrate;   /* video, bits/s */
+  unsigned gop;       /* pictures per GOP */
+  unsigned pack_size; /* bytes per pack */
+  const char *fname;
+} gl;
+
+/* simple big endian bit writer */
+
+typedef struct {
+  uint8_t *buf;
+  unsigned pos; /* bits */
+} bitbuf_t;
+
+static void
+_put_bits (bitbuf_t *bb, uint32_t value, unsigned bits)
+{
+  while (bits--)
+    {
+      const unsigned _byte = bb->pos >> 3;
+      const unsigned _bit = 7 - (bb->pos & 7);
+
+      if (!(bb->pos & 7))
+        bb->buf[_byte] = 0;
+
+      if ((value >> bits) & 1)
+        bb->buf[_byte] |= 1 << _bit;
+
+      bb->pos++;
+    }
+}
+
+static unsigned
+_put_code (uint8_t *buf, uint32_t code)
+{
+  buf[0] = code >> 24;
+  buf[1] = code >> 16;
+  buf[2] = code >> 8;
+  buf[3] = code;
+
+  return 4;
+}
+
+/* 33 bit time stamp as used in PES headers and MPEG-1 pack headers */
+static void
+_put_timestamp (bitbuf_t *bb, unsigned prefix, uint64_t ts)
+{
+  _put_bits (bb, prefix, 4);
+  _put_bits (bb, (ts >> 30) & 0x7, 3);
+  _put_bits (bb, 1, 1);
+  _put_bits (bb, (ts >> 15) & 0x7fff, 15);
+  _put_bits (bb, 1, 1);
+  _put_bits (bb, ts & 0x7fff, 15);
+  _put_bits (bb, 1, 1);
+}
+
+/* filler without any start code prefix in it */
+static uint32_t _rand_state = 0x12345678;
+
+static void
+_fill_random (uint8_t *buf, unsigned len)
+{
+  while (len--)
+    {
+      _rand_state ^= _rand_state << 13;
+      _rand_state ^= _rand_state >> 17;
+      _rand_state ^= _rand_state << 5;
+
+      *buf++ = (_rand_state & 0xff) | 0x01;
+    }
+}
+
+static double
+_frame_rate (void)
+{
+  return gl.pal ? 25.0 : 30000.0 / 1001;
+}
+
+/****************************************************************************
+ * elementary streams, generated a GOP and a few audio frames at a time
+ */
+
+typedef struct {
+  uint8_t *data;
+  unsigned len;
+  unsigned pos;       /* bytes already put into packets */
+
+  /* access units starting in data, with their presentation time */
+  unsigned *unit_pos;
+  uint64_t *unit_pts;
+  unsigned units;
+  unsigned next_unit; /* first unit not yet timestamped */
+} es_t;
+
+static void
+_es_reset (es_t *es)
+{
+  es->len = es->pos = es->units = es->next_unit = 0;
+}
+
+static void
+_es_reserve (es_t *es, unsigned len, unsigned units)
+{
+  es->data = realloc (es->data, es->len + len);
+  es->unit_pos = realloc (es->unit_pos, (es->units + units) * sizeof (unsigned));
+  es->unit_pts = realloc (es->unit_pts, (es->units + units) * sizeof (uint64_t));
+}
+
+static void
+_es_add_unit (es_t *es, uint64_t pts)
+{
+  es->unit_pos[es->units] = es->len;
+  es->unit_pts[es->units] = pts;
+  es->units++;
+}
+
+/* one GOP of I and P pictures, I pictures three times the size */
+static void
+_make_gop (es_t *es, unsigned gop_no)
+{
+  const unsigned frate_code = gl.pal ? 3 : 4;
+  const unsigned hsize = gl.mpeg2 ? 480 : 352;
+  const unsigned vsize = gl.pal ? (gl.mpeg2 ? 576 : 288) : (gl.mpeg2 ? 480 : 240);
+  const double frame_bytes = gl.bitrate / 8.0 / _frame_rate ();
+  const unsigned p_size = frame_bytes * gl.gop / (gl.gop + 2);
+  const unsigned i_size = 3 * p_size;
+  unsigned n;
+
+  _es_reset (es);
+  _es_reserve (es, 256 + i_size + gl.gop * (64 + p_size), gl.gop);
+
+  for (n = 0; n < gl.gop; n++)
+    {
+      const unsigned frame_no = gop_no * gl.gop + n;
+      const uint64_t pts = PTS_DELAY + (uint64_t) (frame_no * 90000.0
+                                                   / _frame_rate ());
+      uint8_t *p = es->data + es->len;
+      bitbuf_t bb;
+
+      _es_add_unit (es, pts);
+
+      if (!n)
+        {
+          p += _put_code (p, SEQUENCE_CODE);
+          bb.buf = p;
+          bb.pos = 0;
+          _put_bits (&bb, hsize, 12);
+          _put_bits (&bb, vsize, 12);
+          _put_bits (&bb, gl.mpeg2 ? 2 : (gl.pal ? 8 : 12), 4); /* aspect */
+          _put_bits (&bb, frate_code, 4);
+          _put_bits (&bb, (gl.bitrate + 399) / 400, 18);
+          _put_bits (&bb, 1, 1);                 /* marker */
+          _put_bits (&bb, gl.mpeg2 ? 112 : 20, 10); /* vbv buffer size */
+          _put_bits (&bb, !gl.mpeg2, 1);         /* constrained */
+          _put_bits (&bb, 0, 1);                 /* intra matrix */
+          _put_bits (&bb, 0, 1);                 /* non-intra matrix */
+          p += bb.pos >> 3;
+
+          if (gl.mpeg2)
+            {
+              /* sequence extension, main profile at main level */
+              p += _put_code (p, EXT_CODE);
+              bb.buf = p;
+              bb.pos = 0;
+              _put_bits (&bb, 1, 4);             /* extension id */
+              _put_bits (&bb, 0x48, 8);          /* profile and level */
+              _put_bits (&bb, 0, 1);             /* progressive */
+              _put_bits (&bb, 1, 2);             /* 4:2:0 */
+              _put_bits (&bb, 0, 2);
+              _put_bits (&bb, 0, 2);
+              _put_bits (&bb, 0, 12);            /* bit rate extension */
+              _put_bits (&bb, 1, 1);             /* marker */
+              _put_bits (&bb, 0, 8);             /* vbv extension */
+              _put_bits (&bb, 0, 1);             /* low delay */
+              _put_bits (&bb, 0, 2);
+              _put_bits (&bb, 0, 5);
+              p += bb.pos >> 3;
+            }
+
+          {
+            const unsigned secs = frame_no / (unsigned) (_frame_rate () + 0.5);
+            const unsigned pics = frame_no % (unsigned) (_frame_rate () + 0.5);
+
+            p += _put_code (p, GOP_CODE);
+            bb.buf = p;
+            bb.pos = 0;
+            _put_bits (&bb, 0, 1);               /* drop frame */
+            _put_bits (&bb, secs / 3600, 5);
+            _put_bits (&bb, (secs / 60) % 60, 6);
+            _put_bits (&bb, 1, 1);               /* marker */
+            _put_bits (&bb, secs % 60, 6);
+            _put_bits (&bb, pics, 6);
+            _put_bits (&bb, 1, 1);               /* closed gop */
+            _put_bits (&bb, 0, 1);               /* broken link */
+            _put_bits (&bb, 0, 5);
+            p += bb.pos >> 3;
+          }
+        }
+
+      p += _put_code (p, PICTURE_CODE);
+      bb.buf = p;
+      bb.pos = 0;
+      _put_bits (&bb, n, 10);                    /* temporal reference */
+      _put_bits (&bb, n ? 2 : 1, 3);             /* P or I */
+      _put_bits (&bb, 0xffff, 16);               /* vbv delay */
+      if (n)
+        {
+          _put_bits (&bb, 0, 1);                 /* full pel forward */
+          _put_bits (&bb, gl.mpeg2 ? 7 : 1, 3);  /* forward f code */
+        }
+      _put_bits (&bb, 0, 1);                     /* extra bit */
+      while (bb.pos & 7)
+        _put_bits (&bb, 0, 1);
+      p += bb.pos >> 3;
+
+      if (gl.mpeg2)
+        {
+          /* picture coding extension */
+          p += _put_code (p, EXT_CODE);
+          bb.buf = p;
+          bb.pos = 0;
+          _put_bits (&bb, 8, 4);                 /* extension id */
+          _put_bits (&bb, n ? 0x11ff : 0xffff, 16); /* f codes */
+          _put_bits (&bb, 0, 2);                 /* intra dc precision */
+          _put_bits (&bb, 3, 2);                 /* frame picture */
+          _put_bits (&bb, 1, 1);                 /* top field first */
+          _put_bits (&bb, 1, 1);                 /* frame pred frame dct */
+          _put_bits (&bb, 0, 6);
+          _put_bits (&bb, 1, 1);                 /* progressive frame */
+          _put_bits (&bb, 0, 1);                 /* composite display */
+          _put_bits (&bb, 0, 3);
+          p += bb.pos >> 3;
+        }
+
+      p += _put_code (p, SLICE_CODE);
+      _fill_random (p, n ? p_size : i_size);
+      p += n ? p_size : i_size;
+
+      es->len = p - es->data;
+    }
+}
+
+/* layer II audio frames up to the given time */
+static void
+_make_audio (es_t *es, unsigned *frame_no, uint64_t until_pts)
+{
+  const double frame_bytes = 144.0 * AUDIO_BITRATE / AUDIO_SAMPFREQ;
+
+  _es_reset (es);
+
+  for (;;)
+    {
+      const uint64_t pts = PTS_DELAY + (uint64_t) (*frame_no * 90000.0
+                                                   * AUDIO_FRAME_LEN
+                                                   / AUDIO_SAMPFREQ);
+      /* the padding bit makes up for the fractional frame size */
+      const bool padding = (unsigned) ((*frame_no + 1) * frame_bytes)
+        - (unsigned) (*frame_no * frame_bytes) > (unsigned) frame_bytes;
+      const unsigned len = (unsigned) frame_bytes + padding;
+      bitbuf_t bb;
+
+      if (pts >= until_pts)
+        break;
+
+      _es_reserve (es, len, 1);
+      _es_add_unit (es, pts);
+
+      bb.buf = es->data + es->len;
+      bb.pos = 0;
+      _put_bits (&bb, 0xfff, 12);                /* sync */
+      _put_bits (&bb, 1, 1);                     /* MPEG-1 */
+      _put_bits (&bb, 2, 2);                     /* layer II */
+      _put_bits (&bb, 1, 1);                     /* no crc */
+      _put_bits (&bb, 11, 4);                    /* 224 kbit/s */
+      _put_bits (&bb, 0, 2);                     /* 44.1 kHz */
+      _put_bits (&bb, padding, 1);
+      _put_bits (&bb, 0, 1);                     /* private */
+      _put_bits (&bb, 0, 2);                     /* stereo */
+      _put_bits (&bb, 0, 2);                     /* mode extension */
+      _put_bits (&bb, 0, 1);                     /* copyright */
+      _put_bits (&bb, 1, 1);                     /* original */
+      _put_bits (&bb, 0, 2);                     /* emphasis */
+
+      _fill_random (es->data + es->len + 4, len - 4);
+
+      es->len += len;
+      (*frame_no)++;
+    }
+}
+
+/****************************************************************************
+ * program stream
+ */
+
+/* a VCD is played at single speed, a SVCD at double speed */
+static unsigned
+_packs_per_second (void)
+{
+  return gl.mpeg2 ? 150 : 75;
+}
+
+/* in units of 50 bytes/s */
+static unsigned
+_mux_rate (void)
+{
+  return (gl.pack_size * _packs_per_second () + 49) / 50;
+}
+
+static unsigned
+_put_pack_header (uint8_t *buf, unsigned pack_no)
+{
+  const uint64_t scr = (uint64_t) pack_no * 90000 / _packs_per_second ();
+  const unsigned mux_rate = _mux_rate ();
+  bitbuf_t bb = { buf, 0 };
+
+  bb.pos = _put_code (buf, PACK_CODE) << 3;
+
+  if (gl.mpeg2)
+    {
+      _put_bits (&bb, 1, 2);
+      _put_bits (&bb, (scr >> 30) & 0x7, 3);
+      _put_bits (&bb, 1, 1);
+      _put_bits (&bb, (scr >> 15) & 0x7fff, 15);
+      _put_bits (&bb, 1, 1);
+      _put_bits (&bb, scr & 0x7fff, 15);
+      _put_bits (&bb, 1, 1);
+      _put_bits (&bb, 0, 9);                     /* SCR extension */
+      _put_bits (&bb, 1, 1);
+      _put_bits (&bb, mux_rate, 22);
+      _put_bits (&bb, 3, 2);
+      _put_bits (&bb, 0x1f, 5);                  /* reserved */
+      _put_bits (&bb, 0, 3);                     /* no stuffing */
+    }
+  else
+    {
+      _put_timestamp (&bb, 0x2, scr);
+      _put_bits (&bb, 1, 1);
+      _put_bits (&bb, mux_rate, 22);
+      _put_bits (&bb, 1, 1);
+    }
+
+  return bb.pos >> 3;
+}
+
+static unsigned
+_put_system_header (uint8_t *buf)
+{
+  bitbuf_t bb = { buf, 0 };
+
+  bb.pos = _put_code (buf, SYSTEM_HEADER_CODE) << 3;
+  _put_bits (&bb, 12, 16);                       /* header length */
+  _put_bits (&bb, 1, 1);
+  _put_bits (&bb, _mux_rate (), 22);             /* rate bound */
+  _put_bits (&bb, 1, 1);
+  _put_bits (&bb, 1, 6);                         /* audio bound */
+  _put_bits (&bb, 0, 1);                         /* fixed */
+  _put_bits (&bb, !gl.mpeg2, 1);                 /* CSPS */
+  _put_bits (&bb, 1, 1);                         /* audio lock */
+  _put_bits (&bb, 1, 1);                         /* video lock */
+  _put_bits (&bb, 1, 1);
+  _put_bits (&bb, 1, 5);                         /* video bound */
+  _put_bits (&bb, 0xff, 8);                      /* reserved */
+
+  _put_bits (&bb, 0xe0, 8);
+  _put_bits (&bb, 3, 2);
+  _put_bits (&bb, 1, 1);                         /* 1024 byte units */
+  _put_bits (&bb, gl.mpeg2 ? 230 : 46, 13);
+
+  _put_bits (&bb, 0xc0, 8);
+  _put_bits (&bb, 3, 2);
+  _put_bits (&bb, 0, 1);                         /* 128 byte units */
+  _put_bits (&bb, 32, 13);
+
+  return bb.pos >> 3;
+}
+
+static unsigned
+_put_padding (uint8_t *buf, unsigned len)
+{
+  if (!len)
+    return 0;
+
+  /* too short for a padding packet, use stuffing */
+  if (len < 6)
+    {
+      memset (buf, 0xff, len);
+      return len;
+    }
+
+  _put_code (buf, PAD_CODE);
+  buf[4] = (len - 6) >> 8;
+  buf[5] = (len - 6);
+  memset (buf + 6, 0xff, len - 6);
+
+  return len;
+}
+
+/* puts as much of es into a PES packet as fits into len bytes; the
+   time stamp is the one of the first access unit starting in it */
+static unsigned
+_put_pes (uint8_t *buf, unsigned len, uint32_t code, es_t *es)
+{
+  const unsigned hdr_len = gl.mpeg2 ? 9 : 6;
+  const unsigned pts_len = 5;
+  unsigned payload = len - hdr_len - pts_len;
+  bool has_pts;
+  bitbuf_t bb = { buf, 0 };
+
+  if (payload > es->len - es->pos)
+    payload = es->len - es->pos;
+
+  while (es->next_unit < es->units
+         && es->unit_pos[es->next_unit] < es->pos)
+    es->next_unit++;
+
+  has_pts = es->next_unit < es->units
+    && es->unit_pos[es->next_unit] < es->pos + payload;
+
+  if (!has_pts)
+    payload = MIN (es->len - es->pos, len - hdr_len - (gl.mpeg2 ? 0 : 1));
+
+  bb.pos = _put_code (buf, code) << 3;
+  _put_bits (&bb, 0, 16);                        /* length, see below */
+
+  if (gl.mpeg2)
+    {
+      _put_bits (&bb, 2, 2);
+      _put_bits (&bb, 0, 5);
+      _put_bits (&bb, 1, 1);                     /* original */
+      _put_bits (&bb, has_pts ? 2 : 0, 2);
+      _put_bits (&bb, 0, 6);
+      _put_bits (&bb, has_pts ? pts_len : 0, 8);
+      if (has_pts)
+        _put_timestamp (&bb, 0x2, es->unit_pts[es->next_unit]);
+    }
+  else if (has_pts)
+    _put_timestamp (&bb, 0x2, es->unit_pts[es->next_unit]);
+  else
+    _put_bits (&bb, 0x0f, 8);
+
+  if (has_pts)
+    es->next_unit++;
+
+  memcpy (buf + (bb.pos >> 3), es->data + es->pos, payload);
+  es->pos += payload;
+
+  len = (bb.pos >> 3) + payload;
+  buf[4] = (len - 6) >> 8;
+  buf[5] = (len - 6);
+
+  return len;
+}
+
+int
+main (int argc, const char *argv[])
+{
+  es_t video = { 0, }, audio = { 0, };
+  unsigned pack_no = 0, gop_no = 0, audio_frame_no = 0;
+  unsigned gops;
+  uint8_t *pack;
+  FILE *fd;
+  int n;
+
+  gl.seconds = DEFAULT_SECONDS;
+  gl.gop = DEFAULT_GOP;
+  gl.pack_size = DEFAULT_PACK_SIZE;
+
+  for (n = 1; n < argc; n++)
+    {
+      const char *arg = argv[n];
+
+      if (!strcmp (arg, "--mpeg2"))
+        gl.mpeg2 = true;
+      else if (!strcmp (arg, "--pal"))
+        gl.pal = true;
+      else if (!strncmp (arg, "--seconds=", 10))
+        gl.seconds = atoi (arg + 10);
+      else if (!strncmp (arg, "--bitrate=", 10))
+        gl.bitrate = atoi (arg + 10);
+      else if (!strncmp (arg, "--gop=", 6))
+        gl.gop = atoi (arg + 6);
+      else if (!strncmp (arg, "--pack-size=", 12))
+        gl.pack_size = atoi (arg + 12);
+      else if (arg[0] != '-' && !gl.fname)
+        gl.fname = arg;
+      else
+        {
+          fprintf (stderr,
+                   "usage: %s [--mpeg2] [--pal] [--seconds=N] [--bitrate=BPS]"
+                   " [--gop=N] [--pack-size=BYTES] FILE\n", argv[0]);
+          return EXIT_FAILURE;
+        }
+    }
+
+  if (!gl.bitrate)
+    gl.bitrate = gl.mpeg2 ? 2000000 : 1150000;
+
+  if (!gl.fname || !gl.seconds || !gl.gop || gl.gop > 1023
+      || gl.pack_size < 64 || gl.pack_size > 2324)
+    {
+      fprintf (stderr, "%s: invalid arguments\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  /* pack and PES headers take up to 28 bytes of each pack */
+  if ((gl.bitrate + AUDIO_BITRATE) / 8
+      > (gl.pack_size - 28) * _packs_per_second ())
+    fprintf (stderr, "%s: warning, bit rate exceeds the mux rate"
+             " -- the stream will run late\n", argv[0]);
+
+  if (!(fd = fopen (gl.fname, "wb")))
+    {
+      perror (gl.fname);
+      return EXIT_FAILURE;
+    }
+
+  gops = gl.seconds * _frame_rate () / gl.gop + 0.5;
+  pack = malloc (gl.pack_size);
+
+  for (gop_no = 0; gop_no < gops; gop_no++)
+    {
+      _make_gop (&video, gop_no);
+      _make_audio (&audio, &audio_frame_no,
+                   video.unit_pts[video.units - 1]
+                   + (uint64_t) (90000 / _frame_rate ()));
+
+      while (video.pos < video.len || audio.pos < audio.len)
+        {
+          const uint64_t scr = (uint64_t) pack_no * 90000
+            / _packs_per_second ();
+          unsigned len = _put_pack_header (pack, pack_no);
+          es_t *es = NULL;
+
+          if (!pack_no)
+            len += _put_system_header (pack + len);
+
+          /* feed whichever stream is due earlier, but not too far
+             ahead of the clock */
+          if (audio.pos < audio.len
+              && (video.pos == video.len
+                  || audio.unit_pts[MIN (audio.next_unit, audio.units - 1)]
+                  < video.unit_pts[MIN (video.next_unit, video.units - 1)]))
+            es = &audio;
+          else if (video.pos < video.len)
+            es = &video;
+
+          if (es && es->unit_pts[MIN (es->next_unit, es->units - 1)]
+              > scr + PTS_DELAY + 90000)
+            es = NULL;
+
+          if (es)
+            len += _put_pes (pack + len, gl.pack_size - len,
+                             es == &video ? VIDEO_CODE : AUDIO_CODE, es);
+
+          len += _put_padding (pack + len, gl.pack_size - len);
+
+          fwrite (pack, gl.pack_size, 1, fd);
+          pack_no++;
+        }
+    }
+
+  /* the program end code takes the place of the last 4 padding bytes */
+  {
+    unsigned len = _put_pack_header (pack, pack_no);
+
+    len += _put_padding (pack + len, gl.pack_size - len - 4);
+    _put_code (pack + len, PROGRAM_END_CODE);
+
+    fwrite (pack, gl.pack_size, 1, fd);
+    pack_no++;
+  }
+
+  fclose (fd);
+
+  printf ("%s: %u packs, %u GOPs, %u audio frames\n", gl.fname, pack_no,
+          gops, audio_frame_no);
+
+  free (pack);
+  free (video.data);
+  free (video.unit_pos);
+  free (video.unit_pts);
+  free (audio.data);
+  free (audio.unit_pos);
+  free (audio.unit_pts);
+
+  return EXIT_SUCCESS;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
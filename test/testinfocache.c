@@ -0,0 +1,147 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Checks the sector cache of libvcdinfo on a cue file the check
+   scripts built: the sectors vcdinfo_open_flags () read come from the
+   cache when read again, a read continuing the previous one brings
+   the read-ahead along, and what the cache returns is what is on the
+   disc. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cdio/cdio.h>
+#include <cdio/iso9660.h>
+
+#include <libvcd/files.h>
+#include <libvcd/info.h>
+#include <libvcd/logging.h>
+
+/* reads sector lsn through the cache and straight from the image */
+static int
+_check_read (const vcdinfo_obj_t *p_vcdinfo, lsn_t lsn)
+{
+  uint8_t cached[ISO_BLOCKSIZE], direct[ISO_BLOCKSIZE];
+
+  if (vcdinfo_read_mode2_sectors (p_vcdinfo, cached, lsn, false, 1)
+      || cdio_read_mode2_sector (vcdinfo_get_cd_image (p_vcdinfo), direct,
+                                 lsn, false))
+    {
+      printf ("reading sector %lu failed\n", (unsigned long int) lsn);
+      return 1;
+    }
+
+  if (memcmp (cached, direct, ISO_BLOCKSIZE))
+    {
+      printf ("sector %lu read through the cache differs\n",
+              (unsigned long int) lsn);
+      return 1;
+    }
+
+  return 0;
+}
+
+/* compares the counters with p_before plus the given numbers */
+static int
+_check_stats (const vcdinfo_obj_t *p_vcdinfo,
+              const vcdinfo_cache_stats_t *p_before, unsigned long int hits,
+              unsigned long int misses, unsigned long int readahead,
+              const char what[])
+{
+  vcdinfo_cache_stats_t stats;
+
+  vcdinfo_get_cache_stats (p_vcdinfo, &stats);
+
+  if (stats.hits - p_before->hits == hits
+      && stats.misses - p_before->misses == misses
+      && stats.readahead - p_before->readahead == readahead)
+    return 0;
+
+  printf ("%s: %lu hits, %lu misses, %lu read ahead;"
+          " expected %lu, %lu, %lu\n", what,
+          stats.hits - p_before->hits, stats.misses - p_before->misses,
+          stats.readahead - p_before->readahead, hits, misses, readahead);
+  return 1;
+}
+
+int
+main (int argc, const char *argv[])
+{
+  vcdinfo_obj_t *p_vcdinfo;
+  vcdinfo_cache_stats_t stats;
+  char *psz_source;
+  int i_rc = 0;
+
+  if (argc != 2)
+    {
+      printf ("usage: %s CUE-FILE\n", argv[0]);
+      return 1;
+    }
+
+  vcd_loglevel_default = VCD_LOG_ERROR;
+
+  psz_source = strdup (argv[1]);
+
+  if (vcdinfo_open_flags (&p_vcdinfo, &psz_source, DRIVER_BINCUE, NULL,
+                          VCDINFO_OPEN_FLAG_CACHE) != VCDINFO_OPEN_VCD)
+    {
+      printf ("%s doesn't hold a (S)VCD\n", psz_source);
+      free (psz_source);
+      return 1;
+    }
+
+  /* the PVD, INFO.VCD and ENTRIES.VCD at least */
+  vcdinfo_get_cache_stats (p_vcdinfo, &stats);
+
+  if (stats.misses < 3 || stats.hits)
+    {
+      printf ("opening: %lu hits, %lu misses\n", stats.hits, stats.misses);
+      i_rc = 1;
+    }
+
+  i_rc |= _check_read (p_vcdinfo, INFO_VCD_SECTOR);
+  i_rc |= _check_read (p_vcdinfo, ENTRIES_VCD_SECTOR);
+  i_rc |= _check_stats (p_vcdinfo, &stats, 2, 0, 0, "reading again");
+
+  /* nobody reads the system area; sector 1 continues the read of
+     sector 0 and fetches the read-ahead, which sector 2 is part of */
+  vcdinfo_get_cache_stats (p_vcdinfo, &stats);
+
+  i_rc |= _check_read (p_vcdinfo, 0);
+  i_rc |= _check_read (p_vcdinfo, 1);
+  i_rc |= _check_read (p_vcdinfo, 2);
+  i_rc |= _check_stats (p_vcdinfo, &stats, 1, 2, VCDINFO_CACHE_READAHEAD - 1,
+                        "reading sectors 0 to 2");
+
+  vcdinfo_close (p_vcdinfo);
+  free (psz_source);
+
+  return i_rc;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,304 @@
+/*
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+/* Times the stages of an image build on a given MPEG program stream
+   (see mpeggen): scanning, packet parsing, sector encoding, writing
+   through the bin/cue image sink and the whole build.  The CPU bound
+   stages are repeated until they took at least a second.  Results go
+   to stdout, one line per benchmark or, with --json, as a JSON
+   array. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <cdio/cdio.h>
+
+/* Public headers */
+#include <libvcd/logging.h>
+#include <libvcd/sector.h>
+
+/* Private headers */
+#include "vcd_assert.h"
+#include "image_sink.h"
+#include "mpeg_stream.h"
+#include "stats.h"
+#include "stream_stdio.h"
+#include "vcd.h"
+
+#define MIN_SECONDS  1.0
+#define SINK_SECTORS (10 * 60 * 75) /* ten minutes worth of image */
+
+static struct {
+  bool json;
+  bool svcd;
+  const char *mpeg_fname;
+  const char *bin_fname;
+  const char *cue_fname;
+  unsigned results;
+} gl;
+
+static void
+_report (const char name[], double value, const char unit[])
+{
+  if (gl.json)
+    printf ("%s\n  { \"name\": \"%s\", \"value\": %.3f, \"unit\": \"%s\" }",
+            gl.results ? "," : "[", name, value, unit);
+  else
+    printf ("%-20s %14.3f %s\n", name, value, unit);
+
+  gl.results++;
+}
+
+static void
+_log_handler (vcd_log_level_t level, const char message[])
+{
+  /* the warnings repeat on every iteration; only errors are of interest */
+  if (level >= VCD_LOG_ERROR)
+    {
+      fprintf (stderr, "%s\n", message);
+      exit (EXIT_FAILURE);
+    }
+}
+
+static void
+_bench_scan (void)
+{
+  VcdDataSource_t *data_src = vcd_data_source_new_stdio (gl.mpeg_fname);
+  const long len = vcd_data_source_stat (data_src);
+  const double start = _vcd_stats_clock ();
+  double bytes = 0;
+
+  vcd_data_source_destroy (data_src);
+
+  do
+    {
+      VcdMpegSource_t *src =
+        vcd_mpeg_source_new (vcd_data_source_new_stdio (gl.mpeg_fname));
+
+      vcd_mpeg_source_scan (src, true, false, NULL, NULL);
+      vcd_mpeg_source_destroy (src, true);
+
+      bytes += len;
+    }
+  while (_vcd_stats_clock () - start < MIN_SECONDS);
+
+  _report ("scan", bytes / (_vcd_stats_clock () - start) / (1024 * 1024),
+           "MiB/s");
+}
+
+static void
+_bench_parse (void)
+{
+  VcdDataSource_t *src = vcd_data_source_new_stdio (gl.mpeg_fname);
+  const long len = vcd_data_source_stat (src);
+  uint8_t *buf = malloc (len);
+  double start, elapsed;
+  uint64_t packets = 0;
+
+  vcd_data_source_read (src, buf, len, 1);
+  vcd_data_source_destroy (src);
+
+  start = _vcd_stats_clock ();
+
+  do
+    {
+      VcdMpegStreamCtx state;
+      long pos = 0;
+
+      memset (&state, 0, sizeof (state));
+
+      while (pos < len)
+        {
+          const int pkt_len =
+            vcd_mpeg_parse_packet (buf + pos, MIN (len - pos, 2324),
+                                   true, &state);
+
+          if (!pkt_len)
+            vcd_error ("invalid packet at byte offset %ld", pos);
+
+          pos += pkt_len;
+          packets++;
+        }
+    }
+  while ((elapsed = _vcd_stats_clock () - start) < MIN_SECONDS);
+
+  _report ("parse", packets / elapsed, "packets/s");
+
+  free (buf);
+}
+
+static void
+_bench_mode2 (void)
+{
+  uint8_t data[M2RAW_SECTOR_SIZE], sector[CDIO_CD_FRAMESIZE_RAW];
+  const double start = _vcd_stats_clock ();
+  double elapsed;
+  uint32_t n = 0;
+
+  memset (data, 0x5a, sizeof (data));
+
+  do
+    {
+      unsigned i;
+
+      for (i = 0; i < 1000; i++, n++)
+        _vcd_make_mode2 (sector, data, n, 1, 1, SM_FORM2 | SM_REALT, 0);
+    }
+  while ((elapsed = _vcd_stats_clock () - start) < MIN_SECONDS);
+
+  _report ("mode2", n / elapsed, "sectors/s");
+}
+
+static void
+_bench_sink (void)
+{
+  VcdImageSink_t *sink = vcd_image_sink_new_bincue ();
+  uint8_t sector[CDIO_CD_FRAMESIZE_RAW];
+  CdioList_t *cue_list = _cdio_list_new ();
+  vcd_cue_t *cue;
+  double start, elapsed;
+  lsn_t lsn;
+
+  vcd_image_sink_set_arg (sink, "bin", gl.bin_fname);
+  vcd_image_sink_set_arg (sink, "cue", gl.cue_fname);
+
+  cue = calloc (1, sizeof (vcd_cue_t));
+  cue->type = VCD_CUE_TRACK_START;
+  _cdio_list_append (cue_list, cue);
+
+  cue = calloc (1, sizeof (vcd_cue_t));
+  cue->type = VCD_CUE_END;
+  cue->lsn = SINK_SECTORS;
+  _cdio_list_append (cue_list, cue);
+
+  vcd_image_sink_set_cuesheet (sink, cue_list);
+  _cdio_list_free (cue_list, true, NULL);
+
+  memset (sector, 0xa5, sizeof (sector));
+
+  start = _vcd_stats_clock ();
+
+  for (lsn = 0; lsn < SINK_SECTORS; lsn++)
+    vcd_image_sink_write (sink, sector, lsn);
+
+  /* closing flushes the last buffers */
+  vcd_image_sink_destroy (sink);
+  elapsed = _vcd_stats_clock () - start;
+
+  _report ("sink", SINK_SECTORS * (double) CDIO_CD_FRAMESIZE_RAW / elapsed
+           / (1024 * 1024), "MiB/s");
+}
+
+static void
+_bench_build (void)
+{
+  const time_t create_time = 269236800L;
+  const double start = _vcd_stats_clock ();
+  VcdObj_t *obj = vcd_obj_new (gl.svcd ? VCD_TYPE_SVCD : VCD_TYPE_VCD2);
+  VcdImageSink_t *sink = vcd_image_sink_new_bincue ();
+  VcdMpegSource_t *src =
+    vcd_mpeg_source_new (vcd_data_source_new_stdio (gl.mpeg_fname));
+  VcdStats_t stats;
+  unsigned sectors;
+  double elapsed;
+
+  vcd_image_sink_set_arg (sink, "bin", gl.bin_fname);
+  vcd_image_sink_set_arg (sink, "cue", gl.cue_fname);
+
+  vcd_mpeg_source_scan (src, true, false, NULL, NULL);
+  vcd_obj_append_sequence_play_item (obj, src, NULL, NULL);
+
+  sectors = vcd_obj_begin_output (obj);
+
+  if (vcd_obj_write_image (obj, sink, NULL, NULL, &create_time))
+    vcd_error ("writing image failed");
+
+  vcd_obj_end_output (obj);
+  elapsed = _vcd_stats_clock () - start;
+
+  _report ("build", elapsed, "s");
+  _report ("build_rate", sectors / elapsed, "sectors/s");
+
+  vcd_obj_get_stats (obj, &stats);
+  _report ("build_peak_rss", stats.peak_rss, "KiB");
+
+  vcd_obj_destroy (obj);
+}
+
+int
+main (int argc, const char *argv[])
+{
+  int n;
+
+  gl.bin_fname = "bench.bin";
+  gl.cue_fname = "bench.cue";
+
+  for (n = 1; n < argc; n++)
+    {
+      const char *arg = argv[n];
+
+      if (!strcmp (arg, "--json"))
+        gl.json = true;
+      else if (!strcmp (arg, "--svcd"))
+        gl.svcd = true;
+      else if (!strncmp (arg, "--bin-file=", 11))
+        gl.bin_fname = arg + 11;
+      else if (!strncmp (arg, "--cue-file=", 11))
+        gl.cue_fname = arg + 11;
+      else if (arg[0] != '-' && !gl.mpeg_fname)
+        gl.mpeg_fname = arg;
+      else
+        {
+          fprintf (stderr, "usage: %s [--json] [--svcd] [--bin-file=FILE]"
+                   " [--cue-file=FILE] MPEG-FILE\n", argv[0]);
+          return EXIT_FAILURE;
+        }
+    }
+
+  if (!gl.mpeg_fname)
+    {
+      fprintf (stderr, "%s: MPEG file argument missing\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  vcd_log_set_handler (_log_handler);
+
+  _bench_scan ();
+  _bench_parse ();
+  _bench_mode2 ();
+  _bench_sink ();
+  _bench_build ();
+
+  if (gl.json)
+    printf ("\n]\n");
+
+  return EXIT_SUCCESS;
+}
+
+
+/*
+ * Local variables:
+ *  c-file-style: "gnu"
+ *  tab-width: 8
+ *  indent-tabs-mode: nil
+ * End:
+ */